@@ -213,6 +213,17 @@ public:
      */
     size_t variableCount() const;
 
+    /**
+     * @brief Get the variables of this component.
+     *
+     * The returned range can be iterated over, e.g. in a range-based for
+     * loop, without copying any variable pointer.  It is only valid until
+     * the variables of this component are next modified.
+     *
+     * @return The variables of this component, in order.
+     */
+    const std::vector<VariablePtr> &variables() const;
+
     /**
      * @brief Test whether the argument @p variable is in this component.
      *
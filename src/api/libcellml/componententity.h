@@ -20,6 +20,9 @@ limitations under the License.
 #include "libcellml/namedentity.h"
 #include "libcellml/types.h"
 
+#include <functional>
+#include <vector>
+
 namespace libcellml {
 
 class Component;
@@ -263,6 +266,29 @@ public:
      */
     size_t componentCount() const;
 
+    /**
+     * @brief Get the components directly contained in this component
+     * entity.
+     *
+     * The returned range can be iterated over, e.g. in a range-based for
+     * loop, without copying any component pointer.  It is only valid until
+     * this component entity or its components are next modified.
+     *
+     * @return The child components, in order.
+     */
+    const std::vector<ComponentPtr> &components() const;
+
+    /**
+     * @brief Call @p visitor for each component of this component entity.
+     *
+     * The components are visited depth first, each one before its children,
+     * and include the components encapsulated at any depth.  @p visitor must
+     * not add or remove components.
+     *
+     * @param visitor The function to call for each component.
+     */
+    void forEachComponent(const std::function<void(const ComponentPtr &)> &visitor) const;
+
     /**
      * @brief Set the encapsulation Id for this entity.
      *
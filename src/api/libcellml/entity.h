@@ -61,6 +61,18 @@ public:
      */
     std::string id() const;
 
+    /**
+     * @brief Get the revision of this entity.
+     *
+     * The revision changes whenever this entity, or any entity it contains,
+     * is changed through its API, and is never given to another entity.  It
+     * can be compared with a revision obtained earlier to find out if
+     * anything has changed since.
+     *
+     * @return The revision of this entity.
+     */
+    size_t revision() const;
+
     /**
      * @brief Returns the parent of the CellML Entity.
      *
@@ -111,7 +123,18 @@ public:
      */
     bool hasParent(Component *component) const;
 
+protected:
+    /**
+     * @brief Mark this entity as modified.
+     *
+     * Give this entity a new revision, as well as its parent and all of its
+     * ancestors.  To be called by any method that changes this entity.
+     */
+    void markModified();
+
 private:
+    friend class ImportedEntity; /**< Access to markModified() for the entities that can be imported. */
+
     void swap(Entity &rhs); /**< Swap method required for C++ 11 move semantics. */
 
     struct EntityImpl;
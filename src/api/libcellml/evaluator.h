@@ -0,0 +1,462 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "libcellml/exportdefinitions.h"
+#include "libcellml/logger.h"
+#include "libcellml/types.h"
+
+namespace libcellml {
+
+/**
+ * @brief The Evaluator class.
+ *
+ * The Evaluator class analyses the math of a CellML model and compiles it
+ * into a form that can be evaluated directly.  The model variables are
+ * split into the variable of integration, the state variables, and the
+ * remaining variables (constants, computed constants and algebraic
+ * variables).  The values of the state variables, their rates, and the
+ * remaining variables are held in caller owned arrays of size
+ * stateCount(), stateCount() and variableCount() respectively.
+ *
+ * The methods with a @c Batch suffix evaluate many instances of the model
+ * at once, for instance for parameter sweeps or tissue simulations.  Their
+ * arrays use a structure-of-arrays layout with the instances as the inner
+ * dimension: the value of entry @c i for instance @c j is held at position
+ * @c i * @c instanceCount + @c j, so that each array is @c instanceCount
+ * times the size of its single instance counterpart.
+ */
+class LIBCELLML_EXPORT Evaluator: public Logger
+{
+public:
+    Evaluator(); /**< Constructor */
+    ~Evaluator() override; /**< Destructor */
+    Evaluator(const Evaluator &rhs); /**< Copy constructor */
+    Evaluator(Evaluator &&rhs) noexcept; /**< Move constructor */
+    Evaluator &operator=(Evaluator rhs); /**< Assignment operator */
+
+    /**
+     * @brief Analyse and compile the math of the @p model.
+     *
+     * Analyse the math of the given @p model and its encapsulated components
+     * and compile it for evaluation.  Any errors will be logged in the
+     * @c Evaluator, in which case the @c Evaluator cannot be used to
+     * evaluate the model.
+     *
+     * @param model The model to process.
+     */
+    void processModel(const ModelPtr &model);
+
+    /**
+     * @brief Set the variable to tabulate expensive expressions against.
+     *
+     * When a model is processed, the largest subexpressions that only
+     * depend on @p variable (or its equivalent variables) and numbers, are
+     * smooth, and call an exponential, logarithm, power or trigonometric
+     * function, are tabulated at the values of @p variable from @p minimum
+     * to @p maximum, @p step apart.  They are then evaluated by linear
+     * interpolation, or exactly if @p variable lies outside of that range.
+     * This is typically used with the membrane potential of cardiac models.
+     *
+     * The setting applies to models processed after this call.
+     *
+     * @param variable The variable the tables are indexed by.
+     * @param minimum The smallest tabulated value of @p variable.
+     * @param maximum The largest tabulated value of @p variable.
+     * @param step The distance between tabulated values of @p variable.
+     */
+    void setLookupTableVariable(const VariablePtr &variable, double minimum, double maximum, double step);
+
+    /**
+     * @brief Stop tabulating expressions.
+     *
+     * The setting applies to models processed after this call.
+     */
+    void removeLookupTableVariable();
+
+    /**
+     * @brief Get the variable expressions are tabulated against.
+     *
+     * @return The variable set by setLookupTableVariable(), or @c nullptr.
+     */
+    VariablePtr lookupTableVariable() const;
+
+    /**
+     * @brief Get the number of lookup tables of the processed model.
+     *
+     * @return The number of tabulated expressions.
+     */
+    size_t lookupTableCount() const;
+
+    /**
+     * @brief Get the interpolation error of the lookup table at @p index.
+     *
+     * The error is the largest absolute difference between the interpolated
+     * and exact values of the tabulated expression halfway between the
+     * tabulated values, where the error of linear interpolation peaks.  If
+     * @p index is not valid @c 0.0 is returned.
+     *
+     * @param index The index of the lookup table.
+     *
+     * @return The estimated maximum absolute error of the lookup table.
+     */
+    double lookupTableError(size_t index) const;
+
+    /**
+     * @brief Set whether constants are folded into the math.
+     *
+     * When a model is processed, subexpressions that only involve numbers
+     * are always evaluated once, and identical subexpressions are only
+     * evaluated once per call.  If @p fold is @c true, the initial values of
+     * constant variables are treated as numbers too, so that the expressions
+     * they are used in can be folded further.  The values of constants then
+     * no longer affect the math once the model is processed, even if they are
+     * changed in the variables array or by a reset.  This is @c false by
+     * default.
+     *
+     * The setting applies to models processed after this call.
+     *
+     * @param fold Whether to fold the values of constant variables.
+     */
+    void setFoldConstantVariables(bool fold);
+
+    /**
+     * @brief Get whether constants are folded into the math.
+     *
+     * @return The value set by setFoldConstantVariables().
+     */
+    bool foldConstantVariables() const;
+
+    /**
+     * @brief Get the number of operations removed from the processed model.
+     *
+     * The number of arithmetic, logical and function call operations saved
+     * by constant folding, common subexpression elimination and lookup
+     * tables in the programs computing the computed constants, rates and
+     * variables, compared to evaluating the math of the model as written.
+     *
+     * @return The number of operations removed.
+     */
+    size_t removedOperationCount() const;
+
+    /**
+     * @brief Test if the @c Evaluator holds a successfully processed model.
+     *
+     * @return @c true if a model was processed without errors, @c false
+     * otherwise.
+     */
+    bool isValid() const;
+
+    /**
+     * @brief Get the variable of integration.
+     *
+     * Get the variable of integration of the processed model, or
+     * @c nullptr if the model has no differential equations.
+     *
+     * @return The variable of integration.
+     */
+    VariablePtr voi() const;
+
+    /**
+     * @brief Get the number of state variables.
+     *
+     * @return The number of state variables.
+     */
+    size_t stateCount() const;
+
+    /**
+     * @brief Get the state variable at @p index.
+     *
+     * Returns the state variable stored at position @p index of the state
+     * array.  If @p index is not valid a @c nullptr is returned.
+     *
+     * @param index The index of the state variable to return.
+     *
+     * @return The state variable at the given @p index.
+     */
+    VariablePtr state(size_t index) const;
+
+    /**
+     * @brief Get the number of variables that are neither states nor the
+     * variable of integration.
+     *
+     * @return The number of variables.
+     */
+    size_t variableCount() const;
+
+    /**
+     * @brief Get the variable at @p index.
+     *
+     * Returns the variable stored at position @p index of the variable
+     * array.  If @p index is not valid a @c nullptr is returned.
+     *
+     * @param index The index of the variable to return.
+     *
+     * @return The variable at the given @p index.
+     */
+    VariablePtr variable(size_t index) const;
+
+    /**
+     * @brief Test if the state variable at @p index is a gating variable.
+     *
+     * A gating variable is a state whose rate is an affine function of the
+     * state itself, i.e. of the form d(state)/d(voi) = a + b * state where
+     * neither @c a nor @c b depend on the state, as for the gates of
+     * Hodgkin-Huxley style models.  Such states can be integrated using the
+     * Rush-Larsen method.
+     *
+     * @param index The index of the state variable.
+     *
+     * @return @c true if the state is a gating variable, @c false otherwise.
+     */
+    bool isGatingState(size_t index) const;
+
+    /**
+     * @brief Get the number of gating variables.
+     *
+     * @return The number of state variables for which isGatingState() is
+     * @c true.
+     */
+    size_t gatingStateCount() const;
+
+    /**
+     * @brief Get the number of structurally non-zero entries of the
+     * Jacobian of the rates.
+     *
+     * The Jacobian of the rates with respect to the states is held in
+     * coordinate format: entry @c i is the derivative of the rate of state
+     * jacobianEntryRow(i) with respect to state jacobianEntryColumn(i).
+     * Entries are sorted by row, then by column, and the derivatives of all
+     * other pairs of states are zero.
+     *
+     * @return The number of Jacobian entries.
+     */
+    size_t jacobianEntryCount() const;
+
+    /**
+     * @brief Get the row of the Jacobian entry at @p index.
+     *
+     * @param index The index of the Jacobian entry.
+     *
+     * @return The index of the state whose rate is differentiated, or
+     * stateCount() if @p index is not valid.
+     */
+    size_t jacobianEntryRow(size_t index) const;
+
+    /**
+     * @brief Get the column of the Jacobian entry at @p index.
+     *
+     * @param index The index of the Jacobian entry.
+     *
+     * @return The index of the state the rate is differentiated with respect
+     * to, or stateCount() if @p index is not valid.
+     */
+    size_t jacobianEntryColumn(size_t index) const;
+
+    /**
+     * @brief Get the number of when conditions.
+     *
+     * Get the number of when conditions found in the resets of the model,
+     * which is the size of the arrays used by computeConditions() and
+     * applyResets().
+     *
+     * @return The number of when conditions.
+     */
+    size_t whenCount() const;
+
+    /**
+     * @brief Set the initial values of the states and constants.
+     *
+     * @param states The state array to initialise.
+     * @param variables The variable array to initialise.
+     */
+    void initialiseStatesAndConstants(double *states, double *variables) const;
+
+    /**
+     * @brief Compute the variables that only depend on constants.
+     *
+     * @param variables The variable array.
+     */
+    void computeComputedConstants(double *variables) const;
+
+    /**
+     * @brief Compute the rates of the states.
+     *
+     * Compute the rates, and the algebraic variables needed to compute them,
+     * at the given value of the variable of integration.
+     *
+     * @param voi The value of the variable of integration.
+     * @param states The state array.
+     * @param rates The rate array to compute.
+     * @param variables The variable array.
+     */
+    void computeRates(double voi, const double *states, double *rates, double *variables) const;
+
+    /**
+     * @brief Compute the algebraic variables.
+     *
+     * @param voi The value of the variable of integration.
+     * @param states The state array.
+     * @param rates The rate array.
+     * @param variables The variable array.
+     */
+    void computeVariables(double voi, const double *states, const double *rates, double *variables) const;
+
+    /**
+     * @brief Compute the affine coefficients of the gating variables.
+     *
+     * For each gating variable at index @c i, set @c coefficients[2 * i] and
+     * @c coefficients[2 * i + 1] to @c a and @c b where the rate of the state
+     * is @c a + @c b * state.  The entries of non-gating states are left
+     * untouched.  The @p variables are expected to have been updated by
+     * computeRates() at the same point.
+     *
+     * @param voi The value of the variable of integration.
+     * @param states The state array.
+     * @param rates The rate array.
+     * @param variables The variable array.
+     * @param coefficients The array of size 2 * stateCount() to compute.
+     */
+    void computeGatingCoefficients(double voi, const double *states, const double *rates, const double *variables, double *coefficients) const;
+
+    /**
+     * @brief Compute the Jacobian of the rates with respect to the states.
+     *
+     * Compute the entries of the Jacobian, as described by
+     * jacobianEntryCount(), from derivatives obtained by symbolic
+     * differentiation of the model math.  The conditions of piecewise
+     * expressions are considered constant.  The @p rates and @p variables
+     * are expected to have been updated by computeRates() at the same point.
+     *
+     * @param voi The value of the variable of integration.
+     * @param states The state array.
+     * @param rates The rate array.
+     * @param variables The variable array.
+     * @param jacobian The array of size jacobianEntryCount() to compute.
+     */
+    void computeJacobian(double voi, const double *states, const double *rates, const double *variables, double *jacobian) const;
+
+    /**
+     * @brief Set the initial values of the states and constants of
+     * @p instanceCount instances.
+     *
+     * @param states The state array to initialise.
+     * @param variables The variable array to initialise.
+     * @param instanceCount The number of instances.
+     */
+    void initialiseStatesAndConstantsBatch(double *states, double *variables, size_t instanceCount) const;
+
+    /**
+     * @brief Compute the variables that only depend on constants for
+     * @p instanceCount instances.
+     *
+     * @param variables The variable array.
+     * @param instanceCount The number of instances.
+     */
+    void computeComputedConstantsBatch(double *variables, size_t instanceCount) const;
+
+    /**
+     * @brief Compute the rates of the states of @p instanceCount instances.
+     *
+     * The batch counterpart of computeRates().  The exponentials, logarithms
+     * and powers are computed using vectorisable approximations, so the
+     * results may differ from those of computeRates() in the last few bits.
+     *
+     * @param voi The value of the variable of integration.
+     * @param states The state array.
+     * @param rates The rate array to compute.
+     * @param variables The variable array.
+     * @param instanceCount The number of instances.
+     */
+    void computeRatesBatch(double voi, const double *states, double *rates, double *variables, size_t instanceCount) const;
+
+    /**
+     * @brief Compute the algebraic variables of @p instanceCount instances.
+     *
+     * The batch counterpart of computeVariables().
+     *
+     * @param voi The value of the variable of integration.
+     * @param states The state array.
+     * @param rates The rate array.
+     * @param variables The variable array.
+     * @param instanceCount The number of instances.
+     */
+    void computeVariablesBatch(double voi, const double *states, const double *rates, double *variables, size_t instanceCount) const;
+
+    /**
+     * @brief Compute the affine coefficients of the gating variables of
+     * @p instanceCount instances.
+     *
+     * The batch counterpart of computeGatingCoefficients(), where
+     * @p coefficients holds 2 * stateCount() entries per instance.
+     *
+     * @param voi The value of the variable of integration.
+     * @param states The state array.
+     * @param rates The rate array.
+     * @param variables The variable array.
+     * @param coefficients The coefficient array to compute.
+     * @param instanceCount The number of instances.
+     */
+    void computeGatingCoefficientsBatch(double voi, const double *states, const double *rates, const double *variables, double *coefficients, size_t instanceCount) const;
+
+    /**
+     * @brief Compute the conditions of all the whens of the model.
+     *
+     * Set each entry of @p conditions to @c 1.0 if the condition of the
+     * corresponding when holds and to @c 0.0 otherwise.
+     *
+     * @param voi The value of the variable of integration.
+     * @param states The state array.
+     * @param rates The rate array.
+     * @param variables The variable array.
+     * @param conditions The array of size whenCount() to compute.
+     */
+    void computeConditions(double voi, const double *states, const double *rates, const double *variables, double *conditions) const;
+
+    /**
+     * @brief Apply the resets triggered between two sets of conditions.
+     *
+     * A when is triggered when its condition changes from false in
+     * @p previousConditions to true in @p conditions.  Resets are considered
+     * in increasing reset order and, within a reset, the triggered when with
+     * the lowest order sets the value of the reset variable.  Only the first
+     * reset applied to a variable takes effect.  All values are computed
+     * from the state of the model before any of them are assigned, after
+     * which the computed constants are recomputed.
+     *
+     * @param voi The value of the variable of integration.
+     * @param states The state array.
+     * @param rates The rate array.
+     * @param variables The variable array.
+     * @param previousConditions The conditions before the event.
+     * @param conditions The conditions after the event.
+     *
+     * @return @c true if any reset was applied, @c false otherwise.
+     */
+    bool applyResets(double voi, double *states, const double *rates, double *variables,
+                     const double *previousConditions, const double *conditions) const;
+
+private:
+    friend class EvaluatorAccess; /**< Access to the programs for the library. */
+
+    void swap(Evaluator &rhs); /**< Swap method required for C++ 11 move semantics. */
+
+    struct EvaluatorImpl; /**< Forward declaration for pImpl idiom. */
+    EvaluatorImpl *mPimpl; /**< Private member to implementation pointer. */
+};
+
+} // namespace libcellml
@@ -0,0 +1,200 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "libcellml/exportdefinitions.h"
+#include "libcellml/types.h"
+#include "libcellml/variable.h"
+
+#include <string>
+#include <vector>
+
+namespace libcellml {
+
+/**
+ * @brief The FlatModel class.
+ *
+ * The FlatModel class holds the structure of a model as a set of contiguous
+ * tables, one per property, for engines that make passes over all the
+ * components or variables of a model.  The components are numbered in
+ * depth-first order of the encapsulation hierarchy and the variables in the
+ * order of their components.  Adjacency lists, i.e. the children of the
+ * components and the equivalences of the variables, are stored in
+ * compressed sparse row form: the neighbours of entry @c i are the entries
+ * of the neighbour table from offset @c i to offset @c i+1.
+ *
+ * A flat model is built once from a model and never changes, so it may be
+ * shared and read by any number of threads at the same time.  It does not
+ * follow later changes to the model.
+ */
+class LIBCELLML_EXPORT FlatModel
+{
+public:
+    /**
+     * The index used when there is no such entity, e.g. for the parent of a
+     * component directly in the model.
+     */
+    static const size_t NO_INDEX;
+
+    /**
+     * @brief Build the flat model of @p model.
+     *
+     * @param model The model to flatten.
+     */
+    explicit FlatModel(const ModelPtr &model);
+    ~FlatModel(); /**< Destructor */
+    FlatModel(const FlatModel &rhs) = delete; /**< Copy constructor */
+    FlatModel(FlatModel &&rhs) noexcept = delete; /**< Move constructor */
+    FlatModel &operator=(const FlatModel &rhs) = delete; /**< Assignment operator */
+
+    /**
+     * @brief Get the number of components, at any depth.
+     *
+     * @return The number of components.
+     */
+    size_t componentCount() const;
+
+    /**
+     * @brief Get the components, in depth-first order.
+     *
+     * @return The components of the model.
+     */
+    const std::vector<ComponentPtr> &components() const;
+
+    /**
+     * @brief Get the index of the parent of each component.
+     *
+     * @return The parent of each component, or @c NO_INDEX for the
+     * components directly in the model.
+     */
+    const std::vector<size_t> &componentParents() const;
+
+    /**
+     * @brief Get the offsets of the children of each component.
+     *
+     * @return The componentCount() + 1 offsets into componentChildren().
+     */
+    const std::vector<size_t> &componentChildOffsets() const;
+
+    /**
+     * @brief Get the children of all the components.
+     *
+     * @return The indices of the children of each component, in order.
+     */
+    const std::vector<size_t> &componentChildren() const;
+
+    /**
+     * @brief Get the offsets of the variables of each component.
+     *
+     * The variables of component @c i are those from offset @c i to offset
+     * @c i+1.
+     *
+     * @return The componentCount() + 1 offsets into the variables.
+     */
+    const std::vector<size_t> &componentVariableOffsets() const;
+
+    /**
+     * @brief Get the number of variables.
+     *
+     * @return The number of variables.
+     */
+    size_t variableCount() const;
+
+    /**
+     * @brief Get the variables, in the order of their components.
+     *
+     * @return The variables of the model.
+     */
+    const std::vector<VariablePtr> &variables() const;
+
+    /**
+     * @brief Get the index of the component of each variable.
+     *
+     * @return The component of each variable.
+     */
+    const std::vector<size_t> &variableComponents() const;
+
+    /**
+     * @brief Get the names of the units used by the variables.
+     *
+     * @return The distinct names of units, in order of first use.
+     */
+    const std::vector<std::string> &unitsNames() const;
+
+    /**
+     * @brief Get the units of each variable.
+     *
+     * @return The index of the units of each variable in unitsNames().
+     */
+    const std::vector<size_t> &variableUnits() const;
+
+    /**
+     * @brief Get the interface type of each variable.
+     *
+     * @return The interface type of each variable, which is
+     * @c Variable::InterfaceType::NONE if it is not set or not valid.
+     */
+    const std::vector<Variable::InterfaceType> &variableInterfaceTypes() const;
+
+    /**
+     * @brief Get the initial value of each variable.
+     *
+     * @return The initial value of each variable, or NaN if it has none or
+     * if it is not a real number, e.g. if it is the name of a variable.
+     */
+    const std::vector<double> &variableInitialValues() const;
+
+    /**
+     * @brief Get the equivalence set of each variable.
+     *
+     * The equivalence sets are numbered from @c 0 in order of first use, so
+     * they can index an array.
+     *
+     * @return The equivalence set of each variable.
+     */
+    const std::vector<size_t> &variableEquivalenceSets() const;
+
+    /**
+     * @brief Get the number of equivalence sets.
+     *
+     * @return The number of equivalence sets.
+     */
+    size_t equivalenceSetCount() const;
+
+    /**
+     * @brief Get the offsets of the equivalences of each variable.
+     *
+     * @return The variableCount() + 1 offsets into equivalentVariables().
+     */
+    const std::vector<size_t> &equivalenceOffsets() const;
+
+    /**
+     * @brief Get the variables directly equivalent to each variable.
+     *
+     * Equivalences to variables that are not in the model are left out.
+     *
+     * @return The indices of the equivalent variables of each variable, in
+     * order.
+     */
+    const std::vector<size_t> &equivalentVariables() const;
+
+private:
+    struct FlatModelImpl; /**< Forward declaration for pImpl idiom. */
+    FlatModelImpl *mPimpl; /**< Private member to implementation pointer */
+};
+
+} // namespace libcellml
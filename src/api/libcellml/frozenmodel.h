@@ -0,0 +1,535 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "libcellml/exportdefinitions.h"
+#include "libcellml/types.h"
+
+#include <string>
+
+namespace libcellml {
+
+/**
+ * @brief The FrozenModel class.
+ *
+ * A frozen model is an immutable snapshot of a model, created by
+ * Model::freeze(), with its units, components and variables laid out in
+ * contiguous arrays.  The components are numbered in depth-first order of
+ * the encapsulation hierarchy, and the variables and resets in the order of
+ * their components, so that the variables and the resets of a component have
+ * consecutive indices.  The unit rows of units and the whens of resets are
+ * referred to by the index of their units or reset and their index within
+ * it.
+ *
+ * Entities are referred to by index and strings are returned by reference,
+ * so reading a frozen model never copies a string or touches the reference
+ * count of a shared pointer.  A frozen model never changes, so any number of
+ * threads may read it at the same time without any synchronisation.
+ */
+class LIBCELLML_EXPORT FrozenModel
+{
+public:
+    /**
+     * The index returned when there is no such entity.
+     */
+    static const size_t NO_INDEX;
+
+    ~FrozenModel(); /**< Destructor */
+    FrozenModel(const FrozenModel &rhs) = delete; /**< Copy constructor */
+    FrozenModel(FrozenModel &&rhs) noexcept = delete; /**< Move constructor */
+    FrozenModel &operator=(const FrozenModel &rhs) = delete; /**< Assignment operator */
+
+    /**
+     * @brief Get the name of the model.
+     *
+     * @return The name of the model.
+     */
+    const std::string &name() const;
+
+    /**
+     * @brief Get the id of the model.
+     *
+     * @return The id of the model.
+     */
+    const std::string &id() const;
+
+    /**
+     * @brief Get the number of units in the model.
+     *
+     * @return The number of units.
+     */
+    size_t unitsCount() const;
+
+    /**
+     * @brief Get the index of the units called @p name.
+     *
+     * @param name The name of the units.
+     *
+     * @return The index of the units, or @c NO_INDEX if there is none.
+     */
+    size_t units(const std::string &name) const;
+
+    /**
+     * @brief Get the name of the units at index @p units.
+     *
+     * @param units The index of the units.
+     *
+     * @return The name of the units, or the empty string if @p units is out
+     * of range.
+     */
+    const std::string &unitsName(size_t units) const;
+
+    /**
+     * @brief Get the id of the units at index @p units.
+     *
+     * @param units The index of the units.
+     *
+     * @return The id of the units, or the empty string if @p units is out of
+     * range.
+     */
+    const std::string &unitsId(size_t units) const;
+
+    /**
+     * @brief Get the URL the units at index @p units is imported from.
+     *
+     * @param units The index of the units.
+     *
+     * @return The URL of the import source of the units, or the empty string
+     * if the units is not imported.
+     */
+    const std::string &unitsImportUrl(size_t units) const;
+
+    /**
+     * @brief Get the reference of the units at index @p units in the model
+     * it is imported from.
+     *
+     * @param units The index of the units.
+     *
+     * @return The import reference of the units, or the empty string if the
+     * units is not imported.
+     */
+    const std::string &unitsImportReference(size_t units) const;
+
+    /**
+     * @brief Get the number of unit rows of the units at index @p units.
+     *
+     * @param units The index of the units.
+     *
+     * @return The number of unit rows, or @c 0 if @p units is out of range.
+     */
+    size_t unitsUnitCount(size_t units) const;
+
+    /**
+     * @brief Get the units referred to by a unit row of the units at index
+     * @p units.
+     *
+     * @param units The index of the units.
+     * @param index The index of the unit row within the units.
+     *
+     * @return The name of the units referred to, or the empty string if
+     * either index is out of range.
+     */
+    const std::string &unitsUnitReference(size_t units, size_t index) const;
+
+    /**
+     * @brief Get the prefix of a unit row of the units at index @p units.
+     *
+     * @param units The index of the units.
+     * @param index The index of the unit row within the units.
+     *
+     * @return The prefix of the unit row, or the empty string if either
+     * index is out of range.
+     */
+    const std::string &unitsUnitPrefix(size_t units, size_t index) const;
+
+    /**
+     * @brief Get the exponent of a unit row of the units at index @p units.
+     *
+     * @param units The index of the units.
+     * @param index The index of the unit row within the units.
+     *
+     * @return The exponent of the unit row, or @c 1.0 if either index is out
+     * of range.
+     */
+    double unitsUnitExponent(size_t units, size_t index) const;
+
+    /**
+     * @brief Get the multiplier of a unit row of the units at index
+     * @p units.
+     *
+     * @param units The index of the units.
+     * @param index The index of the unit row within the units.
+     *
+     * @return The multiplier of the unit row, or @c 1.0 if either index is
+     * out of range.
+     */
+    double unitsUnitMultiplier(size_t units, size_t index) const;
+
+    /**
+     * @brief Get the number of components in the model, at any depth.
+     *
+     * @return The number of components.
+     */
+    size_t componentCount() const;
+
+    /**
+     * @brief Get the index of the component called @p name.
+     *
+     * @param name The name of the component.
+     *
+     * @return The index of the first component called @p name, in
+     * depth-first order, or @c NO_INDEX if there is none.
+     */
+    size_t component(const std::string &name) const;
+
+    /**
+     * @brief Get the name of the component at index @p component.
+     *
+     * @param component The index of the component.
+     *
+     * @return The name of the component, or the empty string if
+     * @p component is out of range.
+     */
+    const std::string &componentName(size_t component) const;
+
+    /**
+     * @brief Get the id of the component at index @p component.
+     *
+     * @param component The index of the component.
+     *
+     * @return The id of the component, or the empty string if @p component
+     * is out of range.
+     */
+    const std::string &componentId(size_t component) const;
+
+    /**
+     * @brief Get the math of the component at index @p component.
+     *
+     * @param component The index of the component.
+     *
+     * @return The math of the component, or the empty string if
+     * @p component is out of range.
+     */
+    const std::string &componentMath(size_t component) const;
+
+    /**
+     * @brief Get the URL the component at index @p component is imported
+     * from.
+     *
+     * @param component The index of the component.
+     *
+     * @return The URL of the import source of the component, or the empty
+     * string if the component is not imported.
+     */
+    const std::string &componentImportUrl(size_t component) const;
+
+    /**
+     * @brief Get the reference of the component at index @p component in
+     * the model it is imported from.
+     *
+     * @param component The index of the component.
+     *
+     * @return The import reference of the component, or the empty string if
+     * the component is not imported.
+     */
+    const std::string &componentImportReference(size_t component) const;
+
+    /**
+     * @brief Get the parent of the component at index @p component.
+     *
+     * @param component The index of the component.
+     *
+     * @return The index of the parent component, or @c NO_INDEX if the
+     * component is directly in the model or @p component is out of range.
+     */
+    size_t componentParent(size_t component) const;
+
+    /**
+     * @brief Get the number of child components of the component at index
+     * @p component.
+     *
+     * @param component The index of the component.
+     *
+     * @return The number of children, or @c 0 if @p component is out of
+     * range.
+     */
+    size_t componentChildCount(size_t component) const;
+
+    /**
+     * @brief Get a child component of the component at index @p component.
+     *
+     * @param component The index of the component.
+     * @param index The index of the child within the component.
+     *
+     * @return The index of the child in the model, or @c NO_INDEX if either
+     * index is out of range.
+     */
+    size_t componentChild(size_t component, size_t index) const;
+
+    /**
+     * @brief Get the number of variables of the component at index
+     * @p component.
+     *
+     * @param component The index of the component.
+     *
+     * @return The number of variables, or @c 0 if @p component is out of
+     * range.
+     */
+    size_t componentVariableCount(size_t component) const;
+
+    /**
+     * @brief Get the index of the first variable of the component at index
+     * @p component.
+     *
+     * The variables of the component are the componentVariableCount()
+     * variables starting from this one.
+     *
+     * @param component The index of the component.
+     *
+     * @return The index of the first variable of the component, or
+     * @c NO_INDEX if @p component is out of range.
+     */
+    size_t componentFirstVariable(size_t component) const;
+
+    /**
+     * @brief Get the number of variables in the model.
+     *
+     * @return The number of variables.
+     */
+    size_t variableCount() const;
+
+    /**
+     * @brief Get the index of the variable called @p name in the component
+     * at index @p component.
+     *
+     * @param component The index of the component.
+     * @param name The name of the variable.
+     *
+     * @return The index of the variable, or @c NO_INDEX if there is none.
+     */
+    size_t variable(size_t component, const std::string &name) const;
+
+    /**
+     * @brief Get the name of the variable at index @p variable.
+     *
+     * @param variable The index of the variable.
+     *
+     * @return The name of the variable, or the empty string if @p variable
+     * is out of range.
+     */
+    const std::string &variableName(size_t variable) const;
+
+    /**
+     * @brief Get the id of the variable at index @p variable.
+     *
+     * @param variable The index of the variable.
+     *
+     * @return The id of the variable, or the empty string if @p variable is
+     * out of range.
+     */
+    const std::string &variableId(size_t variable) const;
+
+    /**
+     * @brief Get the name of the units of the variable at index
+     * @p variable.
+     *
+     * @param variable The index of the variable.
+     *
+     * @return The name of the units of the variable, or the empty string if
+     * @p variable is out of range.
+     */
+    const std::string &variableUnits(size_t variable) const;
+
+    /**
+     * @brief Get the initial value of the variable at index @p variable.
+     *
+     * @param variable The index of the variable.
+     *
+     * @return The initial value of the variable, or the empty string if
+     * @p variable is out of range.
+     */
+    const std::string &variableInitialValue(size_t variable) const;
+
+    /**
+     * @brief Get the interface type of the variable at index @p variable.
+     *
+     * @param variable The index of the variable.
+     *
+     * @return The interface type of the variable, or the empty string if
+     * @p variable is out of range.
+     */
+    const std::string &variableInterfaceType(size_t variable) const;
+
+    /**
+     * @brief Get the component of the variable at index @p variable.
+     *
+     * @param variable The index of the variable.
+     *
+     * @return The index of the component of the variable, or @c NO_INDEX if
+     * @p variable is out of range.
+     */
+    size_t variableComponent(size_t variable) const;
+
+    /**
+     * @brief Get the number of variables directly equivalent to the variable
+     * at index @p variable.
+     *
+     * Equivalences to variables that are not in the model are left out.
+     *
+     * @param variable The index of the variable.
+     *
+     * @return The number of equivalent variables, or @c 0 if @p variable is
+     * out of range.
+     */
+    size_t equivalentVariableCount(size_t variable) const;
+
+    /**
+     * @brief Get a variable directly equivalent to the variable at index
+     * @p variable.
+     *
+     * @param variable The index of the variable.
+     * @param index The index of the equivalence.
+     *
+     * @return The index of the equivalent variable, or @c NO_INDEX if either
+     * index is out of range.
+     */
+    size_t equivalentVariable(size_t variable, size_t index) const;
+
+    /**
+     * @brief Get the number of resets of the component at index
+     * @p component.
+     *
+     * @param component The index of the component.
+     *
+     * @return The number of resets, or @c 0 if @p component is out of range.
+     */
+    size_t componentResetCount(size_t component) const;
+
+    /**
+     * @brief Get the index of the first reset of the component at index
+     * @p component.
+     *
+     * The resets of the component are the componentResetCount() resets
+     * starting from this one.
+     *
+     * @param component The index of the component.
+     *
+     * @return The index of the first reset of the component, or
+     * @c NO_INDEX if @p component is out of range.
+     */
+    size_t componentFirstReset(size_t component) const;
+
+    /**
+     * @brief Get the number of resets in the model.
+     *
+     * @return The number of resets.
+     */
+    size_t resetCount() const;
+
+    /**
+     * @brief Get the id of the reset at index @p reset.
+     *
+     * @param reset The index of the reset.
+     *
+     * @return The id of the reset, or the empty string if @p reset is out of
+     * range.
+     */
+    const std::string &resetId(size_t reset) const;
+
+    /**
+     * @brief Get the order of the reset at index @p reset.
+     *
+     * @param reset The index of the reset.
+     *
+     * @return The order of the reset, or @c 0 if it has none or @p reset is
+     * out of range.
+     */
+    int resetOrder(size_t reset) const;
+
+    /**
+     * @brief Get the variable reset by the reset at index @p reset.
+     *
+     * @param reset The index of the reset.
+     *
+     * @return The index of the variable, or @c NO_INDEX if the reset has no
+     * variable in the model or @p reset is out of range.
+     */
+    size_t resetVariable(size_t reset) const;
+
+    /**
+     * @brief Get the component of the reset at index @p reset.
+     *
+     * @param reset The index of the reset.
+     *
+     * @return The index of the component of the reset, or @c NO_INDEX if
+     * @p reset is out of range.
+     */
+    size_t resetComponent(size_t reset) const;
+
+    /**
+     * @brief Get the number of whens of the reset at index @p reset.
+     *
+     * @param reset The index of the reset.
+     *
+     * @return The number of whens, or @c 0 if @p reset is out of range.
+     */
+    size_t resetWhenCount(size_t reset) const;
+
+    /**
+     * @brief Get the order of a when of the reset at index @p reset.
+     *
+     * @param reset The index of the reset.
+     * @param index The index of the when within the reset.
+     *
+     * @return The order of the when, or @c 0 if it has none or either index
+     * is out of range.
+     */
+    int resetWhenOrder(size_t reset, size_t index) const;
+
+    /**
+     * @brief Get the condition math of a when of the reset at index
+     * @p reset.
+     *
+     * @param reset The index of the reset.
+     * @param index The index of the when within the reset.
+     *
+     * @return The condition of the when, or the empty string if either index
+     * is out of range.
+     */
+    const std::string &resetWhenCondition(size_t reset, size_t index) const;
+
+    /**
+     * @brief Get the value math of a when of the reset at index @p reset.
+     *
+     * @param reset The index of the reset.
+     * @param index The index of the when within the reset.
+     *
+     * @return The value of the when, or the empty string if either index is
+     * out of range.
+     */
+    const std::string &resetWhenValue(size_t reset, size_t index) const;
+
+private:
+    explicit FrozenModel(const Model &model); /**< Constructor, use Model::freeze() instead. */
+
+    friend class Model; /**< Access to the constructor. */
+
+    struct FrozenModelImpl; /**< Forward declaration for pImpl idiom. */
+    FrozenModelImpl *mPimpl; /**< Private member to implementation pointer */
+};
+
+} // namespace libcellml
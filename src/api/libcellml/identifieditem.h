@@ -0,0 +1,144 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "libcellml/exportdefinitions.h"
+#include "libcellml/types.h"
+
+#include <string>
+
+namespace libcellml {
+
+/**
+ * @brief The IdentifiedItem class.
+ *
+ * An identified item is an element of a model that has an id, as returned
+ * by Model::itemWithId().  Most items are entities, but the ids of some XML
+ * elements belong to other items: the 'encapsulation' element of a model,
+ * the 'component_ref' element of a component, the 'unit' elements of a
+ * units, and the 'connection' and 'map_variables' elements of the
+ * equivalences between variables.
+ *
+ * An identified item does not keep the entities it refers to alive.
+ */
+class LIBCELLML_EXPORT IdentifiedItem
+{
+public:
+    /**
+     * @brief The identified item Type enum class.
+     *
+     * Enum to describe the type of element an identified item is.
+     */
+    enum class Type
+    {
+        COMPONENT,
+        COMPONENT_REF,
+        CONNECTION,
+        ENCAPSULATION,
+        IMPORT,
+        MAP_VARIABLES,
+        MODEL,
+        RESET,
+        UNIT,
+        UNITS,
+        VARIABLE,
+        WHEN
+    };
+
+    /**
+     * @brief Constructs an identified item for an entity.
+     *
+     * The entity is the model for an @c Type::ENCAPSULATION item, the
+     * component for a @c Type::COMPONENT_REF item, the units for a
+     * @c Type::UNIT item, and the import source for a @c Type::IMPORT item.
+     *
+     * @param type The type of the item.
+     * @param entity The entity the item is or belongs to.
+     * @param index The index of the unit, for a @c Type::UNIT item.
+     */
+    IdentifiedItem(Type type, const EntityPtr &entity, size_t index = 0);
+
+    /**
+     * @brief Constructs an identified item for an equivalence.
+     *
+     * @overload
+     *
+     * @param type The type of the item, @c Type::CONNECTION or
+     * @c Type::MAP_VARIABLES.
+     * @param variable1 The first variable of the equivalence.
+     * @param variable2 The second variable of the equivalence.
+     */
+    IdentifiedItem(Type type, const VariablePtr &variable1, const VariablePtr &variable2);
+
+    ~IdentifiedItem(); /**< Destructor */
+    IdentifiedItem(const IdentifiedItem &rhs); /**< Copy constructor */
+    IdentifiedItem(IdentifiedItem &&rhs) noexcept; /**< Move constructor */
+    IdentifiedItem &operator=(IdentifiedItem rhs); /**< Assignment operator */
+
+    /**
+     * @brief Get the type of this item.
+     *
+     * @return The type of this item.
+     */
+    Type type() const;
+
+    /**
+     * @brief Get the entity this item is or belongs to.
+     *
+     * @return The entity, or the @c nullptr if it no longer exists or if
+     * this item is an equivalence.
+     */
+    EntityPtr entity() const;
+
+    /**
+     * @brief Get the index of the unit this item is.
+     *
+     * @return The index of the unit in the units returned by entity(), for
+     * a @c Type::UNIT item, and @c 0 otherwise.
+     */
+    size_t index() const;
+
+    /**
+     * @brief Get the first variable of the equivalence this item is.
+     *
+     * For a @c Type::CONNECTION item, this is a variable of the first
+     * component of the connection.
+     *
+     * @return The first variable, or the @c nullptr if it no longer exists
+     * or if this item is not an equivalence.
+     */
+    VariablePtr variable1() const;
+
+    /**
+     * @brief Get the second variable of the equivalence this item is.
+     *
+     * For a @c Type::CONNECTION item, this is a variable of the second
+     * component of the connection.
+     *
+     * @return The second variable, or the @c nullptr if it no longer exists
+     * or if this item is not an equivalence.
+     */
+    VariablePtr variable2() const;
+
+private:
+    void swap(IdentifiedItem &rhs); /**< Swap method required for C++ 11 move semantics. */
+
+    struct IdentifiedItemImpl; /**< Forward declaration for pImpl idiom. */
+    IdentifiedItemImpl *mPimpl; /**< Private member to implementation pointer */
+};
+
+} // namespace libcellml
@@ -82,7 +82,7 @@ public:
      * @return The reference to the entity in the imported model, the empty
      * string if it is not set.
      */
-    std::string importReference() const;
+    const std::string &importReference() const;
 
     /**
      * @brief Set the import reference.
@@ -98,6 +98,7 @@ public:
 
 private:
     void swap(ImportedEntity &rhs); /**< Swap method required for C++ 11 move semantics. */
+    void markEntityModified(); /**< Mark the entity this is part of as modified, see Entity::revision. */
 
     struct ImportedEntityImpl; /**< Forward declaration for pImpl idiom. */
     ImportedEntityImpl *mPimpl; /**< Private member to implementation pointer. */
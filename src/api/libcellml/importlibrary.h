@@ -0,0 +1,93 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "libcellml/exportdefinitions.h"
+#include "libcellml/types.h"
+
+#include <string>
+
+namespace libcellml {
+
+/**
+ * @brief The ImportLibrary class.
+ *
+ * An import library holds the models imported from files by
+ * Model::resolveImports(), by the location of the file they were parsed
+ * from.  Import sources resolved to the same file through the same library,
+ * by any number of models and calls, share the @c Model parsed from it,
+ * which is only parsed again when the contents of the file change.  A shared
+ * @c Model should be modified through ImportSource::mutableModel(), which
+ * copies it first.
+ */
+class LIBCELLML_EXPORT ImportLibrary
+{
+public:
+    ImportLibrary(); /**< Constructor */
+    ~ImportLibrary(); /**< Destructor */
+    ImportLibrary(const ImportLibrary &rhs); /**< Copy constructor */
+    ImportLibrary(ImportLibrary &&rhs) noexcept; /**< Move constructor */
+    ImportLibrary &operator=(ImportLibrary rhs); /**< Assignment operator */
+
+    /**
+     * @brief Get the model imported from the file at @p url.
+     *
+     * The file is read every time, and the @c Model held for @p url is
+     * returned if the contents of the file have not changed since it was
+     * parsed.  Otherwise the file is parsed, and the new @c Model, whose own
+     * imports are resolved using this library, replaces the one held for
+     * @p url.  Import sources resolved to a replaced @c Model keep it.
+     *
+     * @param url The location of the file.
+     *
+     * @return The @c Model imported from @p url, or @c nullptr if the file
+     * could not be read.
+     */
+    ModelPtr importedModel(const std::string &url);
+
+    /**
+     * @brief Test if this library holds a model for @p url.
+     *
+     * @param url The location of the file.
+     *
+     * @return @c true if this library holds a @c Model imported from
+     * @p url, @c false otherwise.
+     */
+    bool hasModel(const std::string &url) const;
+
+    /**
+     * @brief Get the number of models held by this library.
+     *
+     * @return The number of models.
+     */
+    size_t modelCount() const;
+
+    /**
+     * @brief Remove all the models held by this library.
+     *
+     * The import sources already resolved keep their models.
+     */
+    void clear();
+
+private:
+    void swap(ImportLibrary &rhs); /**< Swap method required for C++ 11 move semantics. */
+
+    struct ImportLibraryImpl; /**< Forward declaration for pImpl idiom. */
+    ImportLibraryImpl *mPimpl; /**< Private member to implementation pointer. */
+};
+
+} // namespace libcellml
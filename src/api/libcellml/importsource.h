@@ -77,6 +77,23 @@ public:
      */
     void setModel(const ModelPtr &model);
 
+    /**
+     * @brief Get the @c Model that resolves the import, for modification.
+     *
+     * The @c Model resolving an import may be shared, e.g. by the import
+     * sources resolved to the same file through an @c ImportLibrary, or by
+     * copies of this @c ImportSource.  If anything other than this
+     * @c ImportSource and the pointers previously returned by this method
+     * refers to the @c Model, it is first replaced with a copy, made with
+     * Model::clone().  Use model() rather than the returned pointer to share
+     * the @c Model with other import sources.  If no @c Model has been
+     * assigned then return the @c nullptr.
+     *
+     * @return The @c Model used to resolve this @c ImportSource, which can be
+     * modified without affecting other import sources.
+     */
+    ModelPtr mutableModel();
+
     /**
      * @brief Test if this @c ImportSource is resolved.
      *
@@ -88,6 +105,22 @@ public:
      */
     bool hasModel() const;
 
+    /**
+     * @brief Get the component called @p reference in the @c Model that
+     * resolves the import.
+     *
+     * The component is looked up at any depth in the @c Model.  The result
+     * is remembered, and looked up again only once the @c Model, or any of
+     * its entities, has been modified, or the @c Model or URL of this
+     * @c ImportSource has been set.  Returns the @c nullptr if this
+     * @c ImportSource is not resolved or if there is no such component.
+     *
+     * @param reference The name of the component to get.
+     *
+     * @return The component called @p reference, or the @c nullptr.
+     */
+    ComponentPtr importedComponent(const std::string &reference) const;
+
 private:
     void swap(ImportSource &rhs); /**< Swap method required for C++ 11 move semantics. */
 
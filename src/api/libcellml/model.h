@@ -20,6 +20,7 @@ limitations under the License.
 #include "libcellml/exportdefinitions.h"
 
 #include <string>
+#include <vector>
 
 #ifndef SWIG
 template class LIBCELLML_EXPORT std::weak_ptr<libcellml::Model>;
@@ -236,21 +237,129 @@ public:
      *
      * Resolve all @c Component and @c Units imports by loading the models
      * from local disk through relative URLs.  The @p baseFile is used to determine
-     * the full path to the source model relative to this one.
+     * the full path to the source model relative to this one.  Every import
+     * source gets its own @c Model.
      *
      * @param baseFile The @c std::string location on local disk of the source @c Model.
      */
     void resolveImports(const std::string &baseFile);
 
+    /**
+     * @brief Resolve all imports in this model using @p library.
+     *
+     * Resolve all @c Component and @c Units imports, here and in the imported
+     * models, with the models held by @p library, which reads the files
+     * through relative URLs from the @p baseFile.  The import sources
+     * resolved to the same file, by this or any other call using
+     * @p library, share the @c Model parsed from it.
+     *
+     * @sa ImportLibrary
+     *
+     * @param baseFile The @c std::string location on local disk of the source @c Model.
+     * @param library The @c ImportLibrary to get the imported models from.
+     */
+    void resolveImports(const std::string &baseFile, ImportLibrary &library);
+
     /**
      * @brief Test if this model has unresolved imports.
      *
-     * Test if this model has unresolved imports.
+     * Test if this model has unresolved imports.  The result is remembered
+     * and reused until this model, or any import source or imported model it
+     * was found from, is modified.
      *
      * @return True if the @c Model has unresolved imports and false otherwise.
      */
     bool hasUnresolvedImports();
 
+    /**
+     * @brief Create a deep copy of this model.
+     *
+     * Copy the units, components, variables, resets and whens of this model
+     * in a single pass.  The equivalences and resets of the copy refer to
+     * the copied variables, its entities have the copied entities as their
+     * parents, and its imports use copies of the import sources.  The models
+     * that import sources have been resolved to are shared with this model
+     * rather than copied.
+     *
+     * @return The copy of this model.
+     */
+    ModelPtr clone() const;
+
+    /**
+     * @brief Create an immutable snapshot of this model.
+     *
+     * The snapshot holds the units, components, variables and resets of this
+     * model, laid out compactly and referred to by index, and is not affected by
+     * later changes to this model.  Any number of threads may read it at the
+     * same time.
+     *
+     * @sa FrozenModel
+     *
+     * @return The snapshot of this model.
+     */
+    FrozenModelPtr freeze() const;
+
+    /**
+     * @brief Create a copy of this model with its imports instantiated.
+     *
+     * Each resolved imported component is replaced with a copy of the
+     * component it refers to, together with its encapsulated components, and
+     * each resolved imported units with a copy of the units it refers to.
+     * Imports in the imported models are flattened first, and the units
+     * used by the copied entities are copied too.  Copied components and
+     * units whose names are already used are given a suffix, e.g. "_1".  The
+     * connections of the importing components are remapped to the copied
+     * variables, whereas connections of the copied components to components
+     * that are not copied are dropped.
+     *
+     * Imports that are not resolved, or that are part of an import cycle,
+     * are left as they are.
+     *
+     * @return The flattened copy of this model.
+     */
+    ModelPtr flatten() const;
+
+    /**
+     * @brief Get an item of this model with the id @p id.
+     *
+     * The items are this model, its 'encapsulation' element, and all its
+     * units, unit, components, 'component_ref' elements, variables, resets,
+     * whens, imports, connections and mappings of variables.  They are
+     * indexed by id the first time they are looked up, and indexed again
+     * once any of them has been modified, e.g. by setting its id, so that
+     * looking up ids in a model that does not change takes constant time.
+     *
+     * @sa itemCountWithId
+     *
+     * @param id The id of the item to get.
+     * @param index The index of the item, if more than one has the id
+     * @p id, in the order of the items in the model.
+     *
+     * @return The item, or @c nullptr if there is no such item.
+     */
+    IdentifiedItemPtr itemWithId(const std::string &id, size_t index = 0);
+
+    /**
+     * @brief Get the number of items of this model with the id @p id.
+     *
+     * @sa itemWithId
+     *
+     * @param id The id to count the items of.
+     *
+     * @return The number of items with the id @p id, which is more than
+     * @c 1 if @p id is not unique.
+     */
+    size_t itemCountWithId(const std::string &id);
+
+    /**
+     * @brief Get the ids shared by more than one item of this model.
+     *
+     * @sa itemWithId
+     *
+     * @return The duplicate ids, sorted.
+     */
+    std::vector<std::string> duplicateIds();
+
 private:
     void doAddComponent(const ComponentPtr &component) override;
     void swap(Model & rhs); /**< Swap method required for C++ 11 move semantics. */
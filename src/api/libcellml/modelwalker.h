@@ -0,0 +1,102 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "libcellml/exportdefinitions.h"
+#include "libcellml/types.h"
+
+namespace libcellml {
+
+/**
+ * @brief The ModelWalker class.
+ *
+ * The ModelWalker class walks the encapsulation hierarchy of a model, or of
+ * a component, depth first, visiting each component before its children.
+ * The current component is returned by reference, so walking a model does
+ * not copy any component pointer.  The hierarchy must not be modified while
+ * it is being walked.
+ *
+ * @code
+ *   ModelWalker walker(model);
+ *   while (walker.next()) {
+ *       const ComponentPtr &component = walker.component();
+ *       ...
+ *   }
+ * @endcode
+ */
+class LIBCELLML_EXPORT ModelWalker
+{
+public:
+    /**
+     * @brief Create a walker over the components of @p entity.
+     *
+     * The walker starts before the first component of @p entity, which
+     * itself is not visited.
+     *
+     * @param entity The model or component to walk.
+     */
+    explicit ModelWalker(const ComponentEntityPtr &entity);
+    ~ModelWalker(); /**< Destructor */
+    ModelWalker(const ModelWalker &rhs); /**< Copy constructor */
+    ModelWalker(ModelWalker &&rhs) noexcept; /**< Move constructor */
+    ModelWalker &operator=(ModelWalker rhs); /**< Assignment operator */
+
+    /**
+     * @brief Move to the next component.
+     *
+     * The next component is the first child of the current component,
+     * unless skipChildren() was called, or else the next sibling of the
+     * current component or of its nearest ancestor that has one.
+     *
+     * @return @c true if there is a next component, @c false if the walk is
+     * over.
+     */
+    bool next();
+
+    /**
+     * @brief Get the current component.
+     *
+     * Must only be called after next() has returned @c true.
+     *
+     * @return The current component.
+     */
+    const ComponentPtr &component() const;
+
+    /**
+     * @brief Get the depth of the current component.
+     *
+     * @return The depth of the current component, which is @c 0 for the
+     * components directly contained in the walked entity.
+     */
+    size_t depth() const;
+
+    /**
+     * @brief Do not visit the descendants of the current component.
+     *
+     * The next call to next() then moves to the next sibling of the current
+     * component, or of its nearest ancestor that has one.
+     */
+    void skipChildren();
+
+private:
+    void swap(ModelWalker &rhs); /**< Swap method required for C++ 11 move semantics. */
+
+    struct ModelWalkerImpl; /**< Forward declaration for pImpl idiom. */
+    ModelWalkerImpl *mPimpl; /**< Private member to implementation pointer */
+};
+
+} // namespace libcellml
@@ -20,6 +20,7 @@ limitations under the License.
 #include "libcellml/exportdefinitions.h"
 #include "libcellml/types.h"
 
+#include <cstdint>
 #include <string>
 
 namespace libcellml {
@@ -55,9 +56,13 @@ public:
      *
      * @return @c std::string representation of the Entity name.
      */
-    std::string name() const;
+    const std::string &name() const;
 
 private:
+    friend class NameSymbolAccess; /**< Access to internedName() for the library. */
+
+    uint32_t internedName() const; /**< Get the interned name of this entity. */
+
     void swap(NamedEntity &rhs); /**< Swap method required for C++ 11 move semantics. */
 
     struct NamedEntityImpl; /**< Forward declaration for pImpl idiom. */
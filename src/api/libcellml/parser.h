@@ -51,6 +51,30 @@ public:
      */
     ModelPtr parseModel(const std::string &input);
 
+    /**
+     * @brief Set whether the entities of parsed models are allocated from an arena.
+     *
+     * If @p arenaAllocation is @c true, all the entities of a model created
+     * by parseModel(), and their private implementations, are allocated from
+     * a few large blocks of memory shared by that model, rather than one by
+     * one.  This makes parsing and destroying large models faster, and keeps
+     * related entities close together in memory.  The memory is only
+     * released once every entity of the model has been destroyed, so a
+     * model which is later edited heavily, or whose entities are kept
+     * around without it, may use more memory than otherwise.  The use of the
+     * model is not affected in any other way.  This is @c false by default.
+     *
+     * @param arenaAllocation Whether to allocate entities from an arena.
+     */
+    void setArenaAllocation(bool arenaAllocation);
+
+    /**
+     * @brief Get whether the entities of parsed models are allocated from an arena.
+     *
+     * @return The value set by setArenaAllocation().
+     */
+    bool arenaAllocation() const;
+
 private:
     void swap(Parser &rhs); /**< Swap method required for C++ 11 move semantics. */
 
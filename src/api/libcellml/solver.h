@@ -0,0 +1,179 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "libcellml/evaluator.h"
+#include "libcellml/exportdefinitions.h"
+#include "libcellml/logger.h"
+#include "libcellml/types.h"
+
+namespace libcellml {
+
+/**
+ * @brief The Solver class.
+ *
+ * The Solver class integrates the differential equations of a model
+ * compiled by an @c Evaluator using an explicit method.  Resets are treated
+ * as discrete events, which are detected and applied at the end of each
+ * step.
+ */
+class LIBCELLML_EXPORT Solver: public Logger
+{
+public:
+    /**
+     * @brief The Solver::Method enum class.
+     *
+     * The integration methods supported by the @c Solver.  The
+     * @c RUSH_LARSEN method integrates the gating variables found by the
+     * @c Evaluator exactly over each step, assuming their coefficients are
+     * constant over it, and uses forward Euler for the other states.
+     */
+    enum class Method
+    {
+        FORWARD_EULER,
+        RUNGE_KUTTA_4,
+        DORMAND_PRINCE_54,
+        RUSH_LARSEN
+    };
+
+    Solver(); /**< Constructor */
+    ~Solver() override; /**< Destructor */
+    Solver(const Solver &rhs); /**< Copy constructor */
+    Solver(Solver &&rhs) noexcept; /**< Move constructor */
+    Solver &operator=(Solver rhs); /**< Assignment operator */
+
+    /**
+     * @brief Set the integration method.
+     *
+     * The default method is @c Method::RUNGE_KUTTA_4.
+     *
+     * @param method The @c Method to use.
+     */
+    void setMethod(Method method);
+
+    /**
+     * @brief Get the integration method.
+     *
+     * @return The @c Method used.
+     */
+    Method method() const;
+
+    /**
+     * @brief Set the step size.
+     *
+     * Set the step size of the fixed step methods, which is also the initial
+     * step size of the adaptive method.  The default is @c 1.0e-3.
+     *
+     * @param step The step size.
+     */
+    void setStep(double step);
+
+    /**
+     * @brief Get the step size.
+     *
+     * @return The step size.
+     */
+    double step() const;
+
+    /**
+     * @brief Set the maximum step size of the adaptive method.
+     *
+     * A value of zero, the default, means that the step size is only
+     * limited by the output interval.
+     *
+     * @param maximumStep The maximum step size.
+     */
+    void setMaximumStep(double maximumStep);
+
+    /**
+     * @brief Get the maximum step size of the adaptive method.
+     *
+     * @return The maximum step size.
+     */
+    double maximumStep() const;
+
+    /**
+     * @brief Set the relative tolerance of the adaptive method.
+     *
+     * The default is @c 1.0e-6.
+     *
+     * @param tolerance The relative tolerance.
+     */
+    void setRelativeTolerance(double tolerance);
+
+    /**
+     * @brief Get the relative tolerance of the adaptive method.
+     *
+     * @return The relative tolerance.
+     */
+    double relativeTolerance() const;
+
+    /**
+     * @brief Set the absolute tolerance of the adaptive method.
+     *
+     * The default is @c 1.0e-8.
+     *
+     * @param tolerance The absolute tolerance.
+     */
+    void setAbsoluteTolerance(double tolerance);
+
+    /**
+     * @brief Get the absolute tolerance of the adaptive method.
+     *
+     * @return The absolute tolerance.
+     */
+    double absoluteTolerance() const;
+
+    /**
+     * @brief Integrate the model from @p voiStart to @p voiEnd.
+     *
+     * Integrate the model compiled by @p evaluator, starting from the given
+     * @p states and @p variables, which are expected to have been set using
+     * Evaluator::initialiseStatesAndConstants() and
+     * Evaluator::computeComputedConstants().  On return they hold the values
+     * at @p voiEnd.
+     *
+     * The solution is written at @p pointCount evenly spaced points,
+     * including both @p voiStart and @p voiEnd, to the caller allocated
+     * @p output array.  Each point is a row of
+     * 1 + Evaluator::stateCount() + Evaluator::variableCount() values: the
+     * variable of integration, the states and the variables.  Work arrays
+     * are allocated once per call rather than per step.
+     *
+     * Any errors will be logged in the @c Solver.
+     *
+     * @param evaluator The @c Evaluator holding the compiled model.
+     * @param states The state array.
+     * @param variables The variable array.
+     * @param voiStart The initial value of the variable of integration.
+     * @param voiEnd The final value of the variable of integration.
+     * @param pointCount The number of output points, at least two.
+     * @param output The output array of pointCount rows.
+     *
+     * @return @c true if the integration succeeded, @c false otherwise.
+     */
+    bool solve(const Evaluator &evaluator, double *states, double *variables,
+               double voiStart, double voiEnd, size_t pointCount, double *output);
+
+private:
+    void swap(Solver &rhs); /**< Swap method required for C++ 11 move semantics. */
+
+    struct SolverImpl; /**< Forward declaration for pImpl idiom. */
+    SolverImpl *mPimpl; /**< Private member to implementation pointer. */
+};
+
+} // namespace libcellml
@@ -21,6 +21,8 @@ limitations under the License.
 namespace libcellml {
 
 // Input, output, and error handlers.
+class ImportLibrary; /**< Forward declaration of ImportLibrary class. */
+class Logger; /**< Forward declaration of Logger class. */
 class Parser; /**< Forward declaration of Parser class. */
 class Validator; /**< Forward declaration of Validator class. */
 
@@ -29,8 +31,16 @@ class Component; /**< Forward declaration of Component class. */
 typedef std::shared_ptr<Component> ComponentPtr; /**< Type definition for shared component pointer. */
 class ComponentEntity; /**< Forward declaration of ComponentEntity class. */
 typedef std::shared_ptr<ComponentEntity> ComponentEntityPtr; /**< Type definition for shared component entity pointer. */
+class Entity; /**< Forward declaration of Entity class. */
+typedef std::shared_ptr<Entity> EntityPtr; /**< Type definition for shared entity pointer. */
 class Error; /**< Forward declaration of Error class. */
 typedef std::shared_ptr<Error> ErrorPtr; /**< Type definition for shared error pointer. */
+class FlatModel; /**< Forward declaration of FlatModel class. */
+typedef std::shared_ptr<const FlatModel> FlatModelPtr; /**< Type definition for shared flat model pointer. */
+class FrozenModel; /**< Forward declaration of FrozenModel class. */
+typedef std::shared_ptr<const FrozenModel> FrozenModelPtr; /**< Type definition for shared frozen model pointer. */
+class IdentifiedItem; /**< Forward declaration of IdentifiedItem class. */
+typedef std::shared_ptr<IdentifiedItem> IdentifiedItemPtr; /**< Type definition for shared identified item pointer. */
 class ImportedEntity; /**< Forward declaration of ImportedEntity class. */
 typedef std::shared_ptr<ImportedEntity> ImportedEntityPtr; /**< Type definition for shared imported entity pointer. */
 class ImportSource; /**< Forward declaration of ImportSource class. */
@@ -32,6 +32,8 @@ limitations under the License.
 
 namespace libcellml {
 
+struct UnitsDefinition; /**< Forward declaration of the internal UnitsDefinition struct. */
+
 /**
  * @brief The Units class.
  * Class for Units.
@@ -304,6 +306,32 @@ public:
      */
     void unitAttributes(StandardUnit standardRef, std::string &prefix, double &exponent, double &multiplier, std::string &id) const;
 
+    /**
+     * @brief Get the exponent of the @c unit at the given @p index.
+     *
+     * Get the exponent of the @c unit at the given @p index, as it was
+     * given when the @c unit was added.
+     *
+     * @param index The index of the @c unit.
+     *
+     * @return The exponent of the @c unit, or 1.0 if @p index is not in the
+     * range [0, \#unit).
+     */
+    double unitExponent(size_t index) const;
+
+    /**
+     * @brief Get the multiplier of the @c unit at the given @p index.
+     *
+     * Get the multiplier of the @c unit at the given @p index, as it was
+     * given when the @c unit was added.
+     *
+     * @param index The index of the @c unit.
+     *
+     * @return The multiplier of the @c unit, or 1.0 if @p index is not in the
+     * range [0, \#unit).
+     */
+    double unitMultiplier(size_t index) const;
+
     /**
      * @brief Remove the unit at the given @p index.
      *
@@ -369,9 +397,89 @@ public:
      */
     size_t unitCount() const;
 
+    /**
+     * @brief Test if two units have the same dimension.
+     *
+     * Test if @p units1 and @p units2 reduce to the same powers of the SI
+     * base units and of any base units defined by their models, regardless
+     * of scale.  The units they are defined from are looked up in their
+     * parent models, or in the models of their import sources if they are
+     * imported.  Reductions are cached in each units, so that repeated tests
+     * only compare the cached reductions.
+     *
+     * @param units1 The first units.
+     * @param units2 The second units.
+     *
+     * @return @c true if both units can be reduced to base units and have
+     * the same dimension, @c false otherwise.
+     */
+    static bool compatible(const UnitsPtr &units1, const UnitsPtr &units2);
+
+    /**
+     * @brief Test if two units are the same units.
+     *
+     * Test if @p units1 and @p units2 are compatible() and have the same
+     * scale, e.g. @c millivolt and a units defined as @c volt with a
+     * multiplier of @c 0.001.
+     *
+     * @param units1 The first units.
+     * @param units2 The second units.
+     *
+     * @return @c true if both units can be reduced to base units and are
+     * equivalent, @c false otherwise.
+     */
+    static bool equivalent(const UnitsPtr &units1, const UnitsPtr &units2);
+
+    /**
+     * @brief Get the factor converting values from one units to another.
+     *
+     * Get the factor a value in @p from must be multiplied by to express it
+     * in @p to, e.g. @c 0.001 from @c millivolt to @c volt.  The factor
+     * accounts for the prefixes, exponents and multipliers of both units and
+     * of the units they are defined from, and is computed from the cached
+     * reductions used by compatible().
+     *
+     * If either units cannot be reduced to base units, or if the units have
+     * different dimensions, an error saying which is added to @p logger, if
+     * any, and @p factor is left unchanged.
+     *
+     * @param from The units to convert from.
+     * @param to The units to convert to.
+     * @param factor The @c double to set to the conversion factor.
+     * @param logger The @c Logger to add an error to on failure, or
+     * @c nullptr.
+     *
+     * @return @c true if @p factor was set, @c false otherwise.
+     */
+    static bool conversionFactor(const UnitsPtr &from, const UnitsPtr &to, double &factor, Logger *logger = nullptr);
+
+    /**
+     * @brief Get the factor converting values from one units to another.
+     *
+     * Get the factor converting values from the units called @p from to the
+     * units called @p to, where each name refers to a units of @p model or
+     * to a standard unit.
+     *
+     * @overload
+     *
+     * @param model The model to look the units up in.
+     * @param from The name of the units to convert from.
+     * @param to The name of the units to convert to.
+     * @param factor The @c double to set to the conversion factor.
+     * @param logger The @c Logger to add an error to on failure, or
+     * @c nullptr.
+     *
+     * @return @c true if @p factor was set, @c false if either units cannot
+     * be found or reduced to base units, or if they have different
+     * dimensions.
+     */
+    static bool conversionFactor(const ModelPtr &model, const std::string &from, const std::string &to, double &factor, Logger *logger = nullptr);
+
 private:
     void swap(Units &rhs); /**< Swap method required for C++ 11 move semantics. */
 
+    friend bool reduceUnits(const Units &units, UnitsDefinition &definition); /**< Access to the cached reduction of this units. */
+
     struct UnitsImpl; /**< Forward declaration for pImpl idiom. */
     UnitsImpl *mPimpl; /**< Private member to implementation pointer */
 };
@@ -50,6 +50,82 @@ public:
      */
     void validateModel(const ModelPtr &model);
 
+    /**
+     * @brief Set the number of threads used to validate components.
+     *
+     * The variables, resets and math of the top-level components of a model
+     * are validated independently of each other, and may be validated on up
+     * to @p count threads at once, while the checks that involve the whole
+     * model are always made on the calling thread.  The errors are logged in
+     * the same order whatever the number of threads.  A @p count of 0 uses
+     * as many threads as the hardware supports.  This is 1 by default.
+     *
+     * The model must not be changed while it is being validated.
+     *
+     * @param count The maximum number of threads to use.
+     */
+    void setThreadCount(size_t count);
+
+    /**
+     * @brief Get the number of threads used to validate components.
+     *
+     * @return The value set by setThreadCount().
+     */
+    size_t threadCount() const;
+
+    /**
+     * @brief Set whether the math is checked for dimensional consistency.
+     *
+     * If @p check is @c true, validating a model also works out the
+     * dimension of every expression in the math of its components, from the
+     * units of the variables and the @c cellml:units of the numbers they
+     * use.  An error of kind @c Error::Kind::UNITS is logged, with the
+     * component set, for each operator whose arguments have dimensions that
+     * do not match, and for each function whose argument is not
+     * dimensionless.  The description gives the equation and the operator
+     * the mismatch was found in, and the dimensions involved in terms of
+     * base units.  Units that are only scaled versions of each other, such as
+     * millivolt and volt, have the same dimension.  This is @c false by
+     * default.
+     *
+     * @param check Whether to check the math for dimensional consistency.
+     */
+    void setCheckDimensions(bool check);
+
+    /**
+     * @brief Get whether the math is checked for dimensional consistency.
+     *
+     * @return The value set by setCheckDimensions().
+     */
+    bool checkDimensions() const;
+
+    /**
+     * @brief Set whether models are validated incrementally.
+     *
+     * If @p incremental is @c true, this validator keeps the errors found in
+     * each component of the model it last validated.  Validating the same
+     * model again only validates again the components that have changed
+     * since, according to their revision, and reuses the errors previously
+     * found in the others.  Any change to a component, its variables, its
+     * math or its resets counts as a change, as does renaming, adding or
+     * removing units of the model, which causes all of its components to be
+     * validated again.  The rules that apply to the model as a whole, such as
+     * those on units and connections, are always checked again.  This is
+     * @c false by default.
+     *
+     * @sa Entity::revision
+     *
+     * @param incremental Whether to validate models incrementally.
+     */
+    void setIncremental(bool incremental);
+
+    /**
+     * @brief Get whether models are validated incrementally.
+     *
+     * @return The value set by setIncremental().
+     */
+    bool isIncremental() const;
+
 private:
     void swap(Validator &rhs); /**< Swap method required for C++ 11 move semantics. */
 
@@ -21,6 +21,7 @@ limitations under the License.
 #include "libcellml/types.h"
 
 #include <string>
+#include <vector>
 
 namespace libcellml {
 
@@ -170,9 +171,60 @@ public:
      * @brief Remove all equivalent variables for this variable.
      *
      * Clears all equivalent variables that have been added to the set for this variable.
+     * Variables that still hold this variable as an equivalent variable stay
+     * in its equivalence set.
      */
     void removeAllEquivalences();
 
+    /**
+     * @brief Get the variables connected to @p variable through equivalences.
+     *
+     * Get all the variables that can be reached from @p variable by
+     * following equivalences in either direction, including @p variable
+     * itself.  The equivalence
+     * sets are kept up to date by addEquivalence(), removeEquivalence() and
+     * removeAllEquivalences(), so this does not need to traverse the
+     * equivalences.
+     *
+     * @sa equivalenceRepresentative, equivalenceSetId
+     *
+     * @param variable The variable to get the equivalence set of.
+     *
+     * @return The variables in the equivalence set of @p variable, starting
+     * with its representative.
+     */
+    static std::vector<VariablePtr> equivalenceSet(const VariablePtr &variable);
+
+    /**
+     * @brief Get the representative of the equivalence set of @p variable.
+     *
+     * All the variables of an equivalence set have the same representative,
+     * which is one of them.  The representative only changes when the set is
+     * changed.
+     *
+     * @sa equivalenceSet
+     *
+     * @param variable The variable to get the representative of.
+     *
+     * @return The representative of the equivalence set of @p variable.
+     */
+    static VariablePtr equivalenceRepresentative(const VariablePtr &variable);
+
+    /**
+     * @brief Get the id of the equivalence set of @p variable.
+     *
+     * Two variables are in the same equivalence set if and only if they have
+     * the same id.  The id of a set is kept until the set is merged with a
+     * larger one or split by the removal of an equivalence.
+     *
+     * @sa equivalenceSet
+     *
+     * @param variable The variable to get the equivalence set id of.
+     *
+     * @return The id of the equivalence set of @p variable.
+     */
+    static size_t equivalenceSetId(const VariablePtr &variable);
+
     /**
      * @brief Get an equivalent variable at @p index.
      *
@@ -244,7 +296,7 @@ public:
      *
      * @return The @c std::string name of the units for this variable.
      */
-    std::string units() const;
+    const std::string &units() const;
 
     /**
      * @brief Set the initial value for this variable using a string.
@@ -331,6 +383,8 @@ public:
 private:
     void swap(Variable &rhs); /**< Swap method required for C++ 11 move semantics. */
 
+    friend void cloneEquivalences(const std::vector<VariablePtr> &variables, const std::vector<VariablePtr> &clones); /**< Access to the equivalences of variables being cloned. */
+
     struct VariableImpl; /**< Forward declaration for pImpl idiom. */
     VariableImpl *mPimpl; /**< Private member to implementation pointer */
 };
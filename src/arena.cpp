@@ -0,0 +1,111 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace libcellml {
+
+/**
+ * The largest block an arena allocates, other than for allocations that do
+ * not fit in such a block.
+ */
+static const size_t MAXIMUM_BLOCK_SIZE = 1048576;
+
+/**
+ * The arena entities are allocated from on this thread, if any.
+ */
+static thread_local Arena *threadArena = nullptr;
+
+Arena *Arena::create()
+{
+    return new Arena();
+}
+
+Arena::~Arena()
+{
+    for (char *block : mBlocks) {
+        delete[] block;
+    }
+}
+
+void Arena::retain()
+{
+    mReferences.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Arena::release()
+{
+    if (mReferences.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete this;
+    }
+}
+
+void *Arena::allocate(size_t size, size_t alignment)
+{
+    size_t padding = (alignment - reinterpret_cast<uintptr_t>(mCurrent) % alignment) % alignment;
+    if ((mCurrent == nullptr) || (padding + size > mRemaining)) {
+        // Blocks are allocated with new[], so they are aligned for any
+        // fundamental type.
+        size_t blockSize = std::max(mNextBlockSize, size);
+        mBlocks.push_back(new char[blockSize]);
+        mCurrent = mBlocks.back();
+        mRemaining = blockSize;
+        mNextBlockSize = std::min(2 * mNextBlockSize, MAXIMUM_BLOCK_SIZE);
+        padding = 0;
+    }
+    void *memory = mCurrent + padding;
+    mCurrent += padding + size;
+    mRemaining -= padding + size;
+    return memory;
+}
+
+Arena *currentArena()
+{
+    return threadArena;
+}
+
+ArenaReference::ArenaReference(Arena *arena)
+    : mArena(arena)
+{
+}
+
+ArenaReference::~ArenaReference()
+{
+    if (mArena != nullptr) {
+        mArena->release();
+    }
+}
+
+Arena *ArenaReference::arena() const
+{
+    return mArena;
+}
+
+ArenaScope::ArenaScope(Arena *arena)
+    : mPrevious(threadArena)
+{
+    threadArena = arena;
+}
+
+ArenaScope::~ArenaScope()
+{
+    threadArena = mPrevious;
+}
+
+} // namespace libcellml
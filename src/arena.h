@@ -0,0 +1,306 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace libcellml {
+
+/**
+ * @brief The Arena class.
+ *
+ * An internal monotonic allocator, which hands out memory from a few large
+ * blocks and only frees it all at once.  An arena is reference counted, by
+ * whoever uses it and by everything allocated from it, and deletes itself
+ * once nothing refers to it any more.  Allocating from an arena is not
+ * thread safe, but retaining and releasing it is.
+ */
+class Arena
+{
+public:
+    /**
+     * @brief Create an arena, with a reference held by the caller.
+     *
+     * @return The new arena.
+     */
+    static Arena *create();
+
+    /**
+     * @brief Add a reference to this arena.
+     */
+    void retain();
+
+    /**
+     * @brief Remove a reference to this arena, deleting it if it was the
+     * last one.
+     */
+    void release();
+
+    /**
+     * @brief Allocate @p size bytes aligned to @p alignment.
+     *
+     * @param size The number of bytes to allocate.
+     * @param alignment The alignment of the memory, a power of two no larger
+     * than that of @c std::max_align_t.
+     *
+     * @return A pointer to the memory, which stays valid for the lifetime of
+     * this arena.
+     */
+    void *allocate(size_t size, size_t alignment);
+
+private:
+    Arena() = default; /**< Constructor, use create() instead. */
+    ~Arena(); /**< Destructor, called by release(). */
+
+    std::atomic<size_t> mReferences {1}; /**< The number of references to this arena. */
+    std::vector<char *> mBlocks; /**< The blocks of memory of this arena. */
+    char *mCurrent = nullptr; /**< The next free byte of the last block. */
+    size_t mRemaining = 0; /**< The number of free bytes in the last block. */
+    size_t mNextBlockSize = 4096; /**< The size of the next block to allocate. */
+};
+
+/**
+ * @brief The ArenaReference class.
+ *
+ * An internal guard which holds a reference to an arena, such as the one
+ * returned by Arena::create(), and releases it when the guard is destroyed.
+ */
+class ArenaReference
+{
+public:
+    explicit ArenaReference(Arena *arena); /**< Constructor, takes over the reference to @p arena, which may be @c nullptr. */
+    ~ArenaReference(); /**< Destructor, releases the arena. */
+    ArenaReference(const ArenaReference &rhs) = delete; /**< Copy constructor */
+    ArenaReference &operator=(const ArenaReference &rhs) = delete; /**< Assignment operator */
+
+    /**
+     * @brief Get the arena referred to.
+     *
+     * @return The arena, or @c nullptr.
+     */
+    Arena *arena() const;
+
+private:
+    Arena *mArena; /**< The arena referred to. */
+};
+
+/**
+ * @brief Get the arena entities are allocated from on this thread.
+ *
+ * @return The arena set by the innermost @c ArenaScope on this thread, or
+ * @c nullptr if entities are allocated on the heap.
+ */
+Arena *currentArena();
+
+/**
+ * @brief The ArenaScope class.
+ *
+ * An internal guard which makes an arena the one entities are allocated from
+ * on this thread, for as long as the guard exists.
+ */
+class ArenaScope
+{
+public:
+    explicit ArenaScope(Arena *arena); /**< Constructor, @p arena may be @c nullptr to use the heap. */
+    ~ArenaScope(); /**< Destructor, restores the previous arena. */
+    ArenaScope(const ArenaScope &rhs) = delete; /**< Copy constructor */
+    ArenaScope &operator=(const ArenaScope &rhs) = delete; /**< Assignment operator */
+
+private:
+    Arena *mPrevious; /**< The arena that was current before this scope. */
+};
+
+/**
+ * The size of the header in front of each private implementation allocated
+ * by newImpl(), which records the arena it comes from, if any.
+ */
+static const size_t IMPL_HEADER_SIZE = alignof(std::max_align_t);
+
+/**
+ * @brief Create the private implementation of an entity.
+ *
+ * The implementation is allocated from the current arena, if any, or else
+ * on the heap.  It must be destroyed with deleteImpl().
+ *
+ * @return The new private implementation.
+ */
+template<typename T>
+T *newImpl()
+{
+    static_assert(alignof(T) <= IMPL_HEADER_SIZE, "The private implementation is over-aligned.");
+    static_assert(sizeof(Arena *) <= IMPL_HEADER_SIZE, "The private implementation header is too small.");
+    Arena *arena = currentArena();
+    void *block = nullptr;
+    if (arena != nullptr) {
+        block = arena->allocate(IMPL_HEADER_SIZE + sizeof(T), IMPL_HEADER_SIZE);
+        arena->retain();
+    } else {
+        block = ::operator new(IMPL_HEADER_SIZE + sizeof(T));
+    }
+    *static_cast<Arena **>(block) = arena;
+    return new (static_cast<char *>(block) + IMPL_HEADER_SIZE) T();
+}
+
+/**
+ * @brief Destroy the private implementation @p impl created by newImpl().
+ *
+ * @param impl The private implementation to destroy, which may be
+ * @c nullptr.
+ */
+template<typename T>
+void deleteImpl(T *impl)
+{
+    if (impl == nullptr) {
+        return;
+    }
+    impl->~T();
+    void *block = reinterpret_cast<char *>(impl) - IMPL_HEADER_SIZE;
+    Arena *arena = *static_cast<Arena **>(block);
+    if (arena != nullptr) {
+        arena->release();
+    } else {
+        ::operator delete(block);
+    }
+}
+
+/**
+ * @brief The ArenaAllocator class.
+ *
+ * An internal allocator for @c std::allocate_shared, which allocates from an
+ * arena and holds a reference to it.
+ */
+template<typename T>
+class ArenaAllocator
+{
+public:
+    using value_type = T; /**< The type of the allocated objects. */
+
+    /** Constructor */
+    explicit ArenaAllocator(Arena *arena)
+        : mArena(arena)
+    {
+        mArena->retain();
+    }
+
+    /** Converting constructor */
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U> &rhs)
+        : mArena(rhs.arena())
+    {
+        mArena->retain();
+    }
+
+    /** Copy constructor */
+    ArenaAllocator(const ArenaAllocator &rhs)
+        : mArena(rhs.mArena)
+    {
+        mArena->retain();
+    }
+
+    /** Destructor */
+    ~ArenaAllocator()
+    {
+        mArena->release();
+    }
+
+    ArenaAllocator &operator=(const ArenaAllocator &rhs) = delete; /**< Assignment operator */
+
+    /**
+     * @brief Allocate memory for @p count objects.
+     *
+     * @param count The number of objects.
+     *
+     * @return A pointer to the memory.
+     */
+    T *allocate(size_t count)
+    {
+        return static_cast<T *>(mArena->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    /**
+     * @brief Deallocate memory, which is only freed with the arena.
+     */
+    void deallocate(T * /*pointer*/, size_t /*count*/)
+    {
+    }
+
+    /**
+     * @brief Get the arena this allocator allocates from.
+     *
+     * @return The arena.
+     */
+    Arena *arena() const
+    {
+        return mArena;
+    }
+
+private:
+    Arena *mArena; /**< The arena to allocate from. */
+};
+
+/**
+ * @brief Test if @p lhs and @p rhs allocate from the same arena.
+ *
+ * @param lhs The first allocator.
+ * @param rhs The second allocator.
+ *
+ * @return @c true if memory allocated by one can be deallocated by the other.
+ */
+template<typename T, typename U>
+bool operator==(const ArenaAllocator<T> &lhs, const ArenaAllocator<U> &rhs)
+{
+    return lhs.arena() == rhs.arena();
+}
+
+/**
+ * @brief Test if @p lhs and @p rhs allocate from different arenas.
+ *
+ * @param lhs The first allocator.
+ * @param rhs The second allocator.
+ *
+ * @return @c true if memory allocated by one cannot be deallocated by the
+ * other.
+ */
+template<typename T, typename U>
+bool operator!=(const ArenaAllocator<T> &lhs, const ArenaAllocator<U> &rhs)
+{
+    return lhs.arena() != rhs.arena();
+}
+
+/**
+ * @brief Create an entity of type @c T.
+ *
+ * The entity, and the control block of the pointer to it, are allocated from
+ * the current arena, if any, or else on the heap.
+ *
+ * @return A shared pointer to the new entity.
+ */
+template<typename T>
+std::shared_ptr<T> makeEntity()
+{
+    Arena *arena = currentArena();
+    if (arena != nullptr) {
+        return std::allocate_shared<T>(ArenaAllocator<T>(arena));
+    }
+    return std::make_shared<T>();
+}
+
+} // namespace libcellml
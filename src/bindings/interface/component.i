@@ -106,6 +106,7 @@ resets and False otherwise.";
 
 %ignore libcellml::Component::Component(Component &&);
 %ignore libcellml::Component::operator =;
+%ignore libcellml::Component::variables;
 
 %include "libcellml/types.h"
 %include "libcellml/component.h"
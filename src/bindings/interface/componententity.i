@@ -110,6 +110,8 @@ the structure."
 
 %ignore libcellml::ComponentEntity::ComponentEntity(ComponentEntity &&);
 %ignore libcellml::ComponentEntity::operator =;
+%ignore libcellml::ComponentEntity::components;
+%ignore libcellml::ComponentEntity::forEachComponent;
 
 %include "libcellml/types.h"
 %include "libcellml/componententity.h"
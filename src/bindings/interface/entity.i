@@ -12,6 +12,10 @@
 "Returns the `id` document identifier for this entity, or an empty string if
 not set.";
 
+%feature("docstring") libcellml::Entity::revision
+"Returns the revision of this entity, which changes whenever this entity or any
+entity it contains is changed.";
+
 %feature("docstring") libcellml::Entity::setId
 "Set the `id` document identifier for this entity (use empty string to
 unset).";
@@ -24,9 +24,17 @@ unset).";
 %feature("docstring") libcellml::ImportSource::setModel
 "Sets the Model to resolve this ImportSource.";
 
+%feature("docstring") libcellml::ImportSource::mutableModel
+"Returns the Model that has been assigned to resolve this ImportSource, first
+replacing it with a copy if anything else refers to it.";
+
 %feature("docstring") libcellml::ImportSource::hasModel
 "Returns True if this ImportSource has been resolved, False otherwise.";
 
+%feature("docstring") libcellml::ImportSource::importedComponent
+"Returns the component with the given name in the Model that resolves this
+ImportSource, or None if there is no such component.";
+
 %{
 #include "libcellml/importsource.h"
 %}
@@ -55,6 +55,17 @@ determine the full path to the source model relative to this one.";
 %feature("docstring") libcellml::Model::hasUnresolvedImports
 "Tests if this model has unresolved imports.";
 
+%feature("docstring") libcellml::Model::clone
+"Returns a deep copy of this model, whose equivalences, resets, imports and
+parents refer to the copied entities.";
+
+%feature("docstring") libcellml::Model::flatten
+"Returns a copy of this model in which resolved imported components and units
+are replaced with copies of the entities they import.";
+
+%feature("docstring") libcellml::Model::itemCountWithId
+"Returns the number of items of this model with the given id.";
+
 
 #if defined(SWIGPYTHON)
     // Treat negative size_t as invalid index (instead of unknown method)
@@ -84,6 +95,10 @@ determine the full path to the source model relative to this one.";
 
 %ignore libcellml::Model::Model(Model &&);
 %ignore libcellml::Model::operator =;
+%ignore libcellml::Model::freeze;
+%ignore libcellml::Model::resolveImports(const std::string &, ImportLibrary &);
+%ignore libcellml::Model::itemWithId;
+%ignore libcellml::Model::duplicateIds;
 
 %include "libcellml/types.h"
 %include "libcellml/model.h"
@@ -14,6 +14,13 @@
 %feature("docstring") libcellml::Parser::parseModel
 "Parses a string and returns a :class:`Model`.";
 
+%feature("docstring") libcellml::Parser::setArenaAllocation
+"Sets whether the entities of each parsed model are allocated together, from
+large blocks of memory shared by the model. This is `False` by default.";
+
+%feature("docstring") libcellml::Parser::arenaAllocation
+"Returns whether the entities of each parsed model are allocated together.";
+
 %{
 #include "libcellml/parser.h"
 %}
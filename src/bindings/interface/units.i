@@ -15,6 +15,7 @@
 %apply std::string &OUTPUT { std::string &prefix };
 %apply double &OUTPUT { double &exponent };
 %apply double &OUTPUT { double &multiplier };
+%apply double &OUTPUT { double &factor };
 %apply std::string &OUTPUT { std::string &id };
 // Add typemaps for reference arguments used to return attributes
 %apply std::string &INPUT { const std::string &reference };
@@ -68,6 +69,14 @@ Only the first matching unit is removed.
 "Returns the attributes of the unit specified by index, reference, or
 StandardUnit.";
 
+%feature("docstring") libcellml::Units::unitExponent
+"Returns the exponent of the unit at the given index, or 1.0 if there is no
+such unit.";
+
+%feature("docstring") libcellml::Units::unitMultiplier
+"Returns the multiplier of the unit at the given index, or 1.0 if there is no
+such unit.";
+
 %feature("docstring") libcellml::Units::unitCount
 "Returns the number of units contained by this units object.";
 
@@ -75,6 +84,19 @@ StandardUnit.";
 "Makes this Units an imported units by defining an `ImportSource` from which to
 extract the units with the given `name`.";
 
+%feature("docstring") libcellml::Units::compatible
+"Tests if two units reduce to the same powers of base units, regardless of
+scale.";
+
+%feature("docstring") libcellml::Units::equivalent
+"Tests if two units are compatible and have the same scale.";
+
+%feature("docstring") libcellml::Units::conversionFactor
+"Returns whether the units, given either as units or as names of units in a
+model, can be converted to each other and, if so, the factor converting values
+from one to the other. If they cannot, an error saying why is added to the
+logger, if one is given.";
+
 #if defined(SWIGPYTHON)
     // Treat negative size_t as invalid index (instead of unknown method)
     %extend libcellml::Units {
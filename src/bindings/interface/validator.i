@@ -12,6 +12,31 @@
 "Validate the given `model` and its encapsulated entities using the CellML 2.0
 Specification. Any errors will be logged in the `Validator`.";
 
+%feature("docstring") libcellml::Validator::setThreadCount
+"Sets the maximum number of threads used to validate the components of a
+model, where 0 uses as many threads as the hardware supports. This is 1 by
+default.";
+
+%feature("docstring") libcellml::Validator::threadCount
+"Returns the maximum number of threads used to validate the components of a
+model.";
+
+%feature("docstring") libcellml::Validator::setCheckDimensions
+"Sets whether validating a model also checks that its math is dimensionally
+consistent. This is `False` by default.";
+
+%feature("docstring") libcellml::Validator::checkDimensions
+"Returns whether validating a model also checks that its math is
+dimensionally consistent.";
+
+%feature("docstring") libcellml::Validator::setIncremental
+"Sets whether validating a model again only validates again the components that
+have changed since. This is `False` by default.";
+
+%feature("docstring") libcellml::Validator::isIncremental
+"Returns whether validating a model again only validates again the components
+that have changed since.";
+
 %{
 #include "libcellml/validator.h"
 %}
@@ -5,6 +5,10 @@
 %import "types.i"
 %import "namedentity.i"
 
+%include <std_vector.i>
+
+%template(VariableVector) std::vector<std::shared_ptr<libcellml::Variable>>;
+
 %feature("docstring") libcellml::Variable
 "Represents a CellML Variable entity";
 
@@ -29,6 +33,18 @@ Returns `True` on success.";
 "Removes all equivalent variables for this variable (all relevant objects are
 updated).";
 
+%feature("docstring") libcellml::Variable::equivalenceSet
+"Returns all the variables connected to the given variable through
+equivalences, including the variable itself, starting with their
+representative.";
+
+%feature("docstring") libcellml::Variable::equivalenceRepresentative
+"Returns the representative of the equivalence set of the given variable.";
+
+%feature("docstring") libcellml::Variable::equivalenceSetId
+"Returns the id of the equivalence set of the given variable, which is the
+same for all the variables in the set.";
+
 %feature("docstring") libcellml::Variable::equivalentVariableCount
 "Returns the number of equivalent variables for this variable.";
 
@@ -0,0 +1,1036 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "bytecode.h"
+
+#include "vectormath.h"
+
+#include "libcellml/variable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace libcellml {
+
+/**
+ * @brief Map AST node types to the stack operation implementing them.
+ *
+ * Unary and binary AST operators that map directly onto a single stack
+ * operation.
+ */
+static const std::map<MathAst::Type, OpCode> opCodeMap = {
+    {MathAst::Type::EQ, OpCode::EQ},
+    {MathAst::Type::NEQ, OpCode::NEQ},
+    {MathAst::Type::LT, OpCode::LT},
+    {MathAst::Type::LEQ, OpCode::LEQ},
+    {MathAst::Type::GT, OpCode::GT},
+    {MathAst::Type::GEQ, OpCode::GEQ},
+    {MathAst::Type::AND, OpCode::AND},
+    {MathAst::Type::OR, OpCode::OR},
+    {MathAst::Type::XOR, OpCode::XOR},
+    {MathAst::Type::NOT, OpCode::NOT},
+    {MathAst::Type::PLUS, OpCode::ADD},
+    {MathAst::Type::TIMES, OpCode::MULTIPLY},
+    {MathAst::Type::DIVIDE, OpCode::DIVIDE},
+    {MathAst::Type::POWER, OpCode::POWER},
+    {MathAst::Type::ABS, OpCode::ABS},
+    {MathAst::Type::EXP, OpCode::EXP},
+    {MathAst::Type::LN, OpCode::LN},
+    {MathAst::Type::FLOOR, OpCode::FLOOR},
+    {MathAst::Type::CEILING, OpCode::CEILING},
+    {MathAst::Type::MIN, OpCode::MIN},
+    {MathAst::Type::MAX, OpCode::MAX},
+    {MathAst::Type::REM, OpCode::REM},
+    {MathAst::Type::SIN, OpCode::SIN},
+    {MathAst::Type::COS, OpCode::COS},
+    {MathAst::Type::TAN, OpCode::TAN},
+    {MathAst::Type::SEC, OpCode::SEC},
+    {MathAst::Type::CSC, OpCode::CSC},
+    {MathAst::Type::COT, OpCode::COT},
+    {MathAst::Type::SINH, OpCode::SINH},
+    {MathAst::Type::COSH, OpCode::COSH},
+    {MathAst::Type::TANH, OpCode::TANH},
+    {MathAst::Type::SECH, OpCode::SECH},
+    {MathAst::Type::CSCH, OpCode::CSCH},
+    {MathAst::Type::COTH, OpCode::COTH},
+    {MathAst::Type::ARCSIN, OpCode::ARCSIN},
+    {MathAst::Type::ARCCOS, OpCode::ARCCOS},
+    {MathAst::Type::ARCTAN, OpCode::ARCTAN},
+    {MathAst::Type::ARCSEC, OpCode::ARCSEC},
+    {MathAst::Type::ARCCSC, OpCode::ARCCSC},
+    {MathAst::Type::ARCCOT, OpCode::ARCCOT},
+    {MathAst::Type::ARCSINH, OpCode::ARCSINH},
+    {MathAst::Type::ARCCOSH, OpCode::ARCCOSH},
+    {MathAst::Type::ARCTANH, OpCode::ARCTANH},
+    {MathAst::Type::ARCSECH, OpCode::ARCSECH},
+    {MathAst::Type::ARCCSCH, OpCode::ARCCSCH},
+    {MathAst::Type::ARCCOTH, OpCode::ARCCOTH},
+};
+
+/**
+ * @brief Append a single instruction to @p program.
+ *
+ * Append the instruction and update the stack depth @p depth, and the
+ * maximum stack size of @p program, by @p stackChange.
+ *
+ * @param instruction The instruction to append.
+ * @param stackChange The change in stack depth caused by the instruction.
+ * @param depth The current stack depth.
+ * @param program The program to append to.
+ */
+static void emit(const Instruction &instruction, int stackChange, size_t &depth, Program &program)
+{
+    program.mInstructions.push_back(instruction);
+    depth = static_cast<size_t>(static_cast<int>(depth) + stackChange);
+    if (depth > program.mStackSize) {
+        program.mStackSize = depth;
+    }
+}
+
+static void emitOperation(OpCode opCode, int stackChange, size_t &depth, Program &program)
+{
+    Instruction instruction;
+    instruction.mOpCode = opCode;
+    emit(instruction, stackChange, depth, program);
+}
+
+static void emitConstant(double value, size_t &depth, Program &program)
+{
+    Instruction instruction;
+    instruction.mOpCode = OpCode::LOAD_CONSTANT;
+    instruction.mValue = value;
+    emit(instruction, 1, depth, program);
+}
+
+static bool compileNode(const MathAstPtr &ast, const VariableLoadMap &loads, SharedExpressions *shared, Program &program, size_t &depth, std::string &error);
+
+/**
+ * @brief Compile the arguments of @p ast, skipping any qualifiers.
+ *
+ * @return The number of arguments compiled, or @c -1 on failure.
+ */
+static int compileArguments(const MathAstPtr &ast, const VariableLoadMap &loads, SharedExpressions *shared, Program &program, size_t &depth, std::string &error)
+{
+    int count = 0;
+    for (const MathAstPtr &child : ast->mChildren) {
+        if ((child->mType == MathAst::Type::BVAR)
+            || (child->mType == MathAst::Type::DEGREE)
+            || (child->mType == MathAst::Type::LOGBASE)) {
+            continue;
+        }
+        if (!compileNode(child, loads, shared, program, depth, error)) {
+            return -1;
+        }
+        ++count;
+    }
+    return count;
+}
+
+/**
+ * @brief Find the single argument of the qualifier of type @p type in @p ast.
+ *
+ * @return The qualifier argument, or @c nullptr if there is none.
+ */
+static MathAstPtr qualifier(const MathAstPtr &ast, MathAst::Type type)
+{
+    for (const MathAstPtr &child : ast->mChildren) {
+        if ((child->mType == type) && (child->mChildren.size() == 1)) {
+            return child->mChildren.at(0);
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Compile the operation of @p ast, without looking it up in the
+ * shared expressions.
+ */
+static bool compileOperation(const MathAstPtr &ast, const VariableLoadMap &loads, SharedExpressions *shared, Program &program, size_t &depth, std::string &error)
+{
+    switch (ast->mType) {
+    case MathAst::Type::CN:
+        emitConstant(ast->mValue, depth, program);
+        return true;
+    case MathAst::Type::CI: {
+        auto found = loads.find(ast->mVariable);
+        if (found == loads.end()) {
+            error = "Variable '" + ast->mName + "' cannot be evaluated.";
+            return false;
+        }
+        emit(found->second, 1, depth, program);
+        return true;
+    }
+    case MathAst::Type::BOOLEAN_TRUE:
+        emitConstant(1.0, depth, program);
+        return true;
+    case MathAst::Type::BOOLEAN_FALSE:
+        emitConstant(0.0, depth, program);
+        return true;
+    case MathAst::Type::E:
+        emitConstant(std::exp(1.0), depth, program);
+        return true;
+    case MathAst::Type::PI:
+        emitConstant(4.0 * std::atan(1.0), depth, program);
+        return true;
+    case MathAst::Type::INF:
+        emitConstant(std::numeric_limits<double>::infinity(), depth, program);
+        return true;
+    case MathAst::Type::NOT_A_NUMBER:
+        emitConstant(std::numeric_limits<double>::quiet_NaN(), depth, program);
+        return true;
+    case MathAst::Type::DIFF: {
+        VariablePtr variable;
+        VariablePtr bvar;
+        if (isDerivative(ast, variable, bvar)) {
+            auto found = loads.find(variable);
+            if ((found != loads.end()) && (found->second.mOpCode == OpCode::LOAD_STATE)) {
+                Instruction instruction = found->second;
+                instruction.mOpCode = OpCode::LOAD_RATE;
+                emit(instruction, 1, depth, program);
+                return true;
+            }
+        }
+        error = "Derivative cannot be evaluated as its variable is not a state variable.";
+        return false;
+    }
+    case MathAst::Type::PIECEWISE: {
+        // Compile into nested selects, evaluating every piece, so that the
+        // program has no jumps.  The last piece is the innermost select.
+        std::vector<MathAstPtr> pieces;
+        MathAstPtr otherwise = nullptr;
+        for (const MathAstPtr &child : ast->mChildren) {
+            if (child->mType == MathAst::Type::PIECE) {
+                pieces.push_back(child);
+            } else if (child->mType == MathAst::Type::OTHERWISE) {
+                otherwise = child->mChildren.at(0);
+            }
+        }
+        for (const MathAstPtr &piece : pieces) {
+            if (!compileNode(piece->mChildren.at(0), loads, shared, program, depth, error)) {
+                return false;
+            }
+        }
+        if (otherwise != nullptr) {
+            if (!compileNode(otherwise, loads, shared, program, depth, error)) {
+                return false;
+            }
+        } else {
+            emitConstant(std::numeric_limits<double>::quiet_NaN(), depth, program);
+        }
+        // The stack now holds [v1, ..., vn, otherwise]; fold from the right.
+        for (auto piece = pieces.rbegin(); piece != pieces.rend(); ++piece) {
+            if (!compileNode((*piece)->mChildren.at(1), loads, shared, program, depth, error)) {
+                return false;
+            }
+            emitOperation(OpCode::SELECT, -2, depth, program);
+        }
+        return true;
+    }
+    case MathAst::Type::MINUS: {
+        int count = compileArguments(ast, loads, shared, program, depth, error);
+        if (count == 1) {
+            emitOperation(OpCode::NEGATE, 0, depth, program);
+        } else if (count == 2) {
+            emitOperation(OpCode::SUBTRACT, -1, depth, program);
+        } else {
+            if (count >= 0) {
+                error = "MathML minus operator must have one or two arguments.";
+            }
+            return false;
+        }
+        return true;
+    }
+    case MathAst::Type::ROOT: {
+        MathAstPtr degree = qualifier(ast, MathAst::Type::DEGREE);
+        if (compileArguments(ast, loads, shared, program, depth, error) != 1) {
+            if (error.empty()) {
+                error = "MathML root operator must have one argument.";
+            }
+            return false;
+        }
+        if (degree == nullptr) {
+            emitConstant(0.5, depth, program);
+        } else {
+            emitConstant(1.0, depth, program);
+            if (!compileNode(degree, loads, shared, program, depth, error)) {
+                return false;
+            }
+            emitOperation(OpCode::DIVIDE, -1, depth, program);
+        }
+        emitOperation(OpCode::POWER, -1, depth, program);
+        return true;
+    }
+    case MathAst::Type::LOOKUP: {
+        if (!compileNode(ast->mChildren.at(0), loads, shared, program, depth, error)) {
+            return false;
+        }
+        Instruction instruction;
+        instruction.mOpCode = OpCode::LOOKUP;
+        instruction.mIndex = ast->mIndex;
+        emit(instruction, 0, depth, program);
+        return true;
+    }
+    case MathAst::Type::LOG: {
+        MathAstPtr base = qualifier(ast, MathAst::Type::LOGBASE);
+        if (compileArguments(ast, loads, shared, program, depth, error) != 1) {
+            if (error.empty()) {
+                error = "MathML log operator must have one argument.";
+            }
+            return false;
+        }
+        if (base == nullptr) {
+            emitOperation(OpCode::LOG10, 0, depth, program);
+        } else {
+            emitOperation(OpCode::LN, 0, depth, program);
+            if (!compileNode(base, loads, shared, program, depth, error)) {
+                return false;
+            }
+            emitOperation(OpCode::LN, 0, depth, program);
+            emitOperation(OpCode::DIVIDE, -1, depth, program);
+        }
+        return true;
+    }
+    default:
+        break;
+    }
+
+    auto found = opCodeMap.find(ast->mType);
+    if (found == opCodeMap.end()) {
+        error = "MathML element cannot be evaluated.";
+        return false;
+    }
+    OpCode opCode = found->second;
+    int count = compileArguments(ast, loads, shared, program, depth, error);
+    if (count < 0) {
+        return false;
+    }
+    if (opCode < OpCode::ADD) {
+        if (count != 1) {
+            error = "MathML unary operator must have exactly one argument.";
+            return false;
+        }
+        emitOperation(opCode, 0, depth, program);
+        return true;
+    }
+    bool nary = (opCode == OpCode::ADD) || (opCode == OpCode::MULTIPLY)
+                || (opCode == OpCode::MIN) || (opCode == OpCode::MAX)
+                || (opCode == OpCode::AND) || (opCode == OpCode::OR) || (opCode == OpCode::XOR);
+    if (nary && (count >= 1)) {
+        // Chain n-ary operators as a sequence of binary operations.
+        for (int i = 1; i < count; ++i) {
+            emitOperation(opCode, -1, depth, program);
+        }
+        return true;
+    }
+    if (count != 2) {
+        error = "MathML binary operator must have exactly two arguments.";
+        return false;
+    }
+    emitOperation(opCode, -1, depth, program);
+    return true;
+}
+
+/**
+ * @brief The temporary index of a shared expression yet to be computed.
+ */
+static const size_t UNCOMPUTED = std::numeric_limits<size_t>::max();
+
+static bool compileNode(const MathAstPtr &ast, const VariableLoadMap &loads, SharedExpressions *shared, Program &program, size_t &depth, std::string &error)
+{
+    if (shared == nullptr) {
+        return compileOperation(ast, loads, shared, program, depth, error);
+    }
+    auto found = shared->mTemporaries.find(ast);
+    if (found == shared->mTemporaries.end()) {
+        return compileOperation(ast, loads, shared, program, depth, error);
+    }
+    Instruction instruction;
+    if (found->second != UNCOMPUTED) {
+        instruction.mOpCode = OpCode::LOAD_TEMPORARY;
+        instruction.mIndex = found->second;
+        emit(instruction, 1, depth, program);
+        return true;
+    }
+    if (!compileOperation(ast, loads, shared, program, depth, error)) {
+        return false;
+    }
+    found->second = program.mTemporaryCount++;
+    instruction.mOpCode = OpCode::SAVE_TEMPORARY;
+    instruction.mIndex = found->second;
+    emit(instruction, 0, depth, program);
+    return true;
+}
+
+/**
+ * @brief Test if @p ast is worth keeping in a temporary when shared.
+ */
+static bool isOperation(const MathAstPtr &ast)
+{
+    switch (ast->mType) {
+    case MathAst::Type::CI:
+    case MathAst::Type::CN:
+    case MathAst::Type::DIFF:
+    case MathAst::Type::BVAR:
+    case MathAst::Type::DEGREE:
+    case MathAst::Type::LOGBASE:
+    case MathAst::Type::PIECE:
+    case MathAst::Type::OTHERWISE:
+    case MathAst::Type::BOOLEAN_TRUE:
+    case MathAst::Type::BOOLEAN_FALSE:
+    case MathAst::Type::E:
+    case MathAst::Type::PI:
+    case MathAst::Type::INF:
+    case MathAst::Type::NOT_A_NUMBER:
+        return false;
+    default:
+        return true;
+    }
+}
+
+/**
+ * @brief Count the uses of @p ast and, the first time it is visited, of its
+ * arguments.
+ */
+static void countUses(const MathAstPtr &ast, std::map<MathAstPtr, size_t> &uses)
+{
+    if (uses[ast]++ > 0) {
+        return;
+    }
+    // Only the variable of a lookup node is compiled.
+    if (ast->mType == MathAst::Type::LOOKUP) {
+        countUses(ast->mChildren.at(0), uses);
+        return;
+    }
+    for (const MathAstPtr &child : ast->mChildren) {
+        countUses(child, uses);
+    }
+}
+
+void findSharedExpressions(const std::vector<MathAstPtr> &asts, SharedExpressions &shared)
+{
+    std::map<MathAstPtr, size_t> uses;
+    for (const MathAstPtr &ast : asts) {
+        countUses(ast, uses);
+    }
+    for (const auto &use : uses) {
+        if ((use.second > 1) && isOperation(use.first)) {
+            shared.mTemporaries.emplace(use.first, UNCOMPUTED);
+        }
+    }
+}
+
+bool compileExpression(const MathAstPtr &ast, const VariableLoadMap &loads,
+                       Program &program, std::string &error, SharedExpressions *shared)
+{
+    size_t depth = 0;
+    return compileNode(ast, loads, shared, program, depth, error);
+}
+
+void compileStore(OpCode opCode, size_t index, Program &program)
+{
+    Instruction instruction;
+    instruction.mOpCode = opCode;
+    instruction.mIndex = index;
+    program.mInstructions.push_back(instruction);
+}
+
+/**
+ * @brief Get the value of the expression of @p table at @p x.
+ *
+ * Interpolate linearly between the tabulated values around @p x, or
+ * evaluate the expression exactly if @p x lies outside of the table.
+ */
+static double lookUp(const LookupTable &table, double x)
+{
+    double position = (x - table.mMinimum) * table.mInverseStep;
+    if ((position >= 0.0) && (position < static_cast<double>(table.mValues.size() - 1))) {
+        size_t i = static_cast<size_t>(position);
+        double fraction = position - static_cast<double>(i);
+        return table.mValues[i] + fraction * (table.mValues[i + 1] - table.mValues[i]);
+    }
+    double result = 0.0;
+    ProgramArguments arguments;
+    arguments.mVoi = x;
+    arguments.mResults = &result;
+    executeProgram(table.mExpression, arguments);
+    return result;
+}
+
+double tabulate(double minimum, double maximum, double step, LookupTable &table)
+{
+    auto exact = [&table](double x) {
+        double result = 0.0;
+        ProgramArguments arguments;
+        arguments.mVoi = x;
+        arguments.mResults = &result;
+        executeProgram(table.mExpression, arguments);
+        return result;
+    };
+    double points = std::ceil((maximum - minimum) / step) + 1.0;
+    if (!(points <= static_cast<double>(MAX_LOOKUP_TABLE_POINT_COUNT))) {
+        return std::numeric_limits<double>::infinity();
+    }
+    auto pointCount = static_cast<size_t>(points);
+    table.mMinimum = minimum;
+    table.mStep = step;
+    table.mInverseStep = 1.0 / step;
+    table.mValues.resize(std::max(pointCount, size_t(2)));
+    for (size_t i = 0; i < table.mValues.size(); ++i) {
+        table.mValues.at(i) = exact(minimum + static_cast<double>(i) * step);
+    }
+    double maximumError = 0.0;
+    for (size_t i = 0; i + 1 < table.mValues.size(); ++i) {
+        double x = minimum + (static_cast<double>(i) + 0.5) * step;
+        double error = std::fabs(lookUp(table, x) - exact(x));
+        if (std::isnan(error)) {
+            return std::numeric_limits<double>::infinity();
+        }
+        maximumError = std::max(maximumError, error);
+    }
+    return maximumError;
+}
+
+/**
+ * @brief The size of the stack allocated on the call stack by
+ * executeProgram(), larger programs use a heap allocated stack.
+ */
+static const size_t LOCAL_STACK_SIZE = 64;
+
+size_t programScratchSize(const Program &program)
+{
+    return program.mStackSize + program.mTemporaryCount;
+}
+
+void executeProgram(const Program &program, const ProgramArguments &arguments)
+{
+    // The temporaries follow the stack in the same buffer.
+    double localStack[LOCAL_STACK_SIZE];
+    std::vector<double> heapStack;
+    double *stack = arguments.mScratch;
+    if (stack == nullptr) {
+        stack = localStack;
+        if (programScratchSize(program) > LOCAL_STACK_SIZE) {
+            heapStack.resize(programScratchSize(program));
+            stack = heapStack.data();
+        }
+    }
+    double *temporaries = stack + program.mStackSize;
+    // The top of the stack is at stack[top - 1].
+    size_t top = 0;
+    for (const Instruction &instruction : program.mInstructions) {
+        switch (instruction.mOpCode) {
+        case OpCode::LOAD_CONSTANT:
+            stack[top++] = instruction.mValue;
+            break;
+        case OpCode::LOAD_VOI:
+            stack[top++] = arguments.mVoi;
+            break;
+        case OpCode::LOAD_STATE:
+            stack[top++] = arguments.mStates[instruction.mIndex];
+            break;
+        case OpCode::LOAD_RATE:
+            stack[top++] = arguments.mRates[instruction.mIndex];
+            break;
+        case OpCode::LOAD_VARIABLE:
+            stack[top++] = arguments.mVariables[instruction.mIndex];
+            break;
+        case OpCode::STORE_RATE:
+            arguments.mRatesOut[instruction.mIndex] = stack[--top];
+            break;
+        case OpCode::STORE_VARIABLE:
+            arguments.mVariablesOut[instruction.mIndex] = stack[--top];
+            break;
+        case OpCode::STORE_RESULT:
+            arguments.mResults[instruction.mIndex] = stack[--top];
+            break;
+        case OpCode::LOAD_TEMPORARY:
+            stack[top++] = temporaries[instruction.mIndex];
+            break;
+        case OpCode::SAVE_TEMPORARY:
+            temporaries[instruction.mIndex] = stack[top - 1];
+            break;
+        case OpCode::NEGATE:
+            stack[top - 1] = -stack[top - 1];
+            break;
+        case OpCode::NOT:
+            stack[top - 1] = (stack[top - 1] != 0.0) ? 0.0 : 1.0;
+            break;
+        case OpCode::ABS:
+            stack[top - 1] = std::fabs(stack[top - 1]);
+            break;
+        case OpCode::EXP:
+            stack[top - 1] = std::exp(stack[top - 1]);
+            break;
+        case OpCode::LN:
+            stack[top - 1] = std::log(stack[top - 1]);
+            break;
+        case OpCode::LOG10:
+            stack[top - 1] = std::log10(stack[top - 1]);
+            break;
+        case OpCode::FLOOR:
+            stack[top - 1] = std::floor(stack[top - 1]);
+            break;
+        case OpCode::CEILING:
+            stack[top - 1] = std::ceil(stack[top - 1]);
+            break;
+        case OpCode::SIN:
+            stack[top - 1] = std::sin(stack[top - 1]);
+            break;
+        case OpCode::COS:
+            stack[top - 1] = std::cos(stack[top - 1]);
+            break;
+        case OpCode::TAN:
+            stack[top - 1] = std::tan(stack[top - 1]);
+            break;
+        case OpCode::SEC:
+            stack[top - 1] = 1.0 / std::cos(stack[top - 1]);
+            break;
+        case OpCode::CSC:
+            stack[top - 1] = 1.0 / std::sin(stack[top - 1]);
+            break;
+        case OpCode::COT:
+            stack[top - 1] = 1.0 / std::tan(stack[top - 1]);
+            break;
+        case OpCode::SINH:
+            stack[top - 1] = std::sinh(stack[top - 1]);
+            break;
+        case OpCode::COSH:
+            stack[top - 1] = std::cosh(stack[top - 1]);
+            break;
+        case OpCode::TANH:
+            stack[top - 1] = std::tanh(stack[top - 1]);
+            break;
+        case OpCode::SECH:
+            stack[top - 1] = 1.0 / std::cosh(stack[top - 1]);
+            break;
+        case OpCode::CSCH:
+            stack[top - 1] = 1.0 / std::sinh(stack[top - 1]);
+            break;
+        case OpCode::COTH:
+            stack[top - 1] = 1.0 / std::tanh(stack[top - 1]);
+            break;
+        case OpCode::ARCSIN:
+            stack[top - 1] = std::asin(stack[top - 1]);
+            break;
+        case OpCode::ARCCOS:
+            stack[top - 1] = std::acos(stack[top - 1]);
+            break;
+        case OpCode::ARCTAN:
+            stack[top - 1] = std::atan(stack[top - 1]);
+            break;
+        case OpCode::ARCSEC:
+            stack[top - 1] = std::acos(1.0 / stack[top - 1]);
+            break;
+        case OpCode::ARCCSC:
+            stack[top - 1] = std::asin(1.0 / stack[top - 1]);
+            break;
+        case OpCode::ARCCOT:
+            stack[top - 1] = std::atan(1.0 / stack[top - 1]);
+            break;
+        case OpCode::ARCSINH:
+            stack[top - 1] = std::asinh(stack[top - 1]);
+            break;
+        case OpCode::ARCCOSH:
+            stack[top - 1] = std::acosh(stack[top - 1]);
+            break;
+        case OpCode::ARCTANH:
+            stack[top - 1] = std::atanh(stack[top - 1]);
+            break;
+        case OpCode::ARCSECH:
+            stack[top - 1] = std::acosh(1.0 / stack[top - 1]);
+            break;
+        case OpCode::ARCCSCH:
+            stack[top - 1] = std::asinh(1.0 / stack[top - 1]);
+            break;
+        case OpCode::ARCCOTH:
+            stack[top - 1] = std::atanh(1.0 / stack[top - 1]);
+            break;
+        case OpCode::ADD:
+            --top;
+            stack[top - 1] += stack[top];
+            break;
+        case OpCode::SUBTRACT:
+            --top;
+            stack[top - 1] -= stack[top];
+            break;
+        case OpCode::MULTIPLY:
+            --top;
+            stack[top - 1] *= stack[top];
+            break;
+        case OpCode::DIVIDE:
+            --top;
+            stack[top - 1] /= stack[top];
+            break;
+        case OpCode::POWER:
+            --top;
+            stack[top - 1] = std::pow(stack[top - 1], stack[top]);
+            break;
+        case OpCode::MIN:
+            --top;
+            stack[top - 1] = std::fmin(stack[top - 1], stack[top]);
+            break;
+        case OpCode::MAX:
+            --top;
+            stack[top - 1] = std::fmax(stack[top - 1], stack[top]);
+            break;
+        case OpCode::REM:
+            --top;
+            stack[top - 1] = std::fmod(stack[top - 1], stack[top]);
+            break;
+        case OpCode::EQ:
+            --top;
+            stack[top - 1] = (stack[top - 1] == stack[top]) ? 1.0 : 0.0;
+            break;
+        case OpCode::NEQ:
+            --top;
+            stack[top - 1] = (stack[top - 1] != stack[top]) ? 1.0 : 0.0;
+            break;
+        case OpCode::LT:
+            --top;
+            stack[top - 1] = (stack[top - 1] < stack[top]) ? 1.0 : 0.0;
+            break;
+        case OpCode::LEQ:
+            --top;
+            stack[top - 1] = (stack[top - 1] <= stack[top]) ? 1.0 : 0.0;
+            break;
+        case OpCode::GT:
+            --top;
+            stack[top - 1] = (stack[top - 1] > stack[top]) ? 1.0 : 0.0;
+            break;
+        case OpCode::GEQ:
+            --top;
+            stack[top - 1] = (stack[top - 1] >= stack[top]) ? 1.0 : 0.0;
+            break;
+        case OpCode::AND:
+            --top;
+            stack[top - 1] = ((stack[top - 1] != 0.0) && (stack[top] != 0.0)) ? 1.0 : 0.0;
+            break;
+        case OpCode::OR:
+            --top;
+            stack[top - 1] = ((stack[top - 1] != 0.0) || (stack[top] != 0.0)) ? 1.0 : 0.0;
+            break;
+        case OpCode::XOR:
+            --top;
+            stack[top - 1] = ((stack[top - 1] != 0.0) != (stack[top] != 0.0)) ? 1.0 : 0.0;
+            break;
+        case OpCode::SELECT:
+            // Stack holds [value, otherwise, condition].
+            top -= 2;
+            stack[top - 1] = (stack[top + 1] != 0.0) ? stack[top - 1] : stack[top];
+            break;
+        case OpCode::LOOKUP:
+            stack[top - 1] = lookUp(arguments.mLookupTables[instruction.mIndex], stack[top - 1]);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief The number of instances executeProgramBatch() applies each
+ * instruction to at once.
+ */
+static const size_t BATCH_WIDTH = 64;
+
+/**
+ * @brief Apply @p function to each of the @p width entries of @p operand.
+ */
+template<typename Function>
+static void applyUnary(double *operand, size_t width, Function function)
+{
+    for (size_t j = 0; j < width; ++j) {
+        operand[j] = function(operand[j]);
+    }
+}
+
+/**
+ * @brief Apply @p function to each of the @p width pairs of @p left and
+ * @p right, storing the results in @p left.
+ */
+template<typename Function>
+static void applyBinary(double *left, const double *right, size_t width, Function function)
+{
+    for (size_t j = 0; j < width; ++j) {
+        left[j] = function(left[j], right[j]);
+    }
+}
+
+/**
+ * @brief Copy the @p width entries of @p source to @p target.
+ */
+static void load(double *target, const double *source, size_t width)
+{
+    for (size_t j = 0; j < width; ++j) {
+        target[j] = source[j];
+    }
+}
+
+/**
+ * @brief Execute @p program for the @p width instances starting at @p first
+ * using the given @p stack and @p temporaries.
+ */
+static void executeBlock(const Program &program, const ProgramArguments &arguments,
+                         size_t instanceCount, size_t first, size_t width, double *stack, double *temporaries)
+{
+    // The block of the top of the stack starts at stack[(top - 1) * BATCH_WIDTH].
+    size_t top = 0;
+    for (const Instruction &instruction : program.mInstructions) {
+        double *next = stack + top * BATCH_WIDTH;
+        double *operand = next - BATCH_WIDTH;
+        size_t offset = instruction.mIndex * instanceCount + first;
+        switch (instruction.mOpCode) {
+        case OpCode::LOAD_CONSTANT:
+            std::fill(next, next + width, instruction.mValue);
+            ++top;
+            break;
+        case OpCode::LOAD_VOI:
+            std::fill(next, next + width, arguments.mVoi);
+            ++top;
+            break;
+        case OpCode::LOAD_STATE:
+            load(next, arguments.mStates + offset, width);
+            ++top;
+            break;
+        case OpCode::LOAD_RATE:
+            load(next, arguments.mRates + offset, width);
+            ++top;
+            break;
+        case OpCode::LOAD_VARIABLE:
+            load(next, arguments.mVariables + offset, width);
+            ++top;
+            break;
+        case OpCode::STORE_RATE:
+            load(arguments.mRatesOut + offset, operand, width);
+            --top;
+            break;
+        case OpCode::STORE_VARIABLE:
+            load(arguments.mVariablesOut + offset, operand, width);
+            --top;
+            break;
+        case OpCode::STORE_RESULT:
+            load(arguments.mResults + offset, operand, width);
+            --top;
+            break;
+        case OpCode::LOAD_TEMPORARY:
+            load(next, temporaries + instruction.mIndex * BATCH_WIDTH, width);
+            ++top;
+            break;
+        case OpCode::SAVE_TEMPORARY:
+            load(temporaries + instruction.mIndex * BATCH_WIDTH, operand, width);
+            break;
+        case OpCode::NEGATE:
+            applyUnary(operand, width, [](double x) { return -x; });
+            break;
+        case OpCode::NOT:
+            applyUnary(operand, width, [](double x) { return (x != 0.0) ? 0.0 : 1.0; });
+            break;
+        case OpCode::ABS:
+            applyUnary(operand, width, [](double x) { return std::fabs(x); });
+            break;
+        case OpCode::EXP:
+            applyUnary(operand, width, [](double x) { return vectorExp(x); });
+            break;
+        case OpCode::LN:
+            applyUnary(operand, width, [](double x) { return vectorLog(x); });
+            break;
+        case OpCode::LOG10:
+            applyUnary(operand, width, [](double x) { return vectorLog(x) / std::log(10.0); });
+            break;
+        case OpCode::FLOOR:
+            applyUnary(operand, width, [](double x) { return std::floor(x); });
+            break;
+        case OpCode::CEILING:
+            applyUnary(operand, width, [](double x) { return std::ceil(x); });
+            break;
+        case OpCode::SIN:
+            applyUnary(operand, width, [](double x) { return std::sin(x); });
+            break;
+        case OpCode::COS:
+            applyUnary(operand, width, [](double x) { return std::cos(x); });
+            break;
+        case OpCode::TAN:
+            applyUnary(operand, width, [](double x) { return std::tan(x); });
+            break;
+        case OpCode::SEC:
+            applyUnary(operand, width, [](double x) { return 1.0 / std::cos(x); });
+            break;
+        case OpCode::CSC:
+            applyUnary(operand, width, [](double x) { return 1.0 / std::sin(x); });
+            break;
+        case OpCode::COT:
+            applyUnary(operand, width, [](double x) { return 1.0 / std::tan(x); });
+            break;
+        case OpCode::SINH:
+            applyUnary(operand, width, [](double x) { return std::sinh(x); });
+            break;
+        case OpCode::COSH:
+            applyUnary(operand, width, [](double x) { return std::cosh(x); });
+            break;
+        case OpCode::TANH:
+            applyUnary(operand, width, [](double x) { return std::tanh(x); });
+            break;
+        case OpCode::SECH:
+            applyUnary(operand, width, [](double x) { return 1.0 / std::cosh(x); });
+            break;
+        case OpCode::CSCH:
+            applyUnary(operand, width, [](double x) { return 1.0 / std::sinh(x); });
+            break;
+        case OpCode::COTH:
+            applyUnary(operand, width, [](double x) { return 1.0 / std::tanh(x); });
+            break;
+        case OpCode::ARCSIN:
+            applyUnary(operand, width, [](double x) { return std::asin(x); });
+            break;
+        case OpCode::ARCCOS:
+            applyUnary(operand, width, [](double x) { return std::acos(x); });
+            break;
+        case OpCode::ARCTAN:
+            applyUnary(operand, width, [](double x) { return std::atan(x); });
+            break;
+        case OpCode::ARCSEC:
+            applyUnary(operand, width, [](double x) { return std::acos(1.0 / x); });
+            break;
+        case OpCode::ARCCSC:
+            applyUnary(operand, width, [](double x) { return std::asin(1.0 / x); });
+            break;
+        case OpCode::ARCCOT:
+            applyUnary(operand, width, [](double x) { return std::atan(1.0 / x); });
+            break;
+        case OpCode::ARCSINH:
+            applyUnary(operand, width, [](double x) { return std::asinh(x); });
+            break;
+        case OpCode::ARCCOSH:
+            applyUnary(operand, width, [](double x) { return std::acosh(x); });
+            break;
+        case OpCode::ARCTANH:
+            applyUnary(operand, width, [](double x) { return std::atanh(x); });
+            break;
+        case OpCode::ARCSECH:
+            applyUnary(operand, width, [](double x) { return std::acosh(1.0 / x); });
+            break;
+        case OpCode::ARCCSCH:
+            applyUnary(operand, width, [](double x) { return std::asinh(1.0 / x); });
+            break;
+        case OpCode::ARCCOTH:
+            applyUnary(operand, width, [](double x) { return std::atanh(1.0 / x); });
+            break;
+        case OpCode::ADD:
+            --top;
+            applyBinary(operand - BATCH_WIDTH, operand, width, [](double x, double y) { return x + y; });
+            break;
+        case OpCode::SUBTRACT:
+            --top;
+            applyBinary(operand - BATCH_WIDTH, operand, width, [](double x, double y) { return x - y; });
+            break;
+        case OpCode::MULTIPLY:
+            --top;
+            applyBinary(operand - BATCH_WIDTH, operand, width, [](double x, double y) { return x * y; });
+            break;
+        case OpCode::DIVIDE:
+            --top;
+            applyBinary(operand - BATCH_WIDTH, operand, width, [](double x, double y) { return x / y; });
+            break;
+        case OpCode::POWER:
+            --top;
+            applyBinary(operand - BATCH_WIDTH, operand, width, [](double x, double y) { return vectorPow(x, y); });
+            break;
+        case OpCode::MIN:
+            --top;
+            applyBinary(operand - BATCH_WIDTH, operand, width, [](double x, double y) { return std::fmin(x, y); });
+            break;
+        case OpCode::MAX:
+            --top;
+            applyBinary(operand - BATCH_WIDTH, operand, width, [](double x, double y) { return std::fmax(x, y); });
+            break;
+        case OpCode::REM:
+            --top;
+            applyBinary(operand - BATCH_WIDTH, operand, width, [](double x, double y) { return std::fmod(x, y); });
+            break;
+        case OpCode::EQ:
+            --top;
+            applyBinary(operand - BATCH_WIDTH, operand, width, [](double x, double y) { return (x == y) ? 1.0 : 0.0; });
+            break;
+        case OpCode::NEQ:
+            --top;
+            applyBinary(operand - BATCH_WIDTH, operand, width, [](double x, double y) { return (x != y) ? 1.0 : 0.0; });
+            break;
+        case OpCode::LT:
+            --top;
+            applyBinary(operand - BATCH_WIDTH, operand, width, [](double x, double y) { return (x < y) ? 1.0 : 0.0; });
+            break;
+        case OpCode::LEQ:
+            --top;
+            applyBinary(operand - BATCH_WIDTH, operand, width, [](double x, double y) { return (x <= y) ? 1.0 : 0.0; });
+            break;
+        case OpCode::GT:
+            --top;
+            applyBinary(operand - BATCH_WIDTH, operand, width, [](double x, double y) { return (x > y) ? 1.0 : 0.0; });
+            break;
+        case OpCode::GEQ:
+            --top;
+            applyBinary(operand - BATCH_WIDTH, operand, width, [](double x, double y) { return (x >= y) ? 1.0 : 0.0; });
+            break;
+        case OpCode::AND:
+            --top;
+            applyBinary(operand - BATCH_WIDTH, operand, width, [](double x, double y) { return ((x != 0.0) && (y != 0.0)) ? 1.0 : 0.0; });
+            break;
+        case OpCode::OR:
+            --top;
+            applyBinary(operand - BATCH_WIDTH, operand, width, [](double x, double y) { return ((x != 0.0) || (y != 0.0)) ? 1.0 : 0.0; });
+            break;
+        case OpCode::XOR:
+            --top;
+            applyBinary(operand - BATCH_WIDTH, operand, width, [](double x, double y) { return ((x != 0.0) != (y != 0.0)) ? 1.0 : 0.0; });
+            break;
+        case OpCode::SELECT: {
+            // Stack holds [value, otherwise, condition].
+            top -= 2;
+            double *value = operand - 2 * BATCH_WIDTH;
+            const double *otherwise = operand - BATCH_WIDTH;
+            for (size_t j = 0; j < width; ++j) {
+                value[j] = (operand[j] != 0.0) ? value[j] : otherwise[j];
+            }
+            break;
+        }
+        case OpCode::LOOKUP: {
+            const LookupTable &table = arguments.mLookupTables[instruction.mIndex];
+            applyUnary(operand, width, [&table](double x) { return lookUp(table, x); });
+            break;
+        }
+        }
+    }
+}
+
+void executeProgramBatch(const Program &program, const ProgramArguments &arguments, size_t instanceCount)
+{
+    if (program.mInstructions.empty()) {
+        return;
+    }
+    // The leading block is never used but keeps the pointer to the top of
+    // the stack within the buffer while the stack is empty.  The temporaries
+    // follow the stack.
+    std::vector<double> stack((program.mStackSize + 1 + program.mTemporaryCount) * BATCH_WIDTH);
+    double *temporaries = stack.data() + (program.mStackSize + 1) * BATCH_WIDTH;
+    for (size_t first = 0; first < instanceCount; first += BATCH_WIDTH) {
+        executeBlock(program, arguments, instanceCount, first,
+                     std::min(BATCH_WIDTH, instanceCount - first), stack.data() + BATCH_WIDTH, temporaries);
+    }
+}
+
+} // namespace libcellml
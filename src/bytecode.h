@@ -0,0 +1,344 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "mathast.h"
+
+#include "libcellml/types.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace libcellml {
+
+class Evaluator;
+
+/**
+ * @brief The OpCode enum class.
+ *
+ * The operations of the stack machine used to evaluate compiled model math.
+ * Load operations push a value onto the stack, store operations pop a value
+ * off the stack, and all other operations replace their operands on the top
+ * of the stack with their result.
+ */
+enum class OpCode
+{
+    // Loads and stores.
+    LOAD_CONSTANT,
+    LOAD_VOI,
+    LOAD_STATE,
+    LOAD_RATE,
+    LOAD_VARIABLE,
+    STORE_RATE,
+    STORE_VARIABLE,
+    STORE_RESULT,
+    LOAD_TEMPORARY,
+    SAVE_TEMPORARY,
+
+    // Unary operations.
+    NEGATE,
+    NOT,
+    ABS,
+    EXP,
+    LN,
+    LOG10,
+    FLOOR,
+    CEILING,
+    SIN,
+    COS,
+    TAN,
+    SEC,
+    CSC,
+    COT,
+    SINH,
+    COSH,
+    TANH,
+    SECH,
+    CSCH,
+    COTH,
+    ARCSIN,
+    ARCCOS,
+    ARCTAN,
+    ARCSEC,
+    ARCCSC,
+    ARCCOT,
+    ARCSINH,
+    ARCCOSH,
+    ARCTANH,
+    ARCSECH,
+    ARCCSCH,
+    ARCCOTH,
+
+    // Binary operations.
+    ADD,
+    SUBTRACT,
+    MULTIPLY,
+    DIVIDE,
+    POWER,
+    MIN,
+    MAX,
+    REM,
+    EQ,
+    NEQ,
+    LT,
+    LEQ,
+    GT,
+    GEQ,
+    AND,
+    OR,
+    XOR,
+
+    // Ternary operations.
+    SELECT,
+
+    // Lookup table interpolation.
+    LOOKUP
+};
+
+/**
+ * @brief The Instruction struct.
+ *
+ * A single stack machine instruction.  @c mIndex is the array index used by
+ * load and store operations, and @c mValue is the value pushed by
+ * @c LOAD_CONSTANT.
+ */
+struct Instruction
+{
+    OpCode mOpCode = OpCode::LOAD_CONSTANT; /**< The operation to perform. */
+    size_t mIndex = 0; /**< The array index for load and store operations. */
+    double mValue = 0.0; /**< The value for constant loads. */
+};
+
+/**
+ * @brief The Program struct.
+ *
+ * A compiled sequence of instructions along with the maximum stack depth
+ * needed to execute it.
+ */
+struct Program
+{
+    std::vector<Instruction> mInstructions; /**< The instructions to execute. */
+    size_t mStackSize = 0; /**< The maximum stack depth reached by the instructions. */
+    size_t mTemporaryCount = 0; /**< The number of temporaries used by the instructions. */
+};
+
+/**
+ * @brief The SharedExpressions struct.
+ *
+ * The subexpressions used more than once by the expressions compiled into a
+ * program.  Each of them is computed the first time it is compiled and kept
+ * in a temporary, which is loaded wherever it is used afterwards.  This
+ * relies on identical subexpressions being represented by the same node, and
+ * on programs having no jumps.
+ */
+struct SharedExpressions
+{
+    std::map<MathAstPtr, size_t> mTemporaries; /**< The temporary of each shared expression, once computed. */
+};
+
+/**
+ * @brief The LookupTable struct.
+ *
+ * The values of an expression of a single variable, tabulated at evenly
+ * spaced points between a minimum and a maximum and linearly interpolated
+ * in between.  Outside of that range the expression is evaluated exactly by
+ * executing @c mExpression, which loads the variable using @c LOAD_VOI and
+ * stores the value in result @c 0.
+ */
+struct LookupTable
+{
+    double mMinimum = 0.0; /**< The value of the variable at the first point. */
+    double mStep = 1.0; /**< The distance between consecutive points. */
+    double mInverseStep = 1.0; /**< The reciprocal of @c mStep. */
+    std::vector<double> mValues; /**< The values of the expression at the points. */
+    Program mExpression; /**< The program evaluating the expression exactly. */
+};
+
+/**
+ * The maximum number of points of a lookup table.
+ */
+static const size_t MAX_LOOKUP_TABLE_POINT_COUNT = size_t(1) << 20;
+
+/**
+ * @brief The ProgramArguments struct.
+ *
+ * The arrays a program loads from and stores to.  Loads read from the
+ * @c const arrays and stores write to the non-const ones, which will usually
+ * alias each other.
+ */
+struct ProgramArguments
+{
+    double mVoi = 0.0; /**< The value of the variable of integration. */
+    const double *mStates = nullptr; /**< The state values. */
+    const double *mRates = nullptr; /**< The rate values. */
+    const double *mVariables = nullptr; /**< The variable values. */
+    double *mRatesOut = nullptr; /**< The array stored rates are written to. */
+    double *mVariablesOut = nullptr; /**< The array stored variables are written to. */
+    double *mResults = nullptr; /**< The array stored results are written to. */
+    const LookupTable *mLookupTables = nullptr; /**< The tables used by lookup operations. */
+    double *mScratch = nullptr; /**< A buffer of at least programScratchSize() values for the stack and temporaries, or null. */
+};
+
+/**
+ * Type definition for the map from a model variable to the instruction
+ * loading its value.
+ */
+typedef std::map<VariablePtr, Instruction> VariableLoadMap;
+
+/**
+ * @brief Compile the expression @p ast and append it to @p program.
+ *
+ * Append the instructions evaluating @p ast onto the stack of @p program.
+ * Variables are loaded using the instructions found in @p loads.  On
+ * failure @p error is set to a description of the problem.
+ *
+ * @param ast The expression to compile.
+ * @param loads The map from model variables to load instructions.
+ * @param program The program to append the instructions to.
+ * @param error The @c std::string to set to a description of any error.
+ * @param shared The shared expressions of @p program, if any.
+ *
+ * @return @c true if the expression was compiled, @c false otherwise.
+ */
+bool compileExpression(const MathAstPtr &ast, const VariableLoadMap &loads,
+                       Program &program, std::string &error,
+                       SharedExpressions *shared = nullptr);
+
+/**
+ * @brief Find the subexpressions used more than once by @p asts.
+ *
+ * Add the operation nodes reachable more than once from the expressions in
+ * @p asts, which are meant to be compiled into the same program, to
+ * @p shared.
+ *
+ * @param asts The expressions to examine.
+ * @param shared The shared expressions to add to.
+ */
+void findSharedExpressions(const std::vector<MathAstPtr> &asts, SharedExpressions &shared);
+
+/**
+ * @brief Append a store instruction to @p program.
+ *
+ * Append an instruction popping the top of the stack into the array slot
+ * @p index using the store operation @p opCode.
+ *
+ * @param opCode The store operation.
+ * @param index The array index to store to.
+ * @param program The program to append the instruction to.
+ */
+void compileStore(OpCode opCode, size_t index, Program &program);
+
+/**
+ * @brief Tabulate the expression of @p table.
+ *
+ * Evaluate the expression of @p table at the points from @p minimum to at
+ * least @p maximum, @p step apart, and estimate the interpolation error by
+ * comparing the interpolated and exact values halfway between the points.
+ * The bounds and step must be finite, with @p step positive and @p maximum
+ * greater than @p minimum, and there must be at most
+ * @c MAX_LOOKUP_TABLE_POINT_COUNT points.
+ *
+ * @param minimum The smallest tabulated value of the variable.
+ * @param maximum The largest value of the variable to cover.
+ * @param step The distance between consecutive points.
+ * @param table The table, whose @c mExpression is set, to fill.
+ *
+ * @return The largest absolute interpolation error found.
+ */
+double tabulate(double minimum, double maximum, double step, LookupTable &table);
+
+/**
+ * @brief Get the size of the scratch buffer used to execute @p program.
+ *
+ * @param program The program to get the scratch buffer size of.
+ *
+ * @return The number of values needed for the stack and temporaries of
+ * @p program.
+ */
+size_t programScratchSize(const Program &program);
+
+/**
+ * @brief Execute @p program.
+ *
+ * Execute the instructions of @p program using the arrays in @p arguments.
+ * The stack and temporaries are kept in @c arguments.mScratch when it is
+ * set, otherwise on the call stack, or on the heap for large programs.
+ *
+ * @param program The program to execute.
+ * @param arguments The arrays the program loads from and stores to.
+ */
+void executeProgram(const Program &program, const ProgramArguments &arguments);
+
+/**
+ * @brief Execute @p program for @p instanceCount instances at once.
+ *
+ * Execute the instructions of @p program using the arrays in @p arguments,
+ * which use a structure-of-arrays layout: the value of entry @c i of an
+ * array for instance @c j is at position @c i * @p instanceCount + @c j.
+ * Instances are processed in blocks, with each instruction applied to the
+ * whole block before moving on to the next one so that the inner loops can
+ * be vectorised.
+ *
+ * @param program The program to execute.
+ * @param arguments The arrays the program loads from and stores to.
+ * @param instanceCount The number of instances to execute the program for.
+ */
+void executeProgramBatch(const Program &program, const ProgramArguments &arguments, size_t instanceCount);
+
+/**
+ * @brief The EvaluatorAccess class.
+ *
+ * An internal class letting the library run the programs of an evaluator
+ * with a caller owned scratch buffer, so that repeated calls do not
+ * allocate.  The @p scratch buffers hold at least scratchSize() values.
+ */
+class EvaluatorAccess
+{
+public:
+    /**
+     * @brief Get the size of the scratch buffer needed by @p evaluator.
+     *
+     * @param evaluator The evaluator to get the scratch buffer size of.
+     *
+     * @return The largest scratch buffer size of the programs of
+     * @p evaluator.
+     */
+    static size_t scratchSize(const Evaluator &evaluator);
+
+    /**
+     * @brief Evaluator::computeRates() using @p scratch.
+     */
+    static void computeRates(const Evaluator &evaluator, double voi, const double *states, double *rates, double *variables, double *scratch);
+
+    /**
+     * @brief Evaluator::computeVariables() using @p scratch.
+     */
+    static void computeVariables(const Evaluator &evaluator, double voi, const double *states, const double *rates, double *variables, double *scratch);
+
+    /**
+     * @brief Evaluator::computeConditions() using @p scratch.
+     */
+    static void computeConditions(const Evaluator &evaluator, double voi, const double *states, const double *rates, const double *variables, double *conditions, double *scratch);
+
+    /**
+     * @brief Evaluator::computeGatingCoefficients() using @p scratch.
+     */
+    static void computeGatingCoefficients(const Evaluator &evaluator, double voi, const double *states, const double *rates, const double *variables, double *coefficients, double *scratch);
+};
+
+} // namespace libcellml
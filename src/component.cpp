@@ -14,6 +14,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include "arena.h"
+#include "symbols.h"
+
 #include "libcellml/component.h"
 #include "libcellml/units.h"
 #include "libcellml/variable.h"
@@ -43,8 +46,12 @@ struct Component::ComponentImpl
 
 std::vector<VariablePtr>::iterator Component::ComponentImpl::findVariable(const std::string &name)
 {
+    Symbol symbol;
+    if (!findSymbol(name, symbol)) {
+        return mVariables.end();
+    }
     return std::find_if(mVariables.begin(), mVariables.end(),
-                        [=](const VariablePtr &v) -> bool { return v->name() == name; });
+                        [=](const VariablePtr &v) -> bool { return nameSymbol(*v) == symbol; });
 }
 
 std::vector<VariablePtr>::iterator Component::ComponentImpl::findVariable(const VariablePtr &variable)
@@ -60,24 +67,43 @@ std::vector<ResetPtr>::iterator Component::ComponentImpl::findReset(const ResetP
 }
 
 Component::Component()
-    : mPimpl(new ComponentImpl())
+    : mPimpl(newImpl<ComponentImpl>())
 {
 }
 
+/**
+ * @brief Clear the parent of @p entity if it is @p parent.
+ *
+ * To be called when @p entity is removed from @p parent, or when @p parent
+ * is destroyed, so that @p entity does not keep a pointer to it.
+ *
+ * @param parent The component @p entity is removed from.
+ * @param entity The variable or component removed.
+ */
+static void releaseEntity(const Component *parent, const EntityPtr &entity)
+{
+    if (entity->parent() == parent) {
+        entity->clearParent();
+    }
+}
+
 Component::~Component()
 {
     if (mPimpl != nullptr) {
         for (const auto &variable : mPimpl->mVariables) {
-            variable->clearParent();
+            releaseEntity(this, variable);
+        }
+        for (const auto &component : components()) {
+            releaseEntity(this, component);
         }
     }
-    delete mPimpl;
+    deleteImpl(mPimpl);
 }
 
 Component::Component(const Component &rhs)
     : ComponentEntity(rhs)
     , ImportedEntity(rhs)
-    , mPimpl(new ComponentImpl())
+    , mPimpl(newImpl<ComponentImpl>())
 {
     mPimpl->mVariables = rhs.mPimpl->mVariables;
     mPimpl->mResets = rhs.mPimpl->mResets;
@@ -122,6 +148,7 @@ void Component::setSourceComponent(const ImportSourcePtr &importSource, const st
 void Component::appendMath(const std::string &math)
 {
     mPimpl->mMath.append(math);
+    markModified();
 }
 
 std::string Component::math() const
@@ -132,18 +159,22 @@ std::string Component::math() const
 void Component::setMath(const std::string &math)
 {
     mPimpl->mMath = math;
+    markModified();
 }
 
 void Component::addVariable(const VariablePtr &variable)
 {
     mPimpl->mVariables.push_back(variable);
     variable->setParent(this);
+    markModified();
 }
 
 bool Component::removeVariable(size_t index)
 {
     if (index < mPimpl->mVariables.size()) {
+        releaseEntity(this, mPimpl->mVariables.at(index));
         mPimpl->mVariables.erase(mPimpl->mVariables.begin() + int64_t(index));
+        markModified();
         return true;
     }
 
@@ -154,7 +185,9 @@ bool Component::removeVariable(const std::string &name)
 {
     auto result = mPimpl->findVariable(name);
     if (result != mPimpl->mVariables.end()) {
+        releaseEntity(this, *result);
         mPimpl->mVariables.erase(result);
+        markModified();
         return true;
     }
 
@@ -165,7 +198,9 @@ bool Component::removeVariable(const VariablePtr &variable)
 {
     auto result = mPimpl->findVariable(variable);
     if (result != mPimpl->mVariables.end()) {
+        releaseEntity(this, *result);
         mPimpl->mVariables.erase(result);
+        markModified();
         return true;
     }
 
@@ -174,7 +209,11 @@ bool Component::removeVariable(const VariablePtr &variable)
 
 void Component::removeAllVariables()
 {
+    for (const auto &variable : mPimpl->mVariables) {
+        releaseEntity(this, variable);
+    }
     mPimpl->mVariables.clear();
+    markModified();
 }
 
 VariablePtr Component::variable(size_t index) const
@@ -219,6 +258,11 @@ size_t Component::variableCount() const
     return mPimpl->mVariables.size();
 }
 
+const std::vector<VariablePtr> &Component::variables() const
+{
+    return mPimpl->mVariables;
+}
+
 bool Component::hasVariable(const VariablePtr &variable) const
 {
     return mPimpl->findVariable(variable) != mPimpl->mVariables.end();
@@ -232,12 +276,14 @@ bool Component::hasVariable(const std::string &name) const
 void Component::addReset(const ResetPtr &reset)
 {
     mPimpl->mResets.push_back(reset);
+    markModified();
 }
 
 bool Component::removeReset(size_t index)
 {
     if (index < mPimpl->mResets.size()) {
         mPimpl->mResets.erase(mPimpl->mResets.begin() + int64_t(index));
+        markModified();
         return true;
     }
 
@@ -249,6 +295,7 @@ bool Component::removeReset(const ResetPtr &reset)
     auto result = mPimpl->findReset(reset);
     if (result != mPimpl->mResets.end()) {
         mPimpl->mResets.erase(result);
+        markModified();
         return true;
     }
 
@@ -258,6 +305,7 @@ bool Component::removeReset(const ResetPtr &reset)
 void Component::removeAllResets()
 {
     mPimpl->mResets.clear();
+    markModified();
 }
 
 ResetPtr Component::reset(size_t index) const
@@ -14,12 +14,17 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include "arena.h"
+#include "symbols.h"
+
 #include "libcellml/component.h"
 #include "libcellml/componententity.h"
+#include "libcellml/model.h"
 #include "libcellml/units.h"
 
 #include <algorithm>
 #include <memory>
+#include <utility>
 #include <vector>
 
 namespace libcellml {
@@ -41,8 +46,12 @@ struct ComponentEntity::ComponentEntityImpl
 
 std::vector<ComponentPtr>::iterator ComponentEntity::ComponentEntityImpl::findComponent(const std::string &name)
 {
+    Symbol symbol;
+    if (!findSymbol(name, symbol)) {
+        return mComponents.end();
+    }
     return std::find_if(mComponents.begin(), mComponents.end(),
-                        [=](const ComponentPtr &c) -> bool { return c->name() == name; });
+                        [=](const ComponentPtr &c) -> bool { return nameSymbol(*c) == symbol; });
 }
 
 std::vector<ComponentPtr>::iterator ComponentEntity::ComponentEntityImpl::findComponent(const ComponentPtr &component)
@@ -53,18 +62,18 @@ std::vector<ComponentPtr>::iterator ComponentEntity::ComponentEntityImpl::findCo
 
 // Interface class Model implementation
 ComponentEntity::ComponentEntity()
-    : mPimpl(new ComponentEntityImpl())
+    : mPimpl(newImpl<ComponentEntityImpl>())
 {
 }
 
 ComponentEntity::~ComponentEntity()
 {
-    delete mPimpl;
+    deleteImpl(mPimpl);
 }
 
 ComponentEntity::ComponentEntity(const ComponentEntity &rhs)
     : NamedEntity(rhs)
-    , mPimpl(new ComponentEntityImpl())
+    , mPimpl(newImpl<ComponentEntityImpl>())
 {
     mPimpl->mComponents = rhs.mPimpl->mComponents;
     mPimpl->mEncapsulationId = rhs.mPimpl->mEncapsulationId;
@@ -89,6 +98,42 @@ void ComponentEntity::swap(ComponentEntity &rhs)
     std::swap(this->mPimpl, rhs.mPimpl);
 }
 
+/**
+ * @brief Clear the parent of @p component if it is @p parent.
+ *
+ * To be called when @p component is removed from @p parent, so that it does
+ * not keep a pointer to @p parent, which may then be destroyed.  A component
+ * that has already been added somewhere else keeps its new parent.
+ *
+ * @param parent The component entity @p component is removed from.
+ * @param component The component removed.
+ */
+static void releaseComponent(ComponentEntity *parent, const ComponentPtr &component)
+{
+    if (component->parent() == dynamic_cast<void *>(parent)) {
+        component->clearParent();
+    }
+}
+
+/**
+ * @brief Set the parent of @p component to @p parent.
+ *
+ * To be called when @p component is put in @p parent other than through
+ * doAddComponent(), so that changes to @p component are seen by @p parent.
+ *
+ * @param parent The component entity @p component is put in.
+ * @param component The component put in @p parent.
+ */
+static void adoptComponent(ComponentEntity *parent, const ComponentPtr &component)
+{
+    auto model = dynamic_cast<Model *>(parent);
+    if (model != nullptr) {
+        component->setParent(model);
+    } else {
+        component->setParent(dynamic_cast<Component *>(parent));
+    }
+}
+
 void ComponentEntity::addComponent(const ComponentPtr &component)
 {
     doAddComponent(component);
@@ -97,6 +142,7 @@ void ComponentEntity::addComponent(const ComponentPtr &component)
 void ComponentEntity::doAddComponent(const ComponentPtr &component)
 {
     mPimpl->mComponents.push_back(component);
+    markModified();
 }
 
 bool ComponentEntity::removeComponent(const std::string &name, bool searchEncapsulated)
@@ -104,7 +150,9 @@ bool ComponentEntity::removeComponent(const std::string &name, bool searchEncaps
     bool status = false;
     auto result = mPimpl->findComponent(name);
     if (result != mPimpl->mComponents.end()) {
+        releaseComponent(this, *result);
         mPimpl->mComponents.erase(result);
+        markModified();
         status = true;
     } else if (searchEncapsulated) {
         for (size_t i = 0; i < componentCount() && !status; ++i) {
@@ -119,7 +167,9 @@ bool ComponentEntity::removeComponent(size_t index)
 {
     bool status = false;
     if (index < mPimpl->mComponents.size()) {
+        releaseComponent(this, mPimpl->mComponents.at(index));
         mPimpl->mComponents.erase(mPimpl->mComponents.begin() + int64_t(index));
+        markModified();
         status = true;
     }
 
@@ -131,7 +181,9 @@ bool ComponentEntity::removeComponent(const ComponentPtr &component, bool search
     bool status = false;
     auto result = mPimpl->findComponent(component);
     if (result != mPimpl->mComponents.end()) {
+        releaseComponent(this, *result);
         mPimpl->mComponents.erase(result);
+        markModified();
         status = true;
     } else if (searchEncapsulated) {
         for (size_t i = 0; i < componentCount() && !status; ++i) {
@@ -144,7 +196,11 @@ bool ComponentEntity::removeComponent(const ComponentPtr &component, bool search
 
 void ComponentEntity::removeAllComponents()
 {
+    for (const ComponentPtr &component : mPimpl->mComponents) {
+        releaseComponent(this, component);
+    }
     mPimpl->mComponents.clear();
+    markModified();
 }
 
 size_t ComponentEntity::componentCount() const
@@ -152,6 +208,31 @@ size_t ComponentEntity::componentCount() const
     return mPimpl->mComponents.size();
 }
 
+const std::vector<ComponentPtr> &ComponentEntity::components() const
+{
+    return mPimpl->mComponents;
+}
+
+void ComponentEntity::forEachComponent(const std::function<void(const ComponentPtr &)> &visitor) const
+{
+    // Iterate with an explicit stack of child lists, rather than recursing,
+    // so that deep encapsulation hierarchies cannot overflow the call stack.
+    std::vector<std::pair<const std::vector<ComponentPtr> *, size_t>> stack;
+    stack.emplace_back(&mPimpl->mComponents, 0);
+    while (!stack.empty()) {
+        auto &top = stack.back();
+        if (top.second == top.first->size()) {
+            stack.pop_back();
+            continue;
+        }
+        const ComponentPtr &component = (*top.first)[top.second++];
+        visitor(component);
+        if (component->componentCount() > 0) {
+            stack.emplace_back(&component->components(), 0);
+        }
+    }
+}
+
 bool ComponentEntity::containsComponent(const std::string &name, bool searchEncapsulated) const
 {
     bool status = false;
@@ -213,7 +294,8 @@ ComponentPtr ComponentEntity::takeComponent(size_t index)
     if (index < mPimpl->mComponents.size()) {
         component = mPimpl->mComponents.at(index);
         mPimpl->mComponents.erase(mPimpl->mComponents.begin() + int64_t(index));
-        component->clearParent();
+        releaseComponent(this, component);
+        markModified();
     }
 
     return component;
@@ -225,7 +307,9 @@ ComponentPtr ComponentEntity::takeComponent(const std::string &name, bool search
     auto result = mPimpl->findComponent(name);
     if (result != mPimpl->mComponents.end()) {
         foundComponent = *result;
+        releaseComponent(this, foundComponent);
         mPimpl->mComponents.erase(result);
+        markModified();
     } else if (searchEncapsulated) {
         for (size_t i = 0; i < componentCount() && !foundComponent; ++i) {
             foundComponent = ComponentEntity::component(i)->takeComponent(name, searchEncapsulated);
@@ -240,6 +324,8 @@ bool ComponentEntity::replaceComponent(size_t index, const ComponentPtr &compone
     bool status = false;
     if (removeComponent(index)) {
         mPimpl->mComponents.insert(mPimpl->mComponents.begin() + int64_t(index), component);
+        adoptComponent(this, component);
+        markModified();
         status = true;
     }
 
@@ -273,6 +359,7 @@ bool ComponentEntity::replaceComponent(const ComponentPtr &oldComponent, const C
 void ComponentEntity::setEncapsulationId(const std::string &id)
 {
     mPimpl->mEncapsulationId = id;
+    markModified();
 }
 
 std::string ComponentEntity::encapsulationId() const
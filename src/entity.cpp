@@ -14,12 +14,24 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include "arena.h"
+
 #include "libcellml/component.h"
 #include "libcellml/componententity.h"
 #include "libcellml/entity.h"
+#include "libcellml/model.h"
+
+#include <atomic>
 
 namespace libcellml {
 
+/**
+ * The last revision given to an entity.  Revisions are shared by all entities
+ * so that an entity that is destroyed and replaced by another one at the same
+ * address can never be mistaken for it.
+ */
+static std::atomic<size_t> lastRevision(0);
+
 /**
  * @brief The Entity::EntityImpl struct.
  *
@@ -30,10 +42,11 @@ struct Entity::EntityImpl
     Model *mParentModel = nullptr; /**< Pointer to parent model. */
     Component *mParentComponent = nullptr; /**< Pointer to component model. */
     std::string mId; /**< String document identifier for this entity. */
+    size_t mRevision = ++lastRevision; /**< Revision of this entity and of the entities it contains. */
 };
 
 Entity::Entity()
-    : mPimpl(new EntityImpl())
+    : mPimpl(newImpl<EntityImpl>())
 {
     mPimpl->mParentModel = nullptr;
     mPimpl->mParentComponent = nullptr;
@@ -41,14 +54,14 @@ Entity::Entity()
 
 Entity::~Entity()
 {
-    delete mPimpl;
+    deleteImpl(mPimpl);
 }
 
 Entity::Entity(const Entity &rhs)
-    : mPimpl(new EntityImpl())
+    : mPimpl(newImpl<EntityImpl>())
 {
-    mPimpl->mParentComponent = rhs.mPimpl->mParentComponent;
-    mPimpl->mParentModel = rhs.mPimpl->mParentModel;
+    // The copy is not contained in the parent of rhs, which would not clear
+    // the copy's pointer to it when destroyed.
     mPimpl->mId = rhs.mPimpl->mId;
 }
 
@@ -72,6 +85,7 @@ void Entity::swap(Entity &rhs)
 void Entity::setId(const std::string &id)
 {
     mPimpl->mId = id;
+    markModified();
 }
 
 std::string Entity::id() const
@@ -79,6 +93,21 @@ std::string Entity::id() const
     return mPimpl->mId;
 }
 
+size_t Entity::revision() const
+{
+    return mPimpl->mRevision;
+}
+
+void Entity::markModified()
+{
+    mPimpl->mRevision = ++lastRevision;
+    if (mPimpl->mParentComponent != nullptr) {
+        mPimpl->mParentComponent->markModified();
+    } else if (mPimpl->mParentModel != nullptr) {
+        mPimpl->mParentModel->markModified();
+    }
+}
+
 void *Entity::parent() const
 {
     void *parent = nullptr;
@@ -93,10 +122,12 @@ void *Entity::parent() const
 void Entity::setParent(Component *parent)
 {
     mPimpl->mParentComponent = parent;
+    mPimpl->mParentModel = nullptr;
 }
 
 void Entity::setParent(Model *parent)
 {
+    mPimpl->mParentComponent = nullptr;
     mPimpl->mParentModel = parent;
 }
 
@@ -0,0 +1,1946 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "bytecode.h"
+#include "mathast.h"
+#include "utilities.h"
+#include "vectormath.h"
+
+#include "libcellml/component.h"
+#include "libcellml/error.h"
+#include "libcellml/evaluator.h"
+#include "libcellml/model.h"
+#include "libcellml/reset.h"
+#include "libcellml/variable.h"
+#include "libcellml/when.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace libcellml {
+
+/**
+ * @brief The VariableClass struct.
+ *
+ * An internal structure gathering a set of equivalent variables, which all
+ * share a single value when the model is evaluated.
+ */
+struct VariableClass
+{
+    /**
+     * @brief The VariableClass::Kind enum class.
+     *
+     * The role the variables of a class play in the model.
+     */
+    enum class Kind
+    {
+        UNKNOWN,
+        VOI,
+        STATE,
+        CONSTANT,
+        COMPUTED_CONSTANT,
+        ALGEBRAIC
+    };
+
+    std::vector<VariablePtr> mVariables; /**< The equivalent variables, starting with the representative. */
+    std::vector<ComponentPtr> mComponents; /**< The components the variables belong to. */
+    Kind mKind = Kind::UNKNOWN; /**< The role of the variables. */
+    size_t mIndex = 0; /**< The index of the class in the state or variable array. */
+    double mInitialValue = 0.0; /**< The resolved initial value. */
+    bool mHasInitialValue = false; /**< Whether the class has an initial value. */
+    bool mReferenced = false; /**< Whether the class is used by any math. */
+    size_t mEquation = 0; /**< The index of the equation computing the class, if any. */
+    bool mHasEquation = false; /**< Whether the class is computed by an equation. */
+};
+
+/**
+ * @brief The Equation struct.
+ *
+ * An internal structure for an equation of the form @c variable = rhs or
+ * @c d(state)/d(voi) = rhs.
+ */
+struct Equation
+{
+    MathAstPtr mRhs; /**< The expression computing the value. */
+    MathAstPtr mSourceRhs; /**< The expression as written in the model. */
+    size_t mClass = 0; /**< The variable class being computed. */
+    bool mIsRate = false; /**< Whether the equation computes a rate. */
+    ComponentPtr mComponent; /**< The component the equation belongs to. */
+    bool mIsConstant = true; /**< Whether the equation only depends on constants. */
+    bool mNeededByRates = false; /**< Whether the rates depend on the equation. */
+    std::vector<size_t> mDependencies; /**< The equations this equation depends on. */
+};
+
+/**
+ * @brief The WhenTarget struct.
+ *
+ * An internal structure describing the variable a when of a reset assigns.
+ */
+struct WhenTarget
+{
+    size_t mReset = 0; /**< The position of the reset in reset order. */
+    bool mIsState = false; /**< Whether the reset variable is a state. */
+    size_t mIndex = 0; /**< The index of the reset variable in its array. */
+};
+
+/**
+ * @brief The Evaluator::EvaluatorImpl struct.
+ *
+ * The private implementation for the Evaluator class.
+ */
+struct Evaluator::EvaluatorImpl
+{
+    Evaluator *mEvaluator = nullptr;
+    bool mValid = false;
+
+    VariablePtr mVoi;
+    std::vector<VariablePtr> mStates;
+    std::vector<VariablePtr> mVariables;
+    std::vector<double> mStateInitialValues;
+    std::vector<double> mVariableInitialValues;
+
+    Program mComputedConstantsProgram;
+    Program mRatesProgram;
+    Program mVariablesProgram;
+    Program mConditionsProgram;
+    Program mResetValuesProgram;
+    std::vector<WhenTarget> mWhenTargets;
+    Program mGatingProgram;
+    std::vector<bool> mGatingStates;
+    std::vector<LookupTable> mLookupTables;
+    std::vector<double> mLookupTableErrors;
+    Program mJacobianProgram;
+    std::vector<std::pair<size_t, size_t>> mJacobianEntries;
+    size_t mRemovedOperationCount = 0;
+
+    // Lookup table settings, kept across models.
+    VariablePtr mLookupTableVariable = nullptr;
+    double mLookupTableMinimum = 0.0;
+    double mLookupTableMaximum = 0.0;
+    double mLookupTableStep = 0.0;
+
+    // Optimisation settings, kept across models.
+    bool mFoldConstantVariables = false;
+
+    // Analysis data, only valid while processing a model.
+    std::vector<ComponentPtr> mComponents;
+    std::vector<VariableClass> mClasses;
+    std::map<VariablePtr, size_t> mClassOf;
+    std::vector<Equation> mEquations;
+
+    void reset();
+    void addError(const std::string &description, const ComponentPtr &component, Error::Kind kind);
+    void gatherComponents(const ComponentEntityPtr &entity);
+    void gatherVariableClasses();
+    void gatherEquations();
+    void markReferences(const MathAstPtr &ast);
+    bool resolveInitialValue(size_t classIndex, std::vector<size_t> &visiting);
+    void classifyVariables();
+    void gatherDependencies(const MathAstPtr &ast, Equation &equation);
+    bool sortEquations(std::vector<size_t> &order);
+    void compilePrograms(const std::vector<size_t> &order);
+    void compileResets();
+    bool dependsOn(const MathAstPtr &ast, size_t classIndex, std::map<size_t, bool> &memo);
+    bool decomposeAffine(const MathAstPtr &ast, size_t classIndex, std::map<size_t, bool> &memo, MathAstPtr &a, MathAstPtr &b);
+    void compileGatingCoefficients();
+    bool isTabulable(const MathAstPtr &ast, size_t classIndex, bool &referenced, bool &expensive) const;
+    MathAstPtr tabulateNode(const MathAstPtr &ast, size_t classIndex, std::map<MathAstPtr, MathAstPtr> &memo);
+    void tabulateExpressions();
+    MathAstPtr intern(const MathAstPtr &ast, std::map<std::string, MathAstPtr> &nodes, std::map<MathAstPtr, MathAstPtr> &memo) const;
+    void internExpressions();
+    MathAstPtr differentiate(const MathAstPtr &ast, size_t classIndex, std::map<size_t, bool> &dependsMemo, std::map<size_t, MathAstPtr> &memo);
+    void compileJacobian();
+    bool compileMath(const std::string &math, const ComponentPtr &component, const VariableLoadMap &loads, OpCode store, size_t index, Program &program);
+    VariableLoadMap loads() const;
+    std::string variableName(size_t classIndex) const;
+};
+
+void Evaluator::EvaluatorImpl::reset()
+{
+    mValid = false;
+    mVoi = nullptr;
+    mStates.clear();
+    mVariables.clear();
+    mStateInitialValues.clear();
+    mVariableInitialValues.clear();
+    mComputedConstantsProgram = Program();
+    mRatesProgram = Program();
+    mVariablesProgram = Program();
+    mConditionsProgram = Program();
+    mResetValuesProgram = Program();
+    mWhenTargets.clear();
+    mGatingProgram = Program();
+    mGatingStates.clear();
+    mLookupTables.clear();
+    mLookupTableErrors.clear();
+    mJacobianProgram = Program();
+    mJacobianEntries.clear();
+    mRemovedOperationCount = 0;
+    mComponents.clear();
+    mClasses.clear();
+    mClassOf.clear();
+    mEquations.clear();
+}
+
+void Evaluator::EvaluatorImpl::addError(const std::string &description, const ComponentPtr &component, Error::Kind kind)
+{
+    ErrorPtr err = std::make_shared<Error>();
+    err->setDescription(description);
+    if (component != nullptr) {
+        err->setComponent(component);
+    }
+    err->setKind(kind);
+    mEvaluator->addError(err);
+}
+
+void Evaluator::EvaluatorImpl::gatherComponents(const ComponentEntityPtr &entity)
+{
+    for (size_t i = 0; i < entity->componentCount(); ++i) {
+        ComponentPtr component = entity->component(i);
+        if (component->isImport()) {
+            addError("Component '" + component->name() + "' is imported and cannot be evaluated until its import is resolved.", component, Error::Kind::IMPORT);
+            continue;
+        }
+        mComponents.push_back(component);
+        gatherComponents(component);
+    }
+}
+
+void Evaluator::EvaluatorImpl::gatherVariableClasses()
+{
+    std::map<VariablePtr, ComponentPtr> owners;
+    for (const ComponentPtr &component : mComponents) {
+        for (size_t i = 0; i < component->variableCount(); ++i) {
+            owners[component->variable(i)] = component;
+        }
+    }
+    for (const ComponentPtr &component : mComponents) {
+        for (size_t i = 0; i < component->variableCount(); ++i) {
+            VariablePtr variable = component->variable(i);
+            if (mClassOf.find(variable) != mClassOf.end()) {
+                continue;
+            }
+            size_t classIndex = mClasses.size();
+            mClasses.emplace_back();
+            VariableClass &variableClass = mClasses.back();
+            mClassOf[variable] = classIndex;
+            variableClass.mVariables.push_back(variable);
+            for (const VariablePtr &equivalent : Variable::equivalenceSet(variable)) {
+                if ((owners.find(equivalent) != owners.end()) && (mClassOf.find(equivalent) == mClassOf.end())) {
+                    mClassOf[equivalent] = classIndex;
+                    variableClass.mVariables.push_back(equivalent);
+                }
+            }
+            for (const VariablePtr &member : variableClass.mVariables) {
+                variableClass.mComponents.push_back(owners[member]);
+            }
+        }
+    }
+}
+
+void Evaluator::EvaluatorImpl::markReferences(const MathAstPtr &ast)
+{
+    if (ast->mType == MathAst::Type::CI) {
+        auto found = mClassOf.find(ast->mVariable);
+        if (found != mClassOf.end()) {
+            mClasses.at(found->second).mReferenced = true;
+        }
+    }
+    for (const MathAstPtr &child : ast->mChildren) {
+        markReferences(child);
+    }
+}
+
+void Evaluator::EvaluatorImpl::gatherEquations()
+{
+    for (const ComponentPtr &component : mComponents) {
+        std::vector<MathAstPtr> asts;
+        std::string error;
+        if (!parseMathAst(component->math(), component, asts, error)) {
+            addError("Math in component '" + component->name() + "' cannot be evaluated: " + error, component, Error::Kind::MATHML);
+            continue;
+        }
+        for (const MathAstPtr &ast : asts) {
+            markReferences(ast);
+            if ((ast->mType != MathAst::Type::EQ) || (ast->mChildren.size() != 2)) {
+                addError("Math in component '" + component->name() + "' contains an expression which is not an equation.", component, Error::Kind::MATHML);
+                continue;
+            }
+            MathAstPtr lhs = ast->mChildren.at(0);
+            MathAstPtr rhs = ast->mChildren.at(1);
+            VariablePtr variable;
+            VariablePtr bvar;
+            if ((lhs->mType != MathAst::Type::CI) && !isDerivative(lhs, variable, bvar)
+                && ((rhs->mType == MathAst::Type::CI) || isDerivative(rhs, variable, bvar))) {
+                std::swap(lhs, rhs);
+            }
+            Equation equation;
+            equation.mRhs = rhs;
+            equation.mSourceRhs = rhs;
+            equation.mComponent = component;
+            if (isDerivative(lhs, variable, bvar)) {
+                size_t voiClass = mClassOf.at(bvar);
+                VariableClass &voi = mClasses.at(voiClass);
+                if ((mVoi != nullptr) && (mClassOf.at(mVoi) != voiClass)) {
+                    addError("Math in component '" + component->name() + "' uses '" + bvar->name() + "' as a variable of integration but '" + mVoi->name() + "' is already the variable of integration.", component, Error::Kind::MATHML);
+                    continue;
+                }
+                mVoi = voi.mVariables.front();
+                voi.mKind = VariableClass::Kind::VOI;
+                equation.mIsRate = true;
+                equation.mClass = mClassOf.at(variable);
+            } else if (lhs->mType == MathAst::Type::CI) {
+                equation.mClass = mClassOf.at(lhs->mVariable);
+            } else {
+                addError("Math in component '" + component->name() + "' contains an equation which does not define a variable or a derivative on either side.", component, Error::Kind::MATHML);
+                continue;
+            }
+            VariableClass &variableClass = mClasses.at(equation.mClass);
+            if (variableClass.mHasEquation) {
+                addError("Variable '" + variableName(equation.mClass) + "' is computed by more than one equation.", component, Error::Kind::VARIABLE);
+                continue;
+            }
+            variableClass.mHasEquation = true;
+            variableClass.mEquation = mEquations.size();
+            if (equation.mIsRate) {
+                variableClass.mKind = VariableClass::Kind::STATE;
+            }
+            mEquations.push_back(equation);
+        }
+    }
+}
+
+std::string Evaluator::EvaluatorImpl::variableName(size_t classIndex) const
+{
+    const VariableClass &variableClass = mClasses.at(classIndex);
+    std::string name = variableClass.mVariables.front()->name();
+    ComponentPtr component = variableClass.mComponents.front();
+    if (component != nullptr) {
+        name += "' in component '" + component->name();
+    }
+    return name;
+}
+
+bool Evaluator::EvaluatorImpl::resolveInitialValue(size_t classIndex, std::vector<size_t> &visiting)
+{
+    VariableClass &variableClass = mClasses.at(classIndex);
+    if (variableClass.mHasInitialValue) {
+        return true;
+    }
+    for (size_t i = 0; i < variableClass.mVariables.size(); ++i) {
+        std::string initialValue = variableClass.mVariables.at(i)->initialValue();
+        if (initialValue.empty()) {
+            continue;
+        }
+        if (isCellMLReal(initialValue)) {
+            variableClass.mInitialValue = convertToDouble(initialValue);
+            variableClass.mHasInitialValue = true;
+            return true;
+        }
+        // The initial value references another variable in the same component.
+        ComponentPtr component = variableClass.mComponents.at(i);
+        VariablePtr reference = (component != nullptr) ? component->variable(initialValue) : nullptr;
+        if ((reference == nullptr) || (mClassOf.find(reference) == mClassOf.end())) {
+            addError("Variable '" + variableName(classIndex) + "' has an initial value '" + initialValue + "' which is neither a real number nor a variable.", component, Error::Kind::VARIABLE);
+            return false;
+        }
+        size_t referenceClass = mClassOf.at(reference);
+        if (std::find(visiting.begin(), visiting.end(), referenceClass) != visiting.end()) {
+            addError("Variable '" + variableName(classIndex) + "' has an initial value which refers back to itself.", component, Error::Kind::VARIABLE);
+            return false;
+        }
+        visiting.push_back(referenceClass);
+        if (mClasses.at(referenceClass).mHasEquation || !resolveInitialValue(referenceClass, visiting)) {
+            addError("Variable '" + variableName(classIndex) + "' has an initial value '" + initialValue + "' which does not refer to a constant.", component, Error::Kind::VARIABLE);
+            return false;
+        }
+        variableClass.mInitialValue = mClasses.at(referenceClass).mInitialValue;
+        variableClass.mHasInitialValue = true;
+        return true;
+    }
+    return false;
+}
+
+void Evaluator::EvaluatorImpl::classifyVariables()
+{
+    for (size_t i = 0; i < mClasses.size(); ++i) {
+        VariableClass &variableClass = mClasses.at(i);
+        bool hasInitialValue = false;
+        for (const VariablePtr &variable : variableClass.mVariables) {
+            if (!variable->initialValue().empty()) {
+                hasInitialValue = true;
+            }
+        }
+        std::vector<size_t> visiting = {i};
+        if (hasInitialValue) {
+            resolveInitialValue(i, visiting);
+        }
+        ComponentPtr component = variableClass.mComponents.front();
+        if (variableClass.mKind == VariableClass::Kind::VOI) {
+            if (variableClass.mHasEquation) {
+                addError("Variable '" + variableName(i) + "' is the variable of integration but is also computed by an equation.", component, Error::Kind::VARIABLE);
+            }
+        } else if (variableClass.mKind == VariableClass::Kind::STATE) {
+            if (!hasInitialValue) {
+                addError("State variable '" + variableName(i) + "' does not have an initial value.", component, Error::Kind::VARIABLE);
+            }
+        } else if (variableClass.mHasEquation) {
+            if (hasInitialValue) {
+                addError("Variable '" + variableName(i) + "' is computed by an equation and also has an initial value.", component, Error::Kind::VARIABLE);
+            }
+            variableClass.mKind = VariableClass::Kind::ALGEBRAIC;
+        } else if (hasInitialValue) {
+            variableClass.mKind = VariableClass::Kind::CONSTANT;
+        } else if (variableClass.mReferenced) {
+            addError("Variable '" + variableName(i) + "' is not computed by any equation and does not have an initial value.", component, Error::Kind::VARIABLE);
+        }
+    }
+}
+
+void Evaluator::EvaluatorImpl::gatherDependencies(const MathAstPtr &ast, Equation &equation)
+{
+    VariablePtr variable;
+    VariablePtr bvar;
+    if (isDerivative(ast, variable, bvar)) {
+        const VariableClass &variableClass = mClasses.at(mClassOf.at(variable));
+        equation.mIsConstant = false;
+        if (variableClass.mHasEquation) {
+            equation.mDependencies.push_back(variableClass.mEquation);
+        }
+        return;
+    }
+    if (ast->mType == MathAst::Type::CI) {
+        const VariableClass &variableClass = mClasses.at(mClassOf.at(ast->mVariable));
+        if ((variableClass.mKind == VariableClass::Kind::VOI) || (variableClass.mKind == VariableClass::Kind::STATE)) {
+            equation.mIsConstant = false;
+        } else if (variableClass.mHasEquation) {
+            equation.mDependencies.push_back(variableClass.mEquation);
+        }
+    }
+    for (const MathAstPtr &child : ast->mChildren) {
+        gatherDependencies(child, equation);
+    }
+}
+
+bool Evaluator::EvaluatorImpl::sortEquations(std::vector<size_t> &order)
+{
+    // Depth first topological sort, marking equations as unvisited (0),
+    // in progress (1) or done (2).
+    std::vector<int> marks(mEquations.size(), 0);
+    bool sorted = true;
+    for (size_t start = 0; start < mEquations.size(); ++start) {
+        if (marks.at(start) != 0) {
+            continue;
+        }
+        std::vector<std::pair<size_t, size_t>> stack = {{start, 0}};
+        marks.at(start) = 1;
+        while (!stack.empty()) {
+            size_t current = stack.back().first;
+            size_t &next = stack.back().second;
+            Equation &equation = mEquations.at(current);
+            if (next < equation.mDependencies.size()) {
+                size_t dependency = equation.mDependencies.at(next++);
+                if (marks.at(dependency) == 0) {
+                    marks.at(dependency) = 1;
+                    stack.emplace_back(dependency, 0);
+                } else if (marks.at(dependency) == 1) {
+                    addError("Variable '" + variableName(mEquations.at(dependency).mClass) + "' is part of an algebraic loop, which cannot be evaluated.", mEquations.at(dependency).mComponent, Error::Kind::MATHML);
+                    sorted = false;
+                }
+            } else {
+                for (size_t dependency : equation.mDependencies) {
+                    equation.mIsConstant = equation.mIsConstant && mEquations.at(dependency).mIsConstant;
+                }
+                if (equation.mIsRate) {
+                    equation.mIsConstant = false;
+                }
+                marks.at(current) = 2;
+                order.push_back(current);
+                stack.pop_back();
+            }
+        }
+    }
+    return sorted;
+}
+
+VariableLoadMap Evaluator::EvaluatorImpl::loads() const
+{
+    VariableLoadMap loads;
+    for (const VariableClass &variableClass : mClasses) {
+        Instruction instruction;
+        instruction.mIndex = variableClass.mIndex;
+        switch (variableClass.mKind) {
+        case VariableClass::Kind::VOI:
+            instruction.mOpCode = OpCode::LOAD_VOI;
+            break;
+        case VariableClass::Kind::STATE:
+            instruction.mOpCode = OpCode::LOAD_STATE;
+            break;
+        case VariableClass::Kind::CONSTANT:
+        case VariableClass::Kind::COMPUTED_CONSTANT:
+        case VariableClass::Kind::ALGEBRAIC:
+            instruction.mOpCode = OpCode::LOAD_VARIABLE;
+            break;
+        case VariableClass::Kind::UNKNOWN:
+            continue;
+        }
+        for (const VariablePtr &variable : variableClass.mVariables) {
+            loads[variable] = instruction;
+        }
+    }
+    return loads;
+}
+
+/**
+ * @brief Count the instructions of @p program that compute something, as
+ * opposed to moving values around.
+ */
+static size_t operationCount(const Program &program)
+{
+    size_t count = 0;
+    for (const Instruction &instruction : program.mInstructions) {
+        switch (instruction.mOpCode) {
+        case OpCode::LOAD_CONSTANT:
+        case OpCode::LOAD_VOI:
+        case OpCode::LOAD_STATE:
+        case OpCode::LOAD_RATE:
+        case OpCode::LOAD_VARIABLE:
+        case OpCode::STORE_RATE:
+        case OpCode::STORE_VARIABLE:
+        case OpCode::STORE_RESULT:
+        case OpCode::LOAD_TEMPORARY:
+        case OpCode::SAVE_TEMPORARY:
+            break;
+        default:
+            ++count;
+        }
+    }
+    return count;
+}
+
+void Evaluator::EvaluatorImpl::compilePrograms(const std::vector<size_t> &order)
+{
+    // Assign array indices: states, then constants, computed constants and
+    // algebraic variables.
+    for (VariableClass &variableClass : mClasses) {
+        if (variableClass.mKind == VariableClass::Kind::STATE) {
+            variableClass.mIndex = mStates.size();
+            mStates.push_back(variableClass.mVariables.front());
+            mStateInitialValues.push_back(variableClass.mInitialValue);
+        }
+    }
+    for (size_t equationIndex : order) {
+        const Equation &equation = mEquations.at(equationIndex);
+        if (!equation.mIsRate && equation.mIsConstant) {
+            mClasses.at(equation.mClass).mKind = VariableClass::Kind::COMPUTED_CONSTANT;
+        }
+    }
+    for (auto kind : {VariableClass::Kind::CONSTANT, VariableClass::Kind::COMPUTED_CONSTANT, VariableClass::Kind::ALGEBRAIC}) {
+        for (VariableClass &variableClass : mClasses) {
+            if (variableClass.mKind == kind) {
+                variableClass.mIndex = mVariables.size();
+                mVariables.push_back(variableClass.mVariables.front());
+                mVariableInitialValues.push_back(variableClass.mInitialValue);
+            }
+        }
+    }
+
+    // Mark the equations needed to compute the rates.
+    for (auto equation = order.rbegin(); equation != order.rend(); ++equation) {
+        Equation &current = mEquations.at(*equation);
+        if (current.mIsRate) {
+            current.mNeededByRates = true;
+        }
+        if (current.mNeededByRates) {
+            for (size_t dependency : current.mDependencies) {
+                mEquations.at(dependency).mNeededByRates = true;
+            }
+        }
+    }
+
+    std::vector<std::pair<Program *, size_t>> compilations;
+    for (size_t equationIndex : order) {
+        const Equation &equation = mEquations.at(equationIndex);
+        if (equation.mIsRate) {
+            compilations.emplace_back(&mRatesProgram, equationIndex);
+        } else if (equation.mIsConstant) {
+            compilations.emplace_back(&mComputedConstantsProgram, equationIndex);
+        } else {
+            if (equation.mNeededByRates) {
+                compilations.emplace_back(&mRatesProgram, equationIndex);
+            }
+            compilations.emplace_back(&mVariablesProgram, equationIndex);
+        }
+    }
+    std::map<Program *, std::vector<MathAstPtr>> expressions;
+    for (const auto &compilation : compilations) {
+        expressions[compilation.first].push_back(mEquations.at(compilation.second).mRhs);
+    }
+    std::map<Program *, SharedExpressions> shared;
+    for (const auto &entry : expressions) {
+        findSharedExpressions(entry.second, shared[entry.first]);
+    }
+
+    VariableLoadMap variableLoads = loads();
+    Program unoptimised;
+    for (const auto &compilation : compilations) {
+        Program &program = *compilation.first;
+        const Equation &equation = mEquations.at(compilation.second);
+        std::string error;
+        if (!compileExpression(equation.mRhs, variableLoads, program, error, &shared[&program])) {
+            addError("Equation for variable '" + variableName(equation.mClass) + "' cannot be evaluated: " + error, equation.mComponent, Error::Kind::MATHML);
+            return;
+        }
+        compileStore(equation.mIsRate ? OpCode::STORE_RATE : OpCode::STORE_VARIABLE, mClasses.at(equation.mClass).mIndex, program);
+        compileExpression(equation.mSourceRhs, variableLoads, unoptimised, error);
+    }
+    mRemovedOperationCount = operationCount(unoptimised) - operationCount(mComputedConstantsProgram)
+                             - operationCount(mRatesProgram) - operationCount(mVariablesProgram);
+}
+
+bool Evaluator::EvaluatorImpl::compileMath(const std::string &math, const ComponentPtr &component, const VariableLoadMap &loads, OpCode store, size_t index, Program &program)
+{
+    std::vector<MathAstPtr> asts;
+    std::string error;
+    if (parseMathAst(math, component, asts, error)) {
+        if (asts.size() == 1) {
+            if (compileExpression(asts.front(), loads, program, error)) {
+                compileStore(store, index, program);
+                return true;
+            }
+        } else {
+            error = "it does not contain exactly one expression.";
+        }
+    }
+    addError("Math of a when in component '" + component->name() + "' cannot be evaluated: " + error, component, Error::Kind::WHEN);
+    return false;
+}
+
+void Evaluator::EvaluatorImpl::compileResets()
+{
+    struct ResetEntry
+    {
+        int mOrder;
+        ResetPtr mReset;
+        ComponentPtr mComponent;
+    };
+    std::vector<ResetEntry> resets;
+    for (const ComponentPtr &component : mComponents) {
+        for (size_t i = 0; i < component->resetCount(); ++i) {
+            ResetPtr reset = component->reset(i);
+            resets.push_back({reset->order(), reset, component});
+        }
+    }
+    std::stable_sort(resets.begin(), resets.end(), [](const ResetEntry &a, const ResetEntry &b) { return a.mOrder < b.mOrder; });
+
+    VariableLoadMap variableLoads = loads();
+    for (size_t r = 0; r < resets.size(); ++r) {
+        const ResetEntry &entry = resets.at(r);
+        VariablePtr variable = entry.mReset->variable();
+        auto found = mClassOf.find(variable);
+        if ((variable == nullptr) || (found == mClassOf.end())) {
+            addError("Reset in component '" + entry.mComponent->name() + "' does not reference a variable of the model.", entry.mComponent, Error::Kind::RESET);
+            continue;
+        }
+        const VariableClass &variableClass = mClasses.at(found->second);
+        if ((variableClass.mKind != VariableClass::Kind::STATE) && (variableClass.mKind != VariableClass::Kind::CONSTANT)) {
+            addError("Reset in component '" + entry.mComponent->name() + "' references variable '" + variable->name() + "', which is neither a state variable nor a constant.", entry.mComponent, Error::Kind::RESET);
+            continue;
+        }
+        std::vector<WhenPtr> whens;
+        for (size_t i = 0; i < entry.mReset->whenCount(); ++i) {
+            whens.push_back(entry.mReset->when(i));
+        }
+        std::stable_sort(whens.begin(), whens.end(), [](const WhenPtr &a, const WhenPtr &b) { return a->order() < b->order(); });
+        for (const WhenPtr &when : whens) {
+            WhenTarget target;
+            target.mReset = r;
+            target.mIsState = variableClass.mKind == VariableClass::Kind::STATE;
+            target.mIndex = variableClass.mIndex;
+            size_t whenIndex = mWhenTargets.size();
+            if (compileMath(when->condition(), entry.mComponent, variableLoads, OpCode::STORE_RESULT, whenIndex, mConditionsProgram)
+                && compileMath(when->value(), entry.mComponent, variableLoads, OpCode::STORE_RESULT, whenIndex, mResetValuesProgram)) {
+                mWhenTargets.push_back(target);
+            }
+        }
+    }
+}
+
+bool Evaluator::EvaluatorImpl::dependsOn(const MathAstPtr &ast, size_t classIndex, std::map<size_t, bool> &memo)
+{
+    VariablePtr variable;
+    VariablePtr bvar;
+    VariablePtr referenced = nullptr;
+    if (isDerivative(ast, variable, bvar)) {
+        referenced = variable;
+    } else if (ast->mType == MathAst::Type::CI) {
+        referenced = ast->mVariable;
+    }
+    if (referenced != nullptr) {
+        size_t referencedClass = mClassOf.at(referenced);
+        if (referencedClass == classIndex) {
+            return true;
+        }
+        const VariableClass &variableClass = mClasses.at(referencedClass);
+        // A rate depends on whatever its equation depends on, as does an
+        // algebraic variable, whereas a state value is independent.
+        bool follow = (ast->mType == MathAst::Type::DIFF) || (variableClass.mKind == VariableClass::Kind::ALGEBRAIC);
+        if (!follow || !variableClass.mHasEquation) {
+            return false;
+        }
+        auto found = memo.find(variableClass.mEquation);
+        if (found == memo.end()) {
+            bool depends = dependsOn(mEquations.at(variableClass.mEquation).mRhs, classIndex, memo);
+            found = memo.emplace(variableClass.mEquation, depends).first;
+        }
+        return found->second;
+    }
+    for (const MathAstPtr &child : ast->mChildren) {
+        if (dependsOn(child, classIndex, memo)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Helpers building the terms of an affine decomposition, in which a
+ * @c nullptr stands for zero.
+ */
+static MathAstPtr affineAdd(const MathAstPtr &x, const MathAstPtr &y)
+{
+    if (x == nullptr) {
+        return y;
+    }
+    if (y == nullptr) {
+        return x;
+    }
+    return createMathAstNode(MathAst::Type::PLUS, {x, y});
+}
+
+static MathAstPtr affineNegate(const MathAstPtr &x)
+{
+    return (x == nullptr) ? nullptr : createMathAstNode(MathAst::Type::MINUS, {x});
+}
+
+static MathAstPtr affineScale(const MathAstPtr &x, MathAst::Type type, const std::vector<MathAstPtr> &factors)
+{
+    if ((x == nullptr) || factors.empty()) {
+        return x;
+    }
+    std::vector<MathAstPtr> children = {x};
+    children.insert(children.end(), factors.begin(), factors.end());
+    return createMathAstNode(type, children);
+}
+
+static MathAstPtr affineValue(const MathAstPtr &x)
+{
+    return (x == nullptr) ? createMathAstNumber(0.0) : x;
+}
+
+bool Evaluator::EvaluatorImpl::decomposeAffine(const MathAstPtr &ast, size_t classIndex, std::map<size_t, bool> &memo, MathAstPtr &a, MathAstPtr &b)
+{
+    a = nullptr;
+    b = nullptr;
+    if (!dependsOn(ast, classIndex, memo)) {
+        a = ast;
+        return true;
+    }
+    switch (ast->mType) {
+    case MathAst::Type::CI: {
+        size_t referencedClass = mClassOf.at(ast->mVariable);
+        if (referencedClass == classIndex) {
+            b = createMathAstNumber(1.0);
+            return true;
+        }
+        // An algebraic variable which depends on the state, so inline it.
+        const VariableClass &variableClass = mClasses.at(referencedClass);
+        return decomposeAffine(mEquations.at(variableClass.mEquation).mRhs, classIndex, memo, a, b);
+    }
+    case MathAst::Type::PLUS:
+        for (const MathAstPtr &child : ast->mChildren) {
+            MathAstPtr childA;
+            MathAstPtr childB;
+            if (!decomposeAffine(child, classIndex, memo, childA, childB)) {
+                return false;
+            }
+            a = affineAdd(a, childA);
+            b = affineAdd(b, childB);
+        }
+        return true;
+    case MathAst::Type::MINUS: {
+        MathAstPtr firstA;
+        MathAstPtr firstB;
+        if ((ast->mChildren.empty()) || (ast->mChildren.size() > 2)
+            || !decomposeAffine(ast->mChildren.at(0), classIndex, memo, firstA, firstB)) {
+            return false;
+        }
+        if (ast->mChildren.size() == 1) {
+            a = affineNegate(firstA);
+            b = affineNegate(firstB);
+            return true;
+        }
+        MathAstPtr secondA;
+        MathAstPtr secondB;
+        if (!decomposeAffine(ast->mChildren.at(1), classIndex, memo, secondA, secondB)) {
+            return false;
+        }
+        a = affineAdd(firstA, affineNegate(secondA));
+        b = affineAdd(firstB, affineNegate(secondB));
+        return true;
+    }
+    case MathAst::Type::TIMES: {
+        // Only one factor may depend on the state.
+        MathAstPtr dependent = nullptr;
+        std::vector<MathAstPtr> factors;
+        for (const MathAstPtr &child : ast->mChildren) {
+            if (dependsOn(child, classIndex, memo)) {
+                if (dependent != nullptr) {
+                    return false;
+                }
+                dependent = child;
+            } else {
+                factors.push_back(child);
+            }
+        }
+        if (!decomposeAffine(dependent, classIndex, memo, a, b)) {
+            return false;
+        }
+        a = affineScale(a, MathAst::Type::TIMES, factors);
+        b = affineScale(b, MathAst::Type::TIMES, factors);
+        return true;
+    }
+    case MathAst::Type::DIVIDE:
+        if ((ast->mChildren.size() != 2) || dependsOn(ast->mChildren.at(1), classIndex, memo)
+            || !decomposeAffine(ast->mChildren.at(0), classIndex, memo, a, b)) {
+            return false;
+        }
+        a = affineScale(a, MathAst::Type::DIVIDE, {ast->mChildren.at(1)});
+        b = affineScale(b, MathAst::Type::DIVIDE, {ast->mChildren.at(1)});
+        return true;
+    case MathAst::Type::PIECEWISE: {
+        std::vector<MathAstPtr> aPieces;
+        std::vector<MathAstPtr> bPieces;
+        for (const MathAstPtr &child : ast->mChildren) {
+            MathAstPtr childA;
+            MathAstPtr childB;
+            if (!decomposeAffine(child->mChildren.at(0), classIndex, memo, childA, childB)) {
+                return false;
+            }
+            if (child->mType == MathAst::Type::PIECE) {
+                MathAstPtr condition = child->mChildren.at(1);
+                if (dependsOn(condition, classIndex, memo)) {
+                    return false;
+                }
+                aPieces.push_back(createMathAstNode(MathAst::Type::PIECE, {affineValue(childA), condition}));
+                bPieces.push_back(createMathAstNode(MathAst::Type::PIECE, {affineValue(childB), condition}));
+            } else {
+                aPieces.push_back(createMathAstNode(MathAst::Type::OTHERWISE, {affineValue(childA)}));
+                bPieces.push_back(createMathAstNode(MathAst::Type::OTHERWISE, {affineValue(childB)}));
+            }
+        }
+        a = createMathAstNode(MathAst::Type::PIECEWISE, aPieces);
+        b = createMathAstNode(MathAst::Type::PIECEWISE, bPieces);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+void Evaluator::EvaluatorImpl::compileGatingCoefficients()
+{
+    mGatingStates.assign(mStates.size(), false);
+    VariableLoadMap variableLoads = loads();
+    for (const Equation &equation : mEquations) {
+        if (!equation.mIsRate) {
+            continue;
+        }
+        std::map<size_t, bool> memo;
+        MathAstPtr a;
+        MathAstPtr b;
+        if (!decomposeAffine(equation.mRhs, equation.mClass, memo, a, b) || (b == nullptr)) {
+            continue;
+        }
+        size_t index = mClasses.at(equation.mClass).mIndex;
+        Program program = mGatingProgram;
+        std::string error;
+        if (compileExpression(affineValue(a), variableLoads, program, error)) {
+            compileStore(OpCode::STORE_RESULT, 2 * index, program);
+            if (compileExpression(b, variableLoads, program, error)) {
+                compileStore(OpCode::STORE_RESULT, 2 * index + 1, program);
+                mGatingProgram = program;
+                mGatingStates.at(index) = true;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Helpers building derivative expressions, in which a @c nullptr
+ * stands for zero.
+ */
+static MathAstPtr derivativeTimes(const std::vector<MathAstPtr> &factors)
+{
+    for (const MathAstPtr &factor : factors) {
+        if (factor == nullptr) {
+            return nullptr;
+        }
+    }
+    return createMathAstNode(MathAst::Type::TIMES, factors);
+}
+
+static MathAstPtr derivativeDivide(const MathAstPtr &x, const MathAstPtr &y)
+{
+    return (x == nullptr) ? nullptr : createMathAstNode(MathAst::Type::DIVIDE, {x, y});
+}
+
+static MathAstPtr number(double value)
+{
+    return createMathAstNumber(value);
+}
+
+static MathAstPtr node(MathAst::Type type, const std::vector<MathAstPtr> &children)
+{
+    return createMathAstNode(type, children);
+}
+
+static MathAstPtr square(const MathAstPtr &x)
+{
+    return node(MathAst::Type::POWER, {x, number(2.0)});
+}
+
+/**
+ * @brief Build the expression truncating @p x towards zero.
+ */
+static MathAstPtr truncate(const MathAstPtr &x)
+{
+    return node(MathAst::Type::PIECEWISE,
+                {node(MathAst::Type::PIECE, {node(MathAst::Type::FLOOR, {x}), node(MathAst::Type::GEQ, {x, number(0.0)})}),
+                 node(MathAst::Type::OTHERWISE, {node(MathAst::Type::CEILING, {x})})});
+}
+
+/**
+ * @brief Differentiate @p ast with respect to the state variable class
+ * @p classIndex.
+ *
+ * Algebraic variables and rates used by @p ast are differentiated through
+ * their equations, whose derivatives are cached in @p memo.  The conditions
+ * of piecewise expressions, and the results of relational, logical and
+ * rounding operators, are considered piecewise constant.
+ *
+ * @return The derivative of @p ast, or @c nullptr if it is zero.
+ */
+MathAstPtr Evaluator::EvaluatorImpl::differentiate(const MathAstPtr &ast, size_t classIndex, std::map<size_t, bool> &dependsMemo, std::map<size_t, MathAstPtr> &memo)
+{
+    if (!dependsOn(ast, classIndex, dependsMemo)) {
+        return nullptr;
+    }
+    VariablePtr variable;
+    VariablePtr bvar;
+    bool isRate = isDerivative(ast, variable, bvar);
+    if (isRate || (ast->mType == MathAst::Type::CI)) {
+        size_t referencedClass = mClassOf.at(isRate ? variable : ast->mVariable);
+        if (!isRate && (referencedClass == classIndex)) {
+            return number(1.0);
+        }
+        size_t equation = mClasses.at(referencedClass).mEquation;
+        auto found = memo.find(equation);
+        if (found == memo.end()) {
+            MathAstPtr derivative = differentiate(mEquations.at(equation).mRhs, classIndex, dependsMemo, memo);
+            found = memo.emplace(equation, derivative).first;
+        }
+        return found->second;
+    }
+
+    std::vector<MathAstPtr> arguments;
+    for (const MathAstPtr &child : ast->mChildren) {
+        if ((child->mType != MathAst::Type::BVAR)
+            && (child->mType != MathAst::Type::DEGREE)
+            && (child->mType != MathAst::Type::LOGBASE)) {
+            arguments.push_back(child);
+        }
+    }
+    auto d = [&](const MathAstPtr &x) {
+        return differentiate(x, classIndex, dependsMemo, memo);
+    };
+    MathAstPtr u = arguments.empty() ? nullptr : arguments.front();
+    MathAstPtr du = (u == nullptr) ? nullptr : d(u);
+
+    switch (ast->mType) {
+    case MathAst::Type::LOOKUP:
+        return d(ast->mChildren.at(1));
+    case MathAst::Type::PLUS: {
+        MathAstPtr result = nullptr;
+        for (const MathAstPtr &argument : arguments) {
+            result = affineAdd(result, d(argument));
+        }
+        return result;
+    }
+    case MathAst::Type::MINUS:
+        if (arguments.size() == 1) {
+            return affineNegate(du);
+        }
+        return affineAdd(du, affineNegate(d(arguments.at(1))));
+    case MathAst::Type::TIMES: {
+        MathAstPtr result = nullptr;
+        for (size_t i = 0; i < arguments.size(); ++i) {
+            std::vector<MathAstPtr> factors = {d(arguments.at(i))};
+            for (size_t j = 0; j < arguments.size(); ++j) {
+                if (j != i) {
+                    factors.push_back(arguments.at(j));
+                }
+            }
+            result = affineAdd(result, derivativeTimes(factors));
+        }
+        return result;
+    }
+    case MathAst::Type::DIVIDE: {
+        MathAstPtr v = arguments.at(1);
+        MathAstPtr dv = d(v);
+        return affineAdd(derivativeDivide(du, v),
+                         affineNegate(derivativeDivide(derivativeTimes({u, dv}), square(v))));
+    }
+    case MathAst::Type::POWER: {
+        MathAstPtr v = arguments.at(1);
+        MathAstPtr dv = d(v);
+        MathAstPtr power = node(MathAst::Type::POWER, {u, node(MathAst::Type::MINUS, {v, number(1.0)})});
+        return affineAdd(derivativeTimes({du, v, power}),
+                         derivativeTimes({dv, ast, node(MathAst::Type::LN, {u})}));
+    }
+    case MathAst::Type::ROOT: {
+        MathAstPtr degree = nullptr;
+        for (const MathAstPtr &child : ast->mChildren) {
+            if ((child->mType == MathAst::Type::DEGREE) && (child->mChildren.size() == 1)) {
+                degree = child->mChildren.at(0);
+            }
+        }
+        MathAstPtr exponent = node(MathAst::Type::DIVIDE, {number(1.0), (degree == nullptr) ? number(2.0) : degree});
+        return d(node(MathAst::Type::POWER, {u, exponent}));
+    }
+    case MathAst::Type::ABS:
+        return node(MathAst::Type::PIECEWISE,
+                    {node(MathAst::Type::PIECE, {affineValue(affineNegate(du)), node(MathAst::Type::LT, {u, number(0.0)})}),
+                     node(MathAst::Type::OTHERWISE, {affineValue(du)})});
+    case MathAst::Type::EXP:
+        return derivativeTimes({du, ast});
+    case MathAst::Type::LN:
+        return derivativeDivide(du, u);
+    case MathAst::Type::LOG: {
+        MathAstPtr base = nullptr;
+        for (const MathAstPtr &child : ast->mChildren) {
+            if ((child->mType == MathAst::Type::LOGBASE) && (child->mChildren.size() == 1)) {
+                base = child->mChildren.at(0);
+            }
+        }
+        return d(node(MathAst::Type::DIVIDE, {node(MathAst::Type::LN, {u}), node(MathAst::Type::LN, {(base == nullptr) ? number(10.0) : base})}));
+    }
+    case MathAst::Type::MIN:
+    case MathAst::Type::MAX: {
+        if (arguments.size() == 1) {
+            return du;
+        }
+        // Fold into binary operations, selecting the derivative of the
+        // argument that is the result.
+        MathAstPtr left = node(ast->mType, std::vector<MathAstPtr>(arguments.begin(), arguments.end() - 1));
+        MathAstPtr right = arguments.back();
+        MathAstPtr dLeft = d(left);
+        MathAstPtr dRight = d(right);
+        MathAst::Type comparison = (ast->mType == MathAst::Type::MIN) ? MathAst::Type::LEQ : MathAst::Type::GEQ;
+        return node(MathAst::Type::PIECEWISE,
+                    {node(MathAst::Type::PIECE, {affineValue(dLeft), node(comparison, {left, right})}),
+                     node(MathAst::Type::OTHERWISE, {affineValue(dRight)})});
+    }
+    case MathAst::Type::REM: {
+        MathAstPtr v = arguments.at(1);
+        MathAstPtr dv = d(v);
+        return affineAdd(du, affineNegate(derivativeTimes({dv, truncate(node(MathAst::Type::DIVIDE, {u, v}))})));
+    }
+    case MathAst::Type::PIECEWISE: {
+        std::vector<MathAstPtr> pieces;
+        bool zero = true;
+        bool hasOtherwise = false;
+        for (const MathAstPtr &child : ast->mChildren) {
+            MathAstPtr value = d(child->mChildren.at(0));
+            zero = zero && (value == nullptr);
+            if (child->mType == MathAst::Type::PIECE) {
+                pieces.push_back(node(MathAst::Type::PIECE, {affineValue(value), child->mChildren.at(1)}));
+            } else {
+                pieces.push_back(node(MathAst::Type::OTHERWISE, {affineValue(value)}));
+                hasOtherwise = true;
+            }
+        }
+        if (zero) {
+            return nullptr;
+        }
+        if (!hasOtherwise) {
+            pieces.push_back(node(MathAst::Type::OTHERWISE, {node(MathAst::Type::NOT_A_NUMBER, {})}));
+        }
+        return node(MathAst::Type::PIECEWISE, pieces);
+    }
+    case MathAst::Type::SIN:
+        return derivativeTimes({du, node(MathAst::Type::COS, {u})});
+    case MathAst::Type::COS:
+        return affineNegate(derivativeTimes({du, node(MathAst::Type::SIN, {u})}));
+    case MathAst::Type::TAN:
+        return derivativeDivide(du, square(node(MathAst::Type::COS, {u})));
+    case MathAst::Type::SEC:
+        return derivativeTimes({du, ast, node(MathAst::Type::TAN, {u})});
+    case MathAst::Type::CSC:
+        return affineNegate(derivativeTimes({du, ast, node(MathAst::Type::COT, {u})}));
+    case MathAst::Type::COT:
+        return affineNegate(derivativeDivide(du, square(node(MathAst::Type::SIN, {u}))));
+    case MathAst::Type::SINH:
+        return derivativeTimes({du, node(MathAst::Type::COSH, {u})});
+    case MathAst::Type::COSH:
+        return derivativeTimes({du, node(MathAst::Type::SINH, {u})});
+    case MathAst::Type::TANH:
+        return derivativeDivide(du, square(node(MathAst::Type::COSH, {u})));
+    case MathAst::Type::SECH:
+        return affineNegate(derivativeTimes({du, ast, node(MathAst::Type::TANH, {u})}));
+    case MathAst::Type::CSCH:
+        return affineNegate(derivativeTimes({du, ast, node(MathAst::Type::COTH, {u})}));
+    case MathAst::Type::COTH:
+        return affineNegate(derivativeDivide(du, square(node(MathAst::Type::SINH, {u}))));
+    case MathAst::Type::ARCSIN:
+        return derivativeDivide(du, node(MathAst::Type::ROOT, {node(MathAst::Type::MINUS, {number(1.0), square(u)})}));
+    case MathAst::Type::ARCCOS:
+        return affineNegate(derivativeDivide(du, node(MathAst::Type::ROOT, {node(MathAst::Type::MINUS, {number(1.0), square(u)})})));
+    case MathAst::Type::ARCTAN:
+        return derivativeDivide(du, node(MathAst::Type::PLUS, {number(1.0), square(u)}));
+    case MathAst::Type::ARCSEC:
+        return derivativeDivide(du, node(MathAst::Type::TIMES, {node(MathAst::Type::ABS, {u}), node(MathAst::Type::ROOT, {node(MathAst::Type::MINUS, {square(u), number(1.0)})})}));
+    case MathAst::Type::ARCCSC:
+        return affineNegate(derivativeDivide(du, node(MathAst::Type::TIMES, {node(MathAst::Type::ABS, {u}), node(MathAst::Type::ROOT, {node(MathAst::Type::MINUS, {square(u), number(1.0)})})})));
+    case MathAst::Type::ARCCOT:
+        return affineNegate(derivativeDivide(du, node(MathAst::Type::PLUS, {number(1.0), square(u)})));
+    case MathAst::Type::ARCSINH:
+        return derivativeDivide(du, node(MathAst::Type::ROOT, {node(MathAst::Type::PLUS, {square(u), number(1.0)})}));
+    case MathAst::Type::ARCCOSH:
+        return derivativeDivide(du, node(MathAst::Type::ROOT, {node(MathAst::Type::MINUS, {square(u), number(1.0)})}));
+    case MathAst::Type::ARCTANH:
+    case MathAst::Type::ARCCOTH:
+        return derivativeDivide(du, node(MathAst::Type::MINUS, {number(1.0), square(u)}));
+    case MathAst::Type::ARCSECH:
+        return affineNegate(derivativeDivide(du, node(MathAst::Type::TIMES, {u, node(MathAst::Type::ROOT, {node(MathAst::Type::MINUS, {number(1.0), square(u)})})})));
+    case MathAst::Type::ARCCSCH:
+        return affineNegate(derivativeDivide(du, node(MathAst::Type::TIMES, {node(MathAst::Type::ABS, {u}), node(MathAst::Type::ROOT, {node(MathAst::Type::PLUS, {number(1.0), square(u)})})})));
+    default:
+        // Relational, logical and rounding operators.
+        return nullptr;
+    }
+}
+
+void Evaluator::EvaluatorImpl::compileJacobian()
+{
+    std::vector<size_t> stateClasses(mStates.size());
+    std::vector<const Equation *> rateEquations(mStates.size(), nullptr);
+    for (size_t i = 0; i < mClasses.size(); ++i) {
+        if (mClasses.at(i).mKind == VariableClass::Kind::STATE) {
+            stateClasses.at(mClasses.at(i).mIndex) = i;
+        }
+    }
+    for (const Equation &equation : mEquations) {
+        if (equation.mIsRate) {
+            rateEquations.at(mClasses.at(equation.mClass).mIndex) = &equation;
+        }
+    }
+
+    std::vector<std::map<size_t, bool>> dependsMemos(mStates.size());
+    std::vector<std::map<size_t, MathAstPtr>> derivativeMemos(mStates.size());
+    std::vector<MathAstPtr> derivatives;
+    for (size_t row = 0; row < mStates.size(); ++row) {
+        const Equation *equation = rateEquations.at(row);
+        for (size_t column = 0; column < mStates.size(); ++column) {
+            MathAstPtr derivative = differentiate(equation->mRhs, stateClasses.at(column), dependsMemos.at(column), derivativeMemos.at(column));
+            if (derivative == nullptr) {
+                // The rate only depends on the state through conditions.
+                continue;
+            }
+            derivatives.push_back(derivative);
+            mJacobianEntries.emplace_back(row, column);
+        }
+    }
+
+    // The derivatives share many factors with each other and with the rates.
+    std::map<std::string, MathAstPtr> nodes;
+    std::map<MathAstPtr, MathAstPtr> memo;
+    for (MathAstPtr &derivative : derivatives) {
+        derivative = intern(derivative, nodes, memo);
+    }
+    SharedExpressions shared;
+    findSharedExpressions(derivatives, shared);
+
+    VariableLoadMap variableLoads = loads();
+    for (size_t i = 0; i < derivatives.size(); ++i) {
+        std::string error;
+        if (!compileExpression(derivatives.at(i), variableLoads, mJacobianProgram, error, &shared)) {
+            const Equation *equation = rateEquations.at(mJacobianEntries.at(i).first);
+            addError("The derivative of the rate of '" + variableName(equation->mClass) + "' with respect to '" + variableName(stateClasses.at(mJacobianEntries.at(i).second)) + "' cannot be evaluated: " + error, equation->mComponent, Error::Kind::MATHML);
+            mJacobianEntries.clear();
+            return;
+        }
+        compileStore(OpCode::STORE_RESULT, i, mJacobianProgram);
+    }
+}
+
+/**
+ * @brief Test if @p ast, and all of its arguments, can be tabulated against
+ * the variable class @p classIndex.
+ *
+ * An expression can be tabulated if it is a smooth function of the variables
+ * of the class and of numbers only.  @p referenced is set if the expression
+ * uses the class and @p expensive if it calls a transcendental function.
+ */
+bool Evaluator::EvaluatorImpl::isTabulable(const MathAstPtr &ast, size_t classIndex, bool &referenced, bool &expensive) const
+{
+    switch (ast->mType) {
+    case MathAst::Type::CI:
+        referenced = true;
+        return mClassOf.at(ast->mVariable) == classIndex;
+    case MathAst::Type::CN:
+    case MathAst::Type::E:
+    case MathAst::Type::PI:
+        return true;
+    case MathAst::Type::PLUS:
+    case MathAst::Type::MINUS:
+    case MathAst::Type::TIMES:
+    case MathAst::Type::DIVIDE:
+    case MathAst::Type::DEGREE:
+    case MathAst::Type::LOGBASE:
+        break;
+    case MathAst::Type::POWER:
+    case MathAst::Type::ROOT:
+    case MathAst::Type::EXP:
+    case MathAst::Type::LN:
+    case MathAst::Type::LOG:
+    case MathAst::Type::SIN:
+    case MathAst::Type::COS:
+    case MathAst::Type::TAN:
+    case MathAst::Type::SEC:
+    case MathAst::Type::CSC:
+    case MathAst::Type::COT:
+    case MathAst::Type::SINH:
+    case MathAst::Type::COSH:
+    case MathAst::Type::TANH:
+    case MathAst::Type::SECH:
+    case MathAst::Type::CSCH:
+    case MathAst::Type::COTH:
+    case MathAst::Type::ARCSIN:
+    case MathAst::Type::ARCCOS:
+    case MathAst::Type::ARCTAN:
+    case MathAst::Type::ARCSEC:
+    case MathAst::Type::ARCCSC:
+    case MathAst::Type::ARCCOT:
+    case MathAst::Type::ARCSINH:
+    case MathAst::Type::ARCCOSH:
+    case MathAst::Type::ARCTANH:
+    case MathAst::Type::ARCSECH:
+    case MathAst::Type::ARCCSCH:
+    case MathAst::Type::ARCCOTH:
+        expensive = true;
+        break;
+    default:
+        return false;
+    }
+    for (const MathAstPtr &child : ast->mChildren) {
+        if (!isTabulable(child, classIndex, referenced, expensive)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Replace the largest expensive subexpressions of @p ast that can be
+ * tabulated against the variable class @p classIndex by lookup nodes.
+ *
+ * Shared subexpressions are only tabulated once, using @p memo.
+ *
+ * @return The tabulated version of @p ast.
+ */
+MathAstPtr Evaluator::EvaluatorImpl::tabulateNode(const MathAstPtr &ast, size_t classIndex, std::map<MathAstPtr, MathAstPtr> &memo)
+{
+    auto found = memo.find(ast);
+    if (found != memo.end()) {
+        return found->second;
+    }
+    bool referenced = false;
+    bool expensive = false;
+    if (isTabulable(ast, classIndex, referenced, expensive) && referenced && expensive) {
+        // The variable is loaded as the variable of integration when the
+        // expression is evaluated on its own.
+        VariableLoadMap variableLoads;
+        Instruction load;
+        load.mOpCode = OpCode::LOAD_VOI;
+        for (const VariablePtr &variable : mClasses.at(classIndex).mVariables) {
+            variableLoads.emplace(variable, load);
+        }
+        LookupTable table;
+        std::string error;
+        if (!compileExpression(ast, variableLoads, table.mExpression, error)) {
+            return ast;
+        }
+        compileStore(OpCode::STORE_RESULT, 0, table.mExpression);
+        double tableError = tabulate(mLookupTableMinimum, mLookupTableMaximum, mLookupTableStep, table);
+        mLookupTables.push_back(table);
+        mLookupTableErrors.push_back(tableError);
+
+        MathAstPtr variable = std::make_shared<MathAst>();
+        variable->mType = MathAst::Type::CI;
+        variable->mVariable = mClasses.at(classIndex).mVariables.front();
+        variable->mName = variable->mVariable->name();
+        MathAstPtr lookup = createMathAstNode(MathAst::Type::LOOKUP, {variable, ast});
+        lookup->mIndex = mLookupTables.size() - 1;
+        memo[ast] = lookup;
+        return lookup;
+    }
+    MathAstPtr result = ast;
+    for (size_t i = 0; i < ast->mChildren.size(); ++i) {
+        MathAstPtr child = tabulateNode(ast->mChildren.at(i), classIndex, memo);
+        if (child != ast->mChildren.at(i)) {
+            if (result == ast) {
+                result = std::make_shared<MathAst>(*ast);
+            }
+            result->mChildren.at(i) = child;
+        }
+    }
+    memo[ast] = result;
+    return result;
+}
+
+void Evaluator::EvaluatorImpl::tabulateExpressions()
+{
+    if (mLookupTableVariable == nullptr) {
+        return;
+    }
+    if (!std::isfinite(mLookupTableMinimum) || !std::isfinite(mLookupTableMaximum) || !std::isfinite(mLookupTableStep)) {
+        addError("The lookup table range and step must be finite.", nullptr, Error::Kind::UNDEFINED);
+        return;
+    }
+    if ((mLookupTableStep <= 0.0) || !(mLookupTableMaximum > mLookupTableMinimum)) {
+        addError("The lookup table range must not be empty and its step must be greater than zero.", nullptr, Error::Kind::UNDEFINED);
+        return;
+    }
+    if (!((mLookupTableMaximum - mLookupTableMinimum) / mLookupTableStep < static_cast<double>(MAX_LOOKUP_TABLE_POINT_COUNT - 1))) {
+        addError("The lookup table must not have more than " + std::to_string(MAX_LOOKUP_TABLE_POINT_COUNT) + " points.", nullptr, Error::Kind::UNDEFINED);
+        return;
+    }
+    auto found = mClassOf.find(mLookupTableVariable);
+    if (found == mClassOf.end()) {
+        addError("Lookup table variable '" + mLookupTableVariable->name() + "' is not part of the model.", nullptr, Error::Kind::VARIABLE);
+        return;
+    }
+    std::map<MathAstPtr, MathAstPtr> memo;
+    for (Equation &equation : mEquations) {
+        if (equation.mIsRate || !equation.mIsConstant) {
+            equation.mRhs = tabulateNode(equation.mRhs, found->second, memo);
+        }
+    }
+}
+
+/**
+ * @brief Test if @p ast only involves numbers and constants.
+ */
+static bool isConstantExpression(const MathAstPtr &ast)
+{
+    switch (ast->mType) {
+    case MathAst::Type::CI:
+    case MathAst::Type::DIFF:
+    case MathAst::Type::LOOKUP:
+        return false;
+    default:
+        break;
+    }
+    for (const MathAstPtr &child : ast->mChildren) {
+        if (!isConstantExpression(child)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Evaluate @p ast if it is an expression that only involves numbers
+ * and constants.
+ *
+ * The expression is evaluated by the same instructions it would otherwise be
+ * compiled into, so that folding it does not change any result.
+ *
+ * @return A number node holding the value of @p ast, or @p ast itself.
+ */
+static MathAstPtr foldConstantExpression(const MathAstPtr &ast)
+{
+    switch (ast->mType) {
+    case MathAst::Type::CN:
+    case MathAst::Type::PIECE:
+    case MathAst::Type::OTHERWISE:
+    case MathAst::Type::BVAR:
+    case MathAst::Type::DEGREE:
+    case MathAst::Type::LOGBASE:
+        return ast;
+    default:
+        break;
+    }
+    if (!isConstantExpression(ast)) {
+        return ast;
+    }
+    Program program;
+    std::string error;
+    if (!compileExpression(ast, VariableLoadMap(), program, error)) {
+        return ast;
+    }
+    compileStore(OpCode::STORE_RESULT, 0, program);
+    double value = 0.0;
+    ProgramArguments arguments;
+    arguments.mResults = &value;
+    executeProgram(program, arguments);
+    return createMathAstNumber(value);
+}
+
+/**
+ * @brief Remove the pieces of the piecewise node @p ast whose condition is a
+ * number.
+ *
+ * Pieces whose condition is zero are never selected and are dropped, while a
+ * piece whose condition is any other number is always selected if reached,
+ * and replaces the pieces after it.
+ *
+ * @return The simplified version of @p ast, which may be the value of its
+ * only remaining piece.
+ */
+static MathAstPtr simplifyPiecewise(const MathAstPtr &ast)
+{
+    std::vector<MathAstPtr> pieces;
+    for (const MathAstPtr &piece : ast->mChildren) {
+        if ((piece->mType == MathAst::Type::PIECE) && (piece->mChildren.at(1)->mType == MathAst::Type::CN)) {
+            if (piece->mChildren.at(1)->mValue == 0.0) {
+                continue;
+            }
+            pieces.push_back(createMathAstNode(MathAst::Type::OTHERWISE, {piece->mChildren.at(0)}));
+            break;
+        }
+        pieces.push_back(piece);
+        if (piece->mType == MathAst::Type::OTHERWISE) {
+            break;
+        }
+    }
+    if ((pieces.size() == 1) && (pieces.front()->mType == MathAst::Type::OTHERWISE)) {
+        return pieces.front()->mChildren.at(0);
+    }
+    if (pieces == ast->mChildren) {
+        return ast;
+    }
+    return createMathAstNode(MathAst::Type::PIECEWISE, pieces);
+}
+
+/**
+ * @brief Get the canonical node for @p ast.
+ *
+ * The arguments of @p ast are made canonical first, then any part of @p ast
+ * that only involves numbers is folded into a number.  The canonical node is
+ * the first node found in @p nodes with the same type, value and arguments,
+ * so that identical subexpressions end up being represented by the same
+ * node, which the compiler only evaluates once.  Variables are identified by
+ * their class, so equivalent variables share a node too.  @p memo maps the
+ * nodes already visited to their canonical node.
+ *
+ * @return The canonical node for @p ast.
+ */
+MathAstPtr Evaluator::EvaluatorImpl::intern(const MathAstPtr &ast, std::map<std::string, MathAstPtr> &nodes, std::map<MathAstPtr, MathAstPtr> &memo) const
+{
+    auto found = memo.find(ast);
+    if (found != memo.end()) {
+        return found->second;
+    }
+    MathAstPtr result = ast;
+    if (ast->mType == MathAst::Type::CI) {
+        const VariableClass &variableClass = mClasses.at(mClassOf.at(ast->mVariable));
+        if (mFoldConstantVariables && (variableClass.mKind == VariableClass::Kind::CONSTANT)) {
+            result = createMathAstNumber(variableClass.mInitialValue);
+        }
+    }
+    for (size_t i = 0; i < ast->mChildren.size(); ++i) {
+        MathAstPtr child = intern(ast->mChildren.at(i), nodes, memo);
+        if (child != ast->mChildren.at(i)) {
+            if (result == ast) {
+                result = std::make_shared<MathAst>(*ast);
+            }
+            result->mChildren.at(i) = child;
+        }
+    }
+    if (result->mType == MathAst::Type::PIECEWISE) {
+        result = simplifyPiecewise(result);
+        if (result->mType != MathAst::Type::PIECEWISE) {
+            // The value of a remaining piece is already canonical.
+            memo[ast] = result;
+            return result;
+        }
+        for (MathAstPtr &piece : result->mChildren) {
+            piece = intern(piece, nodes, memo);
+        }
+    }
+    result = foldConstantExpression(result);
+
+    std::string key = std::to_string(static_cast<int>(result->mType));
+    if (result->mType == MathAst::Type::CN) {
+        key += ":" + std::to_string(bitsOf(result->mValue));
+    } else if (result->mType == MathAst::Type::CI) {
+        key += ":" + std::to_string(mClassOf.at(result->mVariable));
+    } else if (result->mType == MathAst::Type::LOOKUP) {
+        key += ":" + std::to_string(result->mIndex);
+    }
+    for (const MathAstPtr &child : result->mChildren) {
+        key += " " + std::to_string(reinterpret_cast<std::uintptr_t>(child.get()));
+    }
+    MathAstPtr canonical = nodes.emplace(key, result).first->second;
+    memo[ast] = canonical;
+    memo[canonical] = canonical;
+    return canonical;
+}
+
+void Evaluator::EvaluatorImpl::internExpressions()
+{
+    std::map<std::string, MathAstPtr> nodes;
+    std::map<MathAstPtr, MathAstPtr> memo;
+    for (Equation &equation : mEquations) {
+        equation.mRhs = intern(equation.mRhs, nodes, memo);
+    }
+}
+
+Evaluator::Evaluator()
+    : mPimpl(new EvaluatorImpl())
+{
+    mPimpl->mEvaluator = this;
+}
+
+Evaluator::~Evaluator()
+{
+    delete mPimpl;
+}
+
+Evaluator::Evaluator(const Evaluator &rhs)
+    : Logger(rhs)
+    , mPimpl(new EvaluatorImpl(*rhs.mPimpl))
+{
+    mPimpl->mEvaluator = this;
+}
+
+Evaluator::Evaluator(Evaluator &&rhs) noexcept
+    : Logger(std::move(rhs))
+    , mPimpl(rhs.mPimpl)
+{
+    if (mPimpl != nullptr) {
+        mPimpl->mEvaluator = this;
+    }
+    rhs.mPimpl = nullptr;
+}
+
+Evaluator &Evaluator::operator=(Evaluator rhs)
+{
+    Logger::operator=(rhs);
+    rhs.swap(*this);
+    return *this;
+}
+
+void Evaluator::swap(Evaluator &rhs)
+{
+    std::swap(this->mPimpl, rhs.mPimpl);
+    // The implementations point back to the evaluators that now own them, if
+    // any, as a moved from evaluator has none.
+    if (this->mPimpl != nullptr) {
+        this->mPimpl->mEvaluator = this;
+    }
+    if (rhs.mPimpl != nullptr) {
+        rhs.mPimpl->mEvaluator = &rhs;
+    }
+}
+
+void Evaluator::processModel(const ModelPtr &model)
+{
+    clearErrors();
+    mPimpl->reset();
+
+    mPimpl->gatherComponents(model);
+    mPimpl->gatherVariableClasses();
+    mPimpl->gatherEquations();
+    mPimpl->classifyVariables();
+    if (errorCount() == 0) {
+        for (Equation &equation : mPimpl->mEquations) {
+            mPimpl->gatherDependencies(equation.mRhs, equation);
+        }
+        std::vector<size_t> order;
+        if (mPimpl->sortEquations(order)) {
+            // Tabulate shared subexpressions once, then share the lookups.
+            mPimpl->internExpressions();
+            mPimpl->tabulateExpressions();
+            mPimpl->internExpressions();
+            mPimpl->compilePrograms(order);
+            mPimpl->compileResets();
+            mPimpl->compileGatingCoefficients();
+            mPimpl->compileJacobian();
+        }
+    }
+    mPimpl->mComponents.clear();
+    mPimpl->mClasses.clear();
+    mPimpl->mClassOf.clear();
+    mPimpl->mEquations.clear();
+    mPimpl->mValid = errorCount() == 0;
+}
+
+void Evaluator::setLookupTableVariable(const VariablePtr &variable, double minimum, double maximum, double step)
+{
+    mPimpl->mLookupTableVariable = variable;
+    mPimpl->mLookupTableMinimum = minimum;
+    mPimpl->mLookupTableMaximum = maximum;
+    mPimpl->mLookupTableStep = step;
+}
+
+void Evaluator::removeLookupTableVariable()
+{
+    mPimpl->mLookupTableVariable = nullptr;
+}
+
+VariablePtr Evaluator::lookupTableVariable() const
+{
+    return mPimpl->mLookupTableVariable;
+}
+
+size_t Evaluator::lookupTableCount() const
+{
+    return mPimpl->mLookupTables.size();
+}
+
+double Evaluator::lookupTableError(size_t index) const
+{
+    if (index < mPimpl->mLookupTableErrors.size()) {
+        return mPimpl->mLookupTableErrors.at(index);
+    }
+    return 0.0;
+}
+
+size_t Evaluator::jacobianEntryCount() const
+{
+    return mPimpl->mJacobianEntries.size();
+}
+
+size_t Evaluator::jacobianEntryRow(size_t index) const
+{
+    if (index < mPimpl->mJacobianEntries.size()) {
+        return mPimpl->mJacobianEntries.at(index).first;
+    }
+    return mPimpl->mStates.size();
+}
+
+size_t Evaluator::jacobianEntryColumn(size_t index) const
+{
+    if (index < mPimpl->mJacobianEntries.size()) {
+        return mPimpl->mJacobianEntries.at(index).second;
+    }
+    return mPimpl->mStates.size();
+}
+
+void Evaluator::setFoldConstantVariables(bool fold)
+{
+    mPimpl->mFoldConstantVariables = fold;
+}
+
+bool Evaluator::foldConstantVariables() const
+{
+    return mPimpl->mFoldConstantVariables;
+}
+
+size_t Evaluator::removedOperationCount() const
+{
+    return mPimpl->mRemovedOperationCount;
+}
+
+bool Evaluator::isValid() const
+{
+    return mPimpl->mValid;
+}
+
+VariablePtr Evaluator::voi() const
+{
+    return mPimpl->mVoi;
+}
+
+size_t Evaluator::stateCount() const
+{
+    return mPimpl->mStates.size();
+}
+
+VariablePtr Evaluator::state(size_t index) const
+{
+    VariablePtr state = nullptr;
+    if (index < mPimpl->mStates.size()) {
+        state = mPimpl->mStates.at(index);
+    }
+    return state;
+}
+
+size_t Evaluator::variableCount() const
+{
+    return mPimpl->mVariables.size();
+}
+
+VariablePtr Evaluator::variable(size_t index) const
+{
+    VariablePtr variable = nullptr;
+    if (index < mPimpl->mVariables.size()) {
+        variable = mPimpl->mVariables.at(index);
+    }
+    return variable;
+}
+
+size_t Evaluator::whenCount() const
+{
+    return mPimpl->mWhenTargets.size();
+}
+
+bool Evaluator::isGatingState(size_t index) const
+{
+    return (index < mPimpl->mGatingStates.size()) && mPimpl->mGatingStates.at(index);
+}
+
+size_t Evaluator::gatingStateCount() const
+{
+    return static_cast<size_t>(std::count(mPimpl->mGatingStates.begin(), mPimpl->mGatingStates.end(), true));
+}
+
+void Evaluator::initialiseStatesAndConstants(double *states, double *variables) const
+{
+    std::copy(mPimpl->mStateInitialValues.begin(), mPimpl->mStateInitialValues.end(), states);
+    std::copy(mPimpl->mVariableInitialValues.begin(), mPimpl->mVariableInitialValues.end(), variables);
+}
+
+void Evaluator::computeComputedConstants(double *variables) const
+{
+    ProgramArguments arguments;
+    arguments.mLookupTables = mPimpl->mLookupTables.data();
+    arguments.mVariables = variables;
+    arguments.mVariablesOut = variables;
+    executeProgram(mPimpl->mComputedConstantsProgram, arguments);
+}
+
+void Evaluator::computeRates(double voi, const double *states, double *rates, double *variables) const
+{
+    EvaluatorAccess::computeRates(*this, voi, states, rates, variables, nullptr);
+}
+
+void Evaluator::computeVariables(double voi, const double *states, const double *rates, double *variables) const
+{
+    EvaluatorAccess::computeVariables(*this, voi, states, rates, variables, nullptr);
+}
+
+void Evaluator::computeConditions(double voi, const double *states, const double *rates, const double *variables, double *conditions) const
+{
+    EvaluatorAccess::computeConditions(*this, voi, states, rates, variables, conditions, nullptr);
+}
+
+void Evaluator::computeGatingCoefficients(double voi, const double *states, const double *rates, const double *variables, double *coefficients) const
+{
+    EvaluatorAccess::computeGatingCoefficients(*this, voi, states, rates, variables, coefficients, nullptr);
+}
+
+size_t EvaluatorAccess::scratchSize(const Evaluator &evaluator)
+{
+    const Evaluator::EvaluatorImpl *pimpl = evaluator.mPimpl;
+    return std::max({programScratchSize(pimpl->mRatesProgram),
+                     programScratchSize(pimpl->mVariablesProgram),
+                     programScratchSize(pimpl->mConditionsProgram),
+                     programScratchSize(pimpl->mGatingProgram)});
+}
+
+void EvaluatorAccess::computeRates(const Evaluator &evaluator, double voi, const double *states, double *rates, double *variables, double *scratch)
+{
+    ProgramArguments arguments;
+    arguments.mLookupTables = evaluator.mPimpl->mLookupTables.data();
+    arguments.mVoi = voi;
+    arguments.mStates = states;
+    arguments.mRates = rates;
+    arguments.mVariables = variables;
+    arguments.mRatesOut = rates;
+    arguments.mVariablesOut = variables;
+    arguments.mScratch = scratch;
+    executeProgram(evaluator.mPimpl->mRatesProgram, arguments);
+}
+
+void EvaluatorAccess::computeVariables(const Evaluator &evaluator, double voi, const double *states, const double *rates, double *variables, double *scratch)
+{
+    ProgramArguments arguments;
+    arguments.mLookupTables = evaluator.mPimpl->mLookupTables.data();
+    arguments.mVoi = voi;
+    arguments.mStates = states;
+    arguments.mRates = rates;
+    arguments.mVariables = variables;
+    arguments.mVariablesOut = variables;
+    arguments.mScratch = scratch;
+    executeProgram(evaluator.mPimpl->mVariablesProgram, arguments);
+}
+
+void EvaluatorAccess::computeConditions(const Evaluator &evaluator, double voi, const double *states, const double *rates, const double *variables, double *conditions, double *scratch)
+{
+    ProgramArguments arguments;
+    arguments.mLookupTables = evaluator.mPimpl->mLookupTables.data();
+    arguments.mVoi = voi;
+    arguments.mStates = states;
+    arguments.mRates = rates;
+    arguments.mVariables = variables;
+    arguments.mResults = conditions;
+    arguments.mScratch = scratch;
+    executeProgram(evaluator.mPimpl->mConditionsProgram, arguments);
+}
+
+void EvaluatorAccess::computeGatingCoefficients(const Evaluator &evaluator, double voi, const double *states, const double *rates, const double *variables, double *coefficients, double *scratch)
+{
+    ProgramArguments arguments;
+    arguments.mLookupTables = evaluator.mPimpl->mLookupTables.data();
+    arguments.mVoi = voi;
+    arguments.mStates = states;
+    arguments.mRates = rates;
+    arguments.mVariables = variables;
+    arguments.mResults = coefficients;
+    arguments.mScratch = scratch;
+    executeProgram(evaluator.mPimpl->mGatingProgram, arguments);
+}
+
+void Evaluator::initialiseStatesAndConstantsBatch(double *states, double *variables, size_t instanceCount) const
+{
+    for (size_t i = 0; i < mPimpl->mStateInitialValues.size(); ++i) {
+        std::fill(states + i * instanceCount, states + (i + 1) * instanceCount, mPimpl->mStateInitialValues.at(i));
+    }
+    for (size_t i = 0; i < mPimpl->mVariableInitialValues.size(); ++i) {
+        std::fill(variables + i * instanceCount, variables + (i + 1) * instanceCount, mPimpl->mVariableInitialValues.at(i));
+    }
+}
+
+void Evaluator::computeComputedConstantsBatch(double *variables, size_t instanceCount) const
+{
+    ProgramArguments arguments;
+    arguments.mLookupTables = mPimpl->mLookupTables.data();
+    arguments.mVariables = variables;
+    arguments.mVariablesOut = variables;
+    executeProgramBatch(mPimpl->mComputedConstantsProgram, arguments, instanceCount);
+}
+
+void Evaluator::computeRatesBatch(double voi, const double *states, double *rates, double *variables, size_t instanceCount) const
+{
+    ProgramArguments arguments;
+    arguments.mLookupTables = mPimpl->mLookupTables.data();
+    arguments.mVoi = voi;
+    arguments.mStates = states;
+    arguments.mRates = rates;
+    arguments.mVariables = variables;
+    arguments.mRatesOut = rates;
+    arguments.mVariablesOut = variables;
+    executeProgramBatch(mPimpl->mRatesProgram, arguments, instanceCount);
+}
+
+void Evaluator::computeVariablesBatch(double voi, const double *states, const double *rates, double *variables, size_t instanceCount) const
+{
+    ProgramArguments arguments;
+    arguments.mLookupTables = mPimpl->mLookupTables.data();
+    arguments.mVoi = voi;
+    arguments.mStates = states;
+    arguments.mRates = rates;
+    arguments.mVariables = variables;
+    arguments.mVariablesOut = variables;
+    executeProgramBatch(mPimpl->mVariablesProgram, arguments, instanceCount);
+}
+
+void Evaluator::computeGatingCoefficientsBatch(double voi, const double *states, const double *rates, const double *variables, double *coefficients, size_t instanceCount) const
+{
+    ProgramArguments arguments;
+    arguments.mLookupTables = mPimpl->mLookupTables.data();
+    arguments.mVoi = voi;
+    arguments.mStates = states;
+    arguments.mRates = rates;
+    arguments.mVariables = variables;
+    arguments.mResults = coefficients;
+    executeProgramBatch(mPimpl->mGatingProgram, arguments, instanceCount);
+}
+
+void Evaluator::computeJacobian(double voi, const double *states, const double *rates, const double *variables, double *jacobian) const
+{
+    ProgramArguments arguments;
+    arguments.mLookupTables = mPimpl->mLookupTables.data();
+    arguments.mVoi = voi;
+    arguments.mStates = states;
+    arguments.mRates = rates;
+    arguments.mVariables = variables;
+    arguments.mResults = jacobian;
+    executeProgram(mPimpl->mJacobianProgram, arguments);
+}
+
+bool Evaluator::applyResets(double voi, double *states, const double *rates, double *variables,
+                            const double *previousConditions, const double *conditions) const
+{
+    const std::vector<WhenTarget> &targets = mPimpl->mWhenTargets;
+    bool triggered = false;
+    for (size_t i = 0; (i < targets.size()) && !triggered; ++i) {
+        triggered = (previousConditions[i] == 0.0) && (conditions[i] != 0.0);
+    }
+    if (!triggered) {
+        return false;
+    }
+
+    std::vector<double> values(targets.size());
+    ProgramArguments arguments;
+    arguments.mLookupTables = mPimpl->mLookupTables.data();
+    arguments.mVoi = voi;
+    arguments.mStates = states;
+    arguments.mRates = rates;
+    arguments.mVariables = variables;
+    arguments.mResults = values.data();
+    executeProgram(mPimpl->mResetValuesProgram, arguments);
+
+    // Decide on the assignments before making any of them.
+    std::vector<size_t> applied;
+    std::vector<bool> resetDone;
+    std::vector<std::pair<bool, size_t>> assigned;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        const WhenTarget &target = targets.at(i);
+        if (target.mReset >= resetDone.size()) {
+            resetDone.resize(target.mReset + 1, false);
+        }
+        if (resetDone.at(target.mReset) || (previousConditions[i] != 0.0) || (conditions[i] == 0.0)) {
+            continue;
+        }
+        resetDone.at(target.mReset) = true;
+        std::pair<bool, size_t> variable = {target.mIsState, target.mIndex};
+        if (std::find(assigned.begin(), assigned.end(), variable) == assigned.end()) {
+            assigned.push_back(variable);
+            applied.push_back(i);
+        }
+    }
+    for (size_t i : applied) {
+        const WhenTarget &target = targets.at(i);
+        if (target.mIsState) {
+            states[target.mIndex] = values.at(i);
+        } else {
+            variables[target.mIndex] = values.at(i);
+        }
+    }
+    computeComputedConstants(variables);
+    return true;
+}
+
+} // namespace libcellml
@@ -0,0 +1,253 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "utilities.h"
+
+#include "libcellml/component.h"
+#include "libcellml/flatmodel.h"
+#include "libcellml/model.h"
+#include "libcellml/modelwalker.h"
+
+#include <limits>
+#include <unordered_map>
+
+namespace libcellml {
+
+const size_t FlatModel::NO_INDEX = std::numeric_limits<size_t>::max();
+
+/**
+ * @brief The FlatModel::FlatModelImpl struct.
+ *
+ * The private implementation for the FlatModel class.
+ */
+struct FlatModel::FlatModelImpl
+{
+    std::vector<ComponentPtr> mComponents;
+    std::vector<size_t> mComponentParents;
+    std::vector<size_t> mComponentChildOffsets;
+    std::vector<size_t> mComponentChildren;
+    std::vector<size_t> mComponentVariableOffsets;
+    std::vector<VariablePtr> mVariables;
+    std::vector<size_t> mVariableComponents;
+    std::vector<std::string> mUnitsNames;
+    std::unordered_map<std::string, size_t> mUnitsIndices;
+    std::vector<size_t> mVariableUnits;
+    std::vector<Variable::InterfaceType> mVariableInterfaceTypes;
+    std::vector<double> mVariableInitialValues;
+    std::vector<size_t> mVariableEquivalenceSets;
+    size_t mEquivalenceSetCount = 0;
+    std::vector<size_t> mEquivalenceOffsets;
+    std::vector<size_t> mEquivalentVariables;
+
+    void addComponent(const ComponentPtr &component, size_t parent);
+    void buildChildren();
+    void buildEquivalences();
+};
+
+/**
+ * @brief Get the interface type called @p interfaceType.
+ *
+ * @param interfaceType The name of the interface type.
+ *
+ * @return The interface type, or @c Variable::InterfaceType::NONE if
+ * @p interfaceType is not the name of one.
+ */
+static Variable::InterfaceType interfaceTypeFromString(const std::string &interfaceType)
+{
+    static const std::unordered_map<std::string, Variable::InterfaceType> interfaceTypes = {
+        {"private", Variable::InterfaceType::PRIVATE},
+        {"public", Variable::InterfaceType::PUBLIC},
+        {"public_and_private", Variable::InterfaceType::PUBLIC_AND_PRIVATE}};
+    auto found = interfaceTypes.find(interfaceType);
+    if (found == interfaceTypes.end()) {
+        return Variable::InterfaceType::NONE;
+    }
+    return found->second;
+}
+
+void FlatModel::FlatModelImpl::addComponent(const ComponentPtr &component, size_t parent)
+{
+    size_t index = mComponents.size();
+    mComponents.push_back(component);
+    mComponentParents.push_back(parent);
+    mComponentVariableOffsets.push_back(mVariables.size());
+    for (const VariablePtr &variable : component->variables()) {
+        mVariables.push_back(variable);
+        mVariableComponents.push_back(index);
+        auto units = mUnitsIndices.emplace(variable->units(), mUnitsNames.size());
+        if (units.second) {
+            mUnitsNames.push_back(variable->units());
+        }
+        mVariableUnits.push_back(units.first->second);
+        mVariableInterfaceTypes.push_back(interfaceTypeFromString(variable->interfaceType()));
+        std::string initialValue = variable->initialValue();
+        mVariableInitialValues.push_back(isCellMLReal(initialValue) ? convertToDouble(initialValue) : std::numeric_limits<double>::quiet_NaN());
+    }
+}
+
+void FlatModel::FlatModelImpl::buildChildren()
+{
+    // Counting sort of the components by parent, which keeps the children of
+    // each component in order since the components are in depth-first order.
+    size_t componentCount = mComponents.size();
+    mComponentChildOffsets.assign(componentCount + 1, 0);
+    for (size_t parent : mComponentParents) {
+        if (parent != NO_INDEX) {
+            ++mComponentChildOffsets[parent + 1];
+        }
+    }
+    for (size_t i = 0; i < componentCount; ++i) {
+        mComponentChildOffsets[i + 1] += mComponentChildOffsets[i];
+    }
+    mComponentChildren.resize(mComponentChildOffsets[componentCount]);
+    std::vector<size_t> next(mComponentChildOffsets.begin(), mComponentChildOffsets.end() - 1);
+    for (size_t i = 0; i < componentCount; ++i) {
+        size_t parent = mComponentParents[i];
+        if (parent != NO_INDEX) {
+            mComponentChildren[next[parent]++] = i;
+        }
+    }
+}
+
+void FlatModel::FlatModelImpl::buildEquivalences()
+{
+    std::unordered_map<const Variable *, size_t> variableIndices;
+    for (size_t i = 0; i < mVariables.size(); ++i) {
+        variableIndices.emplace(mVariables[i].get(), i);
+    }
+    std::unordered_map<size_t, size_t> equivalenceSetIndices;
+    mEquivalenceOffsets.reserve(mVariables.size() + 1);
+    for (const VariablePtr &variable : mVariables) {
+        auto set = equivalenceSetIndices.emplace(Variable::equivalenceSetId(variable), equivalenceSetIndices.size());
+        mVariableEquivalenceSets.push_back(set.first->second);
+        mEquivalenceOffsets.push_back(mEquivalentVariables.size());
+        for (size_t j = 0; j < variable->equivalentVariableCount(); ++j) {
+            auto found = variableIndices.find(variable->equivalentVariable(j).get());
+            if (found != variableIndices.end()) {
+                mEquivalentVariables.push_back(found->second);
+            }
+        }
+    }
+    mEquivalenceOffsets.push_back(mEquivalentVariables.size());
+    mEquivalenceSetCount = equivalenceSetIndices.size();
+}
+
+FlatModel::FlatModel(const ModelPtr &model)
+    : mPimpl(new FlatModelImpl())
+{
+    std::vector<size_t> ancestors;
+    ModelWalker walker(model);
+    while (walker.next()) {
+        ancestors.resize(walker.depth());
+        mPimpl->addComponent(walker.component(), ancestors.empty() ? NO_INDEX : ancestors.back());
+        ancestors.push_back(mPimpl->mComponents.size() - 1);
+    }
+    mPimpl->mComponentVariableOffsets.push_back(mPimpl->mVariables.size());
+    mPimpl->buildChildren();
+    mPimpl->buildEquivalences();
+}
+
+FlatModel::~FlatModel()
+{
+    delete mPimpl;
+}
+
+size_t FlatModel::componentCount() const
+{
+    return mPimpl->mComponents.size();
+}
+
+const std::vector<ComponentPtr> &FlatModel::components() const
+{
+    return mPimpl->mComponents;
+}
+
+const std::vector<size_t> &FlatModel::componentParents() const
+{
+    return mPimpl->mComponentParents;
+}
+
+const std::vector<size_t> &FlatModel::componentChildOffsets() const
+{
+    return mPimpl->mComponentChildOffsets;
+}
+
+const std::vector<size_t> &FlatModel::componentChildren() const
+{
+    return mPimpl->mComponentChildren;
+}
+
+const std::vector<size_t> &FlatModel::componentVariableOffsets() const
+{
+    return mPimpl->mComponentVariableOffsets;
+}
+
+size_t FlatModel::variableCount() const
+{
+    return mPimpl->mVariables.size();
+}
+
+const std::vector<VariablePtr> &FlatModel::variables() const
+{
+    return mPimpl->mVariables;
+}
+
+const std::vector<size_t> &FlatModel::variableComponents() const
+{
+    return mPimpl->mVariableComponents;
+}
+
+const std::vector<std::string> &FlatModel::unitsNames() const
+{
+    return mPimpl->mUnitsNames;
+}
+
+const std::vector<size_t> &FlatModel::variableUnits() const
+{
+    return mPimpl->mVariableUnits;
+}
+
+const std::vector<Variable::InterfaceType> &FlatModel::variableInterfaceTypes() const
+{
+    return mPimpl->mVariableInterfaceTypes;
+}
+
+const std::vector<double> &FlatModel::variableInitialValues() const
+{
+    return mPimpl->mVariableInitialValues;
+}
+
+const std::vector<size_t> &FlatModel::variableEquivalenceSets() const
+{
+    return mPimpl->mVariableEquivalenceSets;
+}
+
+size_t FlatModel::equivalenceSetCount() const
+{
+    return mPimpl->mEquivalenceSetCount;
+}
+
+const std::vector<size_t> &FlatModel::equivalenceOffsets() const
+{
+    return mPimpl->mEquivalenceOffsets;
+}
+
+const std::vector<size_t> &FlatModel::equivalentVariables() const
+{
+    return mPimpl->mEquivalentVariables;
+}
+
+} // namespace libcellml
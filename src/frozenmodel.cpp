@@ -0,0 +1,654 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "symbols.h"
+
+#include "libcellml/component.h"
+#include "libcellml/frozenmodel.h"
+#include "libcellml/importsource.h"
+#include "libcellml/model.h"
+#include "libcellml/reset.h"
+#include "libcellml/units.h"
+#include "libcellml/variable.h"
+#include "libcellml/when.h"
+
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace libcellml {
+
+const size_t FrozenModel::NO_INDEX = std::numeric_limits<size_t>::max();
+
+/**
+ * @brief The FrozenUnit struct.
+ *
+ * The frozen data of a unit row of a units.
+ */
+struct FrozenUnit
+{
+    InternedString mReference; /**< The name of the units referred to. */
+    double mExponent = 1.0; /**< The exponent of the unit. */
+    double mMultiplier = 1.0; /**< The multiplier of the unit. */
+    std::string mPrefix; /**< The prefix of the unit. */
+};
+
+/**
+ * @brief The FrozenUnits struct.
+ *
+ * The frozen data of a units, whose unit rows are a range of the array of
+ * unit rows of the frozen model.
+ */
+struct FrozenUnits
+{
+    InternedString mName; /**< The name of the units. */
+    InternedString mImportReference; /**< The import reference of the units. */
+    size_t mFirstUnit = 0; /**< The position of the first unit row in the array of unit rows. */
+    size_t mUnitCount = 0; /**< The number of unit rows. */
+    std::string mId; /**< The id of the units. */
+    std::string mImportUrl; /**< The URL of the import source of the units. */
+};
+
+/**
+ * @brief The FrozenComponent struct.
+ *
+ * The frozen data of a component, whose children, variables and resets are
+ * ranges of the arrays of the frozen model.
+ */
+struct FrozenComponent
+{
+    InternedString mName; /**< The name of the component. */
+    InternedString mImportReference; /**< The import reference of the component. */
+    size_t mParent = FrozenModel::NO_INDEX; /**< The index of the parent component. */
+    size_t mFirstChild = 0; /**< The position of the first child in the array of children. */
+    size_t mChildCount = 0; /**< The number of children. */
+    size_t mFirstVariable = 0; /**< The index of the first variable. */
+    size_t mVariableCount = 0; /**< The number of variables. */
+    size_t mFirstReset = 0; /**< The index of the first reset. */
+    size_t mResetCount = 0; /**< The number of resets. */
+    std::string mId; /**< The id of the component. */
+    std::string mMath; /**< The math of the component. */
+    std::string mImportUrl; /**< The URL of the import source of the component. */
+};
+
+/**
+ * @brief The FrozenVariable struct.
+ *
+ * The frozen data of a variable, whose equivalent variables are a range of
+ * the array of equivalences of the frozen model.
+ */
+struct FrozenVariable
+{
+    InternedString mName; /**< The name of the variable. */
+    InternedString mUnits; /**< The name of the units of the variable. */
+    size_t mComponent = 0; /**< The index of the component of the variable. */
+    size_t mFirstEquivalent = 0; /**< The position of the first equivalent variable in the array of equivalences. */
+    size_t mEquivalentCount = 0; /**< The number of equivalent variables. */
+    std::string mId; /**< The id of the variable. */
+    std::string mInitialValue; /**< The initial value of the variable. */
+    std::string mInterfaceType; /**< The interface type of the variable. */
+};
+
+/**
+ * @brief The FrozenWhen struct.
+ *
+ * The frozen data of a when of a reset.
+ */
+struct FrozenWhen
+{
+    int mOrder = 0; /**< The order of the when. */
+    std::string mCondition; /**< The condition math of the when. */
+    std::string mValue; /**< The value math of the when. */
+};
+
+/**
+ * @brief The FrozenReset struct.
+ *
+ * The frozen data of a reset, whose whens are a range of the array of whens
+ * of the frozen model.
+ */
+struct FrozenReset
+{
+    int mOrder = 0; /**< The order of the reset. */
+    size_t mVariable = FrozenModel::NO_INDEX; /**< The index of the variable reset. */
+    size_t mComponent = 0; /**< The index of the component of the reset. */
+    size_t mFirstWhen = 0; /**< The position of the first when in the array of whens. */
+    size_t mWhenCount = 0; /**< The number of whens. */
+    std::string mId; /**< The id of the reset. */
+};
+
+/**
+ * @brief The FrozenModel::FrozenModelImpl struct.
+ *
+ * The private implementation for the FrozenModel class.
+ */
+struct FrozenModel::FrozenModelImpl
+{
+    InternedString mName;
+    std::string mId;
+    std::vector<FrozenUnits> mUnits;
+    std::vector<FrozenUnit> mUnitRows;
+    std::vector<FrozenComponent> mComponents;
+    std::vector<size_t> mChildren;
+    std::vector<FrozenVariable> mVariables;
+    std::vector<size_t> mEquivalents;
+    std::vector<FrozenReset> mResets;
+    std::vector<FrozenWhen> mWhens;
+    std::unordered_map<std::string, size_t> mUnitsIndices;
+    std::unordered_map<std::string, size_t> mComponentIndices;
+
+    size_t freezeComponent(const ComponentPtr &component, size_t parent,
+                           std::unordered_map<const Variable *, size_t> &variableIndices,
+                           std::vector<VariablePtr> &variables, std::vector<ResetPtr> &resets);
+};
+
+/**
+ * @brief The empty string returned for out of range indices.
+ */
+static const std::string EMPTY_STRING;
+
+size_t FrozenModel::FrozenModelImpl::freezeComponent(const ComponentPtr &component, size_t parent,
+                                                     std::unordered_map<const Variable *, size_t> &variableIndices,
+                                                     std::vector<VariablePtr> &variables, std::vector<ResetPtr> &resets)
+{
+    size_t index = mComponents.size();
+    mComponents.emplace_back();
+    FrozenComponent &frozenComponent = mComponents.back();
+    frozenComponent.mName = InternedString(nameSymbol(*component));
+    frozenComponent.mParent = parent;
+    frozenComponent.mId = component->id();
+    frozenComponent.mMath = component->math();
+    if (component->isImport()) {
+        frozenComponent.mImportReference = InternedString(component->importReference());
+        frozenComponent.mImportUrl = component->importSource()->url();
+    }
+    frozenComponent.mFirstVariable = mVariables.size();
+    frozenComponent.mVariableCount = component->variableCount();
+    mComponentIndices.emplace(component->name(), index);
+    for (const VariablePtr &variable : component->variables()) {
+        variableIndices.emplace(variable.get(), mVariables.size());
+        variables.push_back(variable);
+        mVariables.emplace_back();
+        FrozenVariable &frozenVariable = mVariables.back();
+        frozenVariable.mName = InternedString(nameSymbol(*variable));
+        frozenVariable.mUnits = InternedString(variable->units());
+        frozenVariable.mComponent = index;
+        frozenVariable.mId = variable->id();
+        frozenVariable.mInitialValue = variable->initialValue();
+        frozenVariable.mInterfaceType = variable->interfaceType();
+    }
+    // The variables of the resets are only known once all the components
+    // have been frozen, so they are set afterwards.
+    frozenComponent.mFirstReset = mResets.size();
+    frozenComponent.mResetCount = component->resetCount();
+    for (size_t i = 0; i < component->resetCount(); ++i) {
+        ResetPtr reset = component->reset(i);
+        resets.push_back(reset);
+        mResets.emplace_back();
+        FrozenReset &frozenReset = mResets.back();
+        frozenReset.mOrder = reset->order();
+        frozenReset.mComponent = index;
+        frozenReset.mId = reset->id();
+        frozenReset.mFirstWhen = mWhens.size();
+        frozenReset.mWhenCount = reset->whenCount();
+        for (size_t j = 0; j < reset->whenCount(); ++j) {
+            WhenPtr when = reset->when(j);
+            mWhens.emplace_back();
+            FrozenWhen &frozenWhen = mWhens.back();
+            frozenWhen.mOrder = when->order();
+            frozenWhen.mCondition = when->condition();
+            frozenWhen.mValue = when->value();
+        }
+    }
+    std::vector<size_t> children;
+    for (const ComponentPtr &child : component->components()) {
+        children.push_back(freezeComponent(child, index, variableIndices, variables, resets));
+    }
+    // The children are only known once their descendants have been frozen,
+    // so they are appended to the array of children afterwards.
+    mComponents.at(index).mFirstChild = mChildren.size();
+    mComponents.at(index).mChildCount = children.size();
+    mChildren.insert(mChildren.end(), children.begin(), children.end());
+    return index;
+}
+
+FrozenModel::FrozenModel(const Model &model)
+    : mPimpl(new FrozenModelImpl())
+{
+    mPimpl->mName = InternedString(nameSymbol(model));
+    mPimpl->mId = model.id();
+    for (size_t i = 0; i < model.unitsCount(); ++i) {
+        UnitsPtr units = model.units(i);
+        FrozenUnits frozenUnits;
+        frozenUnits.mName = InternedString(nameSymbol(*units));
+        frozenUnits.mId = units->id();
+        frozenUnits.mFirstUnit = mPimpl->mUnitRows.size();
+        frozenUnits.mUnitCount = units->unitCount();
+        for (size_t j = 0; j < units->unitCount(); ++j) {
+            std::string reference;
+            std::string id;
+            FrozenUnit frozenUnit;
+            units->unitAttributes(j, reference, frozenUnit.mPrefix, frozenUnit.mExponent, frozenUnit.mMultiplier, id);
+            frozenUnit.mReference = InternedString(reference);
+            mPimpl->mUnitRows.push_back(frozenUnit);
+        }
+        if (units->isImport()) {
+            frozenUnits.mImportReference = InternedString(units->importReference());
+            frozenUnits.mImportUrl = units->importSource()->url();
+        }
+        mPimpl->mUnitsIndices.emplace(units->name(), i);
+        mPimpl->mUnits.push_back(frozenUnits);
+    }
+    std::unordered_map<const Variable *, size_t> variableIndices;
+    std::vector<VariablePtr> variables;
+    std::vector<ResetPtr> resets;
+    for (const ComponentPtr &component : model.components()) {
+        mPimpl->freezeComponent(component, NO_INDEX, variableIndices, variables, resets);
+    }
+    for (size_t i = 0; i < variables.size(); ++i) {
+        const VariablePtr &variable = variables.at(i);
+        FrozenVariable &frozenVariable = mPimpl->mVariables.at(i);
+        frozenVariable.mFirstEquivalent = mPimpl->mEquivalents.size();
+        for (size_t j = 0; j < variable->equivalentVariableCount(); ++j) {
+            auto found = variableIndices.find(variable->equivalentVariable(j).get());
+            if (found != variableIndices.end()) {
+                mPimpl->mEquivalents.push_back(found->second);
+            }
+        }
+        frozenVariable.mEquivalentCount = mPimpl->mEquivalents.size() - frozenVariable.mFirstEquivalent;
+    }
+    for (size_t i = 0; i < resets.size(); ++i) {
+        auto found = variableIndices.find(resets.at(i)->variable().get());
+        if (found != variableIndices.end()) {
+            mPimpl->mResets.at(i).mVariable = found->second;
+        }
+    }
+}
+
+FrozenModel::~FrozenModel()
+{
+    delete mPimpl;
+}
+
+const std::string &FrozenModel::name() const
+{
+    return mPimpl->mName.string();
+}
+
+const std::string &FrozenModel::id() const
+{
+    return mPimpl->mId;
+}
+
+size_t FrozenModel::unitsCount() const
+{
+    return mPimpl->mUnits.size();
+}
+
+size_t FrozenModel::units(const std::string &name) const
+{
+    auto found = mPimpl->mUnitsIndices.find(name);
+    if (found == mPimpl->mUnitsIndices.end()) {
+        return NO_INDEX;
+    }
+    return found->second;
+}
+
+const std::string &FrozenModel::unitsName(size_t units) const
+{
+    if (units < mPimpl->mUnits.size()) {
+        return mPimpl->mUnits[units].mName.string();
+    }
+    return EMPTY_STRING;
+}
+
+const std::string &FrozenModel::unitsId(size_t units) const
+{
+    if (units < mPimpl->mUnits.size()) {
+        return mPimpl->mUnits[units].mId;
+    }
+    return EMPTY_STRING;
+}
+
+const std::string &FrozenModel::unitsImportUrl(size_t units) const
+{
+    if (units < mPimpl->mUnits.size()) {
+        return mPimpl->mUnits[units].mImportUrl;
+    }
+    return EMPTY_STRING;
+}
+
+const std::string &FrozenModel::unitsImportReference(size_t units) const
+{
+    if (units < mPimpl->mUnits.size()) {
+        return mPimpl->mUnits[units].mImportReference.string();
+    }
+    return EMPTY_STRING;
+}
+
+size_t FrozenModel::unitsUnitCount(size_t units) const
+{
+    if (units < mPimpl->mUnits.size()) {
+        return mPimpl->mUnits[units].mUnitCount;
+    }
+    return 0;
+}
+
+const std::string &FrozenModel::unitsUnitReference(size_t units, size_t index) const
+{
+    if ((units < mPimpl->mUnits.size())
+        && (index < mPimpl->mUnits[units].mUnitCount)) {
+        return mPimpl->mUnitRows[mPimpl->mUnits[units].mFirstUnit + index].mReference.string();
+    }
+    return EMPTY_STRING;
+}
+
+const std::string &FrozenModel::unitsUnitPrefix(size_t units, size_t index) const
+{
+    if ((units < mPimpl->mUnits.size())
+        && (index < mPimpl->mUnits[units].mUnitCount)) {
+        return mPimpl->mUnitRows[mPimpl->mUnits[units].mFirstUnit + index].mPrefix;
+    }
+    return EMPTY_STRING;
+}
+
+double FrozenModel::unitsUnitExponent(size_t units, size_t index) const
+{
+    if ((units < mPimpl->mUnits.size())
+        && (index < mPimpl->mUnits[units].mUnitCount)) {
+        return mPimpl->mUnitRows[mPimpl->mUnits[units].mFirstUnit + index].mExponent;
+    }
+    return 1.0;
+}
+
+double FrozenModel::unitsUnitMultiplier(size_t units, size_t index) const
+{
+    if ((units < mPimpl->mUnits.size())
+        && (index < mPimpl->mUnits[units].mUnitCount)) {
+        return mPimpl->mUnitRows[mPimpl->mUnits[units].mFirstUnit + index].mMultiplier;
+    }
+    return 1.0;
+}
+
+size_t FrozenModel::componentCount() const
+{
+    return mPimpl->mComponents.size();
+}
+
+size_t FrozenModel::component(const std::string &name) const
+{
+    auto found = mPimpl->mComponentIndices.find(name);
+    if (found == mPimpl->mComponentIndices.end()) {
+        return NO_INDEX;
+    }
+    return found->second;
+}
+
+const std::string &FrozenModel::componentName(size_t component) const
+{
+    if (component < mPimpl->mComponents.size()) {
+        return mPimpl->mComponents[component].mName.string();
+    }
+    return EMPTY_STRING;
+}
+
+const std::string &FrozenModel::componentId(size_t component) const
+{
+    if (component < mPimpl->mComponents.size()) {
+        return mPimpl->mComponents[component].mId;
+    }
+    return EMPTY_STRING;
+}
+
+const std::string &FrozenModel::componentMath(size_t component) const
+{
+    if (component < mPimpl->mComponents.size()) {
+        return mPimpl->mComponents[component].mMath;
+    }
+    return EMPTY_STRING;
+}
+
+const std::string &FrozenModel::componentImportUrl(size_t component) const
+{
+    if (component < mPimpl->mComponents.size()) {
+        return mPimpl->mComponents[component].mImportUrl;
+    }
+    return EMPTY_STRING;
+}
+
+const std::string &FrozenModel::componentImportReference(size_t component) const
+{
+    if (component < mPimpl->mComponents.size()) {
+        return mPimpl->mComponents[component].mImportReference.string();
+    }
+    return EMPTY_STRING;
+}
+
+size_t FrozenModel::componentParent(size_t component) const
+{
+    if (component < mPimpl->mComponents.size()) {
+        return mPimpl->mComponents[component].mParent;
+    }
+    return NO_INDEX;
+}
+
+size_t FrozenModel::componentChildCount(size_t component) const
+{
+    if (component < mPimpl->mComponents.size()) {
+        return mPimpl->mComponents[component].mChildCount;
+    }
+    return 0;
+}
+
+size_t FrozenModel::componentChild(size_t component, size_t index) const
+{
+    if ((component < mPimpl->mComponents.size())
+        && (index < mPimpl->mComponents[component].mChildCount)) {
+        return mPimpl->mChildren[mPimpl->mComponents[component].mFirstChild + index];
+    }
+    return NO_INDEX;
+}
+
+size_t FrozenModel::componentVariableCount(size_t component) const
+{
+    if (component < mPimpl->mComponents.size()) {
+        return mPimpl->mComponents[component].mVariableCount;
+    }
+    return 0;
+}
+
+size_t FrozenModel::componentFirstVariable(size_t component) const
+{
+    if (component < mPimpl->mComponents.size()) {
+        return mPimpl->mComponents[component].mFirstVariable;
+    }
+    return NO_INDEX;
+}
+
+size_t FrozenModel::variableCount() const
+{
+    return mPimpl->mVariables.size();
+}
+
+size_t FrozenModel::variable(size_t component, const std::string &name) const
+{
+    if (component < mPimpl->mComponents.size()) {
+        const FrozenComponent &frozenComponent = mPimpl->mComponents[component];
+        for (size_t i = 0; i < frozenComponent.mVariableCount; ++i) {
+            size_t variable = frozenComponent.mFirstVariable + i;
+            if (mPimpl->mVariables[variable].mName.string() == name) {
+                return variable;
+            }
+        }
+    }
+    return NO_INDEX;
+}
+
+const std::string &FrozenModel::variableName(size_t variable) const
+{
+    if (variable < mPimpl->mVariables.size()) {
+        return mPimpl->mVariables[variable].mName.string();
+    }
+    return EMPTY_STRING;
+}
+
+const std::string &FrozenModel::variableId(size_t variable) const
+{
+    if (variable < mPimpl->mVariables.size()) {
+        return mPimpl->mVariables[variable].mId;
+    }
+    return EMPTY_STRING;
+}
+
+const std::string &FrozenModel::variableUnits(size_t variable) const
+{
+    if (variable < mPimpl->mVariables.size()) {
+        return mPimpl->mVariables[variable].mUnits.string();
+    }
+    return EMPTY_STRING;
+}
+
+const std::string &FrozenModel::variableInitialValue(size_t variable) const
+{
+    if (variable < mPimpl->mVariables.size()) {
+        return mPimpl->mVariables[variable].mInitialValue;
+    }
+    return EMPTY_STRING;
+}
+
+const std::string &FrozenModel::variableInterfaceType(size_t variable) const
+{
+    if (variable < mPimpl->mVariables.size()) {
+        return mPimpl->mVariables[variable].mInterfaceType;
+    }
+    return EMPTY_STRING;
+}
+
+size_t FrozenModel::variableComponent(size_t variable) const
+{
+    if (variable < mPimpl->mVariables.size()) {
+        return mPimpl->mVariables[variable].mComponent;
+    }
+    return NO_INDEX;
+}
+
+size_t FrozenModel::equivalentVariableCount(size_t variable) const
+{
+    if (variable < mPimpl->mVariables.size()) {
+        return mPimpl->mVariables[variable].mEquivalentCount;
+    }
+    return 0;
+}
+
+size_t FrozenModel::equivalentVariable(size_t variable, size_t index) const
+{
+    if ((variable < mPimpl->mVariables.size())
+        && (index < mPimpl->mVariables[variable].mEquivalentCount)) {
+        return mPimpl->mEquivalents[mPimpl->mVariables[variable].mFirstEquivalent + index];
+    }
+    return NO_INDEX;
+}
+
+size_t FrozenModel::componentResetCount(size_t component) const
+{
+    if (component < mPimpl->mComponents.size()) {
+        return mPimpl->mComponents[component].mResetCount;
+    }
+    return 0;
+}
+
+size_t FrozenModel::componentFirstReset(size_t component) const
+{
+    if (component < mPimpl->mComponents.size()) {
+        return mPimpl->mComponents[component].mFirstReset;
+    }
+    return NO_INDEX;
+}
+
+size_t FrozenModel::resetCount() const
+{
+    return mPimpl->mResets.size();
+}
+
+const std::string &FrozenModel::resetId(size_t reset) const
+{
+    if (reset < mPimpl->mResets.size()) {
+        return mPimpl->mResets[reset].mId;
+    }
+    return EMPTY_STRING;
+}
+
+int FrozenModel::resetOrder(size_t reset) const
+{
+    if (reset < mPimpl->mResets.size()) {
+        return mPimpl->mResets[reset].mOrder;
+    }
+    return 0;
+}
+
+size_t FrozenModel::resetVariable(size_t reset) const
+{
+    if (reset < mPimpl->mResets.size()) {
+        return mPimpl->mResets[reset].mVariable;
+    }
+    return NO_INDEX;
+}
+
+size_t FrozenModel::resetComponent(size_t reset) const
+{
+    if (reset < mPimpl->mResets.size()) {
+        return mPimpl->mResets[reset].mComponent;
+    }
+    return NO_INDEX;
+}
+
+size_t FrozenModel::resetWhenCount(size_t reset) const
+{
+    if (reset < mPimpl->mResets.size()) {
+        return mPimpl->mResets[reset].mWhenCount;
+    }
+    return 0;
+}
+
+int FrozenModel::resetWhenOrder(size_t reset, size_t index) const
+{
+    if ((reset < mPimpl->mResets.size())
+        && (index < mPimpl->mResets[reset].mWhenCount)) {
+        return mPimpl->mWhens[mPimpl->mResets[reset].mFirstWhen + index].mOrder;
+    }
+    return 0;
+}
+
+const std::string &FrozenModel::resetWhenCondition(size_t reset, size_t index) const
+{
+    if ((reset < mPimpl->mResets.size())
+        && (index < mPimpl->mResets[reset].mWhenCount)) {
+        return mPimpl->mWhens[mPimpl->mResets[reset].mFirstWhen + index].mCondition;
+    }
+    return EMPTY_STRING;
+}
+
+const std::string &FrozenModel::resetWhenValue(size_t reset, size_t index) const
+{
+    if ((reset < mPimpl->mResets.size())
+        && (index < mPimpl->mResets[reset].mWhenCount)) {
+        return mPimpl->mWhens[mPimpl->mResets[reset].mFirstWhen + index].mValue;
+    }
+    return EMPTY_STRING;
+}
+
+} // namespace libcellml
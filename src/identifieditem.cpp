@@ -0,0 +1,107 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "libcellml/entity.h"
+#include "libcellml/identifieditem.h"
+#include "libcellml/variable.h"
+
+#include <memory>
+
+namespace libcellml {
+
+/**
+ * @brief The IdentifiedItem::IdentifiedItemImpl struct.
+ *
+ * The private implementation for the IdentifiedItem class.
+ */
+struct IdentifiedItem::IdentifiedItemImpl
+{
+    IdentifiedItem::Type mType = IdentifiedItem::Type::MODEL; /**< The type of the item. */
+    std::weak_ptr<Entity> mEntity; /**< The entity the item is or belongs to. */
+    size_t mIndex = 0; /**< The index of the unit the item is. */
+    std::weak_ptr<Variable> mVariable1; /**< The first variable of the equivalence the item is. */
+    std::weak_ptr<Variable> mVariable2; /**< The second variable of the equivalence the item is. */
+};
+
+IdentifiedItem::IdentifiedItem(Type type, const EntityPtr &entity, size_t index)
+    : mPimpl(new IdentifiedItemImpl())
+{
+    mPimpl->mType = type;
+    mPimpl->mEntity = entity;
+    mPimpl->mIndex = index;
+}
+
+IdentifiedItem::IdentifiedItem(Type type, const VariablePtr &variable1, const VariablePtr &variable2)
+    : mPimpl(new IdentifiedItemImpl())
+{
+    mPimpl->mType = type;
+    mPimpl->mVariable1 = variable1;
+    mPimpl->mVariable2 = variable2;
+}
+
+IdentifiedItem::~IdentifiedItem()
+{
+    delete mPimpl;
+}
+
+IdentifiedItem::IdentifiedItem(const IdentifiedItem &rhs)
+    : mPimpl(new IdentifiedItemImpl(*rhs.mPimpl))
+{
+}
+
+IdentifiedItem::IdentifiedItem(IdentifiedItem &&rhs) noexcept
+    : mPimpl(rhs.mPimpl)
+{
+    rhs.mPimpl = nullptr;
+}
+
+IdentifiedItem &IdentifiedItem::operator=(IdentifiedItem rhs)
+{
+    rhs.swap(*this);
+    return *this;
+}
+
+void IdentifiedItem::swap(IdentifiedItem &rhs)
+{
+    std::swap(this->mPimpl, rhs.mPimpl);
+}
+
+IdentifiedItem::Type IdentifiedItem::type() const
+{
+    return mPimpl->mType;
+}
+
+EntityPtr IdentifiedItem::entity() const
+{
+    return mPimpl->mEntity.lock();
+}
+
+size_t IdentifiedItem::index() const
+{
+    return mPimpl->mIndex;
+}
+
+VariablePtr IdentifiedItem::variable1() const
+{
+    return mPimpl->mVariable1.lock();
+}
+
+VariablePtr IdentifiedItem::variable2() const
+{
+    return mPimpl->mVariable2.lock();
+}
+
+} // namespace libcellml
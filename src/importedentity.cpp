@@ -14,6 +14,10 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include "arena.h"
+#include "symbols.h"
+
+#include "libcellml/entity.h"
 #include "libcellml/importedentity.h"
 
 namespace libcellml {
@@ -26,23 +30,22 @@ namespace libcellml {
 struct ImportedEntity::ImportedEntityImpl
 {
     ImportSourcePtr mImportSource;
-    std::string mImportReference;
+    InternedString mImportReference;
 };
 
 ImportedEntity::ImportedEntity()
-    : mPimpl(new ImportedEntityImpl())
+    : mPimpl(newImpl<ImportedEntityImpl>())
 {
     mPimpl->mImportSource = nullptr;
-    mPimpl->mImportReference = "";
 }
 
 ImportedEntity::~ImportedEntity()
 {
-    delete mPimpl;
+    deleteImpl(mPimpl);
 }
 
 ImportedEntity::ImportedEntity(const ImportedEntity &rhs)
-    : mPimpl(new ImportedEntityImpl())
+    : mPimpl(newImpl<ImportedEntityImpl>())
 {
     mPimpl->mImportSource = rhs.mPimpl->mImportSource;
     mPimpl->mImportReference = rhs.mPimpl->mImportReference;
@@ -75,19 +78,29 @@ ImportSourcePtr ImportedEntity::importSource() const
     return mPimpl->mImportSource;
 }
 
+void ImportedEntity::markEntityModified()
+{
+    auto entity = dynamic_cast<Entity *>(this);
+    if (entity != nullptr) {
+        entity->markModified();
+    }
+}
+
 void ImportedEntity::setImportSource(const ImportSourcePtr &importSource)
 {
     mPimpl->mImportSource = importSource;
+    markEntityModified();
 }
 
-std::string ImportedEntity::importReference() const
+const std::string &ImportedEntity::importReference() const
 {
-    return mPimpl->mImportReference;
+    return mPimpl->mImportReference.string();
 }
 
 void ImportedEntity::setImportReference(const std::string &reference)
 {
-    mPimpl->mImportReference = reference;
+    mPimpl->mImportReference = InternedString(reference);
+    markEntityModified();
 }
 
 } // namespace libcellml
@@ -0,0 +1,122 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "libcellml/importlibrary.h"
+#include "libcellml/model.h"
+#include "libcellml/parser.h"
+
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+
+namespace libcellml {
+
+/**
+ * @brief The ImportedFile struct.
+ *
+ * A model held by an import library, with the contents of the file it was
+ * parsed from.
+ */
+struct ImportedFile
+{
+    std::string mContents; /**< The contents of the file when the model was parsed. */
+    ModelPtr mModel; /**< The model parsed from the file. */
+};
+
+/**
+ * @brief The ImportLibrary::ImportLibraryImpl struct.
+ *
+ * The private implementation for the ImportLibrary class.
+ */
+struct ImportLibrary::ImportLibraryImpl
+{
+    std::map<std::string, ImportedFile> mFiles; /**< The imported files, by location. */
+};
+
+ImportLibrary::ImportLibrary()
+    : mPimpl(new ImportLibraryImpl())
+{
+}
+
+ImportLibrary::~ImportLibrary()
+{
+    delete mPimpl;
+}
+
+ImportLibrary::ImportLibrary(const ImportLibrary &rhs)
+    : mPimpl(new ImportLibraryImpl(*rhs.mPimpl))
+{
+}
+
+ImportLibrary::ImportLibrary(ImportLibrary &&rhs) noexcept
+    : mPimpl(rhs.mPimpl)
+{
+    rhs.mPimpl = nullptr;
+}
+
+ImportLibrary &ImportLibrary::operator=(ImportLibrary rhs)
+{
+    rhs.swap(*this);
+    return *this;
+}
+
+void ImportLibrary::swap(ImportLibrary &rhs)
+{
+    std::swap(this->mPimpl, rhs.mPimpl);
+}
+
+ModelPtr ImportLibrary::importedModel(const std::string &url)
+{
+    std::ifstream file(url);
+    if (!file.good()) {
+        return nullptr;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string contents = buffer.str();
+    auto found = mPimpl->mFiles.find(url);
+    if ((found != mPimpl->mFiles.end()) && (found->second.mContents == contents)) {
+        return found->second.mModel;
+    }
+    Parser parser;
+    ModelPtr model = parser.parseModel(contents);
+    // The model is held before its own imports are resolved, so that files
+    // importing each other do not lead to endless recursion.
+    ImportedFile &importedFile = mPimpl->mFiles[url];
+    importedFile.mContents = std::move(contents);
+    importedFile.mModel = model;
+    model->resolveImports(url, *this);
+    return model;
+}
+
+bool ImportLibrary::hasModel(const std::string &url) const
+{
+    return mPimpl->mFiles.find(url) != mPimpl->mFiles.end();
+}
+
+size_t ImportLibrary::modelCount() const
+{
+    return mPimpl->mFiles.size();
+}
+
+void ImportLibrary::clear()
+{
+    mPimpl->mFiles.clear();
+}
+
+} // namespace libcellml
@@ -14,9 +14,16 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include "arena.h"
+
 #include "libcellml/importsource.h"
 #include "libcellml/model.h"
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
 namespace libcellml {
 
 /**
@@ -28,22 +35,34 @@ struct ImportSource::ImportSourceImpl
 {
     std::string mUrl;
     ModelPtr mModel;
+    std::shared_ptr<ModelPtr> mModelOwner; /**< The private handle on mModel behind the pointers given out by mutableModel(), set while this import source owns mModel. */
+    std::mutex mComponentsMutex; /**< The mutex guarding the components looked up below. */
+    size_t mComponentsRevision = 0; /**< The revision of the model when the components were looked up in it. */
+    std::map<std::string, std::weak_ptr<Component>> mComponents; /**< The components looked up by name, see importedComponent(). */
+
+    void clearComponents();
 };
 
+void ImportSource::ImportSourceImpl::clearComponents()
+{
+    std::lock_guard<std::mutex> lock(mComponentsMutex);
+    mComponents.clear();
+}
+
 ImportSource::ImportSource()
-    : mPimpl(new ImportSourceImpl())
+    : mPimpl(newImpl<ImportSourceImpl>())
 {
     mPimpl->mModel = nullptr;
 }
 
 ImportSource::~ImportSource()
 {
-    delete mPimpl;
+    deleteImpl(mPimpl);
 }
 
 ImportSource::ImportSource(const ImportSource &rhs)
     : Entity(rhs)
-    , mPimpl(new ImportSourceImpl())
+    , mPimpl(newImpl<ImportSourceImpl>())
 {
     mPimpl->mUrl = rhs.mPimpl->mUrl;
     mPimpl->mModel = rhs.mPimpl->mModel;
@@ -76,6 +95,8 @@ std::string ImportSource::url() const
 void ImportSource::setUrl(const std::string &url)
 {
     mPimpl->mUrl = url;
+    mPimpl->clearComponents();
+    markModified();
 }
 
 ModelPtr ImportSource::model() const
@@ -86,6 +107,30 @@ ModelPtr ImportSource::model() const
 void ImportSource::setModel(const ModelPtr &model)
 {
     mPimpl->mModel = model;
+    mPimpl->mModelOwner = nullptr;
+    mPimpl->clearComponents();
+    markModified();
+}
+
+ModelPtr ImportSource::mutableModel()
+{
+    if (mPimpl->mModel == nullptr) {
+        return nullptr;
+    }
+    // The pointers given out below share the control block of the private
+    // handle, which holds a single reference to the model, so any reference
+    // beyond those of this import source means the model is shared.
+    long ownReferences = (mPimpl->mModelOwner != nullptr) ? 2 : 1;
+    if (mPimpl->mModel.use_count() > ownReferences) {
+        mPimpl->mModel = mPimpl->mModel->clone();
+        mPimpl->mModelOwner = nullptr;
+        mPimpl->clearComponents();
+        markModified();
+    }
+    if (mPimpl->mModelOwner == nullptr) {
+        mPimpl->mModelOwner = std::make_shared<ModelPtr>(mPimpl->mModel);
+    }
+    return ModelPtr(mPimpl->mModelOwner, mPimpl->mModelOwner->get());
 }
 
 bool ImportSource::hasModel() const
@@ -93,4 +138,24 @@ bool ImportSource::hasModel() const
     return mPimpl->mModel != nullptr;
 }
 
+ComponentPtr ImportSource::importedComponent(const std::string &reference) const
+{
+    if (mPimpl->mModel == nullptr) {
+        return nullptr;
+    }
+    // Look ups may happen concurrently, e.g. from the threads of the validator.
+    std::lock_guard<std::mutex> lock(mPimpl->mComponentsMutex);
+    if (mPimpl->mComponentsRevision != mPimpl->mModel->revision()) {
+        mPimpl->mComponents.clear();
+        mPimpl->mComponentsRevision = mPimpl->mModel->revision();
+    }
+    auto found = mPimpl->mComponents.find(reference);
+    if (found != mPimpl->mComponents.end()) {
+        return found->second.lock();
+    }
+    ComponentPtr component = mPimpl->mModel->component(reference, true);
+    mPimpl->mComponents.emplace(reference, component);
+    return component;
+}
+
 } // namespace libcellml
@@ -0,0 +1,377 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "mathast.h"
+#include "namespaces.h"
+#include "utilities.h"
+#include "xmldoc.h"
+#include "xmlnode.h"
+
+#include "libcellml/component.h"
+#include "libcellml/variable.h"
+
+#include <cmath>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace libcellml {
+
+/**
+ * @brief Map MathML operator and constant element names to AST node types.
+ *
+ * An internal map used to convert the name of a MathML element into the
+ * @c MathAst::Type of the node it is parsed into.
+ */
+static const std::map<std::string, MathAst::Type> mathAstTypeMap = {
+    {"eq", MathAst::Type::EQ},
+    {"neq", MathAst::Type::NEQ},
+    {"lt", MathAst::Type::LT},
+    {"leq", MathAst::Type::LEQ},
+    {"gt", MathAst::Type::GT},
+    {"geq", MathAst::Type::GEQ},
+    {"and", MathAst::Type::AND},
+    {"or", MathAst::Type::OR},
+    {"xor", MathAst::Type::XOR},
+    {"not", MathAst::Type::NOT},
+    {"plus", MathAst::Type::PLUS},
+    {"minus", MathAst::Type::MINUS},
+    {"times", MathAst::Type::TIMES},
+    {"divide", MathAst::Type::DIVIDE},
+    {"power", MathAst::Type::POWER},
+    {"root", MathAst::Type::ROOT},
+    {"abs", MathAst::Type::ABS},
+    {"exp", MathAst::Type::EXP},
+    {"ln", MathAst::Type::LN},
+    {"log", MathAst::Type::LOG},
+    {"floor", MathAst::Type::FLOOR},
+    {"ceiling", MathAst::Type::CEILING},
+    {"min", MathAst::Type::MIN},
+    {"max", MathAst::Type::MAX},
+    {"rem", MathAst::Type::REM},
+    {"diff", MathAst::Type::DIFF},
+    {"sin", MathAst::Type::SIN},
+    {"cos", MathAst::Type::COS},
+    {"tan", MathAst::Type::TAN},
+    {"sec", MathAst::Type::SEC},
+    {"csc", MathAst::Type::CSC},
+    {"cot", MathAst::Type::COT},
+    {"sinh", MathAst::Type::SINH},
+    {"cosh", MathAst::Type::COSH},
+    {"tanh", MathAst::Type::TANH},
+    {"sech", MathAst::Type::SECH},
+    {"csch", MathAst::Type::CSCH},
+    {"coth", MathAst::Type::COTH},
+    {"arcsin", MathAst::Type::ARCSIN},
+    {"arccos", MathAst::Type::ARCCOS},
+    {"arctan", MathAst::Type::ARCTAN},
+    {"arcsec", MathAst::Type::ARCSEC},
+    {"arccsc", MathAst::Type::ARCCSC},
+    {"arccot", MathAst::Type::ARCCOT},
+    {"arcsinh", MathAst::Type::ARCSINH},
+    {"arccosh", MathAst::Type::ARCCOSH},
+    {"arctanh", MathAst::Type::ARCTANH},
+    {"arcsech", MathAst::Type::ARCSECH},
+    {"arccsch", MathAst::Type::ARCCSCH},
+    {"arccoth", MathAst::Type::ARCCOTH},
+    {"true", MathAst::Type::BOOLEAN_TRUE},
+    {"false", MathAst::Type::BOOLEAN_FALSE},
+    {"exponentiale", MathAst::Type::E},
+    {"pi", MathAst::Type::PI},
+    {"infinity", MathAst::Type::INF},
+    {"notanumber", MathAst::Type::NOT_A_NUMBER},
+};
+
+/**
+ * @brief Get the next MathML element at or after @p node.
+ *
+ * Skip over any text, comment or non-MathML nodes starting from (and
+ * including) @p node.
+ *
+ * @param node The node to start searching from.
+ *
+ * @return The next MathML element, or @c nullptr if there is none.
+ */
+static XmlNodePtr nextMathmlElement(XmlNodePtr node)
+{
+    while ((node != nullptr) && (node->isText() || node->isComment() || (node->namespaceUri() != MATHML_NS))) {
+        node = node->next();
+    }
+    return node;
+}
+
+static MathAstPtr parseMathAstNode(const XmlNodePtr &node, const ComponentPtr &component, std::string &error);
+
+/**
+ * @brief Parse the MathML element children of @p node into @p ast.
+ *
+ * Parse each MathML element child of @p node, starting from @p firstChild, and
+ * append it to the children of @p ast.
+ *
+ * @param firstChild The first candidate child node.
+ * @param ast The AST node to append the children to.
+ * @param component The component the math belongs to.
+ * @param error The @c std::string to set to a description of any error.
+ *
+ * @return @c true on success, @c false otherwise.
+ */
+static bool parseMathAstChildren(const XmlNodePtr &firstChild, const MathAstPtr &ast, const ComponentPtr &component, std::string &error)
+{
+    XmlNodePtr childNode = nextMathmlElement(firstChild);
+    while (childNode != nullptr) {
+        MathAstPtr child = parseMathAstNode(childNode, component, error);
+        if (child == nullptr) {
+            return false;
+        }
+        ast->mChildren.push_back(child);
+        childNode = nextMathmlElement(childNode->next());
+    }
+    return true;
+}
+
+/**
+ * @brief Parse the MathML element @p node into an AST node.
+ *
+ * @param node The MathML element to parse.
+ * @param component The component the math belongs to.
+ * @param error The @c std::string to set to a description of any error.
+ *
+ * @return The parsed AST node, or @c nullptr on failure.
+ */
+static MathAstPtr parseMathAstNode(const XmlNodePtr &node, const ComponentPtr &component, std::string &error)
+{
+    MathAstPtr ast = std::make_shared<MathAst>();
+    std::string name = node->name();
+    if (name == "ci") {
+        XmlNodePtr textNode = node->firstChild();
+        if (textNode != nullptr) {
+            ast->mName = textNode->convertToStrippedString();
+        }
+        ast->mType = MathAst::Type::CI;
+        ast->mVariable = component->variable(ast->mName);
+        if (ast->mVariable == nullptr) {
+            error = "MathML ci element '" + ast->mName + "' does not correspond with any variable in component '" + component->name() + "'.";
+            return nullptr;
+        }
+    } else if (name == "cn") {
+        ast->mType = MathAst::Type::CN;
+        ast->mUnits = node->attribute("units");
+        std::string mantissa;
+        std::string exponent;
+        bool seenSep = false;
+        XmlNodePtr childNode = node->firstChild();
+        while (childNode != nullptr) {
+            if (childNode->isText()) {
+                if (seenSep) {
+                    exponent += childNode->convertToStrippedString();
+                } else {
+                    mantissa += childNode->convertToStrippedString();
+                }
+            } else if (childNode->isMathmlElement("sep")) {
+                seenSep = true;
+            }
+            childNode = childNode->next();
+        }
+        if (!isCellMLReal(mantissa) || (seenSep && !isCellMLInteger(exponent))) {
+            error = "MathML cn element '" + mantissa + (seenSep ? "e" + exponent : "") + "' in component '" + component->name() + "' is not a valid real number.";
+            return nullptr;
+        }
+        ast->mValue = convertToDouble(mantissa);
+        if (seenSep) {
+            ast->mValue *= std::pow(10.0, convertToDouble(exponent));
+        }
+    } else if (name == "apply") {
+        XmlNodePtr operatorNode = nextMathmlElement(node->firstChild());
+        if (operatorNode == nullptr) {
+            error = "MathML apply element in component '" + component->name() + "' has no operator.";
+            return nullptr;
+        }
+        auto found = mathAstTypeMap.find(operatorNode->name());
+        if ((found == mathAstTypeMap.end()) || (found->second >= MathAst::Type::PIECEWISE)) {
+            error = "MathML operator '" + operatorNode->name() + "' in component '" + component->name() + "' is not supported.";
+            return nullptr;
+        }
+        ast->mType = found->second;
+        if (!parseMathAstChildren(operatorNode->next(), ast, component, error)) {
+            return nullptr;
+        }
+    } else if (name == "piecewise") {
+        ast->mType = MathAst::Type::PIECEWISE;
+        if (!parseMathAstChildren(node->firstChild(), ast, component, error)) {
+            return nullptr;
+        }
+    } else if (name == "piece") {
+        ast->mType = MathAst::Type::PIECE;
+        if (!parseMathAstChildren(node->firstChild(), ast, component, error)) {
+            return nullptr;
+        }
+        if (ast->mChildren.size() != 2) {
+            error = "MathML piece element in component '" + component->name() + "' does not have exactly two children.";
+            return nullptr;
+        }
+    } else if (name == "otherwise") {
+        ast->mType = MathAst::Type::OTHERWISE;
+        if (!parseMathAstChildren(node->firstChild(), ast, component, error)) {
+            return nullptr;
+        }
+        if (ast->mChildren.size() != 1) {
+            error = "MathML otherwise element in component '" + component->name() + "' does not have exactly one child.";
+            return nullptr;
+        }
+    } else if ((name == "bvar") || (name == "degree") || (name == "logbase")) {
+        if (name == "bvar") {
+            ast->mType = MathAst::Type::BVAR;
+        } else if (name == "degree") {
+            ast->mType = MathAst::Type::DEGREE;
+        } else {
+            ast->mType = MathAst::Type::LOGBASE;
+        }
+        if (!parseMathAstChildren(node->firstChild(), ast, component, error)) {
+            return nullptr;
+        }
+    } else {
+        auto found = mathAstTypeMap.find(name);
+        if ((found == mathAstTypeMap.end()) || (found->second < MathAst::Type::BOOLEAN_TRUE)) {
+            error = "MathML element '" + name + "' in component '" + component->name() + "' is not supported.";
+            return nullptr;
+        }
+        ast->mType = found->second;
+    }
+    return ast;
+}
+
+bool parseMathAst(const std::string &math, const ComponentPtr &component,
+                  std::vector<MathAstPtr> &asts, std::string &error)
+{
+    // The stored math may consist of several sibling math elements, each of
+    // which may start with an XML declaration and refer to the cellml prefix
+    // without declaring it, so wrap it all up into a single document.
+    std::string content = math;
+    size_t declarationStart = content.find("<?xml");
+    while (declarationStart != std::string::npos) {
+        size_t declarationEnd = content.find("?>", declarationStart);
+        if (declarationEnd == std::string::npos) {
+            break;
+        }
+        content.erase(declarationStart, declarationEnd + 2 - declarationStart);
+        declarationStart = content.find("<?xml", declarationStart);
+    }
+    std::string wrapped = std::string("<wrapper xmlns=\"") + MATHML_NS + "\" xmlns:cellml=\"" + CELLML_2_0_NS + "\">" + content + "</wrapper>";
+    XmlDocPtr doc = std::make_shared<XmlDoc>();
+    doc->parse(wrapped);
+    if (doc->xmlErrorCount() > 0) {
+        error = doc->xmlError(0);
+        return false;
+    }
+    XmlNodePtr root = doc->rootNode();
+    if (root == nullptr) {
+        error = "Could not get a valid XML root node from the math on component '" + component->name() + "'.";
+        return false;
+    }
+    XmlNodePtr mathNode = nextMathmlElement(root->firstChild());
+    while (mathNode != nullptr) {
+        if (!mathNode->isMathmlElement("math")) {
+            error = "Math root node is of invalid type '" + mathNode->name() + "' on component '" + component->name() + "'. A valid math root node should be of type 'math'.";
+            return false;
+        }
+        MathAstPtr wrapper = std::make_shared<MathAst>();
+        if (!parseMathAstChildren(mathNode->firstChild(), wrapper, component, error)) {
+            return false;
+        }
+        asts.insert(asts.end(), wrapper->mChildren.begin(), wrapper->mChildren.end());
+        mathNode = nextMathmlElement(mathNode->next());
+    }
+    return true;
+}
+
+bool isDerivative(const MathAstPtr &ast, VariablePtr &variable, VariablePtr &bvar)
+{
+    if ((ast == nullptr) || (ast->mType != MathAst::Type::DIFF) || (ast->mChildren.size() != 2)) {
+        return false;
+    }
+    MathAstPtr bvarNode = ast->mChildren.at(0);
+    MathAstPtr variableNode = ast->mChildren.at(1);
+    if ((bvarNode->mType != MathAst::Type::BVAR) || (variableNode->mType != MathAst::Type::CI)) {
+        return false;
+    }
+    // Only first order derivatives are supported.
+    for (const MathAstPtr &child : bvarNode->mChildren) {
+        if (child->mType == MathAst::Type::DEGREE) {
+            if ((child->mChildren.size() != 1)
+                || (child->mChildren.at(0)->mType != MathAst::Type::CN)
+                || (child->mChildren.at(0)->mValue != 1.0)) {
+                return false;
+            }
+        } else if (child->mType == MathAst::Type::CI) {
+            bvar = child->mVariable;
+        } else {
+            return false;
+        }
+    }
+    if (bvar == nullptr) {
+        return false;
+    }
+    variable = variableNode->mVariable;
+    return true;
+}
+
+MathAstPtr createMathAstNumber(double value)
+{
+    MathAstPtr ast = std::make_shared<MathAst>();
+    ast->mType = MathAst::Type::CN;
+    ast->mValue = value;
+    return ast;
+}
+
+MathAstPtr createMathAstNode(MathAst::Type type, const std::vector<MathAstPtr> &children)
+{
+    MathAstPtr ast = std::make_shared<MathAst>();
+    ast->mType = type;
+    ast->mChildren = children;
+    return ast;
+}
+
+std::string mathAstTypeName(MathAst::Type type)
+{
+    for (const auto &entry : mathAstTypeMap) {
+        if (entry.second == type) {
+            return entry.first;
+        }
+    }
+    switch (type) {
+    case MathAst::Type::CI:
+        return "ci";
+    case MathAst::Type::PIECEWISE:
+        return "piecewise";
+    case MathAst::Type::PIECE:
+        return "piece";
+    case MathAst::Type::OTHERWISE:
+        return "otherwise";
+    case MathAst::Type::BVAR:
+        return "bvar";
+    case MathAst::Type::DEGREE:
+        return "degree";
+    case MathAst::Type::LOGBASE:
+        return "logbase";
+    case MathAst::Type::LOOKUP:
+        return "lookup";
+    default:
+        return "cn";
+    }
+}
+
+} // namespace libcellml
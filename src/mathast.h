@@ -0,0 +1,206 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "libcellml/types.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace libcellml {
+
+struct MathAst; /**< Forward declaration of the internal MathAst struct. */
+typedef std::shared_ptr<MathAst> MathAstPtr; /**< Type definition for shared math AST pointer. */
+
+/**
+ * @brief The MathAst struct.
+ *
+ * An internal structure holding a node of the abstract syntax tree built from
+ * the content MathML of a component.  Operator nodes hold their arguments as
+ * children, in document order, including any qualifier (@c bvar, @c degree,
+ * @c logbase) nodes.  A @c piecewise node holds @c piece children of the form
+ * [value, condition] optionally followed by an @c otherwise child of the form
+ * [value].  A @c lookup node, which is only created by the evaluator, stands
+ * for an expression tabulated in lookup table @c mIndex and is of the form
+ * [variable, expression], where the table is indexed by the variable.
+ */
+struct MathAst
+{
+    /**
+     * @brief The MathAst::Type enum class.
+     *
+     * The kind of MathML element a node was built from.
+     */
+    enum class Type
+    {
+        // Token elements.
+        CI,
+        CN,
+
+        // Relational and logical operators.
+        EQ,
+        NEQ,
+        LT,
+        LEQ,
+        GT,
+        GEQ,
+        AND,
+        OR,
+        XOR,
+        NOT,
+
+        // Arithmetic operators.
+        PLUS,
+        MINUS,
+        TIMES,
+        DIVIDE,
+        POWER,
+        ROOT,
+        ABS,
+        EXP,
+        LN,
+        LOG,
+        FLOOR,
+        CEILING,
+        MIN,
+        MAX,
+        REM,
+
+        // Calculus.
+        DIFF,
+
+        // Trigonometric operators.
+        SIN,
+        COS,
+        TAN,
+        SEC,
+        CSC,
+        COT,
+        SINH,
+        COSH,
+        TANH,
+        SECH,
+        CSCH,
+        COTH,
+        ARCSIN,
+        ARCCOS,
+        ARCTAN,
+        ARCSEC,
+        ARCCSC,
+        ARCCOT,
+        ARCSINH,
+        ARCCOSH,
+        ARCTANH,
+        ARCSECH,
+        ARCCSCH,
+        ARCCOTH,
+
+        // Piecewise statement.
+        PIECEWISE,
+        PIECE,
+        OTHERWISE,
+
+        // Qualifier elements.
+        BVAR,
+        DEGREE,
+        LOGBASE,
+
+        // Constants.
+        BOOLEAN_TRUE,
+        BOOLEAN_FALSE,
+        E,
+        PI,
+        INF,
+        NOT_A_NUMBER,
+
+        // Internal nodes, not built from MathML.
+        LOOKUP
+    };
+
+    Type mType = Type::CN; /**< The type of this node. */
+    double mValue = 0.0; /**< The numeric value of a @c cn node. */
+    std::string mName; /**< The text of a @c ci node. */
+    std::string mUnits; /**< The @c cellml:units attribute of a @c cn node. */
+    VariablePtr mVariable = nullptr; /**< The component variable a @c ci node refers to. */
+    size_t mIndex = 0; /**< The lookup table a @c lookup node refers to. */
+    std::vector<MathAstPtr> mChildren; /**< The arguments of this node. */
+};
+
+/**
+ * @brief Parse the content MathML in @p math into a list of ASTs.
+ *
+ * Parse the @c std::string @p math, which may hold several sibling @c math
+ * elements, into one AST per top-level MathML expression.  The @c ci
+ * elements are resolved against the variables of @p component.  On failure
+ * @p error is set to a description of the first problem found and @c false
+ * is returned.
+ *
+ * @param math The @c std::string math to parse.
+ * @param component The component the math belongs to.
+ * @param asts The list of ASTs to append the parsed expressions to.
+ * @param error The @c std::string to set to a description of any error.
+ *
+ * @return @c true if the math was parsed successfully, @c false otherwise.
+ */
+bool parseMathAst(const std::string &math, const ComponentPtr &component,
+                  std::vector<MathAstPtr> &asts, std::string &error);
+
+/**
+ * @brief Test if @p ast is a derivative.
+ *
+ * Test if @p ast is a @c diff node of the form d(variable)/d(bvar).  If it is,
+ * @p variable and @p bvar are set to the differentiated and bound variables.
+ *
+ * @param ast The AST node to test.
+ * @param variable The variable being differentiated.
+ * @param bvar The variable of integration.
+ *
+ * @return @c true if @p ast is a first order derivative, @c false otherwise.
+ */
+bool isDerivative(const MathAstPtr &ast, VariablePtr &variable, VariablePtr &bvar);
+
+/**
+ * @brief Create a @c cn node holding @p value.
+ *
+ * @param value The value of the node.
+ *
+ * @return The new AST node.
+ */
+MathAstPtr createMathAstNumber(double value);
+
+/**
+ * @brief Create an operator node of type @p type with the given @p children.
+ *
+ * @param type The type of the node.
+ * @param children The arguments of the node.
+ *
+ * @return The new AST node.
+ */
+MathAstPtr createMathAstNode(MathAst::Type type, const std::vector<MathAstPtr> &children);
+
+/**
+ * @brief Get the name of the MathML element a node of type @p type is
+ * built from.
+ *
+ * @param type The type of node.
+ *
+ * @return The name of the MathML element, e.g. @c "plus".
+ */
+std::string mathAstTypeName(MathAst::Type type);
+
+} // namespace libcellml
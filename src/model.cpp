@@ -14,18 +14,35 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include "arena.h"
+#include "mathast.h"
+#include "symbols.h"
+#include "unitsdefinition.h"
+#include "utilities.h"
+
 #include "libcellml/component.h"
+#include "libcellml/frozenmodel.h"
+#include "libcellml/identifieditem.h"
+#include "libcellml/importlibrary.h"
 #include "libcellml/importsource.h"
 #include "libcellml/model.h"
+#include "libcellml/modelwalker.h"
 #include "libcellml/parser.h"
+#include "libcellml/reset.h"
 #include "libcellml/units.h"
 #include "libcellml/variable.h"
+#include "libcellml/when.h"
 
 #include <algorithm>
 #include <fstream>
 #include <map>
+#include <memory>
+#include <regex>
+#include <set>
 #include <sstream>
 #include <stack>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -42,13 +59,22 @@ struct Model::ModelImpl
 {
     std::vector<UnitsPtr>::iterator findUnits(const std::string &name);
     std::vector<UnitsPtr>::iterator findUnits(const UnitsPtr &units);
+    void indexIds(const ModelPtr &model);
     std::vector<UnitsPtr> mUnits;
+    EntityDependencies mImportDependencies; /**< What the last result of hasUnresolvedImports() depended on. */
+    bool mHasUnresolvedImports = false; /**< The last result of hasUnresolvedImports(). */
+    EntityDependencies mIdDependencies; /**< What the index of items by id depends on. */
+    std::unordered_map<std::string, std::vector<IdentifiedItemPtr>> mIdItems; /**< The items of the model, indexed by id. */
 };
 
 std::vector<UnitsPtr>::iterator Model::ModelImpl::findUnits(const std::string &name)
 {
+    Symbol symbol;
+    if (!findSymbol(name, symbol)) {
+        return mUnits.end();
+    }
     return std::find_if(mUnits.begin(), mUnits.end(),
-                        [=](const UnitsPtr &u) -> bool { return u->name() == name; });
+                        [=](const UnitsPtr &u) -> bool { return nameSymbol(*u) == symbol; });
 }
 
 std::vector<UnitsPtr>::iterator Model::ModelImpl::findUnits(const UnitsPtr &units)
@@ -58,13 +84,37 @@ std::vector<UnitsPtr>::iterator Model::ModelImpl::findUnits(const UnitsPtr &unit
 }
 
 Model::Model()
-    : mPimpl(new ModelImpl())
+    : mPimpl(newImpl<ModelImpl>())
 {
 }
 
+/**
+ * @brief Clear the parent of @p entity if it is @p parent.
+ *
+ * To be called when @p entity is removed from @p parent, or when @p parent
+ * is destroyed, so that @p entity does not keep a pointer to it.
+ *
+ * @param parent The model @p entity is removed from.
+ * @param entity The units or component removed.
+ */
+static void releaseEntity(const Model *parent, const EntityPtr &entity)
+{
+    if (entity->parent() == parent) {
+        entity->clearParent();
+    }
+}
+
 Model::~Model()
 {
-    delete mPimpl;
+    if (mPimpl != nullptr) {
+        for (const UnitsPtr &units : mPimpl->mUnits) {
+            releaseEntity(this, units);
+        }
+        for (const ComponentPtr &component : components()) {
+            releaseEntity(this, component);
+        }
+    }
+    deleteImpl(mPimpl);
 }
 
 Model::Model(const Model &rhs)
@@ -72,7 +122,7 @@ Model::Model(const Model &rhs)
 #ifndef SWIG
     , std::enable_shared_from_this<Model>(rhs)
 #endif
-    , mPimpl(new ModelImpl())
+    , mPimpl(newImpl<ModelImpl>())
 {
     mPimpl->mUnits = rhs.mPimpl->mUnits;
 }
@@ -108,13 +158,17 @@ void Model::doAddComponent(const ComponentPtr &component)
 void Model::addUnits(const UnitsPtr &units)
 {
     mPimpl->mUnits.push_back(units);
+    units->setParent(this);
+    markModified();
 }
 
 bool Model::removeUnits(size_t index)
 {
     bool status = false;
     if (index < mPimpl->mUnits.size()) {
+        releaseEntity(this, mPimpl->mUnits.at(index));
         mPimpl->mUnits.erase(mPimpl->mUnits.begin() + int64_t(index));
+        markModified();
         status = true;
     }
 
@@ -126,7 +180,9 @@ bool Model::removeUnits(const std::string &name)
     bool status = false;
     auto result = mPimpl->findUnits(name);
     if (result != mPimpl->mUnits.end()) {
+        releaseEntity(this, *result);
         mPimpl->mUnits.erase(result);
+        markModified();
         status = true;
     }
 
@@ -138,7 +194,9 @@ bool Model::removeUnits(const UnitsPtr &units)
     bool status = false;
     auto result = mPimpl->findUnits(units);
     if (result != mPimpl->mUnits.end()) {
+        releaseEntity(this, *result);
         mPimpl->mUnits.erase(result);
+        markModified();
         status = true;
     }
 
@@ -147,7 +205,11 @@ bool Model::removeUnits(const UnitsPtr &units)
 
 void Model::removeAllUnits()
 {
+    for (const UnitsPtr &units : mPimpl->mUnits) {
+        releaseEntity(this, units);
+    }
     mPimpl->mUnits.clear();
+    markModified();
 }
 
 bool Model::hasUnits(const std::string &name) const
@@ -187,7 +249,6 @@ UnitsPtr Model::takeUnits(size_t index)
     if (index < mPimpl->mUnits.size()) {
         units = mPimpl->mUnits.at(index);
         removeUnits(index);
-        units->clearParent();
     }
 
     return units;
@@ -203,6 +264,8 @@ bool Model::replaceUnits(size_t index, const UnitsPtr &units)
     bool status = false;
     if (removeUnits(index)) {
         mPimpl->mUnits.insert(mPimpl->mUnits.begin() + int64_t(index), units);
+        units->setParent(this);
+        markModified();
         status = true;
     }
 
@@ -243,53 +306,214 @@ std::string resolvePath(const std::string &filename, const std::string &base)
     return path;
 }
 
+static void resolveModelImports(const ModelPtr &model, const std::string &baseFile, ImportLibrary *library);
+
+/**
+ * @brief Get the model imported from the file at @p url.
+ *
+ * If @p library is not @c nullptr, the model is got from it, so that import
+ * sources resolved to the same file share it.  Otherwise the file is parsed
+ * into a new model.
+ *
+ * @param url The location of the file.
+ * @param library The library to get the model from, or @c nullptr if
+ * imported models are not shared.
+ *
+ * @return The model, with its own imports resolved, or @c nullptr if the
+ * file could not be read.
+ */
+static ModelPtr importedModel(const std::string &url, ImportLibrary *library)
+{
+    if (library != nullptr) {
+        return library->importedModel(url);
+    }
+    std::ifstream file(url);
+    if (!file.good()) {
+        return nullptr;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    Parser parser;
+    ModelPtr model = parser.parseModel(buffer.str());
+    resolveModelImports(model, url, nullptr);
+    return model;
+}
+
 void resolveImport(const ImportedEntityPtr &importedEntity,
-                   const std::string &baseFile)
+                   const std::string &baseFile, ImportLibrary *library)
 {
     if (importedEntity->isImport()) {
         ImportSourcePtr importSource = importedEntity->importSource();
         if (!importSource->hasModel()) {
             std::string url = resolvePath(importSource->url(), baseFile);
-            std::ifstream file(url);
-            if (file.good()) {
-                std::stringstream buffer;
-                buffer << file.rdbuf();
-                Parser parser;
-                ModelPtr model = parser.parseModel(buffer.str());
+            ModelPtr model = importedModel(url, library);
+            if (model != nullptr) {
                 importSource->setModel(model);
-                model->resolveImports(url);
             }
         }
     }
 }
 
 void resolveComponentImports(const ComponentEntityPtr &parentComponentEntity,
-                             const std::string &baseFile)
+                             const std::string &baseFile, ImportLibrary *library)
 {
     for (size_t n = 0; n < parentComponentEntity->componentCount(); ++n) {
         libcellml::ComponentPtr component = parentComponentEntity->component(n);
         if (component->isImport()) {
-            resolveImport(component, baseFile);
+            resolveImport(component, baseFile, library);
         } else {
-            resolveComponentImports(component, baseFile);
+            resolveComponentImports(component, baseFile, library);
         }
     }
 }
 
+static void resolveModelImports(const ModelPtr &model, const std::string &baseFile, ImportLibrary *library)
+{
+    for (size_t n = 0; n < model->unitsCount(); ++n) {
+        libcellml::UnitsPtr units = model->units(n);
+        resolveImport(units, baseFile, library);
+    }
+    resolveComponentImports(model, baseFile, library);
+}
+
 void Model::resolveImports(const std::string &baseFile)
 {
-    for (size_t n = 0; n < unitsCount(); ++n) {
-        libcellml::UnitsPtr units = Model::units(n);
-        resolveImport(units, baseFile);
+    resolveModelImports(shared_from_this(), baseFile, nullptr);
+}
+
+void Model::resolveImports(const std::string &baseFile, ImportLibrary &library)
+{
+    resolveModelImports(shared_from_this(), baseFile, &library);
+}
+
+void Model::ModelImpl::indexIds(const ModelPtr &model)
+{
+    if ((mIdDependencies.mRevision != 0)
+        && (dependenciesRevision(mIdDependencies, model->revision()) == mIdDependencies.mRevision)) {
+        return;
+    }
+    EntityDependencies dependencies;
+    dependencies.mRevision = model->revision();
+    mIdItems.clear();
+    auto addItem = [this](const std::string &id, IdentifiedItem::Type type, const EntityPtr &entity, size_t index) {
+        if (!id.empty()) {
+            mIdItems[id].push_back(std::make_shared<IdentifiedItem>(type, entity, index));
+        }
+    };
+    std::unordered_set<const ImportSource *> importSources;
+    auto addImport = [&](const ImportedEntity &importedEntity) {
+        ImportSourcePtr importSource = importedEntity.importSource();
+        if ((importSource != nullptr) && importSources.insert(importSource.get()).second) {
+            dependencies.add(importSource);
+            addItem(importSource->id(), IdentifiedItem::Type::IMPORT, importSource, 0);
+        }
+    };
+
+    addItem(model->id(), IdentifiedItem::Type::MODEL, model, 0);
+    addItem(model->encapsulationId(), IdentifiedItem::Type::ENCAPSULATION, model, 0);
+    for (const UnitsPtr &units : mUnits) {
+        addImport(*units);
+        addItem(units->id(), IdentifiedItem::Type::UNITS, units, 0);
+        for (size_t i = 0; i < units->unitCount(); ++i) {
+            std::string reference;
+            std::string prefix;
+            double exponent;
+            double multiplier;
+            std::string id;
+            units->unitAttributes(i, reference, prefix, exponent, multiplier, id);
+            addItem(id, IdentifiedItem::Type::UNIT, units, i);
+        }
+    }
+    std::vector<VariablePtr> variables;
+    ModelWalker walker(model);
+    while (walker.next()) {
+        const ComponentPtr &component = walker.component();
+        addImport(*component);
+        addItem(component->id(), IdentifiedItem::Type::COMPONENT, component, 0);
+        addItem(component->encapsulationId(), IdentifiedItem::Type::COMPONENT_REF, component, 0);
+        for (const VariablePtr &variable : component->variables()) {
+            addItem(variable->id(), IdentifiedItem::Type::VARIABLE, variable, 0);
+            variables.push_back(variable);
+        }
+        // Resets and whens have no parent, so modifying them does not modify
+        // the model.
+        for (size_t i = 0; i < component->resetCount(); ++i) {
+            ResetPtr reset = component->reset(i);
+            dependencies.add(reset);
+            addItem(reset->id(), IdentifiedItem::Type::RESET, reset, 0);
+            for (size_t j = 0; j < reset->whenCount(); ++j) {
+                WhenPtr when = reset->when(j);
+                dependencies.add(when);
+                addItem(when->id(), IdentifiedItem::Type::WHEN, when, 0);
+            }
+        }
     }
-    resolveComponentImports(shared_from_this(), baseFile);
+
+    // Each equivalence is seen from both of its variables, and all the
+    // equivalences between the variables of two components make up a
+    // single connection.
+    std::set<std::pair<const Variable *, const Variable *>> mappings;
+    std::set<std::pair<std::pair<void *, void *>, std::string>> connections;
+    for (const VariablePtr &variable : variables) {
+        for (size_t i = 0; i < variable->equivalentVariableCount(); ++i) {
+            VariablePtr equivalentVariable = variable->equivalentVariable(i);
+            if (equivalentVariable == nullptr) {
+                // The equivalent variable no longer exists.
+                continue;
+            }
+            if (!mappings.emplace(std::min(variable.get(), equivalentVariable.get()), std::max(variable.get(), equivalentVariable.get())).second) {
+                continue;
+            }
+            std::string mappingId = Variable::equivalenceMappingId(variable, equivalentVariable);
+            if (!mappingId.empty()) {
+                mIdItems[mappingId].push_back(std::make_shared<IdentifiedItem>(IdentifiedItem::Type::MAP_VARIABLES, variable, equivalentVariable));
+            }
+            std::string connectionId = Variable::equivalenceConnectionId(variable, equivalentVariable);
+            auto components = std::make_pair(std::min(variable->parent(), equivalentVariable->parent()), std::max(variable->parent(), equivalentVariable->parent()));
+            if (!connectionId.empty() && connections.emplace(components, connectionId).second) {
+                mIdItems[connectionId].push_back(std::make_shared<IdentifiedItem>(IdentifiedItem::Type::CONNECTION, variable, equivalentVariable));
+            }
+        }
+    }
+    mIdDependencies = dependencies;
+}
+
+IdentifiedItemPtr Model::itemWithId(const std::string &id, size_t index)
+{
+    mPimpl->indexIds(shared_from_this());
+    auto found = mPimpl->mIdItems.find(id);
+    if ((found == mPimpl->mIdItems.end()) || (index >= found->second.size())) {
+        return nullptr;
+    }
+    return found->second.at(index);
 }
 
-bool isUnresolvedImport(const ImportedEntityPtr &importedEntity)
+size_t Model::itemCountWithId(const std::string &id)
+{
+    mPimpl->indexIds(shared_from_this());
+    auto found = mPimpl->mIdItems.find(id);
+    return (found == mPimpl->mIdItems.end()) ? 0 : found->second.size();
+}
+
+std::vector<std::string> Model::duplicateIds()
+{
+    mPimpl->indexIds(shared_from_this());
+    std::vector<std::string> ids;
+    for (const auto &items : mPimpl->mIdItems) {
+        if (items.second.size() > 1) {
+            ids.push_back(items.first);
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+bool isUnresolvedImport(const ImportedEntityPtr &importedEntity, EntityDependencies &dependencies)
 {
     bool unresolvedImport = false;
     if (importedEntity->isImport()) {
         ImportSourcePtr importedSource = importedEntity->importSource();
+        dependencies.add(importedSource);
         if (!importedSource->hasModel()) {
             unresolvedImport = true;
         }
@@ -297,49 +521,468 @@ bool isUnresolvedImport(const ImportedEntityPtr &importedEntity)
     return unresolvedImport;
 }
 
-bool hasUnresolvedComponentImports(const ComponentEntityPtr &parentComponentEntity);
+bool hasUnresolvedComponentImports(const ComponentEntityPtr &parentComponentEntity, EntityDependencies &dependencies);
 
-bool doHasUnresolvedComponentImports(const ComponentPtr &component)
+bool doHasUnresolvedComponentImports(const ComponentPtr &component, EntityDependencies &dependencies)
 {
     bool unresolvedImports = false;
     if (component->isImport()) {
-        unresolvedImports = isUnresolvedImport(component);
+        unresolvedImports = isUnresolvedImport(component, dependencies);
         if (!unresolvedImports) {
             // Check that the imported component can import all it needs from its model.
             ImportSourcePtr importedSource = component->importSource();
-            if (importedSource->hasModel()) {
-                ModelPtr importedModel = importedSource->model();
-                ComponentPtr importedComponent = importedModel->component(component->importReference());
-                unresolvedImports = doHasUnresolvedComponentImports(importedComponent);
-            }
+            dependencies.add(importedSource->model());
+            ComponentPtr importedComponent = importedSource->importedComponent(component->importReference());
+            unresolvedImports = (importedComponent == nullptr) || doHasUnresolvedComponentImports(importedComponent, dependencies);
         }
     } else {
-        unresolvedImports = hasUnresolvedComponentImports(component);
+        unresolvedImports = hasUnresolvedComponentImports(component, dependencies);
     }
     return unresolvedImports;
 }
 
-bool hasUnresolvedComponentImports(const ComponentEntityPtr &parentComponentEntity)
+bool hasUnresolvedComponentImports(const ComponentEntityPtr &parentComponentEntity, EntityDependencies &dependencies)
 {
     bool unresolvedImports = false;
     for (size_t n = 0; n < parentComponentEntity->componentCount() && !unresolvedImports; ++n) {
         libcellml::ComponentPtr component = parentComponentEntity->component(n);
-        unresolvedImports = doHasUnresolvedComponentImports(component);
+        unresolvedImports = doHasUnresolvedComponentImports(component, dependencies);
     }
     return unresolvedImports;
 }
 
 bool Model::hasUnresolvedImports()
 {
+    // The result is reused for as long as neither this model nor any of the
+    // import sources and imported models it was found from are modified.
+    if ((mPimpl->mImportDependencies.mRevision != 0)
+        && (dependenciesRevision(mPimpl->mImportDependencies, revision()) == mPimpl->mImportDependencies.mRevision)) {
+        return mPimpl->mHasUnresolvedImports;
+    }
+    EntityDependencies dependencies;
+    dependencies.mRevision = revision();
     bool unresolvedImports = false;
     for (size_t n = 0; n < unitsCount() && !unresolvedImports; ++n) {
         libcellml::UnitsPtr units = Model::units(n);
-        unresolvedImports = isUnresolvedImport(units);
+        unresolvedImports = isUnresolvedImport(units, dependencies);
     }
     if (!unresolvedImports) {
-        unresolvedImports = hasUnresolvedComponentImports(shared_from_this());
+        unresolvedImports = hasUnresolvedComponentImports(shared_from_this(), dependencies);
     }
+    mPimpl->mImportDependencies = dependencies;
+    mPimpl->mHasUnresolvedImports = unresolvedImports;
     return unresolvedImports;
 }
 
+/**
+ * @brief The ModelClone struct.
+ *
+ * Internal state used while cloning a model, mapping the import sources and
+ * variables of the original model to their copies.
+ */
+struct ModelClone
+{
+    std::map<ImportSourcePtr, ImportSourcePtr> mImportSources; /**< The copies of the import sources. */
+    std::vector<VariablePtr> mVariables; /**< The original variables. */
+    std::vector<VariablePtr> mVariableClones; /**< The copies of the variables, in the same order. */
+    std::vector<ResetPtr> mResetClones; /**< The copies of the resets, still referring to the original variables. */
+
+    ImportSourcePtr cloneImportSource(const ImportSourcePtr &importSource);
+    ComponentPtr cloneComponent(const ComponentPtr &component);
+    void cloneReferences();
+};
+
+ImportSourcePtr ModelClone::cloneImportSource(const ImportSourcePtr &importSource)
+{
+    auto found = mImportSources.find(importSource);
+    if (found != mImportSources.end()) {
+        return found->second;
+    }
+    ImportSourcePtr clone = std::make_shared<ImportSource>(*importSource);
+    mImportSources.emplace(importSource, clone);
+    return clone;
+}
+
+ComponentPtr ModelClone::cloneComponent(const ComponentPtr &component)
+{
+    // The copy constructors also copy the parents and children of an entity,
+    // which are cleared before the copy is modified.
+    ComponentPtr clone = std::make_shared<Component>(*component);
+    clone->clearParent();
+    clone->removeAllVariables();
+    clone->removeAllResets();
+    clone->removeAllComponents();
+    if (component->importSource() != nullptr) {
+        clone->setImportSource(cloneImportSource(component->importSource()));
+    }
+    for (size_t i = 0; i < component->variableCount(); ++i) {
+        VariablePtr variable = component->variable(i);
+        VariablePtr variableClone = std::make_shared<Variable>(*variable);
+        variableClone->clearParent();
+        clone->addVariable(variableClone);
+        mVariables.push_back(variable);
+        mVariableClones.push_back(variableClone);
+    }
+    for (size_t i = 0; i < component->resetCount(); ++i) {
+        ResetPtr reset = component->reset(i);
+        ResetPtr resetClone = std::make_shared<Reset>(*reset);
+        resetClone->removeAllWhens();
+        for (size_t j = 0; j < reset->whenCount(); ++j) {
+            resetClone->addWhen(std::make_shared<When>(*reset->when(j)));
+        }
+        clone->addReset(resetClone);
+        mResetClones.push_back(resetClone);
+    }
+    for (size_t i = 0; i < component->componentCount(); ++i) {
+        clone->addComponent(cloneComponent(component->component(i)));
+    }
+    return clone;
+}
+
+/**
+ * @brief Make the copied variables and resets refer to the copies.
+ *
+ * To be called once all the components have been copied.  Equivalences to
+ * variables that have not been copied are dropped, and resets of variables
+ * that have not been copied keep referring to the original variables.
+ */
+void ModelClone::cloneReferences()
+{
+    cloneEquivalences(mVariables, mVariableClones);
+    if (!mResetClones.empty()) {
+        std::unordered_map<const Variable *, VariablePtr> cloneOf;
+        for (size_t i = 0; i < mVariables.size(); ++i) {
+            cloneOf.emplace(mVariables.at(i).get(), mVariableClones.at(i));
+        }
+        for (const ResetPtr &reset : mResetClones) {
+            auto found = cloneOf.find(reset->variable().get());
+            if (found != cloneOf.end()) {
+                reset->setVariable(found->second);
+            }
+        }
+    }
+}
+
+ModelPtr Model::clone() const
+{
+    ModelPtr clone = std::make_shared<Model>();
+    clone->setName(name());
+    clone->setId(id());
+    clone->setEncapsulationId(encapsulationId());
+    ModelClone modelClone;
+    for (const UnitsPtr &units : mPimpl->mUnits) {
+        UnitsPtr unitsClone = std::make_shared<Units>(*units);
+        unitsClone->clearParent();
+        if (units->importSource() != nullptr) {
+            unitsClone->setImportSource(modelClone.cloneImportSource(units->importSource()));
+        }
+        clone->addUnits(unitsClone);
+    }
+    for (size_t i = 0; i < componentCount(); ++i) {
+        clone->addComponent(modelClone.cloneComponent(component(i)));
+    }
+    modelClone.cloneReferences();
+    return clone;
+}
+
+FrozenModelPtr Model::freeze() const
+{
+    return FrozenModelPtr(new FrozenModel(*this));
+}
+
+/**
+ * @brief Get a name based on @p name that is not in @p usedNames.
+ *
+ * The name returned is added to @p usedNames.
+ *
+ * @param name The preferred name.
+ * @param usedNames The names already in use.
+ *
+ * @return @p name, or @p name followed by the first suffix "_1", "_2", ...
+ * that makes it unique.
+ */
+static std::string uniqueName(const std::string &name, std::set<std::string> &usedNames)
+{
+    std::string result = name;
+    for (size_t i = 1; usedNames.count(result) != 0; ++i) {
+        result = name + "_" + std::to_string(i);
+    }
+    usedNames.insert(result);
+    return result;
+}
+
+/**
+ * @brief Collect the units of the constants in @p ast.
+ *
+ * @param ast The AST to walk.
+ * @param units The set to add the @c cellml:units of its @c cn nodes to.
+ */
+static void collectConstantUnits(const MathAstPtr &ast, std::set<std::string> &units)
+{
+    if ((ast->mType == MathAst::Type::CN) && !ast->mUnits.empty()) {
+        units.insert(ast->mUnits);
+    }
+    for (const MathAstPtr &child : ast->mChildren) {
+        collectConstantUnits(child, units);
+    }
+}
+
+/**
+ * @brief The ModelFlattener struct.
+ *
+ * Internal state used while flattening a model and, recursively, the models
+ * it imports from.  Each imported model is flattened once, and each of its
+ * units is copied at most once into each flattened model.
+ */
+struct ModelFlattener
+{
+    /**
+     * @brief The FlatUnits struct.
+     *
+     * The units of a flattened model, and the names given to the units
+     * copied into it from flattened imported models.
+     */
+    struct FlatUnits
+    {
+        std::set<std::string> mUsedNames; /**< The names of the units of the flattened model. */
+        std::map<std::pair<const Model *, std::string>, std::string> mCopiedNames; /**< The names of the units copied from each flattened imported model. */
+    };
+
+    std::map<const Model *, ModelPtr> mFlattenedModels; /**< The flattened copies of the models seen so far. */
+    std::set<const Model *> mModelsInProgress; /**< The models being flattened, to detect import cycles. */
+
+    ModelPtr flatten(const Model &model);
+    ModelPtr flattenedSource(const ImportedEntity &importedEntity);
+    std::string copyUnits(const ModelPtr &flatModel, FlatUnits &flatUnits, const ModelPtr &sourceModel, const std::string &name);
+    void remapUnitReferences(const UnitsPtr &units, const ModelPtr &flatModel, FlatUnits &flatUnits, const ModelPtr &sourceModel);
+    ComponentPtr instantiateComponent(const ComponentPtr &component, const ModelPtr &flatModel, FlatUnits &flatUnits, std::set<std::string> &componentNames);
+};
+
+ModelPtr ModelFlattener::flattenedSource(const ImportedEntity &importedEntity)
+{
+    ImportSourcePtr importSource = importedEntity.importSource();
+    if ((importSource == nullptr) || !importSource->hasModel()
+        || (mModelsInProgress.count(importSource->model().get()) != 0)) {
+        return nullptr;
+    }
+    return flatten(*importSource->model());
+}
+
+std::string ModelFlattener::copyUnits(const ModelPtr &flatModel, FlatUnits &flatUnits, const ModelPtr &sourceModel, const std::string &name)
+{
+    auto key = std::make_pair(sourceModel.get(), name);
+    auto found = flatUnits.mCopiedNames.find(key);
+    if (found != flatUnits.mCopiedNames.end()) {
+        return found->second;
+    }
+    UnitsPtr sourceUnits = sourceModel->units(name);
+    if (sourceUnits == nullptr) {
+        // Standard units, or units that cannot be found, keep their name.
+        return name;
+    }
+    std::string flatName = uniqueName(name, flatUnits.mUsedNames);
+    flatUnits.mCopiedNames.emplace(key, flatName);
+    UnitsPtr units = std::make_shared<Units>(*sourceUnits);
+    units->clearParent();
+    units->setName(flatName);
+    flatModel->addUnits(units);
+    remapUnitReferences(units, flatModel, flatUnits, sourceModel);
+    return flatName;
+}
+
+void ModelFlattener::remapUnitReferences(const UnitsPtr &units, const ModelPtr &flatModel, FlatUnits &flatUnits, const ModelPtr &sourceModel)
+{
+    struct UnitAttributes
+    {
+        std::string mReference;
+        std::string mPrefix;
+        double mExponent;
+        double mMultiplier;
+        std::string mId;
+    };
+    std::vector<UnitAttributes> unitAttributes(units->unitCount());
+    bool remapped = false;
+    for (size_t i = 0; i < unitAttributes.size(); ++i) {
+        UnitAttributes &attributes = unitAttributes.at(i);
+        units->unitAttributes(i, attributes.mReference, attributes.mPrefix, attributes.mExponent, attributes.mMultiplier, attributes.mId);
+        std::string reference = copyUnits(flatModel, flatUnits, sourceModel, attributes.mReference);
+        if (reference != attributes.mReference) {
+            attributes.mReference = reference;
+            remapped = true;
+        }
+    }
+    if (remapped) {
+        units->removeAllUnits();
+        for (const UnitAttributes &attributes : unitAttributes) {
+            units->addUnit(attributes.mReference, attributes.mPrefix, attributes.mExponent, attributes.mMultiplier, attributes.mId);
+        }
+    }
+}
+
+ComponentPtr ModelFlattener::instantiateComponent(const ComponentPtr &component, const ModelPtr &flatModel, FlatUnits &flatUnits, std::set<std::string> &componentNames)
+{
+    ModelPtr sourceModel = flattenedSource(*component);
+    ComponentPtr sourceComponent = (sourceModel != nullptr) ? sourceModel->component(component->importReference()) : nullptr;
+    if (sourceComponent == nullptr) {
+        return nullptr;
+    }
+    // Copy the imported component, with its encapsulated components, out of
+    // the flattened imported model.  Connections to components that are not
+    // copied are dropped.
+    ModelClone componentClone;
+    ComponentPtr instance = componentClone.cloneComponent(sourceComponent);
+    componentClone.cloneReferences();
+    std::vector<ComponentPtr> instanceComponents = {instance};
+    instance->forEachComponent([&instanceComponents](const ComponentPtr &child) {
+        instanceComponents.push_back(child);
+    });
+
+    // The units used are copied into the flattened model, and encapsulated
+    // components are renamed if their name is already used.
+    std::map<std::string, std::string> renamedUnits;
+    for (const ComponentPtr &instanceComponent : instanceComponents) {
+        if (instanceComponent != instance) {
+            instanceComponent->setName(uniqueName(instanceComponent->name(), componentNames));
+        }
+        for (const VariablePtr &variable : instanceComponent->variables()) {
+            if (!variable->units().empty()) {
+                std::string units = copyUnits(flatModel, flatUnits, sourceModel, variable->units());
+                if (units != variable->units()) {
+                    renamedUnits.emplace(variable->units(), units);
+                    variable->setUnits(units);
+                }
+            }
+        }
+        std::vector<MathAstPtr> asts;
+        std::string error;
+        std::set<std::string> constantUnits;
+        if (!instanceComponent->math().empty() && parseMathAst(instanceComponent->math(), instanceComponent, asts, error)) {
+            for (const MathAstPtr &ast : asts) {
+                collectConstantUnits(ast, constantUnits);
+            }
+        }
+        for (const std::string &constantUnit : constantUnits) {
+            std::string units = copyUnits(flatModel, flatUnits, sourceModel, constantUnit);
+            if (units != constantUnit) {
+                renamedUnits.emplace(constantUnit, units);
+            }
+        }
+    }
+    if (!renamedUnits.empty()) {
+        // Constants in the math refer to units through their cellml:units
+        // attribute.
+        for (const ComponentPtr &instanceComponent : instanceComponents) {
+            std::string math = instanceComponent->math();
+            for (const auto &renamed : renamedUnits) {
+                std::regex unitsAttribute(":units(\\s*=\\s*[\"'])" + renamed.first + "([\"'])");
+                math = std::regex_replace(math, unitsAttribute, ":units$1" + renamed.second + "$2");
+            }
+            if (math != instanceComponent->math()) {
+                instanceComponent->setMath(math);
+            }
+        }
+    }
+
+    // The instance takes the place of the importing component, with its
+    // name, id and encapsulated components, and with the connections of its
+    // variables.
+    instance->setName(component->name());
+    instance->setId(component->id());
+    for (const VariablePtr &importingVariable : std::vector<VariablePtr>(component->variables())) {
+        VariablePtr variable = instance->variable(importingVariable->name());
+        if (variable == nullptr) {
+            component->removeVariable(importingVariable);
+            instance->addVariable(importingVariable);
+            continue;
+        }
+        while (importingVariable->equivalentVariableCount() > 0) {
+            VariablePtr equivalentVariable = importingVariable->equivalentVariable(0);
+            std::string mappingId = Variable::equivalenceMappingId(importingVariable, equivalentVariable);
+            std::string connectionId = Variable::equivalenceConnectionId(importingVariable, equivalentVariable);
+            Variable::removeEquivalence(importingVariable, equivalentVariable);
+            Variable::addEquivalence(variable, equivalentVariable, mappingId, connectionId);
+        }
+    }
+    for (const ComponentPtr &child : component->components()) {
+        instance->addComponent(child);
+    }
+    component->removeAllComponents();
+    return instance;
+}
+
+ModelPtr ModelFlattener::flatten(const Model &model)
+{
+    auto found = mFlattenedModels.find(&model);
+    if (found != mFlattenedModels.end()) {
+        return found->second;
+    }
+    mModelsInProgress.insert(&model);
+    ModelPtr flatModel = model.clone();
+    FlatUnits flatUnits;
+    for (size_t i = 0; i < flatModel->unitsCount(); ++i) {
+        flatUnits.mUsedNames.insert(flatModel->units(i)->name());
+    }
+    std::set<std::string> componentNames;
+    std::vector<std::pair<ComponentEntityPtr, ComponentPtr>> importedComponents;
+    std::vector<ComponentEntityPtr> parents = {flatModel};
+    while (!parents.empty()) {
+        ComponentEntityPtr parent = parents.back();
+        parents.pop_back();
+        for (const ComponentPtr &component : parent->components()) {
+            componentNames.insert(component->name());
+            if (component->isImport()) {
+                importedComponents.emplace_back(parent, component);
+            }
+            parents.push_back(component);
+        }
+    }
+
+    // Imported units are replaced with copies of the units they refer to.
+    for (size_t i = 0; i < flatModel->unitsCount(); ++i) {
+        UnitsPtr units = flatModel->units(i);
+        ModelPtr sourceModel = units->isImport() ? flattenedSource(*units) : nullptr;
+        UnitsPtr sourceUnits = (sourceModel != nullptr) ? sourceModel->units(units->importReference()) : nullptr;
+        if (sourceUnits != nullptr) {
+            UnitsPtr instance = std::make_shared<Units>(*sourceUnits);
+            instance->clearParent();
+            instance->setName(units->name());
+            instance->setId(units->id());
+            flatUnits.mCopiedNames.emplace(std::make_pair(sourceModel.get(), units->importReference()), units->name());
+            flatModel->replaceUnits(i, instance);
+            remapUnitReferences(instance, flatModel, flatUnits, sourceModel);
+        }
+    }
+
+    // Imported components are replaced with copies of the components they
+    // refer to, in the order they were found, so that the parent of an
+    // imported component may itself have been replaced already.
+    std::map<ComponentEntityPtr, ComponentPtr> instances;
+    for (const auto &importedComponent : importedComponents) {
+        ComponentEntityPtr parent = importedComponent.first;
+        auto replaced = instances.find(parent);
+        if (replaced != instances.end()) {
+            parent = replaced->second;
+        }
+        const ComponentPtr &component = importedComponent.second;
+        ComponentPtr instance = instantiateComponent(component, flatModel, flatUnits, componentNames);
+        if (instance == nullptr) {
+            continue;
+        }
+        const std::vector<ComponentPtr> &siblings = parent->components();
+        size_t index = size_t(std::find(siblings.begin(), siblings.end(), component) - siblings.begin());
+        parent->replaceComponent(index, instance);
+        instances.emplace(component, instance);
+    }
+
+    mModelsInProgress.erase(&model);
+    mFlattenedModels.emplace(&model, flatModel);
+    return flatModel;
+}
+
+ModelPtr Model::flatten() const
+{
+    ModelFlattener flattener;
+    return flattener.flatten(*this);
+}
+
 } // namespace libcellml
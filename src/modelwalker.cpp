@@ -0,0 +1,120 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "libcellml/component.h"
+#include "libcellml/modelwalker.h"
+
+#include <utility>
+#include <vector>
+
+namespace libcellml {
+
+/**
+ * @brief The ModelWalker::ModelWalkerImpl struct.
+ *
+ * The private implementation for the ModelWalker class.  The stack holds,
+ * for the current component and each of its ancestors, the list of
+ * components it belongs to and its position in that list.
+ */
+struct ModelWalker::ModelWalkerImpl
+{
+    ComponentEntityPtr mEntity;
+    std::vector<std::pair<const std::vector<ComponentPtr> *, size_t>> mStack;
+    bool mStarted = false;
+    bool mSkipChildren = false;
+};
+
+ModelWalker::ModelWalker(const ComponentEntityPtr &entity)
+    : mPimpl(new ModelWalkerImpl())
+{
+    mPimpl->mEntity = entity;
+}
+
+ModelWalker::~ModelWalker()
+{
+    delete mPimpl;
+}
+
+ModelWalker::ModelWalker(const ModelWalker &rhs)
+    : mPimpl(new ModelWalkerImpl(*rhs.mPimpl))
+{
+}
+
+ModelWalker::ModelWalker(ModelWalker &&rhs) noexcept
+    : mPimpl(rhs.mPimpl)
+{
+    rhs.mPimpl = nullptr;
+}
+
+ModelWalker &ModelWalker::operator=(ModelWalker rhs)
+{
+    rhs.swap(*this);
+    return *this;
+}
+
+void ModelWalker::swap(ModelWalker &rhs)
+{
+    std::swap(this->mPimpl, rhs.mPimpl);
+}
+
+bool ModelWalker::next()
+{
+    auto &stack = mPimpl->mStack;
+    if (stack.empty()) {
+        if (mPimpl->mStarted || (mPimpl->mEntity == nullptr)) {
+            return false;
+        }
+        mPimpl->mStarted = true;
+        const std::vector<ComponentPtr> &components = mPimpl->mEntity->components();
+        if (components.empty()) {
+            return false;
+        }
+        stack.emplace_back(&components, 0);
+        return true;
+    }
+    const ComponentPtr &current = component();
+    if (!mPimpl->mSkipChildren && (current->componentCount() > 0)) {
+        stack.emplace_back(&current->components(), 0);
+        return true;
+    }
+    mPimpl->mSkipChildren = false;
+    while (!stack.empty()) {
+        auto &top = stack.back();
+        if (++top.second < top.first->size()) {
+            return true;
+        }
+        stack.pop_back();
+    }
+    return false;
+}
+
+const ComponentPtr &ModelWalker::component() const
+{
+    const auto &top = mPimpl->mStack.back();
+    return (*top.first)[top.second];
+}
+
+size_t ModelWalker::depth() const
+{
+    return mPimpl->mStack.size() - 1;
+}
+
+void ModelWalker::skipChildren()
+{
+    mPimpl->mSkipChildren = true;
+}
+
+} // namespace libcellml
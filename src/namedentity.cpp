@@ -14,6 +14,9 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include "arena.h"
+#include "symbols.h"
+
 #include "libcellml/component.h"
 #include "libcellml/componententity.h"
 #include "libcellml/namedentity.h"
@@ -27,22 +30,22 @@ namespace libcellml {
  */
 struct NamedEntity::NamedEntityImpl
 {
-    std::string mName; /**< Entity name represented as a std::string. */
+    InternedString mName; /**< Entity name represented as an interned string. */
 };
 
 NamedEntity::NamedEntity()
-    : mPimpl(new NamedEntityImpl())
+    : mPimpl(newImpl<NamedEntityImpl>())
 {
 }
 
 NamedEntity::~NamedEntity()
 {
-    delete mPimpl;
+    deleteImpl(mPimpl);
 }
 
 NamedEntity::NamedEntity(const NamedEntity &rhs)
     : Entity(rhs)
-    , mPimpl(new NamedEntityImpl())
+    , mPimpl(newImpl<NamedEntityImpl>())
 {
     mPimpl->mName = rhs.mPimpl->mName;
 }
@@ -68,12 +71,24 @@ void NamedEntity::swap(NamedEntity &rhs)
 
 void NamedEntity::setName(const std::string &name)
 {
-    mPimpl->mName = name;
+    mPimpl->mName = InternedString(name);
+    markModified();
+    // Units references are resolved by name.
+}
+
+const std::string &NamedEntity::name() const
+{
+    return mPimpl->mName.string();
+}
+
+Symbol NamedEntity::internedName() const
+{
+    return mPimpl->mName.symbol();
 }
 
-std::string NamedEntity::name() const
+Symbol NameSymbolAccess::nameSymbol(const NamedEntity &entity)
 {
-    return mPimpl->mName;
+    return entity.internedName();
 }
 
 } // namespace libcellml
@@ -14,6 +14,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include "arena.h"
+
 #include "libcellml/orderedentity.h"
 
 #include <utility>
@@ -32,7 +34,7 @@ struct OrderedEntity::OrderedEntityImpl
 };
 
 OrderedEntity::OrderedEntity()
-    : mPimpl(new OrderedEntityImpl())
+    : mPimpl(newImpl<OrderedEntityImpl>())
 {
     mPimpl->mOrder = 0;
     mPimpl->mOrderSet = false;
@@ -40,12 +42,12 @@ OrderedEntity::OrderedEntity()
 
 OrderedEntity::~OrderedEntity()
 {
-    delete mPimpl;
+    deleteImpl(mPimpl);
 }
 
 OrderedEntity::OrderedEntity(const OrderedEntity &rhs)
     : Entity(rhs)
-    , mPimpl(new OrderedEntityImpl())
+    , mPimpl(newImpl<OrderedEntityImpl>())
 {
     mPimpl->mOrder = rhs.mPimpl->mOrder;
     mPimpl->mOrderSet = rhs.mPimpl->mOrderSet;
@@ -74,6 +76,7 @@ void OrderedEntity::setOrder(int order)
 {
     mPimpl->mOrder = order;
     mPimpl->mOrderSet = true;
+    markModified();
 }
 
 int OrderedEntity::order() const
@@ -84,6 +87,7 @@ int OrderedEntity::order() const
 void OrderedEntity::unsetOrder()
 {
     mPimpl->mOrderSet = false;
+    markModified();
 }
 
 bool OrderedEntity::isOrderSet()
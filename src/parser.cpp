@@ -14,6 +14,7 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include "arena.h"
 #include "namespaces.h"
 #include "utilities.h"
 #include "xmldoc.h"
@@ -40,6 +41,7 @@ namespace libcellml {
 struct Parser::ParserImpl
 {
     Parser *mParser;
+    bool mArenaAllocation = false;
 
     /**
      * @brief Update the @p model with attributes parsed from a @c std::string.
@@ -197,6 +199,7 @@ Parser::Parser(const Parser &rhs)
     , mPimpl(new ParserImpl())
 {
     mPimpl->mParser = rhs.mPimpl->mParser;
+    mPimpl->mArenaAllocation = rhs.mPimpl->mArenaAllocation;
 }
 
 Parser::Parser(Parser &&rhs) noexcept
@@ -220,11 +223,25 @@ void Parser::swap(Parser &rhs)
 
 ModelPtr Parser::parseModel(const std::string &input)
 {
-    ModelPtr model = std::make_shared<Model>();
+    // Allocate the entities of the model from an arena of their own, if
+    // requested, which they keep alive for as long as any of them exists.
+    ArenaReference arena(mPimpl->mArenaAllocation ? Arena::create() : nullptr);
+    ArenaScope scope(arena.arena());
+    ModelPtr model = makeEntity<Model>();
     mPimpl->updateModel(model, input);
     return model;
 }
 
+void Parser::setArenaAllocation(bool arenaAllocation)
+{
+    mPimpl->mArenaAllocation = arenaAllocation;
+}
+
+bool Parser::arenaAllocation() const
+{
+    return mPimpl->mArenaAllocation;
+}
+
 void Parser::ParserImpl::updateModel(const ModelPtr &model, const std::string &input)
 {
     loadModel(model, input);
@@ -288,15 +305,15 @@ void Parser::ParserImpl::loadModel(const ModelPtr &model, const std::string &inp
     std::vector<XmlNodePtr> encapsulationNodes;
     while (childNode) {
         if (childNode->isCellmlElement("component")) {
-            ComponentPtr component = std::make_shared<Component>();
+            ComponentPtr component = makeEntity<Component>();
             loadComponent(component, childNode);
             model->addComponent(component);
         } else if (childNode->isCellmlElement("units")) {
-            UnitsPtr units = std::make_shared<Units>();
+            UnitsPtr units = makeEntity<Units>();
             loadUnits(units, childNode);
             model->addUnits(units);
         } else if (childNode->isCellmlElement("import")) {
-            ImportSourcePtr importSource = std::make_shared<ImportSource>();
+            ImportSourcePtr importSource = makeEntity<ImportSource>();
             loadImport(importSource, model, childNode);
         } else if (childNode->isCellmlElement("encapsulation")) {
             // An encapsulation should not have attributes other than an 'id' attribute.
@@ -388,11 +405,11 @@ void Parser::ParserImpl::loadComponent(const ComponentPtr &component, const XmlN
     XmlNodePtr childNode = node->firstChild();
     while (childNode) {
         if (childNode->isCellmlElement("variable")) {
-            VariablePtr variable = std::make_shared<Variable>();
+            VariablePtr variable = makeEntity<Variable>();
             loadVariable(variable, childNode);
             component->addVariable(variable);
         } else if (childNode->isCellmlElement("reset")) {
-            ResetPtr reset = std::make_shared<Reset>();
+            ResetPtr reset = makeEntity<Reset>();
             loadReset(reset, component, childNode);
             component->addReset(reset);
         } else if (childNode->isMathmlElement("math")) {
@@ -593,6 +610,7 @@ void Parser::ParserImpl::loadConnection(const ModelPtr &model, const XmlNodePtr
     NamePair componentNamePair;
     NamePair variableNamePair;
     NamePairMap variableNameMap;
+    std::vector<std::string> mappingIds;
     bool mapVariablesFound = false;
     bool component1Missing = false;
     bool component2Missing = false;
@@ -602,7 +620,6 @@ void Parser::ParserImpl::loadConnection(const ModelPtr &model, const XmlNodePtr
     // Check connection for component_{1, 2} attributes and get the name pair.
     std::string component1Name;
     std::string component2Name;
-    std::string mappingId;
     std::string connectionId;
     XmlAttributePtr attribute = node->firstAttribute();
     while (attribute) {
@@ -683,6 +700,7 @@ void Parser::ParserImpl::loadConnection(const ModelPtr &model, const XmlNodePtr
         if (childNode->isCellmlElement("map_variables")) {
             std::string variable1Name;
             std::string variable2Name;
+            std::string mappingId;
             XmlAttributePtr childAttribute = childNode->firstAttribute();
             while (childAttribute) {
                 if (childAttribute->isType("variable_1")) {
@@ -722,6 +740,7 @@ void Parser::ParserImpl::loadConnection(const ModelPtr &model, const XmlNodePtr
             // We can have multiple map_variables per connection.
             variableNamePair = std::make_pair(variable1Name, variable2Name);
             variableNameMap.push_back(variableNamePair);
+            mappingIds.push_back(mappingId);
             mapVariablesFound = true;
 
         } else if (childNode->isText()) {
@@ -777,7 +796,8 @@ void Parser::ParserImpl::loadConnection(const ModelPtr &model, const XmlNodePtr
 
     // If we have a map_variables, check that the variables exist in the named components.
     if (mapVariablesFound) {
-        for (const auto &iterPair : variableNameMap) {
+        for (size_t i = 0; i < variableNameMap.size(); ++i) {
+            const auto &iterPair = variableNameMap.at(i);
             VariablePtr variable1 = nullptr;
             VariablePtr variable2 = nullptr;
             if (component1) {
@@ -785,7 +805,7 @@ void Parser::ParserImpl::loadConnection(const ModelPtr &model, const XmlNodePtr
                     variable1 = component1->variable(iterPair.first);
                 } else if (component1->isImport()) {
                     // With an imported component we assume this variable exists in the imported component.
-                    variable1 = std::make_shared<Variable>();
+                    variable1 = makeEntity<Variable>();
                     variable1->setName(iterPair.first);
                     component1->addVariable(variable1);
                 } else {
@@ -811,7 +831,7 @@ void Parser::ParserImpl::loadConnection(const ModelPtr &model, const XmlNodePtr
                     variable2 = component2->variable(iterPair.second);
                 } else if (component2->isImport()) {
                     // With an imported component we assume this variable exists in the imported component.
-                    variable2 = std::make_shared<Variable>();
+                    variable2 = makeEntity<Variable>();
                     variable2->setName(iterPair.second);
                     component2->addVariable(variable2);
                 } else {
@@ -834,7 +854,7 @@ void Parser::ParserImpl::loadConnection(const ModelPtr &model, const XmlNodePtr
             }
             // Set the variable equivalence relationship for this variable pair.
             if ((variable1) && (variable2)) {
-                Variable::addEquivalence(variable1, variable2, mappingId, connectionId);
+                Variable::addEquivalence(variable1, variable2, mappingIds.at(i), connectionId);
             }
         }
     } else {
@@ -1051,7 +1071,7 @@ void Parser::ParserImpl::loadImport(const ImportSourcePtr &importSource, const M
     XmlNodePtr childNode = node->firstChild();
     while (childNode) {
         if (childNode->isCellmlElement("component")) {
-            ComponentPtr importedComponent = std::make_shared<Component>();
+            ComponentPtr importedComponent = makeEntity<Component>();
             bool errorOccurred = false;
             XmlAttributePtr childAttribute = childNode->firstAttribute();
             while (childAttribute) {
@@ -1074,7 +1094,7 @@ void Parser::ParserImpl::loadImport(const ImportSourcePtr &importSource, const M
                 model->addComponent(importedComponent);
             }
         } else if (childNode->isCellmlElement("units")) {
-            UnitsPtr importedUnits = std::make_shared<Units>();
+            UnitsPtr importedUnits = makeEntity<Units>();
             bool errorOccurred = false;
             XmlAttributePtr childAttribute = childNode->firstAttribute();
             while (childAttribute) {
@@ -1191,7 +1211,7 @@ void Parser::ParserImpl::loadReset(const ResetPtr &reset, const ComponentPtr &co
     XmlNodePtr childNode = node->firstChild();
     while (childNode) {
         if (childNode->isCellmlElement("when")) {
-            WhenPtr when = std::make_shared<When>();
+            WhenPtr when = makeEntity<When>();
             loadWhen(when, reset, childNode);
             reset->addWhen(when);
         } else if (childNode->isText()) {
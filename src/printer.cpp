@@ -20,6 +20,7 @@ limitations under the License.
 #include "libcellml/enumerations.h"
 #include "libcellml/importsource.h"
 #include "libcellml/model.h"
+#include "libcellml/modelwalker.h"
 #include "libcellml/printer.h"
 #include "libcellml/reset.h"
 #include "libcellml/units.h"
@@ -29,7 +30,6 @@ limitations under the License.
 #include <iostream>
 #include <map>
 #include <sstream>
-#include <stack>
 #include <utility>
 #include <vector>
 
@@ -452,53 +452,12 @@ std::string Printer::printModel(const ModelPtr &model) const
     ComponentMap componentMap;
 
     // Gather all imports.
-    std::stack<size_t> indeciesStack;
-    std::stack<ComponentPtr> componentStack;
-    bool incrementComponent = false;
-    for (size_t i = 0; i < model->componentCount(); ++i) {
-        ComponentPtr comp = model->component(i);
-        ComponentPtr modelComponent = comp;
-        size_t index = 0;
-        while (comp) {
-            incrementComponent = false;
-            if (comp->isImport()) {
-                ImportPair pair = std::make_pair(comp->importReference(), comp);
-                ImportSourcePtr importSource = comp->importSource();
-                if (importMap.count(importSource) == 0) {
-                    importMap[importSource] = std::vector<ImportPair>();
-                }
-                importMap[importSource].push_back(pair);
-                incrementComponent = true;
-            } else if (comp->componentCount() != 0) {
-                // If the current component is a model component
-                // let the 'for' loop take care of the stack.
-                if (modelComponent != comp) {
-                    componentStack.push(comp);
-                    indeciesStack.push(index);
-                }
-                index = 0;
-                comp = comp->component(index);
-            } else {
-                incrementComponent = true;
-            }
-
-            if (incrementComponent) {
-                if (!componentStack.empty()) {
-                    index = indeciesStack.top();
-                    comp = componentStack.top();
-                    indeciesStack.pop();
-                    componentStack.pop();
-                    index += 1;
-                    if (index < comp->componentCount()) {
-                        comp = comp->component(index);
-                    } else {
-                        comp = nullptr;
-                    }
-                } else {
-                    index = 0;
-                    comp = nullptr;
-                }
-            }
+    ModelWalker walker(model);
+    while (walker.next()) {
+        const ComponentPtr &component = walker.component();
+        if (component->isImport()) {
+            importMap[component->importSource()].push_back(std::make_pair(component->importReference(), component));
+            walker.skipChildren();
         }
     }
 
@@ -14,6 +14,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include "arena.h"
+
 #include "libcellml/reset.h"
 #include "libcellml/when.h"
 
@@ -42,18 +44,18 @@ std::vector<WhenPtr>::iterator Reset::ResetImpl::findWhen(const WhenPtr &when)
 }
 
 Reset::Reset()
-    : mPimpl(new ResetImpl())
+    : mPimpl(newImpl<ResetImpl>())
 {
 }
 
 Reset::~Reset()
 {
-    delete mPimpl;
+    deleteImpl(mPimpl);
 }
 
 Reset::Reset(const Reset &rhs)
     : OrderedEntity(rhs)
-    , mPimpl(new ResetImpl())
+    , mPimpl(newImpl<ResetImpl>())
 {
     mPimpl->mOrder = rhs.mPimpl->mOrder;
     mPimpl->mVariable = rhs.mPimpl->mVariable;
@@ -82,6 +84,7 @@ void Reset::swap(Reset &rhs)
 void Reset::setVariable(const VariablePtr &variable)
 {
     mPimpl->mVariable = variable;
+    markModified();
 }
 
 VariablePtr Reset::variable() const
@@ -92,6 +95,7 @@ VariablePtr Reset::variable() const
 void Reset::addWhen(const WhenPtr &when)
 {
     mPimpl->mWhens.push_back(when);
+    markModified();
 }
 
 bool Reset::removeWhen(size_t index)
@@ -100,6 +104,7 @@ bool Reset::removeWhen(size_t index)
 
     if (index < mPimpl->mWhens.size()) {
         mPimpl->mWhens.erase(mPimpl->mWhens.begin() + int64_t(index));
+        markModified();
         status = true;
     }
 
@@ -112,6 +117,7 @@ bool Reset::removeWhen(const WhenPtr &when)
     auto result = mPimpl->findWhen(when);
     if (result != mPimpl->mWhens.end()) {
         mPimpl->mWhens.erase(result);
+        markModified();
         status = true;
     }
 
@@ -121,6 +127,7 @@ bool Reset::removeWhen(const WhenPtr &when)
 void Reset::removeAllWhens()
 {
     mPimpl->mWhens.clear();
+    markModified();
 }
 
 bool Reset::containsWhen(const WhenPtr &when) const
@@ -150,6 +157,7 @@ WhenPtr Reset::takeWhen(size_t index)
     if (index < mPimpl->mWhens.size()) {
         when = mPimpl->mWhens.at(index);
         mPimpl->mWhens.erase(mPimpl->mWhens.begin() + int64_t(index));
+        markModified();
     }
 
     return when;
@@ -160,6 +168,7 @@ bool Reset::replaceWhen(size_t index, const WhenPtr &when)
     bool status = false;
     if (removeWhen(index)) {
         mPimpl->mWhens.insert(mPimpl->mWhens.begin() + int64_t(index), when);
+        markModified();
         status = true;
     }
 
@@ -0,0 +1,384 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "bytecode.h"
+#include "utilities.h"
+
+#include "libcellml/error.h"
+#include "libcellml/evaluator.h"
+#include "libcellml/solver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace libcellml {
+
+/**
+ * @brief The Solver::SolverImpl struct.
+ *
+ * The private implementation for the Solver class.
+ */
+struct Solver::SolverImpl
+{
+    Solver *mSolver = nullptr;
+    Method mMethod = Method::RUNGE_KUTTA_4;
+    double mStep = 1.0e-3;
+    double mMaximumStep = 0.0;
+    double mRelativeTolerance = 1.0e-6;
+    double mAbsoluteTolerance = 1.0e-8;
+
+    // Work arrays, sized once per call to solve().
+    std::vector<double> mRates;
+    std::vector<double> mStates;
+    std::vector<std::vector<double>> mStages;
+    std::vector<double> mCoefficients;
+    std::vector<double> mConditions;
+    std::vector<double> mPreviousConditions;
+    std::vector<double> mScratch;
+
+    // The adaptive step size carried between steps.
+    double mAdaptiveStep = 0.0;
+
+    void addError(const std::string &description);
+    void forwardEulerStep(double h, double *states);
+    void rushLarsenStep(const Evaluator &evaluator, double voi, double h, double *states, double *variables);
+    void rungeKutta4Step(const Evaluator &evaluator, double voi, double h, double *states, double *variables);
+    bool dormandPrince54Step(const Evaluator &evaluator, double voi, double &h, double *states, double *variables);
+};
+
+void Solver::SolverImpl::addError(const std::string &description)
+{
+    ErrorPtr err = std::make_shared<Error>();
+    err->setDescription(description);
+    mSolver->addError(err);
+}
+
+void Solver::SolverImpl::forwardEulerStep(double h, double *states)
+{
+    for (size_t i = 0; i < mRates.size(); ++i) {
+        states[i] += h * mRates[i];
+    }
+}
+
+void Solver::SolverImpl::rushLarsenStep(const Evaluator &evaluator, double voi, double h, double *states, double *variables)
+{
+    EvaluatorAccess::computeGatingCoefficients(evaluator, voi, states, mRates.data(), variables, mCoefficients.data(), mScratch.data());
+    for (size_t i = 0; i < mRates.size(); ++i) {
+        double b = mCoefficients[2 * i + 1];
+        if (evaluator.isGatingState(i) && (std::fabs(b * h) > 1.0e-12)) {
+            // Exact solution of d(state)/d(voi) = a + b * state over the step.
+            states[i] += mRates[i] * std::expm1(b * h) / b;
+        } else {
+            states[i] += h * mRates[i];
+        }
+    }
+}
+
+void Solver::SolverImpl::rungeKutta4Step(const Evaluator &evaluator, double voi, double h, double *states, double *variables)
+{
+    size_t n = mRates.size();
+    std::vector<double> &k2 = mStages[0];
+    std::vector<double> &k3 = mStages[1];
+    std::vector<double> &k4 = mStages[2];
+    for (size_t i = 0; i < n; ++i) {
+        mStates[i] = states[i] + 0.5 * h * mRates[i];
+    }
+    EvaluatorAccess::computeRates(evaluator, voi + 0.5 * h, mStates.data(), k2.data(), variables, mScratch.data());
+    for (size_t i = 0; i < n; ++i) {
+        mStates[i] = states[i] + 0.5 * h * k2[i];
+    }
+    EvaluatorAccess::computeRates(evaluator, voi + 0.5 * h, mStates.data(), k3.data(), variables, mScratch.data());
+    for (size_t i = 0; i < n; ++i) {
+        mStates[i] = states[i] + h * k3[i];
+    }
+    EvaluatorAccess::computeRates(evaluator, voi + h, mStates.data(), k4.data(), variables, mScratch.data());
+    for (size_t i = 0; i < n; ++i) {
+        states[i] += h / 6.0 * (mRates[i] + 2.0 * k2[i] + 2.0 * k3[i] + k4[i]);
+    }
+}
+
+bool Solver::SolverImpl::dormandPrince54Step(const Evaluator &evaluator, double voi, double &h, double *states, double *variables)
+{
+    // Dormand-Prince 5(4) coefficients.
+    static const double c[] = {0.0, 1.0 / 5.0, 3.0 / 10.0, 4.0 / 5.0, 8.0 / 9.0, 1.0, 1.0};
+    static const double a[7][6] = {
+        {0.0, 0.0, 0.0, 0.0, 0.0, 0.0},
+        {1.0 / 5.0, 0.0, 0.0, 0.0, 0.0, 0.0},
+        {3.0 / 40.0, 9.0 / 40.0, 0.0, 0.0, 0.0, 0.0},
+        {44.0 / 45.0, -56.0 / 15.0, 32.0 / 9.0, 0.0, 0.0, 0.0},
+        {19372.0 / 6561.0, -25360.0 / 2187.0, 64448.0 / 6561.0, -212.0 / 729.0, 0.0, 0.0},
+        {9017.0 / 3168.0, -355.0 / 33.0, 46732.0 / 5247.0, 49.0 / 176.0, -5103.0 / 18656.0, 0.0},
+        {35.0 / 384.0, 0.0, 500.0 / 1113.0, 125.0 / 192.0, -2187.0 / 6784.0, 11.0 / 84.0},
+    };
+    static const double e[] = {71.0 / 57600.0, 0.0, -71.0 / 16695.0, 71.0 / 1920.0, -17253.0 / 339200.0, 22.0 / 525.0, -1.0 / 40.0};
+
+    size_t n = mRates.size();
+    // mStages[0..5] hold k2..k7, k1 is mRates.
+    auto k = [this](size_t stage) -> std::vector<double> & {
+        return (stage == 0) ? mRates : mStages[stage - 1];
+    };
+    for (size_t s = 1; s < 7; ++s) {
+        for (size_t i = 0; i < n; ++i) {
+            double sum = 0.0;
+            for (size_t j = 0; j < s; ++j) {
+                sum += a[s][j] * k(j)[i];
+            }
+            mStates[i] = states[i] + h * sum;
+        }
+        EvaluatorAccess::computeRates(evaluator, voi + c[s] * h, mStates.data(), k(s).data(), variables, mScratch.data());
+    }
+    // mStates now holds the fifth order solution and k7 its rates.
+    double errorNorm = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        double error = 0.0;
+        for (size_t j = 0; j < 7; ++j) {
+            error += e[j] * k(j)[i];
+        }
+        double scale = mAbsoluteTolerance + mRelativeTolerance * std::max(std::fabs(states[i]), std::fabs(mStates[i]));
+        double ratio = h * error / scale;
+        errorNorm += ratio * ratio;
+    }
+    errorNorm = (n > 0) ? std::sqrt(errorNorm / static_cast<double>(n)) : 0.0;
+
+    double factor = (errorNorm > 0.0) ? 0.9 * std::pow(errorNorm, -0.2) : 5.0;
+    factor = std::min(5.0, std::max(0.2, factor));
+    if (!(errorNorm <= 1.0)) {
+        h *= std::min(1.0, factor);
+        return false;
+    }
+    std::copy(mStates.begin(), mStates.end(), states);
+    // First same as last: the rates at the new point are k7.
+    std::copy(k(6).begin(), k(6).end(), mRates.begin());
+    h *= factor;
+    return true;
+}
+
+Solver::Solver()
+    : mPimpl(new SolverImpl())
+{
+    mPimpl->mSolver = this;
+}
+
+Solver::~Solver()
+{
+    delete mPimpl;
+}
+
+Solver::Solver(const Solver &rhs)
+    : Logger(rhs)
+    , mPimpl(new SolverImpl(*rhs.mPimpl))
+{
+    mPimpl->mSolver = this;
+}
+
+Solver::Solver(Solver &&rhs) noexcept
+    : Logger(std::move(rhs))
+    , mPimpl(rhs.mPimpl)
+{
+    if (mPimpl != nullptr) {
+        mPimpl->mSolver = this;
+    }
+    rhs.mPimpl = nullptr;
+}
+
+Solver &Solver::operator=(Solver rhs)
+{
+    Logger::operator=(rhs);
+    rhs.swap(*this);
+    return *this;
+}
+
+void Solver::swap(Solver &rhs)
+{
+    std::swap(this->mPimpl, rhs.mPimpl);
+    // The implementations point back to the solvers that now own them, if
+    // any, as a moved from solver has none.
+    if (this->mPimpl != nullptr) {
+        this->mPimpl->mSolver = this;
+    }
+    if (rhs.mPimpl != nullptr) {
+        rhs.mPimpl->mSolver = &rhs;
+    }
+}
+
+void Solver::setMethod(Method method)
+{
+    mPimpl->mMethod = method;
+}
+
+Solver::Method Solver::method() const
+{
+    return mPimpl->mMethod;
+}
+
+void Solver::setStep(double step)
+{
+    mPimpl->mStep = step;
+}
+
+double Solver::step() const
+{
+    return mPimpl->mStep;
+}
+
+void Solver::setMaximumStep(double maximumStep)
+{
+    mPimpl->mMaximumStep = maximumStep;
+}
+
+double Solver::maximumStep() const
+{
+    return mPimpl->mMaximumStep;
+}
+
+void Solver::setRelativeTolerance(double tolerance)
+{
+    mPimpl->mRelativeTolerance = tolerance;
+}
+
+double Solver::relativeTolerance() const
+{
+    return mPimpl->mRelativeTolerance;
+}
+
+void Solver::setAbsoluteTolerance(double tolerance)
+{
+    mPimpl->mAbsoluteTolerance = tolerance;
+}
+
+double Solver::absoluteTolerance() const
+{
+    return mPimpl->mAbsoluteTolerance;
+}
+
+bool Solver::solve(const Evaluator &evaluator, double *states, double *variables,
+                   double voiStart, double voiEnd, size_t pointCount, double *output)
+{
+    clearErrors();
+    if (!evaluator.isValid()) {
+        mPimpl->addError("Evaluator does not hold a successfully processed model.");
+        return false;
+    }
+    if (pointCount < 2) {
+        mPimpl->addError("The number of output points must be at least two.");
+        return false;
+    }
+    if (!(voiEnd > voiStart)) {
+        mPimpl->addError("The end of the integration interval must be greater than its start.");
+        return false;
+    }
+    if (!(mPimpl->mStep > 0.0)) {
+        mPimpl->addError("The step size must be greater than zero.");
+        return false;
+    }
+
+    size_t stateCount = evaluator.stateCount();
+    size_t variableCount = evaluator.variableCount();
+    size_t whenCount = evaluator.whenCount();
+    size_t rowSize = 1 + stateCount + variableCount;
+    mPimpl->mRates.assign(stateCount, 0.0);
+    mPimpl->mStates.assign(stateCount, 0.0);
+    mPimpl->mStages.assign(6, std::vector<double>(stateCount, 0.0));
+    mPimpl->mCoefficients.assign(2 * stateCount, 0.0);
+    mPimpl->mConditions.assign(whenCount, 0.0);
+    mPimpl->mPreviousConditions.assign(whenCount, 0.0);
+    mPimpl->mScratch.assign(EvaluatorAccess::scratchSize(evaluator), 0.0);
+    mPimpl->mAdaptiveStep = mPimpl->mStep;
+
+    double voi = voiStart;
+    double *rates = mPimpl->mRates.data();
+    EvaluatorAccess::computeRates(evaluator, voi, states, rates, variables, mPimpl->mScratch.data());
+    EvaluatorAccess::computeVariables(evaluator, voi, states, rates, variables, mPimpl->mScratch.data());
+    EvaluatorAccess::computeConditions(evaluator, voi, states, rates, variables, mPimpl->mPreviousConditions.data(), mPimpl->mScratch.data());
+
+    auto record = [&](size_t point) {
+        double *row = output + point * rowSize;
+        row[0] = voi;
+        std::copy(states, states + stateCount, row + 1);
+        std::copy(variables, variables + variableCount, row + 1 + stateCount);
+    };
+    record(0);
+
+    for (size_t point = 1; point < pointCount; ++point) {
+        double target = voiStart + (voiEnd - voiStart) * static_cast<double>(point) / static_cast<double>(pointCount - 1);
+        double tolerance = 1.0e-12 * std::max(1.0, std::fabs(target));
+        while (target - voi > tolerance) {
+            double remaining = target - voi;
+            if (mPimpl->mMethod == Method::DORMAND_PRINCE_54) {
+                double h = mPimpl->mAdaptiveStep;
+                if (mPimpl->mMaximumStep > 0.0) {
+                    h = std::min(h, mPimpl->mMaximumStep);
+                }
+                bool clamped = h >= remaining;
+                if (clamped) {
+                    h = remaining;
+                }
+                double nextStep = h;
+                bool accepted = mPimpl->dormandPrince54Step(evaluator, voi, nextStep, states, variables);
+                if (!accepted || !clamped || (nextStep < mPimpl->mAdaptiveStep)) {
+                    mPimpl->mAdaptiveStep = nextStep;
+                }
+                if (!accepted) {
+                    if (mPimpl->mAdaptiveStep < 1.0e-14 * std::max(1.0, std::fabs(voi))) {
+                        mPimpl->addError("The step size became too small at a variable of integration value of " + convertDoubleToString(voi) + ".");
+                        return false;
+                    }
+                    continue;
+                }
+                voi = clamped ? target : voi + h;
+            } else {
+                double h = std::min(mPimpl->mStep, remaining);
+                if (mPimpl->mMethod == Method::FORWARD_EULER) {
+                    mPimpl->forwardEulerStep(h, states);
+                } else if (mPimpl->mMethod == Method::RUSH_LARSEN) {
+                    mPimpl->rushLarsenStep(evaluator, voi, h, states, variables);
+                } else {
+                    mPimpl->rungeKutta4Step(evaluator, voi, h, states, variables);
+                }
+                voi = (h == remaining) ? target : voi + h;
+                EvaluatorAccess::computeRates(evaluator, voi, states, rates, variables, mPimpl->mScratch.data());
+            }
+
+            for (size_t i = 0; i < stateCount; ++i) {
+                if (!std::isfinite(states[i])) {
+                    mPimpl->addError("The solution is not finite at a variable of integration value of " + convertDoubleToString(voi) + ".");
+                    return false;
+                }
+            }
+
+            // Discrete events, detected at the end of the step.
+            if (whenCount > 0) {
+                EvaluatorAccess::computeVariables(evaluator, voi, states, rates, variables, mPimpl->mScratch.data());
+                EvaluatorAccess::computeConditions(evaluator, voi, states, rates, variables, mPimpl->mConditions.data(), mPimpl->mScratch.data());
+                if (evaluator.applyResets(voi, states, rates, variables, mPimpl->mPreviousConditions.data(), mPimpl->mConditions.data())) {
+                    EvaluatorAccess::computeRates(evaluator, voi, states, rates, variables, mPimpl->mScratch.data());
+                    EvaluatorAccess::computeVariables(evaluator, voi, states, rates, variables, mPimpl->mScratch.data());
+                    EvaluatorAccess::computeConditions(evaluator, voi, states, rates, variables, mPimpl->mConditions.data(), mPimpl->mScratch.data());
+                }
+                std::swap(mPimpl->mConditions, mPimpl->mPreviousConditions);
+            }
+        }
+        voi = target;
+        EvaluatorAccess::computeVariables(evaluator, voi, states, rates, variables, mPimpl->mScratch.data());
+        record(point);
+    }
+    return true;
+}
+
+} // namespace libcellml
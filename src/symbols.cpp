@@ -0,0 +1,441 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "symbols.h"
+
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace libcellml {
+
+/**
+ * The number of strings in a chunk of the symbol table, as a power of two.
+ */
+static const size_t SYMBOL_CHUNK_BITS = 12;
+
+/**
+ * The maximum number of chunks in the symbol table, which allows for a few
+ * hundred million strings interned at the same time.
+ */
+static const size_t SYMBOL_CHUNK_COUNT = 65536;
+
+/**
+ * The initial number of slots of the index of the symbol table, as a power
+ * of two.
+ */
+static const size_t SYMBOL_INDEX_INITIAL_BITS = 12;
+
+/**
+ * The value of an index slot whose symbol has been removed.
+ */
+static const Symbol REMOVED_SLOT = std::numeric_limits<Symbol>::max();
+
+/**
+ * @brief The SymbolEntry struct.
+ *
+ * An internal structure holding an interned string and the number of
+ * references to it.
+ */
+struct SymbolEntry
+{
+    std::string mString; /**< The string. */
+    std::atomic<size_t> mReferences {0}; /**< The number of references to the string. */
+    bool mInterned = false; /**< Whether the string is in the index, guarded by the mutex of the table. */
+};
+
+/**
+ * @brief The SymbolIndex struct.
+ *
+ * An internal open addressing hash table from the interned strings to their
+ * symbols.  Each slot holds one more than the symbol it refers to, zero if it
+ * is empty, or REMOVED_SLOT if its symbol has been removed.  Empty slots are
+ * only ever filled, and filled slots only ever marked as removed, so that the
+ * index can be read without a lock while strings are being interned and
+ * removed.
+ */
+struct SymbolIndex
+{
+    size_t mMask; /**< The number of slots minus one. */
+    std::atomic<Symbol> *mSlots; /**< The slots. */
+};
+
+/**
+ * @brief The SymbolTable struct.
+ *
+ * An internal structure holding the interned strings.  The strings are
+ * stored in chunks that never move, so that they can be read without a lock
+ * while other strings are being interned.
+ *
+ * Lookups without a lock are counted in mReaders.  A removed symbol, or a
+ * replaced index, is only retired at first, and is only reused, or freed,
+ * once no lookup is in progress, since a lookup that started before it was
+ * retired may still be reading it.
+ */
+struct SymbolTable
+{
+    std::mutex mMutex; /**< The mutex guarding the changes to the table. */
+    size_t mCount = 0; /**< The number of symbols ever used. */
+    size_t mLiveCount = 0; /**< The number of symbols in the index. */
+    size_t mUsedSlots = 0; /**< The number of slots of the index that are not empty. */
+    std::vector<Symbol> mFreeSymbols; /**< The symbols that can be reused. */
+    std::vector<Symbol> mRetiredSymbols; /**< The removed symbols that may still be read by a lookup. */
+    std::vector<SymbolIndex *> mRetiredIndices; /**< The replaced indices that may still be read by a lookup. */
+    std::atomic<size_t> mReaders {0}; /**< The number of lookups in progress. */
+    std::atomic<SymbolIndex *> mIndex {nullptr}; /**< The index of the interned strings. */
+    std::array<std::atomic<SymbolEntry *>, SYMBOL_CHUNK_COUNT> mChunks {}; /**< The chunks of interned strings, indexed by symbol. */
+
+    /** Constructor */
+    SymbolTable()
+    {
+        // The empty string is always interned, as EMPTY_SYMBOL.
+        mIndex.store(createIndex(SYMBOL_INDEX_INITIAL_BITS));
+        insert(std::string());
+    }
+
+    static SymbolIndex *createIndex(size_t bits);
+    static void deleteIndex(SymbolIndex *index);
+    SymbolEntry &entry(Symbol symbol) const;
+    bool find(const SymbolIndex &index, const std::string &string, Symbol &symbol, std::atomic<Symbol> *&slot) const;
+    bool lookUp(const std::string &string, Symbol &symbol, bool acquire);
+    Symbol insert(const std::string &string);
+    void rebuildIndex();
+    void remove(Symbol symbol);
+    void reclaim();
+};
+
+/**
+ * @brief Create an empty index with 2^@p bits slots.
+ *
+ * @param bits The number of slots, as a power of two.
+ *
+ * @return The index.
+ */
+SymbolIndex *SymbolTable::createIndex(size_t bits)
+{
+    size_t slotCount = size_t(1) << bits;
+    auto index = new SymbolIndex();
+    index->mMask = slotCount - 1;
+    index->mSlots = new std::atomic<Symbol>[slotCount];
+    for (size_t i = 0; i < slotCount; ++i) {
+        index->mSlots[i].store(0, std::memory_order_relaxed);
+    }
+    return index;
+}
+
+/**
+ * @brief Delete @p index.
+ *
+ * @param index The index to delete.
+ */
+void SymbolTable::deleteIndex(SymbolIndex *index)
+{
+    delete[] index->mSlots;
+    delete index;
+}
+
+/**
+ * @brief Get the entry of @p symbol.
+ *
+ * @param symbol The symbol.
+ *
+ * @return The entry.
+ */
+SymbolEntry &SymbolTable::entry(Symbol symbol) const
+{
+    SymbolEntry *chunk = mChunks[symbol >> SYMBOL_CHUNK_BITS].load(std::memory_order_acquire);
+    return chunk[symbol & ((size_t(1) << SYMBOL_CHUNK_BITS) - 1)];
+}
+
+/**
+ * @brief Find @p string in @p index.
+ *
+ * @param index The index to look @p string up in.
+ * @param string The string to look up.
+ * @param symbol The symbol to set if @p string is in @p index.
+ * @param slot The slot to set to that of @p string if it is in @p index, or
+ * to the empty slot where it would go otherwise.
+ *
+ * @return @c true if @p string is in @p index, @c false otherwise.
+ */
+bool SymbolTable::find(const SymbolIndex &index, const std::string &string, Symbol &symbol, std::atomic<Symbol> *&slot) const
+{
+    for (size_t i = std::hash<std::string>()(string);; ++i) {
+        slot = &index.mSlots[i & index.mMask];
+        Symbol value = slot->load();
+        if (value == 0) {
+            return false;
+        }
+        if ((value != REMOVED_SLOT) && (entry(value - 1).mString == string)) {
+            symbol = value - 1;
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief Look @p string up without a lock.
+ *
+ * @param string The string to look up.
+ * @param symbol The symbol to set if @p string is found.
+ * @param acquire Whether to take a reference to the symbol found, which
+ * fails if it is being removed.
+ *
+ * @return @c true if @p string is found, and a reference taken to it if
+ * @p acquire is @c true, @c false otherwise.
+ */
+bool SymbolTable::lookUp(const std::string &string, Symbol &symbol, bool acquire)
+{
+    // Sequentially consistent, like the removal of symbols, so that either
+    // the lookup sees a symbol removed, or the removal sees the lookup.
+    mReaders.fetch_add(1);
+    std::atomic<Symbol> *slot;
+    bool found = find(*mIndex.load(), string, symbol, slot);
+    if (found && acquire && (symbol != EMPTY_SYMBOL)) {
+        std::atomic<size_t> &references = entry(symbol).mReferences;
+        size_t count = references.load(std::memory_order_relaxed);
+        do {
+            if (count == 0) {
+                found = false;
+                break;
+            }
+        } while (!references.compare_exchange_weak(count, count + 1, std::memory_order_relaxed));
+    }
+    mReaders.fetch_sub(1);
+    return found;
+}
+
+/**
+ * @brief Intern @p string, which is not in the index.
+ *
+ * To be called with mMutex locked.
+ *
+ * @param string The string to intern.
+ *
+ * @return The symbol of @p string, with a reference taken to it.
+ */
+Symbol SymbolTable::insert(const std::string &string)
+{
+    reclaim();
+    Symbol symbol;
+    if (mFreeSymbols.empty()) {
+        symbol = Symbol(mCount);
+        size_t chunk = mCount >> SYMBOL_CHUNK_BITS;
+        assert(chunk < SYMBOL_CHUNK_COUNT);
+        if (mChunks[chunk].load(std::memory_order_relaxed) == nullptr) {
+            mChunks[chunk].store(new SymbolEntry[size_t(1) << SYMBOL_CHUNK_BITS], std::memory_order_release);
+        }
+        ++mCount;
+    } else {
+        symbol = mFreeSymbols.back();
+        mFreeSymbols.pop_back();
+    }
+    SymbolEntry &symbolEntry = entry(symbol);
+    symbolEntry.mString = string;
+    symbolEntry.mReferences.store(1, std::memory_order_relaxed);
+    symbolEntry.mInterned = true;
+    ++mLiveCount;
+
+    // The index is kept at most half full, counting the removed slots.
+    if (2 * (mUsedSlots + 1) > mIndex.load(std::memory_order_relaxed)->mMask + 1) {
+        rebuildIndex();
+    }
+    Symbol unused;
+    std::atomic<Symbol> *slot;
+    find(*mIndex.load(std::memory_order_relaxed), string, unused, slot);
+    slot->store(Symbol(symbol + 1));
+    ++mUsedSlots;
+    return symbol;
+}
+
+/**
+ * @brief Replace the index with one holding the symbols still interned.
+ *
+ * The new index is a quarter full at most.  The previous index is retired
+ * for the lookups that may still be using it.
+ *
+ * To be called with mMutex locked.
+ */
+void SymbolTable::rebuildIndex()
+{
+    size_t bits = SYMBOL_INDEX_INITIAL_BITS;
+    while ((size_t(1) << bits) < 4 * mLiveCount) {
+        ++bits;
+    }
+    SymbolIndex *index = mIndex.load(std::memory_order_relaxed);
+    SymbolIndex *newIndex = createIndex(bits);
+    Symbol unused;
+    std::atomic<Symbol> *slot;
+    mUsedSlots = 0;
+    for (size_t i = 0; i <= index->mMask; ++i) {
+        Symbol value = index->mSlots[i].load(std::memory_order_relaxed);
+        if ((value != 0) && (value != REMOVED_SLOT)) {
+            find(*newIndex, entry(value - 1).mString, unused, slot);
+            slot->store(value, std::memory_order_relaxed);
+            ++mUsedSlots;
+        }
+    }
+    mIndex.store(newIndex);
+    mRetiredIndices.push_back(index);
+}
+
+/**
+ * @brief Remove @p symbol, which is no longer referenced, from the index.
+ *
+ * To be called with mMutex locked.
+ *
+ * @param symbol The symbol to remove.
+ */
+void SymbolTable::remove(Symbol symbol)
+{
+    SymbolEntry &symbolEntry = entry(symbol);
+    Symbol found;
+    std::atomic<Symbol> *slot;
+    if (find(*mIndex.load(std::memory_order_relaxed), symbolEntry.mString, found, slot)) {
+        slot->store(REMOVED_SLOT);
+    }
+    symbolEntry.mInterned = false;
+    --mLiveCount;
+    mRetiredSymbols.push_back(symbol);
+    // The index is shrunk once it is less than an eighth full.
+    SymbolIndex *index = mIndex.load(std::memory_order_relaxed);
+    if ((index->mMask + 1 > (size_t(1) << SYMBOL_INDEX_INITIAL_BITS))
+        && (8 * mLiveCount < index->mMask + 1)) {
+        rebuildIndex();
+    }
+    reclaim();
+}
+
+/**
+ * @brief Free the retired symbols and indices, if no lookup may still be
+ * reading them.
+ *
+ * To be called with mMutex locked.
+ */
+void SymbolTable::reclaim()
+{
+    if ((mRetiredSymbols.empty() && mRetiredIndices.empty())
+        || (mReaders.load() != 0)) {
+        return;
+    }
+    for (Symbol symbol : mRetiredSymbols) {
+        std::string().swap(entry(symbol).mString);
+        mFreeSymbols.push_back(symbol);
+    }
+    mRetiredSymbols.clear();
+    for (SymbolIndex *index : mRetiredIndices) {
+        deleteIndex(index);
+    }
+    mRetiredIndices.clear();
+}
+
+/**
+ * @brief Get the symbol table.
+ *
+ * The table is created on first use and never destroyed, so that names can
+ * still be read, and released, while other static objects are being
+ * destroyed.  Only the strings still referenced are kept in it.
+ *
+ * @return The symbol table.
+ */
+static SymbolTable &symbolTable()
+{
+    static SymbolTable *table = new SymbolTable();
+    return *table;
+}
+
+InternedString::InternedString(const std::string &string)
+{
+    SymbolTable &table = symbolTable();
+    if (table.lookUp(string, mSymbol, true)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(table.mMutex);
+    // The string may have been interned since it was looked up, or be about
+    // to be removed, in which case it is kept.
+    std::atomic<Symbol> *slot;
+    if (table.find(*table.mIndex.load(std::memory_order_relaxed), string, mSymbol, slot)) {
+        if (mSymbol != EMPTY_SYMBOL) {
+            table.entry(mSymbol).mReferences.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+    mSymbol = table.insert(string);
+}
+
+InternedString::InternedString(Symbol symbol)
+    : mSymbol(symbol)
+{
+    if (mSymbol != EMPTY_SYMBOL) {
+        symbolTable().entry(mSymbol).mReferences.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+InternedString::~InternedString()
+{
+    if (mSymbol == EMPTY_SYMBOL) {
+        return;
+    }
+    SymbolTable &table = symbolTable();
+    SymbolEntry &symbolEntry = table.entry(mSymbol);
+    if (symbolEntry.mReferences.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        std::lock_guard<std::mutex> lock(table.mMutex);
+        // The symbol may have been referenced again, or removed by another
+        // release, since the last reference was released.
+        if (symbolEntry.mInterned && (symbolEntry.mReferences.load(std::memory_order_acquire) == 0)) {
+            table.remove(mSymbol);
+        }
+    }
+}
+
+InternedString::InternedString(const InternedString &rhs)
+    : InternedString(rhs.mSymbol)
+{
+}
+
+InternedString::InternedString(InternedString &&rhs) noexcept
+    : mSymbol(rhs.mSymbol)
+{
+    rhs.mSymbol = EMPTY_SYMBOL;
+}
+
+InternedString &InternedString::operator=(InternedString rhs)
+{
+    std::swap(mSymbol, rhs.mSymbol);
+    return *this;
+}
+
+const std::string &InternedString::string() const
+{
+    return symbolTable().entry(mSymbol).mString;
+}
+
+bool findSymbol(const std::string &string, Symbol &symbol)
+{
+    return symbolTable().lookUp(string, symbol, false);
+}
+
+const std::string &symbolString(Symbol symbol)
+{
+    return symbolTable().entry(symbol).mString;
+}
+
+} // namespace libcellml
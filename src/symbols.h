@@ -0,0 +1,153 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace libcellml {
+
+class NamedEntity;
+
+/*
+ * Names and references are interned in a table shared by all models, so that
+ * each distinct string is only stored once, and so that two of them can be
+ * compared by comparing their symbols.  Each symbol is reference counted by
+ * the InternedString objects holding it, and is removed from the table, and
+ * its string freed, once none does.
+ */
+
+/**
+ * The identifier of an interned string.
+ */
+using Symbol = uint32_t;
+
+/**
+ * The symbol of the empty string, which is never removed from the table.
+ */
+static const Symbol EMPTY_SYMBOL = 0;
+
+/**
+ * @brief The InternedString class.
+ *
+ * An internal class holding a reference to an interned string, which stays in
+ * the table for as long as a reference to it is held.  Thread safe.
+ */
+class InternedString
+{
+public:
+    InternedString() = default; /**< Constructor, holding the empty string. */
+
+    /**
+     * @brief Intern @p string and hold a reference to it.
+     *
+     * @param string The string to intern.
+     */
+    explicit InternedString(const std::string &string);
+
+    /**
+     * @brief Hold another reference to @p symbol.
+     *
+     * @param symbol The symbol, which must already be held, e.g. by the
+     * entity it was obtained from.
+     */
+    explicit InternedString(Symbol symbol);
+
+    ~InternedString(); /**< Destructor, releasing the reference. */
+    InternedString(const InternedString &rhs); /**< Copy constructor */
+    InternedString(InternedString &&rhs) noexcept; /**< Move constructor */
+    InternedString &operator=(InternedString rhs); /**< Assignment operator */
+
+    /**
+     * @brief Get the symbol of this string.
+     *
+     * @return The symbol, which is the same for all equal strings.
+     */
+    Symbol symbol() const
+    {
+        return mSymbol;
+    }
+
+    /**
+     * @brief Get this string.
+     *
+     * @return The string, which stays valid while this object holds it.
+     */
+    const std::string &string() const;
+
+private:
+    Symbol mSymbol = EMPTY_SYMBOL; /**< The symbol held. */
+};
+
+/**
+ * @brief Find the symbol of @p string, if it has been interned.
+ *
+ * Thread safe, and lock free.  No reference is taken to the symbol, which
+ * is only valid for as long as something else holds it.  No entity can have a
+ * name or reference that has not been interned, so looking an entity up by a
+ * string that has not been interned can stop here.
+ *
+ * @param string The string to look up.
+ * @param symbol The symbol to set if @p string has been interned.
+ *
+ * @return @c true if @p string has been interned, @c false otherwise.
+ */
+bool findSymbol(const std::string &string, Symbol &symbol);
+
+/**
+ * @brief Get the string interned as @p symbol.
+ *
+ * Thread safe, and lock free.
+ *
+ * @param symbol The symbol of the string, which must be held.
+ *
+ * @return The string, which stays valid while @p symbol is held.
+ */
+const std::string &symbolString(Symbol symbol);
+
+/**
+ * @brief The NameSymbolAccess class.
+ *
+ * An internal class giving the library access to the interned names of
+ * entities, which are not part of the public interface.
+ */
+class NameSymbolAccess
+{
+public:
+    /**
+     * @brief Get the symbol of the name of @p entity.
+     *
+     * @param entity The entity to get the name of.
+     *
+     * @return The symbol of the name of @p entity, held by @p entity.
+     */
+    static Symbol nameSymbol(const NamedEntity &entity);
+};
+
+/**
+ * @brief Get the symbol of the name of @p entity.
+ *
+ * @param entity The entity to get the name of.
+ *
+ * @return The symbol of the name of @p entity.
+ */
+inline Symbol nameSymbol(const NamedEntity &entity)
+{
+    return NameSymbolAccess::nameSymbol(entity);
+}
+
+} // namespace libcellml
@@ -14,14 +14,23 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include "arena.h"
+#include "symbols.h"
+#include "unitsdefinition.h"
 #include "utilities.h"
 
+#include "libcellml/error.h"
 #include "libcellml/importsource.h"
+#include "libcellml/logger.h"
+#include "libcellml/model.h"
 #include "libcellml/units.h"
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <map>
+#include <mutex>
+#include <stdexcept>
 #include <vector>
 
 namespace libcellml {
@@ -102,13 +111,39 @@ static const std::map<Units::StandardUnit, const std::string> standardUnitToStri
  */
 struct Unit
 {
-    std::string mReference; /**< Reference to the units for the unit.*/
+    InternedString mReference; /**< Reference to the units for the unit, interned.*/
     std::string mPrefix; /**< String expression of the prefix for the unit.*/
-    std::string mExponent; /**< Exponent for the unit.*/
-    std::string mMultiplier; /**< Multiplier for the unit.*/
+    bool mPrefixValid = true; /**< Whether the prefix is a prefix name or an integer.*/
+    int mPrefixExponent = 0; /**< The power of ten of the prefix, if it is valid.*/
+    double mExponent = 1.0; /**< Exponent for the unit.*/
+    double mMultiplier = 1.0; /**< Multiplier for the unit.*/
     std::string mId; /**< Id for the unit.*/
 };
 
+/**
+ * @brief Get the power of ten of the prefix @p prefix.
+ *
+ * @return @c true if @p prefix is a prefix name or an integer, @c false
+ * otherwise.
+ */
+static bool prefixExponent(const std::string &prefix, int &exponent)
+{
+    auto found = standardPrefixList.find(prefix);
+    if (found != standardPrefixList.end()) {
+        exponent = found->second;
+        return true;
+    }
+    if (isCellMLInteger(prefix)) {
+        try {
+            exponent = convertToInt(prefix);
+            return true;
+        } catch (std::out_of_range &) {
+            return false;
+        }
+    }
+    return false;
+}
+
 /**
  * @brief The Units::UnitsImpl struct.
  *
@@ -118,28 +153,42 @@ struct Units::UnitsImpl
 {
     std::vector<Unit>::iterator findUnit(const std::string &reference);
     std::vector<Unit> mUnits; /**< A vector of unit defined for this Units.*/
+
+    bool reduce(const Units &units, UnitsDefinition &definition, EntityDependencies &dependencies, std::vector<const Units *> &reducing);
+    static bool reduce(const Model *model, const std::string &name, UnitsDefinition &definition, EntityDependencies &dependencies, std::vector<const Units *> &reducing);
+
+    std::mutex mDefinitionMutex; /**< The mutex guarding the cached reduction below. */
+    size_t mDefinitionRevision = 0; /**< The latest revision of this Units, its model and mDefinitionDependencies when reduced, zero if never. */
+    const Model *mDefinitionModel = nullptr; /**< The model this Units belonged to when reduced. */
+    EntityDependencies mDefinitionDependencies; /**< The import sources and imported models the reduction went through. */
+    bool mReducible = false; /**< Whether this Units could be reduced to base units. */
+    UnitsDefinition mDefinition; /**< The reduction of this Units to base units. */
 };
 
 std::vector<Unit>::iterator Units::UnitsImpl::findUnit(const std::string &reference)
 {
+    Symbol symbol;
+    if (!findSymbol(reference, symbol)) {
+        return mUnits.end();
+    }
     return std::find_if(mUnits.begin(), mUnits.end(),
-                        [=](const Unit &u) -> bool { return u.mReference == reference; });
+                        [=](const Unit &u) -> bool { return u.mReference.symbol() == symbol; });
 }
 
 Units::Units()
-    : mPimpl(new UnitsImpl())
+    : mPimpl(newImpl<UnitsImpl>())
 {
 }
 
 Units::~Units()
 {
-    delete mPimpl;
+    deleteImpl(mPimpl);
 }
 
 Units::Units(const Units &rhs)
     : NamedEntity(rhs)
     , ImportedEntity(rhs)
-    , mPimpl(new UnitsImpl())
+    , mPimpl(newImpl<UnitsImpl>())
 {
     mPimpl->mUnits = rhs.mPimpl->mUnits;
 }
@@ -174,7 +223,7 @@ void Units::addUnit(const std::string &reference, const std::string &prefix, dou
                     double multiplier, const std::string &id)
 {
     Unit u;
-    u.mReference = reference;
+    u.mReference = InternedString(reference);
     // Allow all nonzero user-specified prefixes
     try {
         int prefixInteger = std::stoi(prefix);
@@ -186,16 +235,14 @@ void Units::addUnit(const std::string &reference, const std::string &prefix, dou
     } catch (std::out_of_range &) {
         u.mPrefix = prefix;
     }
-    if (exponent != 1.0) {
-        u.mExponent = convertDoubleToString(exponent);
-    }
-    if (multiplier != 1.0) {
-        u.mMultiplier = convertDoubleToString(multiplier);
-    }
+    u.mPrefixValid = u.mPrefix.empty() || prefixExponent(u.mPrefix, u.mPrefixExponent);
+    u.mExponent = exponent;
+    u.mMultiplier = multiplier;
     if (!id.empty()) {
         u.mId = id;
     }
     mPimpl->mUnits.push_back(u);
+    markModified();
 }
 
 void Units::addUnit(const std::string &reference, Prefix prefix, double exponent,
@@ -279,27 +326,30 @@ void Units::unitAttributes(size_t index, std::string &reference, std::string &pr
     if (index < mPimpl->mUnits.size()) {
         u = mPimpl->mUnits.at(index);
     }
-    reference = u.mReference;
+    reference = u.mReference.string();
     prefix = u.mPrefix;
-    if (!u.mExponent.empty()) {
-        exponent = std::stod(u.mExponent);
-    } else {
-        exponent = 1.0;
-    }
-    if (!u.mMultiplier.empty()) {
-        multiplier = std::stod(u.mMultiplier);
-    } else {
-        multiplier = 1.0;
-    }
+    exponent = u.mExponent;
+    multiplier = u.mMultiplier;
     id = u.mId;
 }
 
+double Units::unitExponent(size_t index) const
+{
+    return (index < mPimpl->mUnits.size()) ? mPimpl->mUnits.at(index).mExponent : 1.0;
+}
+
+double Units::unitMultiplier(size_t index) const
+{
+    return (index < mPimpl->mUnits.size()) ? mPimpl->mUnits.at(index).mMultiplier : 1.0;
+}
+
 bool Units::removeUnit(const std::string &reference)
 {
     bool status = false;
     auto result = mPimpl->findUnit(reference);
     if (result != mPimpl->mUnits.end()) {
         mPimpl->mUnits.erase(result);
+        markModified();
         status = true;
     }
 
@@ -311,6 +361,7 @@ bool Units::removeUnit(size_t index)
     bool status = false;
     if (index < mPimpl->mUnits.size()) {
         mPimpl->mUnits.erase(mPimpl->mUnits.begin() + int64_t(index));
+        markModified();
         status = true;
     }
 
@@ -326,6 +377,7 @@ bool Units::removeUnit(StandardUnit standardRef)
 void Units::removeAllUnits()
 {
     mPimpl->mUnits.clear();
+    markModified();
 }
 
 void Units::setSourceUnits(const ImportSourcePtr &importSource, const std::string &name)
@@ -339,4 +391,282 @@ size_t Units::unitCount() const
     return mPimpl->mUnits.size();
 }
 
+bool Units::compatible(const UnitsPtr &units1, const UnitsPtr &units2)
+{
+    UnitsDefinition definition1;
+    UnitsDefinition definition2;
+    return (units1 != nullptr) && (units2 != nullptr)
+           && reduceUnits(*units1, definition1) && reduceUnits(*units2, definition2)
+           && definition1.hasSameDimension(definition2);
+}
+
+bool Units::equivalent(const UnitsPtr &units1, const UnitsPtr &units2)
+{
+    UnitsDefinition definition1;
+    UnitsDefinition definition2;
+    return (units1 != nullptr) && (units2 != nullptr)
+           && reduceUnits(*units1, definition1) && reduceUnits(*units2, definition2)
+           && definition1.hasSameDimension(definition2)
+           && (std::fabs(definition1.mFactor - definition2.mFactor) <= UNITS_TOLERANCE * std::fabs(definition1.mFactor));
+}
+
+/**
+ * @brief Add an error about a units conversion to @p logger, if any.
+ *
+ * @param logger The logger to add the error to, or @c nullptr.
+ * @param description The description of the error.
+ */
+static void addConversionError(Logger *logger, const std::string &description)
+{
+    if (logger != nullptr) {
+        ErrorPtr err = std::make_shared<Error>();
+        err->setDescription(description);
+        err->setKind(Error::Kind::UNITS);
+        logger->addError(err);
+    }
+}
+
+/**
+ * @brief Get the factor converting values from @p from to @p to.
+ *
+ * @param from The reduction of the units to convert from.
+ * @param to The reduction of the units to convert to.
+ * @param fromName The name of the units to convert from.
+ * @param toName The name of the units to convert to.
+ * @param factor The @c double to set to the conversion factor.
+ * @param logger The logger to add an error to if the definitions have
+ * different dimensions, or @c nullptr.
+ *
+ * @return @c true if @p factor was set, @c false otherwise.
+ */
+static bool conversionFactor(const UnitsDefinition &from, const UnitsDefinition &to,
+                             const std::string &fromName, const std::string &toName,
+                             double &factor, Logger *logger)
+{
+    if (!from.hasSameDimension(to)) {
+        addConversionError(logger, "Units '" + fromName + "' and '" + toName + "' have different dimensions and cannot be converted to each other.");
+        return false;
+    }
+    factor = from.mFactor / to.mFactor;
+    return true;
+}
+
+bool Units::conversionFactor(const UnitsPtr &from, const UnitsPtr &to, double &factor, Logger *logger)
+{
+    if ((from == nullptr) || (to == nullptr)) {
+        addConversionError(logger, "The units to convert from and to must both be given.");
+        return false;
+    }
+    UnitsDefinition fromDefinition;
+    if (!reduceUnits(*from, fromDefinition)) {
+        addConversionError(logger, "Units '" + from->name() + "' cannot be reduced to base units.");
+        return false;
+    }
+    UnitsDefinition toDefinition;
+    if (!reduceUnits(*to, toDefinition)) {
+        addConversionError(logger, "Units '" + to->name() + "' cannot be reduced to base units.");
+        return false;
+    }
+    return libcellml::conversionFactor(fromDefinition, toDefinition, from->name(), to->name(), factor, logger);
+}
+
+bool Units::conversionFactor(const ModelPtr &model, const std::string &from, const std::string &to, double &factor, Logger *logger)
+{
+    UnitsDefinition fromDefinition;
+    if (!reduceUnits(model.get(), from, fromDefinition)) {
+        addConversionError(logger, "Units '" + from + "' cannot be found or reduced to base units.");
+        return false;
+    }
+    UnitsDefinition toDefinition;
+    if (!reduceUnits(model.get(), to, toDefinition)) {
+        addConversionError(logger, "Units '" + to + "' cannot be found or reduced to base units.");
+        return false;
+    }
+    return libcellml::conversionFactor(fromDefinition, toDefinition, from, to, factor, logger);
+}
+
+void UnitsDefinition::multiply(const UnitsDefinition &definition, double exponent)
+{
+    mFactor *= std::pow(definition.mFactor, exponent);
+    for (size_t i = 0; i < SI_BASE_UNIT_COUNT; ++i) {
+        mExponents.at(i) += exponent * definition.mExponents.at(i);
+    }
+    for (const auto &other : definition.mOtherExponents) {
+        auto found = std::lower_bound(mOtherExponents.begin(), mOtherExponents.end(), other,
+                                      [](const std::pair<std::string, double> &a, const std::pair<std::string, double> &b) { return a.first < b.first; });
+        if ((found != mOtherExponents.end()) && (found->first == other.first)) {
+            found->second += exponent * other.second;
+        } else {
+            mOtherExponents.insert(found, std::make_pair(other.first, exponent * other.second));
+        }
+    }
+}
+
+bool UnitsDefinition::hasSameDimension(const UnitsDefinition &definition) const
+{
+    for (size_t i = 0; i < SI_BASE_UNIT_COUNT; ++i) {
+        if (std::fabs(mExponents.at(i) - definition.mExponents.at(i)) > UNITS_TOLERANCE) {
+            return false;
+        }
+    }
+    // Other base units whose exponents cancelled out may still be listed.
+    auto differs = [](const std::vector<std::pair<std::string, double>> &a, const std::vector<std::pair<std::string, double>> &b) {
+        for (const auto &entry : a) {
+            auto found = std::lower_bound(b.begin(), b.end(), entry,
+                                          [](const std::pair<std::string, double> &x, const std::pair<std::string, double> &y) { return x.first < y.first; });
+            double exponent = ((found != b.end()) && (found->first == entry.first)) ? found->second : 0.0;
+            if (std::fabs(entry.second - exponent) > UNITS_TOLERANCE) {
+                return true;
+            }
+        }
+        return false;
+    };
+    return !differs(mOtherExponents, definition.mOtherExponents) && !differs(definition.mOtherExponents, mOtherExponents);
+}
+
+std::string UnitsDefinition::dimension() const
+{
+    static const std::array<std::string, SI_BASE_UNIT_COUNT> siBaseUnits = {{"ampere", "candela", "kelvin", "kilogram", "metre", "mole", "second"}};
+    std::string result;
+    auto append = [&result](const std::string &name, double exponent) {
+        if (std::fabs(exponent) <= UNITS_TOLERANCE) {
+            return;
+        }
+        if (!result.empty()) {
+            result += ".";
+        }
+        result += name;
+        if (std::fabs(exponent - 1.0) > UNITS_TOLERANCE) {
+            result += "^" + convertDoubleToString(exponent);
+        }
+    };
+    for (size_t i = 0; i < SI_BASE_UNIT_COUNT; ++i) {
+        append(siBaseUnits.at(i), mExponents.at(i));
+    }
+    for (const auto &other : mOtherExponents) {
+        append(other.first, other.second);
+    }
+    return result.empty() ? "dimensionless" : result;
+}
+
+/**
+ * @brief Get the reduction of the standard units called @p name.
+ *
+ * @return @c true if @p name is a standard units, @c false otherwise.
+ */
+static bool reduceStandardUnits(const std::string &name, UnitsDefinition &definition)
+{
+    static const std::map<std::string, UnitsDefinition> standardDefinitions = []() {
+        const std::vector<std::string> siBaseUnits = {"ampere", "candela", "kelvin", "kilogram", "metre", "mole", "second"};
+        std::map<std::string, UnitsDefinition> definitions;
+        for (const auto &standardUnits : standardUnitsList) {
+            UnitsDefinition standardDefinition;
+            standardDefinition.mFactor = std::pow(10.0, standardMultiplierList.at(standardUnits.first));
+            for (const auto &baseUnits : standardUnits.second) {
+                auto position = std::find(siBaseUnits.begin(), siBaseUnits.end(), baseUnits.first);
+                if (position != siBaseUnits.end()) {
+                    standardDefinition.mExponents.at(size_t(position - siBaseUnits.begin())) = baseUnits.second;
+                }
+            }
+            definitions.emplace(standardUnits.first, standardDefinition);
+        }
+        return definitions;
+    }();
+    auto found = standardDefinitions.find(name);
+    if (found == standardDefinitions.end()) {
+        return false;
+    }
+    definition = found->second;
+    return true;
+}
+
+bool Units::UnitsImpl::reduce(const Model *model, const std::string &name, UnitsDefinition &definition,
+                              EntityDependencies &dependencies, std::vector<const Units *> &reducing)
+{
+    UnitsPtr units = (model != nullptr) ? model->units(name) : nullptr;
+    if (units != nullptr) {
+        return units->mPimpl->reduce(*units, definition, dependencies, reducing);
+    }
+    return reduceStandardUnits(name, definition);
+}
+
+bool Units::UnitsImpl::reduce(const Units &units, UnitsDefinition &definition, EntityDependencies &dependencies, std::vector<const Units *> &reducing)
+{
+    // The reduction depends on this units, on the model it belongs to, which
+    // holds the units it refers to, and on the import sources and imported
+    // models it goes through.
+    auto model = static_cast<const Model *>(units.parent());
+    size_t revision = std::max(units.revision(), (model != nullptr) ? model->revision() : 0);
+    {
+        std::lock_guard<std::mutex> lock(mDefinitionMutex);
+        if ((mDefinitionRevision != 0) && (mDefinitionModel == model)
+            && (dependenciesRevision(mDefinitionDependencies, revision) == mDefinitionRevision)) {
+            definition = mDefinition;
+            dependencies.add(mDefinitionDependencies);
+            return mReducible;
+        }
+    }
+    if (std::find(reducing.begin(), reducing.end(), &units) != reducing.end()) {
+        // Units defined in terms of themselves are not reducible.
+        return false;
+    }
+    reducing.push_back(&units);
+
+    UnitsDefinition result;
+    EntityDependencies resultDependencies;
+    bool reducible = true;
+    if (units.isImport()) {
+        ImportSourcePtr importSource = units.importSource();
+        resultDependencies.add(importSource);
+        ModelPtr importedModel = importSource->model();
+        if (importedModel != nullptr) {
+            resultDependencies.add(importedModel);
+        }
+        UnitsPtr imported = (importedModel != nullptr) ? importedModel->units(units.importReference()) : nullptr;
+        reducible = (imported != nullptr) && imported->mPimpl->reduce(*imported, result, resultDependencies, reducing);
+    } else if (units.isBaseUnit()) {
+        result.mOtherExponents.emplace_back(units.name(), 1.0);
+    } else {
+        for (const Unit &unit : mUnits) {
+            UnitsDefinition reference;
+            if (!unit.mPrefixValid || !std::isfinite(unit.mExponent) || !std::isfinite(unit.mMultiplier)
+                || !reduce(model, unit.mReference.string(), reference, resultDependencies, reducing)) {
+                reducible = false;
+                break;
+            }
+            reference.mFactor *= unit.mMultiplier * std::pow(10.0, unit.mPrefixExponent);
+            result.multiply(reference, unit.mExponent);
+        }
+    }
+    reducing.pop_back();
+
+    {
+        std::lock_guard<std::mutex> lock(mDefinitionMutex);
+        mDefinitionRevision = std::max(revision, resultDependencies.mRevision);
+        mDefinitionModel = model;
+        mDefinitionDependencies = resultDependencies;
+        mReducible = reducible;
+        mDefinition = result;
+    }
+    dependencies.add(resultDependencies);
+    definition = result;
+    return reducible;
+}
+
+bool reduceUnits(const Model *model, const std::string &name, UnitsDefinition &definition)
+{
+    UnitsPtr units = (model != nullptr) ? model->units(name) : nullptr;
+    if (units != nullptr) {
+        return reduceUnits(*units, definition);
+    }
+    return reduceStandardUnits(name, definition);
+}
+
+bool reduceUnits(const Units &units, UnitsDefinition &definition)
+{
+    EntityDependencies dependencies;
+    std::vector<const Units *> reducing;
+    return units.mPimpl->reduce(units, definition, dependencies, reducing);
+}
+
 } // namespace libcellml
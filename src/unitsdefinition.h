@@ -0,0 +1,119 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include "libcellml/types.h"
+
+#include <array>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace libcellml {
+
+/**
+ * The number of SI base units, which are, in order, the ampere, candela,
+ * kelvin, kilogram, metre, mole and second.
+ */
+static const size_t SI_BASE_UNIT_COUNT = 7;
+
+/**
+ * The tolerance used when comparing the exponents and scaling factors of
+ * units, which may not add up exactly.
+ */
+static const double UNITS_TOLERANCE = 1.0e-12;
+
+/**
+ * @brief The UnitsDefinition struct.
+ *
+ * An internal structure holding a units reduced to a scaling factor times a
+ * product of powers of base units.  Base units are the SI base units and
+ * any base units defined by a model, which are identified by name.
+ */
+struct UnitsDefinition
+{
+    double mFactor = 1.0; /**< The number of base units in one of the units. */
+    std::array<double, SI_BASE_UNIT_COUNT> mExponents {}; /**< The exponents of the SI base units. */
+    std::vector<std::pair<std::string, double>> mOtherExponents; /**< The exponents of other base units, sorted by name. */
+
+    /**
+     * @brief Multiply this definition by @p definition raised to the power
+     * @p exponent.
+     *
+     * @param definition The definition to multiply by.
+     * @param exponent The power to raise @p definition to.
+     */
+    void multiply(const UnitsDefinition &definition, double exponent);
+
+    /**
+     * @brief Test if this definition has the same dimension as
+     * @p definition.
+     *
+     * The exponents are compared with a small tolerance, to allow for
+     * fractional exponents that do not add up exactly.
+     *
+     * @param definition The definition to compare with.
+     *
+     * @return @c true if both definitions use the same powers of the same
+     * base units, @c false otherwise.
+     */
+    bool hasSameDimension(const UnitsDefinition &definition) const;
+
+    /**
+     * @brief Get the dimension of this definition as a product of powers of
+     * base units.
+     *
+     * @return The dimension, e.g. @c "kilogram.metre^2.second^-2", or
+     * @c "dimensionless" if all the exponents are zero.
+     */
+    std::string dimension() const;
+};
+
+/**
+ * @brief Reduce @p units to base units.
+ *
+ * The units @p units is defined from are looked up in its parent model, or
+ * in the model of its import source if @p units is imported, and in the
+ * standard units.  The reduction is cached in @p units until @p units, its
+ * model, or any import source or imported model it was reduced through is
+ * modified.  Any number of threads may reduce the same units at the same
+ * time.
+ *
+ * @param units The units to reduce.
+ * @param definition The definition to set.
+ *
+ * @return @c true if @p units could be reduced, @c false if it refers to
+ * units that cannot be found, including through an unresolved import, or
+ * that are defined in terms of themselves.
+ */
+bool reduceUnits(const Units &units, UnitsDefinition &definition);
+
+/**
+ * @brief Reduce the units called @p name in @p model to base units.
+ *
+ * @overload
+ *
+ * @param model The model to look @p name up in, which may be @c nullptr to
+ * only look up standard units.
+ * @param name The name of the units to reduce.
+ * @param definition The definition to set.
+ *
+ * @return @c true if the units could be reduced, @c false otherwise.
+ */
+bool reduceUnits(const Model *model, const std::string &name, UnitsDefinition &definition);
+
+} // namespace libcellml
@@ -16,6 +16,8 @@ limitations under the License.
 
 #include "utilities.h"
 
+#include "libcellml/entity.h"
+
 #include <algorithm>
 #include <iomanip>
 #include <iostream>
@@ -148,4 +150,28 @@ bool isCellMLReal(const std::string &candidate)
     return isReal;
 }
 
+void EntityDependencies::add(const EntityPtr &entity)
+{
+    mEntities.push_back(entity);
+    mRevision = std::max(mRevision, entity->revision());
+}
+
+void EntityDependencies::add(const EntityDependencies &dependencies)
+{
+    mEntities.insert(mEntities.end(), dependencies.mEntities.begin(), dependencies.mEntities.end());
+    mRevision = std::max(mRevision, dependencies.mRevision);
+}
+
+size_t dependenciesRevision(const EntityDependencies &dependencies, size_t revision)
+{
+    for (const auto &weakEntity : dependencies.mEntities) {
+        EntityPtr entity = weakEntity.lock();
+        if (entity == nullptr) {
+            return 0;
+        }
+        revision = std::max(revision, entity->revision());
+    }
+    return revision;
+}
+
 } // namespace libcellml
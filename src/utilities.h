@@ -17,8 +17,10 @@ limitations under the License.
 #pragma once
 
 #include "libcellml/exportdefinitions.h"
+#include "libcellml/types.h"
 
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -306,4 +308,61 @@ bool isCellMLInteger(const std::string &candidate);
  */
 bool isCellMLReal(const std::string &candidate);
 
+/**
+ * @brief Connect @p clones the way @p variables are connected.
+ *
+ * Each variable of @p clones is a copy of the variable with the same index in
+ * @p variables.  Its equivalences, together with their mapping and connection
+ * ids, are replaced with those of the original variable, remapped to the
+ * corresponding clones and kept in the same order.  Equivalences to variables
+ * that are not in @p variables are dropped.
+ *
+ * @param variables The original variables.
+ * @param clones The copies of the original variables.
+ */
+void cloneEquivalences(const std::vector<VariablePtr> &variables, const std::vector<VariablePtr> &clones);
+
+/**
+ * @brief The EntityDependencies struct.
+ *
+ * The entities that something computed from a model depends on, besides the
+ * model itself, i.e. those whose modifications do not change the revision of
+ * the model: import sources, imported models, resets and whens.
+ */
+struct EntityDependencies
+{
+    std::vector<std::weak_ptr<Entity>> mEntities; /**< The entities depended on. */
+    size_t mRevision = 0; /**< The latest revision of the entities, and of the model. */
+
+    /**
+     * @brief Add @p entity to the dependencies.
+     *
+     * @param entity The entity to add.
+     */
+    void add(const EntityPtr &entity);
+
+    /**
+     * @brief Add the entities of @p dependencies to the dependencies.
+     *
+     * @overload
+     *
+     * @param dependencies The dependencies to add.
+     */
+    void add(const EntityDependencies &dependencies);
+};
+
+/**
+ * @brief Get the latest revision of the entities in @p dependencies.
+ *
+ * Since revisions only ever increase, the latest revision changes whenever
+ * any of the entities is modified.
+ *
+ * @param dependencies The dependencies to check.
+ * @param revision The revision of the model.
+ *
+ * @return The latest revision, or @c 0 if any of the entities no longer
+ * exists.
+ */
+size_t dependenciesRevision(const EntityDependencies &dependencies, size_t revision);
+
 } // namespace libcellml
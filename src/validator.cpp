@@ -14,7 +14,10 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include "mathast.h"
 #include "namespaces.h"
+#include "symbols.h"
+#include "unitsdefinition.h"
 #include "utilities.h"
 #include "xmldoc.h"
 
@@ -28,16 +31,170 @@ limitations under the License.
 #include "libcellml/variable.h"
 #include "libcellml/when.h"
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <map>
 #include <regex>
 #include <sstream>
 #include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include <libxml/parser.h>
 #include <libxml/uri.h>
 
 namespace libcellml {
 
+/**
+ * @brief The ExpressionDimension struct.
+ *
+ * An internal structure holding the dimension worked out for an expression
+ * when checking the math of a model for dimensional consistency.  The
+ * dimension is unknown if the expression uses numbers without units, or units
+ * that cannot be reduced, in which case it matches any other dimension.
+ */
+struct ExpressionDimension
+{
+    bool mKnown = false; /**< Whether the dimension is known. */
+    UnitsDefinition mDefinition; /**< The dimension, if it is known. */
+};
+
+/**
+ * @brief Create a known dimensionless @c ExpressionDimension.
+ *
+ * @return The dimensionless dimension.
+ */
+static ExpressionDimension dimensionless()
+{
+    ExpressionDimension dimension;
+    dimension.mKnown = true;
+    return dimension;
+}
+
+/**
+ * @brief Test if @p dimension is known to be other than dimensionless.
+ *
+ * @param dimension The dimension to test.
+ *
+ * @return @c true if @p dimension is known and not dimensionless, @c false
+ * otherwise.
+ */
+static bool isDimensional(const ExpressionDimension &dimension)
+{
+    return dimension.mKnown && !dimension.mDefinition.hasSameDimension(UnitsDefinition());
+}
+
+/**
+ * @brief Get the value of @p ast if it is a constant.
+ *
+ * A constant is a number, or the negation, product or quotient of constants,
+ * such as the exponent 1/3.
+ *
+ * @param ast The expression to evaluate.
+ * @param value The value to set.
+ *
+ * @return @c true if @p ast is a constant, @c false otherwise.
+ */
+static bool constantValue(const MathAstPtr &ast, double &value)
+{
+    if (ast->mType == MathAst::Type::CN) {
+        value = ast->mValue;
+        return true;
+    }
+    double first;
+    double second;
+    if ((ast->mType == MathAst::Type::MINUS) && (ast->mChildren.size() == 1) && constantValue(ast->mChildren.at(0), first)) {
+        value = -first;
+        return true;
+    }
+    if (((ast->mType == MathAst::Type::TIMES) || (ast->mType == MathAst::Type::DIVIDE))
+        && (ast->mChildren.size() == 2)
+        && constantValue(ast->mChildren.at(0), first)
+        && constantValue(ast->mChildren.at(1), second)) {
+        value = (ast->mType == MathAst::Type::TIMES) ? first * second : first / second;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * The errors of the component being validated by this thread, when
+ * components are validated in parallel, or @c nullptr otherwise.
+ */
+static thread_local std::vector<ErrorPtr> *componentErrors = nullptr;
+
+/**
+ * @brief The CachedComponentErrors struct.
+ *
+ * An internal structure holding the errors found in a component, and the
+ * revision of the component they were found at.
+ */
+struct CachedComponentErrors
+{
+    size_t mRevision = 0; /**< The revision of the component, see componentRevision. */
+    std::vector<ErrorPtr> mErrors; /**< The errors found in the component. */
+};
+
+/**
+ * @brief Get the revision of @p component as far as its validation goes.
+ *
+ * Resets and whens are not parented to the component they belong to, nor is
+ * the variable a reset references, so their revisions are combined with that
+ * of @p component.  Since revisions only ever increase, the result changes
+ * whenever any of them changes.
+ *
+ * @param component The component to get the revision of.
+ *
+ * @return The latest revision of @p component and of its resets.
+ */
+static size_t componentRevision(const ComponentPtr &component)
+{
+    size_t revision = component->revision();
+    for (size_t i = 0; i < component->resetCount(); ++i) {
+        ResetPtr reset = component->reset(i);
+        revision = std::max(revision, reset->revision());
+        if (reset->variable() != nullptr) {
+            revision = std::max(revision, reset->variable()->revision());
+        }
+        for (size_t j = 0; j < reset->whenCount(); ++j) {
+            revision = std::max(revision, reset->when(j)->revision());
+        }
+    }
+    return revision;
+}
+
+/**
+ * @brief The MathWalkItem struct.
+ *
+ * An internal structure holding a node still to be visited when walking a
+ * math tree, and what its ancestors are.
+ */
+struct MathWalkItem
+{
+    XmlNodePtr mNode; /**< The node to visit. */
+    bool mInBvar; /**< Whether the node is within a @c bvar element. */
+    bool mInCiCn; /**< Whether the node is within a @c ci or @c cn element. */
+};
+
+/**
+ * @brief The VariablePairHash struct.
+ *
+ * An internal hash function for pairs of variables, used to look up
+ * equivalences in constant time.
+ */
+struct VariablePairHash
+{
+    size_t operator()(const std::pair<const Variable *, const Variable *> &pair) const
+    {
+        size_t first = std::hash<const Variable *>()(pair.first);
+        return first ^ (std::hash<const Variable *>()(pair.second) + 0x9e3779b9 + (first << 6) + (first >> 2));
+    }
+};
+
 /**
  * @brief The Validator::ValidatorImpl struct.
  *
@@ -46,6 +203,42 @@ namespace libcellml {
 struct Validator::ValidatorImpl
 {
     Validator *mValidator;
+    size_t mThreadCount = 1;
+    bool mCheckDimensions = false;
+    bool mIncremental = false;
+    std::map<std::string, ExpressionDimension> mUnitsDimensions;
+    const Model *mCachedModel = nullptr; /**< The model the cached component errors were found in. */
+    std::vector<std::string> mCachedUnitsNames; /**< The names of the units of @c mCachedModel at the time. */
+    std::map<const Component *, CachedComponentErrors> mComponentErrors; /**< The errors found in each component of @c mCachedModel. */
+
+    /**
+     * @brief Log the error @p err.
+     *
+     * The error is added to the @c Validator, or held back in the errors of
+     * the current component if components are being validated in parallel.
+     *
+     * @param err The error to log.
+     */
+    void addError(const ErrorPtr &err);
+
+    /**
+     * @brief Validate the components of @p model.
+     *
+     * Validate the top-level components of the given @p model on up to
+     * @c mThreadCount threads.  The errors found in each component are
+     * collected in @p errors, in the order they would be found by validating
+     * the component on its own, for the caller to log in component order.
+     *
+     * When validating incrementally, a component that has not changed since
+     * the previous validation of the same model is not validated again, and
+     * its previous errors are reused instead.  All components are validated
+     * again if the units of the model have been renamed, added or removed,
+     * since variables and math refer to units by name.
+     *
+     * @param model The model whose components to validate.
+     * @param errors The errors to set, one list per component.
+     */
+    void validateComponents(const ModelPtr &model, std::vector<std::vector<ErrorPtr>> &errors);
 
     /**
      * @brief Validate the @p component using the CellML 2.0 Specification.
@@ -73,6 +266,10 @@ struct Validator::ValidatorImpl
      *
      * Validate the variable connections in the given @p model using
      * the CellML 2.0 Specification. Any errors will be logged in the @c Validator.
+     * Each equivalence is checked once, for reciprocity, for duplicating a
+     * connection that already exists through other variables, and for the
+     * interfaces of its variables, so that the time taken is linear in the
+     * number of variables and equivalences.
      *
      * @param model The model which may contain variable connections to validate.
      */
@@ -150,40 +347,34 @@ struct Validator::ValidatorImpl
     void validateMath(const std::string &input, const ComponentPtr &component);
 
     /**
-     * @brief Populate @p bvarNames with new variables declared in MathML @c bvar elements.
-     *
-     * Populate @p bvarNames with new variables declared in MathML @c bvar elements found within
-     * the XmlNode @p node.
-     *
-     * @param node The @c XmlNode to search for @c bvar element names.
-     * @param bvarNames The @c std::string @c vector to populate with MathML @c bvar element names.
-     */
-    void gatherMathBvarVariableNames(XmlNodePtr &node, std::vector<std::string> &bvarNames);
-
-    /**
-     * @brief Traverse the node tree for invalid MathML elements.
+     * @brief Walk the math tree under @p node in one pass.
      *
-     * Traverse the Xml node tree checking that all MathML elements are listed in the
-     * supported MathML elements table from the CellML specification 2.0 document.
+     * Walk the Xml node tree, without recursion, checking that all MathML elements are
+     * listed in the supported MathML elements table from the CellML specification 2.0
+     * document, populating @p bvarNames with new variables declared in MathML @c bvar
+     * elements and collecting the outermost MathML @c ci and @c cn elements in
+     * @p ciCnNodes, in document order.
      *
-     * @param node The node to check children and sibling nodes.
+     * @param node The @c math element to walk the descendants of.
      * @param component The component the MathML belongs to.
+     * @param bvarNames The @c std::string @c vector to populate with MathML @c bvar element names.
+     * @param ciCnNodes The @c vector to populate with MathML @c ci and @c cn elements.
      */
-    void validateMathMLElements(const XmlNodePtr &node, const ComponentPtr &component);
+    void walkMath(const XmlNodePtr &node, const ComponentPtr &component, std::vector<std::string> &bvarNames, std::vector<XmlNodePtr> &ciCnNodes);
 
     /**
-     * @brief Validate CellML variables and units in MathML @c ci and @c cn variables. Removes CellML units from the @p node.
+     * @brief Validate CellML variables and units in a MathML @c ci or @c cn element. Removes CellML units from the @p node.
      *
      * Validates CellML variables found in MathML @c ci elements and new variables from @c bvar elements. Validates @c cellml:units
      * attributes found on @c ci and @c cn elements and removes them from the @c XmlNode @p node to leave MathML that may then
      * be validated using the MathML DTD.
      *
-     * @param node The @c XmlNode to validate CellML entities on and remove @c cellml:units from.
+     * @param node The @c ci or @c cn element to validate CellML entities on and remove @c cellml:units from.
      * @param component The component that the math @c XmlNode @p node is contained within.
      * @param variableNames A @c vector list of the names of variables found within the @p component.
-     * @param bvarNames A @c vector list of the names of new MathML @c bvar variables in this @c XmlNode @p node.
+     * @param bvarNames A @c vector list of the names of new MathML @c bvar variables in the math.
      */
-    void validateAndCleanMathCiCnNodes(XmlNodePtr &node, const ComponentPtr &component, const std::vector<std::string> &variableNames, const std::vector<std::string> &bvarNames);
+    void validateAndCleanMathCiCnNode(const XmlNodePtr &node, const ComponentPtr &component, const std::vector<std::string> &variableNames, const std::vector<std::string> &bvarNames);
 
     /**
      * @brief Remove the @c std::string @p pattern from the @c std::string @p input.
@@ -231,6 +422,77 @@ struct Validator::ValidatorImpl
      * @return @c true if @node is a supported MathML element and @c false otherwise.
      */
     bool isSupportedMathMLElement(const XmlNodePtr &node);
+
+    /**
+     * @brief Check the math of @p component and its encapsulated components
+     * for dimensional consistency.
+     *
+     * Parse the math of the given @p component and work out the dimension of
+     * each of its expressions.  Any mismatches will be logged in the
+     * @c Validator.  Math that cannot be parsed is skipped, as it is
+     * reported by validateMath().
+     *
+     * @param model The model the @p component belongs to.
+     * @param component The component to check.
+     */
+    void checkComponentDimensions(const ModelPtr &model, const ComponentPtr &component);
+
+    /**
+     * @brief Get the dimension of the units called @p name in @p model.
+     *
+     * Reductions are remembered for the rest of the validation, so that each
+     * units is only reduced once however often it is used.
+     *
+     * @param model The model to look @p name up in.
+     * @param name The name of the units.
+     *
+     * @return The dimension of the units, which is unknown if the units
+     * cannot be reduced.
+     */
+    ExpressionDimension unitsDimension(const ModelPtr &model, const std::string &name);
+
+    /**
+     * @brief Work out the dimension of @p ast.
+     *
+     * Propagate the dimensions of the variables and numbers in @p ast up
+     * through its operators, logging an error for each operator whose
+     * arguments do not have the dimensions it requires.  The dimension of an
+     * operator with mismatched arguments is unknown, so that a mismatch is
+     * only reported once.
+     *
+     * @param ast The expression to work out the dimension of.
+     * @param model The model the math belongs to.
+     * @param component The component the math belongs to.
+     * @param equation The number of the equation @p ast is part of.
+     *
+     * @return The dimension of @p ast.
+     */
+    ExpressionDimension expressionDimension(const MathAstPtr &ast, const ModelPtr &model, const ComponentPtr &component, size_t equation);
+
+    /**
+     * @brief Check that all the @p dimensions match.
+     *
+     * Unknown dimensions match any dimension.  If a known dimension differs
+     * from the first known one, an error is logged for the operator @p type.
+     *
+     * @param dimensions The dimensions of the arguments of the operator.
+     * @param type The type of the operator.
+     * @param component The component the math belongs to.
+     * @param equation The number of the equation the operator is part of.
+     *
+     * @return The common dimension, which is unknown if none of the
+     * @p dimensions is known or if they do not match.
+     */
+    ExpressionDimension commonDimension(const std::vector<ExpressionDimension> &dimensions, MathAst::Type type, const ComponentPtr &component, size_t equation);
+
+    /**
+     * @brief Log a dimensional inconsistency in the math of @p component.
+     *
+     * @param component The component the math belongs to.
+     * @param equation The number of the equation the inconsistency was found in.
+     * @param description The description of the inconsistency.
+     */
+    void addDimensionError(const ComponentPtr &component, size_t equation, const std::string &description);
 };
 
 Validator::Validator()
@@ -249,6 +511,9 @@ Validator::Validator(const Validator &rhs)
     , mPimpl(new ValidatorImpl())
 {
     mPimpl->mValidator = rhs.mPimpl->mValidator;
+    mPimpl->mThreadCount = rhs.mPimpl->mThreadCount;
+    mPimpl->mCheckDimensions = rhs.mPimpl->mCheckDimensions;
+    mPimpl->mIncremental = rhs.mPimpl->mIncremental;
 }
 
 Validator::Validator(Validator &&rhs) noexcept
@@ -282,9 +547,14 @@ void Validator::validateModel(const ModelPtr &model)
         err->setRule(SpecificationRule::MODEL_NAME);
         addError(err);
     }
+    // Validate the components themselves up front, since they may be
+    // validated in parallel or not at all, so that their errors can be logged
+    // in the usual order below.
+    std::vector<std::vector<ErrorPtr>> errorsPerComponent;
+    mPimpl->validateComponents(model, errorsPerComponent);
     // Check for components in this model.
     if (model->componentCount() > 0) {
-        std::vector<std::string> componentNames;
+        std::unordered_set<Symbol> componentSymbols;
         std::vector<std::string> componentRefs;
         std::vector<std::string> componentImportSources;
         for (size_t i = 0; i < model->componentCount(); ++i) {
@@ -327,21 +597,23 @@ void Validator::validateModel(const ModelPtr &model)
                     componentImportSources.push_back(importSource);
                     componentRefs.push_back(componentRef);
                 }
-                if (std::find(componentNames.begin(), componentNames.end(), componentName) != componentNames.end()) {
+                if (!componentSymbols.insert(nameSymbol(*component)).second) {
                     ErrorPtr err = std::make_shared<Error>();
                     err->setDescription("Model '" + model->name() + "' contains multiple components with the name '" + componentName + "'. Valid component names must be unique to their model.");
                     err->setModel(model);
                     addError(err);
                 }
-                componentNames.push_back(componentName);
             }
-            // Validate component.
-            mPimpl->validateComponent(component);
+            // Log the errors found in the component.
+            for (const ErrorPtr &err : errorsPerComponent.at(i)) {
+                addError(err);
+            }
         }
     }
     // Check for units in this model.
     if (model->unitsCount() > 0) {
         std::vector<std::string> unitsNames;
+        std::unordered_set<Symbol> unitsSymbols;
         std::vector<std::string> unitsRefs;
         std::vector<std::string> unitsImportSources;
         for (size_t i = 0; i < model->unitsCount(); ++i) {
@@ -388,7 +660,7 @@ void Validator::validateModel(const ModelPtr &model)
                     unitsRefs.push_back(unitsRef);
                 }
                 // Check for duplicate units names in this model.
-                if (std::find(unitsNames.begin(), unitsNames.end(), unitsName) != unitsNames.end()) {
+                if (!unitsSymbols.insert(nameSymbol(*units)).second) {
                     ErrorPtr err = std::make_shared<Error>();
                     err->setDescription("Model '" + model->name() + "' contains multiple units with the name '" + unitsName + "'. Valid units names must be unique to their model.");
                     err->setModel(model);
@@ -406,6 +678,146 @@ void Validator::validateModel(const ModelPtr &model)
     }
     // Validate any connections / variable equivalence networks in the model.
     mPimpl->validateConnections(model);
+    // Check the math for dimensional consistency, if requested.
+    if (mPimpl->mCheckDimensions) {
+        mPimpl->mUnitsDimensions.clear();
+        for (size_t i = 0; i < model->componentCount(); ++i) {
+            mPimpl->checkComponentDimensions(model, model->component(i));
+        }
+        mPimpl->mUnitsDimensions.clear();
+    }
+}
+
+void Validator::setThreadCount(size_t count)
+{
+    mPimpl->mThreadCount = count;
+}
+
+size_t Validator::threadCount() const
+{
+    return mPimpl->mThreadCount;
+}
+
+void Validator::setCheckDimensions(bool check)
+{
+    mPimpl->mCheckDimensions = check;
+}
+
+bool Validator::checkDimensions() const
+{
+    return mPimpl->mCheckDimensions;
+}
+
+void Validator::setIncremental(bool incremental)
+{
+    mPimpl->mIncremental = incremental;
+    mPimpl->mCachedModel = nullptr;
+    mPimpl->mCachedUnitsNames.clear();
+    mPimpl->mComponentErrors.clear();
+}
+
+bool Validator::isIncremental() const
+{
+    return mPimpl->mIncremental;
+}
+
+void Validator::ValidatorImpl::addError(const ErrorPtr &err)
+{
+    if (componentErrors != nullptr) {
+        componentErrors->push_back(err);
+    } else {
+        mValidator->addError(err);
+    }
+}
+
+void Validator::ValidatorImpl::validateComponents(const ModelPtr &model, std::vector<std::vector<ErrorPtr>> &errors)
+{
+    std::vector<ComponentPtr> components;
+    std::vector<size_t> revisions;
+    for (size_t i = 0; i < model->componentCount(); ++i) {
+        components.push_back(model->component(i));
+        revisions.push_back(componentRevision(components.back()));
+    }
+    errors.assign(components.size(), std::vector<ErrorPtr>());
+
+    // Find the components that need validating.
+    if (mIncremental) {
+        std::vector<std::string> unitsNames;
+        for (size_t i = 0; i < model->unitsCount(); ++i) {
+            unitsNames.push_back(model->units(i)->name());
+        }
+        if ((model.get() != mCachedModel) || (unitsNames != mCachedUnitsNames)) {
+            mCachedModel = model.get();
+            mCachedUnitsNames = unitsNames;
+            mComponentErrors.clear();
+        }
+    }
+    std::vector<size_t> pending;
+    for (size_t i = 0; i < components.size(); ++i) {
+        auto cached = mComponentErrors.find(components.at(i).get());
+        if (mIncremental && (cached != mComponentErrors.end()) && (cached->second.mRevision == revisions.at(i))) {
+            errors.at(i) = cached->second.mErrors;
+        } else {
+            pending.push_back(i);
+        }
+    }
+    size_t threadCount = (mThreadCount == 0) ? std::thread::hardware_concurrency() : mThreadCount;
+    threadCount = std::max(size_t(1), std::min(threadCount, pending.size()));
+
+    // libxml2 must be initialised before it is used from several threads.
+    // Its error handlers and parser defaults are per thread, so each thread
+    // collects the errors of the math it parses, but needs the same defaults
+    // as this thread for the errors to read the same.
+    xmlInitParser();
+    int keepBlanks = xmlKeepBlanksDefault(1);
+    xmlKeepBlanksDefault(keepBlanks);
+    // An exception thrown by a thread stops all of them from taking more
+    // components, and is thrown again here once they have all finished.
+    std::atomic<size_t> next(0);
+    std::vector<std::exception_ptr> exceptions(threadCount);
+    auto worker = [&](size_t thread) {
+        try {
+            xmlKeepBlanksDefault(keepBlanks);
+            for (size_t i = next++; i < pending.size(); i = next++) {
+                componentErrors = &errors.at(pending.at(i));
+                validateComponent(components.at(pending.at(i)));
+                componentErrors = nullptr;
+            }
+        } catch (...) {
+            componentErrors = nullptr;
+            exceptions.at(thread) = std::current_exception();
+            next = pending.size();
+        }
+    };
+    std::vector<std::thread> threads;
+    try {
+        for (size_t i = 1; i < threadCount; ++i) {
+            threads.emplace_back(worker, i);
+        }
+    } catch (const std::system_error &) {
+        // The components are shared by fewer threads if no more can be
+        // started.
+    }
+    worker(0);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    for (const std::exception_ptr &exception : exceptions) {
+        if (exception != nullptr) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    // Keep the errors of the components currently in the model for next time.
+    if (mIncremental) {
+        std::map<const Component *, CachedComponentErrors> cache;
+        for (size_t i = 0; i < components.size(); ++i) {
+            CachedComponentErrors &cached = cache[components.at(i).get()];
+            cached.mRevision = revisions.at(i);
+            cached.mErrors = errors.at(i);
+        }
+        mComponentErrors.swap(cache);
+    }
 }
 
 void Validator::ValidatorImpl::validateComponent(const ComponentPtr &component)
@@ -421,22 +833,23 @@ void Validator::ValidatorImpl::validateComponent(const ComponentPtr &component)
             err->setDescription("Component does not have a valid name attribute.");
             err->setRule(SpecificationRule::COMPONENT_NAME);
         }
-        mValidator->addError(err);
+        addError(err);
     }
     // Check for variables in this component.
     std::vector<std::string> variableNames;
+    std::unordered_set<Symbol> variableSymbols;
     if (component->variableCount() > 0) {
         // Check for duplicate variable names and construct vector of valid names in case
         // we have a variable initial_value set by reference.
         for (size_t i = 0; i < component->variableCount(); ++i) {
             std::string variableName = component->variable(i)->name();
             if (!variableName.empty()) {
-                if (std::find(variableNames.begin(), variableNames.end(), variableName) != variableNames.end()) {
+                if (!variableSymbols.insert(nameSymbol(*component->variable(i))).second) {
                     ErrorPtr err = std::make_shared<Error>();
                     err->setDescription("Component '" + component->name() + "' contains multiple variables with the name '" + variableName + "'. Valid variable names must be unique to their component.");
                     err->setComponent(component);
                     err->setRule(SpecificationRule::VARIABLE_NAME);
-                    mValidator->addError(err);
+                    addError(err);
                 }
                 variableNames.push_back(variableName);
             }
@@ -460,7 +873,7 @@ void Validator::ValidatorImpl::validateComponent(const ComponentPtr &component)
                     err->setDescription("Component '" + component->name() + "' contains multiple resets with order '" + convertIntToString(resetOrder) + "'.");
                     err->setComponent(component);
                     err->setRule(SpecificationRule::RESET_ORDER);
-                    mValidator->addError(err);
+                    addError(err);
                 } else {
                     resetOrders.push_back(resetOrder);
                 }
@@ -492,7 +905,7 @@ void Validator::ValidatorImpl::validateUnits(const UnitsPtr &units, const std::v
             err->setDescription("Units does not have a valid name attribute.");
             err->setRule(SpecificationRule::UNITS_NAME);
         }
-        mValidator->addError(err);
+        addError(err);
     } else {
         // Check for a matching standard units.
         if (isStandardUnitName(units->name())) {
@@ -500,7 +913,7 @@ void Validator::ValidatorImpl::validateUnits(const UnitsPtr &units, const std::v
             err->setDescription("Units is named '" + units->name() + "', which is a protected standard unit name.");
             err->setUnits(units);
             err->setRule(SpecificationRule::UNITS_STANDARD);
-            mValidator->addError(err);
+            addError(err);
         }
     }
     if (units->unitCount() > 0) {
@@ -526,14 +939,14 @@ void Validator::ValidatorImpl::validateUnitsUnit(size_t index, const UnitsPtr &u
             err->setDescription("Units reference '" + reference + "' in units '" + units->name() + "' is not a valid reference to a local units or a standard unit type.");
             err->setUnits(units);
             err->setRule(SpecificationRule::UNIT_UNITS_REF);
-            mValidator->addError(err);
+            addError(err);
         }
     } else {
         ErrorPtr err = std::make_shared<Error>();
         err->setDescription("Unit in units '" + units->name() + "' does not have a valid units reference.");
         err->setUnits(units);
         err->setRule(SpecificationRule::UNIT_UNITS_REF);
-        mValidator->addError(err);
+        addError(err);
     }
     if (!prefix.empty()) {
         // If the prefix is not in the list of valid prefix names, check if it is a real number.
@@ -543,7 +956,7 @@ void Validator::ValidatorImpl::validateUnitsUnit(size_t index, const UnitsPtr &u
                 err->setDescription("Prefix '" + prefix + "' of a unit referencing '" + reference + "' in units '" + units->name() + "' is not a valid real number or a SI prefix.");
                 err->setUnits(units);
                 err->setRule(SpecificationRule::UNIT_PREFIX);
-                mValidator->addError(err);
+                addError(err);
             }
         }
     }
@@ -557,7 +970,7 @@ void Validator::ValidatorImpl::validateVariable(const VariablePtr &variable, con
         err->setDescription("Variable does not have a valid name attribute.");
         err->setVariable(variable);
         err->setRule(SpecificationRule::VARIABLE_NAME);
-        mValidator->addError(err);
+        addError(err);
     }
     // Check for a valid units attribute.
     if (!isCellmlIdentifier(variable->units())) {
@@ -565,7 +978,7 @@ void Validator::ValidatorImpl::validateVariable(const VariablePtr &variable, con
         err->setDescription("Variable '" + variable->name() + "' does not have a valid units attribute.");
         err->setVariable(variable);
         err->setRule(SpecificationRule::VARIABLE_UNITS);
-        mValidator->addError(err);
+        addError(err);
     } else if (!isStandardUnitName(variable->units())) {
         auto component = static_cast<Component *>(variable->parent());
         auto model = static_cast<Model *>(component->parent());
@@ -574,7 +987,7 @@ void Validator::ValidatorImpl::validateVariable(const VariablePtr &variable, con
             err->setDescription("Variable '" + variable->name() + "' has an invalid units reference '" + variable->units() + "' that does not correspond with a standard unit or units in the variable's parent component or model.");
             err->setVariable(variable);
             err->setRule(SpecificationRule::VARIABLE_UNITS);
-            mValidator->addError(err);
+            addError(err);
         }
     }
     // Check for a valid interface attribute.
@@ -585,7 +998,7 @@ void Validator::ValidatorImpl::validateVariable(const VariablePtr &variable, con
             err->setDescription("Variable '" + variable->name() + "' has an invalid interface attribute value '" + interfaceType + "'.");
             err->setVariable(variable);
             err->setRule(SpecificationRule::VARIABLE_INTERFACE);
-            mValidator->addError(err);
+            addError(err);
         }
     }
     // Check for a valid initial value attribute.
@@ -599,7 +1012,7 @@ void Validator::ValidatorImpl::validateVariable(const VariablePtr &variable, con
                 err->setDescription("Variable '" + variable->name() + "' has an invalid initial value '" + initialValue + "'. Initial values must be a real number string or a variable reference.");
                 err->setVariable(variable);
                 err->setRule(SpecificationRule::VARIABLE_INITIAL_VALUE);
-                mValidator->addError(err);
+                addError(err);
             }
         }
     }
@@ -623,7 +1036,7 @@ void Validator::ValidatorImpl::validateReset(const ResetPtr &reset, const Compon
         err->setDescription("Reset in component '" + component->name() + "' " + orderString + " " + variableString + ".");
         err->setReset(reset);
         err->setRule(SpecificationRule::RESET_VARIABLE_REFERENCE);
-        mValidator->addError(err);
+        addError(err);
     } else {
         variableString = "referencing variable '" + reset->variable()->name() + "'";
     }
@@ -633,7 +1046,7 @@ void Validator::ValidatorImpl::validateReset(const ResetPtr &reset, const Compon
         err->setDescription("Reset in component '" + component->name() + "' " + orderString + " " + variableString + ".");
         err->setComponent(component);
         err->setRule(SpecificationRule::RESET_ORDER);
-        mValidator->addError(err);
+        addError(err);
     }
 
     if (reset->whenCount() > 0) {
@@ -648,7 +1061,7 @@ void Validator::ValidatorImpl::validateReset(const ResetPtr &reset, const Compon
                     err->setDescription("Reset in component '" + component->name() + "' " + orderString + " " + variableString + variableContinuation + " has multiple whens with order '" + convertIntToString(whenOrder) + "'.");
                     err->setComponent(component);
                     err->setRule(SpecificationRule::RESET_ORDER);
-                    mValidator->addError(err);
+                    addError(err);
                 } else {
                     whenOrders.push_back(whenOrder);
                 }
@@ -663,7 +1076,7 @@ void Validator::ValidatorImpl::validateReset(const ResetPtr &reset, const Compon
         err->setDescription("Reset in component '" + component->name() + "' " + orderString + " " + variableString + variableContinuation + " does not have at least one child When.");
         err->setReset(reset);
         err->setRule(SpecificationRule::RESET_CHILD);
-        mValidator->addError(err);
+        addError(err);
     }
 }
 
@@ -698,7 +1111,7 @@ void Validator::ValidatorImpl::validateWhen(const WhenPtr &when, const ResetPtr
         err->setDescription("When in reset " + resetOrderString + " " + resetVariableString + resetVariableContinuation + " does not have an order set.");
         err->setWhen(when);
         err->setRule(SpecificationRule::WHEN_ORDER);
-        mValidator->addError(err);
+        addError(err);
     }
 
     if (!when->condition().empty()) {
@@ -708,7 +1121,7 @@ void Validator::ValidatorImpl::validateWhen(const WhenPtr &when, const ResetPtr
         err->setDescription("When in reset " + resetOrderString + " " + resetVariableString + resetVariableContinuation + " " + orderString + " does not have a MathML condition set.");
         err->setWhen(when);
         err->setRule(SpecificationRule::WHEN_CHILD);
-        mValidator->addError(err);
+        addError(err);
     }
 
     if (!when->value().empty()) {
@@ -718,7 +1131,7 @@ void Validator::ValidatorImpl::validateWhen(const WhenPtr &when, const ResetPtr
         err->setDescription("When in reset " + resetOrderString + " " + resetVariableString + resetVariableContinuation + " " + orderString + " does not have a MathML value set.");
         err->setWhen(when);
         err->setRule(SpecificationRule::WHEN_CHILD);
-        mValidator->addError(err);
+        addError(err);
     }
 }
 
@@ -733,7 +1146,7 @@ void Validator::ValidatorImpl::validateMath(const std::string &input, const Comp
             ErrorPtr err = std::make_shared<Error>();
             err->setDescription(doc->xmlError(i));
             err->setKind(Error::Kind::XML);
-            mValidator->addError(err);
+            addError(err);
         }
     }
     XmlNodePtr node = doc->rootNode();
@@ -742,7 +1155,7 @@ void Validator::ValidatorImpl::validateMath(const std::string &input, const Comp
         err->setDescription("Could not get a valid XML root node from the math on component '" + component->name() + "'.");
         err->setKind(Error::Kind::XML);
         err->setComponent(component);
-        mValidator->addError(err);
+        addError(err);
         return;
     }
     if (!node->isMathmlElement("math")) {
@@ -750,11 +1163,11 @@ void Validator::ValidatorImpl::validateMath(const std::string &input, const Comp
         err->setDescription("Math root node is of invalid type '" + node->name() + "' on component '" + component->name() + "'. A valid math root node should be of type 'math'.");
         err->setComponent(component);
         err->setKind(Error::Kind::XML);
-        mValidator->addError(err);
+        addError(err);
         return;
     }
-    XmlNodePtr nodeCopy = node;
     std::vector<std::string> bvarNames;
+    std::vector<XmlNodePtr> ciCnNodes;
     std::vector<std::string> variableNames;
     for (size_t i = 0; i < component->variableCount(); ++i) {
         std::string variableName = component->variable(i)->name();
@@ -763,10 +1176,8 @@ void Validator::ValidatorImpl::validateMath(const std::string &input, const Comp
         }
     }
 
-    validateMathMLElements(nodeCopy, component);
-    // Get the bvar names in this math element.
-    // TODO: may want to do this with XPath instead...
-    gatherMathBvarVariableNames(nodeCopy, bvarNames);
+    // Check the elements, and get the bvar names and ci/cn elements in this math element.
+    walkMath(node, component, bvarNames, ciCnNodes);
     // Check that no variable names match new bvar names.
     for (const std::string &variableName : variableNames) {
         if (std::find(bvarNames.begin(), bvarNames.end(), variableName) != bvarNames.end()) {
@@ -774,17 +1185,18 @@ void Validator::ValidatorImpl::validateMath(const std::string &input, const Comp
             err->setDescription("Math in component '" + component->name() + "' contains '" + variableName + "' as a bvar ci element but it is already a variable name.");
             err->setComponent(component);
             err->setKind(Error::Kind::MATHML);
-            mValidator->addError(err);
+            addError(err);
         }
     }
     // Iterate through ci/cn elements and remove cellml units attributes.
-    XmlNodePtr mathNode = node;
-    validateAndCleanMathCiCnNodes(node, component, variableNames, bvarNames);
+    for (const XmlNodePtr &ciCnNode : ciCnNodes) {
+        validateAndCleanMathCiCnNode(ciCnNode, component, variableNames, bvarNames);
+    }
     // Get the MathML string (with cellml:units attributes already removed) and remove the CellML namespace.
     // While the removeSubstring() approach for removing the cellml namespace before validating with the MathML DTD
     // is not ideal, libxml does not appear to have a better way to remove a namespace declaration from the tree.
     std::string cellml2NamespaceString = std::string(" xmlns:cellml=\"http://www.cellml.org/cellml/2.0#\"");
-    std::string cleanMathml = mathNode->convertToString();
+    std::string cleanMathml = node->convertToString();
     removeSubstring(cleanMathml, cellml2NamespaceString);
 
     // Parse/validate the clean math string with the W3C MathML DTD.
@@ -797,226 +1209,535 @@ void Validator::ValidatorImpl::validateMath(const std::string &input, const Comp
             err->setDescription(mathmlDoc->xmlError(i));
             err->setComponent(component);
             err->setKind(Error::Kind::MATHML);
-            mValidator->addError(err);
+            addError(err);
         }
     }
 }
 
-void Validator::ValidatorImpl::validateAndCleanMathCiCnNodes(XmlNodePtr &node, const ComponentPtr &component, const std::vector<std::string> &variableNames,
-                                                             const std::vector<std::string> &bvarNames)
+void Validator::ValidatorImpl::walkMath(const XmlNodePtr &node, const ComponentPtr &component, std::vector<std::string> &bvarNames,
+                                        std::vector<XmlNodePtr> &ciCnNodes)
+{
+    // Walk the tree depth first, with an explicit stack holding the next
+    // sibling of each node on the way down, so that the stack only grows with
+    // the depth of the tree, not with the number of siblings.
+    std::vector<MathWalkItem> stack;
+    stack.push_back({node, false, false});
+    while (!stack.empty()) {
+        MathWalkItem item = stack.back();
+        stack.pop_back();
+        const XmlNodePtr &current = item.mNode;
+        // The siblings of the math element itself are not part of the math.
+        if (current != node) {
+            XmlNodePtr nextNode = current->next();
+            if (nextNode != nullptr) {
+                stack.push_back({nextNode, item.mInBvar, item.mInCiCn});
+            }
+            // Check that the element is a supported MathML element.
+            if (!current->isComment() && !current->isText() && !isSupportedMathMLElement(current)) {
+                ErrorPtr err = std::make_shared<Error>();
+                err->setDescription("Math has a '" + current->name() + "' element" + " that is not a supported MathML element.");
+                err->setComponent(component);
+                err->setKind(Error::Kind::MATHML);
+                addError(err);
+            }
+        }
+        bool inBvar = item.mInBvar;
+        bool inCiCn = item.mInCiCn;
+        if (!inBvar && current->isMathmlElement("bvar")) {
+            // Get the name of the new variable declared by the bvar.
+            inBvar = true;
+            XmlNodePtr childNode = current->firstChild();
+            while (childNode != nullptr) {
+                if (childNode->isMathmlElement("ci")) {
+                    XmlNodePtr grandchildNode = childNode->firstChild();
+                    bool hasBvarName = false;
+                    while (grandchildNode != nullptr) {
+                        if (grandchildNode->isText()) {
+                            std::string textNode = grandchildNode->convertToStrippedString();
+                            if (!textNode.empty()) {
+                                bvarNames.push_back(textNode);
+                                hasBvarName = true;
+                                break;
+                            }
+                        }
+                        grandchildNode = grandchildNode->next();
+                    }
+                    if (hasBvarName) {
+                        break;
+                    }
+                }
+                childNode = childNode->next();
+            }
+        }
+        if (!inCiCn && (current->isMathmlElement("ci") || current->isMathmlElement("cn"))) {
+            inCiCn = true;
+            ciCnNodes.push_back(current);
+        }
+        XmlNodePtr childNode = current->firstChild();
+        if (childNode != nullptr) {
+            stack.push_back({childNode, inBvar, inCiCn});
+        }
+    }
+}
+
+void Validator::ValidatorImpl::validateAndCleanMathCiCnNode(const XmlNodePtr &node, const ComponentPtr &component, const std::vector<std::string> &variableNames,
+                                                            const std::vector<std::string> &bvarNames)
 {
     XmlNodePtr childNode = node->firstChild();
     std::string textNode;
     bool ciType = node->isMathmlElement("ci");
     bool cnType = node->isMathmlElement("cn");
-    if (ciType || cnType) {
-        if (childNode != nullptr) {
-            if (childNode->isText()) {
-                textNode = childNode->convertToStrippedString();
-                if (!textNode.empty()) {
-                    if (ciType) {
-                        // Check whether we can find this text as a variable name in this component.
-                        if ((std::find(variableNames.begin(), variableNames.end(), textNode) == variableNames.end()) && (std::find(bvarNames.begin(), bvarNames.end(), textNode) == bvarNames.end())) {
-                            ErrorPtr err = std::make_shared<Error>();
-                            err->setDescription("MathML ci element has the child text '" + textNode + "', which does not correspond with any variable names present in component '" + component->name() + "' and is not a variable defined within a bvar element.");
-                            err->setComponent(component);
-                            err->setKind(Error::Kind::MATHML);
-                            mValidator->addError(err);
-                        }
+    if (childNode != nullptr) {
+        if (childNode->isText()) {
+            textNode = childNode->convertToStrippedString();
+            if (!textNode.empty()) {
+                if (ciType) {
+                    // Check whether we can find this text as a variable name in this component.
+                    if ((std::find(variableNames.begin(), variableNames.end(), textNode) == variableNames.end()) && (std::find(bvarNames.begin(), bvarNames.end(), textNode) == bvarNames.end())) {
+                        ErrorPtr err = std::make_shared<Error>();
+                        err->setDescription("MathML ci element has the child text '" + textNode + "', which does not correspond with any variable names present in component '" + component->name() + "' and is not a variable defined within a bvar element.");
+                        err->setComponent(component);
+                        err->setKind(Error::Kind::MATHML);
+                        addError(err);
                     }
-                } else {
-                    ErrorPtr err = std::make_shared<Error>();
-                    err->setDescription("MathML " + node->name() + " element has an empty child element.");
-                    err->setComponent(component);
-                    err->setKind(Error::Kind::MATHML);
-                    mValidator->addError(err);
                 }
+            } else {
+                ErrorPtr err = std::make_shared<Error>();
+                err->setDescription("MathML " + node->name() + " element has an empty child element.");
+                err->setComponent(component);
+                err->setKind(Error::Kind::MATHML);
+                addError(err);
             }
+        }
+    } else {
+        ErrorPtr err = std::make_shared<Error>();
+        err->setDescription("MathML " + node->name() + " element has no child.");
+        err->setComponent(component);
+        err->setKind(Error::Kind::MATHML);
+        addError(err);
+    }
+    // Get cellml:units attribute.
+    XmlAttributePtr attribute = node->firstAttribute();
+    std::string unitsName;
+    XmlAttributePtr unitsAttribute = nullptr;
+    while (attribute) {
+        if (!attribute->value().empty()) {
+            if (attribute->isCellmlType("units")) {
+                unitsName = attribute->value();
+                unitsAttribute = attribute;
+            } else {
+                ErrorPtr err = std::make_shared<Error>();
+                err->setDescription("Math " + node->name() + " element has an invalid attribute type '" + attribute->name() + "' in the cellml namespace.");
+                err->setComponent(component);
+                err->setKind(Error::Kind::MATHML);
+                addError(err);
+            }
+        }
+        attribute = attribute->next();
+    }
+
+    bool checkUnitsIsInComponent = false;
+    // Check that cellml:units has been set.
+    if (ciType) {
+        if (unitsAttribute != nullptr) {
+            ErrorPtr err = std::make_shared<Error>();
+            err->setDescription("Math ci element with value '" + textNode + "' has a cellml:units attribute with name '" + unitsAttribute->value() + "'.");
+        }
+    } else if (cnType) {
+        if (isCellmlIdentifier(unitsName)) {
+            checkUnitsIsInComponent = true;
         } else {
             ErrorPtr err = std::make_shared<Error>();
-            err->setDescription("MathML " + node->name() + " element has no child.");
+            err->setDescription("Math cn element with the value '" + textNode + "' does not have a valid cellml:units attribute.");
             err->setComponent(component);
             err->setKind(Error::Kind::MATHML);
-            mValidator->addError(err);
-        }
-        // Get cellml:units attribute.
-        XmlAttributePtr attribute = node->firstAttribute();
-        std::string unitsName;
-        XmlAttributePtr unitsAttribute = nullptr;
-        while (attribute) {
-            if (!attribute->value().empty()) {
-                if (attribute->isCellmlType("units")) {
-                    unitsName = attribute->value();
-                    unitsAttribute = attribute;
-                } else {
-                    ErrorPtr err = std::make_shared<Error>();
-                    err->setDescription("Math " + node->name() + " element has an invalid attribute type '" + attribute->name() + "' in the cellml namespace.");
-                    err->setComponent(component);
-                    err->setKind(Error::Kind::MATHML);
-                    mValidator->addError(err);
-                }
-            }
-            attribute = attribute->next();
+            addError(err);
         }
+    }
 
-        bool checkUnitsIsInComponent = false;
-        // Check that cellml:units has been set.
-        if (ciType) {
-            if (unitsAttribute != nullptr) {
-                ErrorPtr err = std::make_shared<Error>();
-                err->setDescription("Math ci element with value '" + textNode + "' has a cellml:units attribute with name '" + unitsAttribute->value() + "'.");
-            }
-        } else if (cnType) {
-            if (isCellmlIdentifier(unitsName)) {
-                checkUnitsIsInComponent = true;
-            } else {
+    // Check that a specified units is valid.
+    if (checkUnitsIsInComponent) {
+        // Check for a matching units in this component.
+        auto model = static_cast<Model *>(component->parent());
+        if (!model->hasUnits(unitsName)) {
+            // Check for a matching standard units.
+            if (!isStandardUnitName(unitsName)) {
                 ErrorPtr err = std::make_shared<Error>();
-                err->setDescription("Math cn element with the value '" + textNode + "' does not have a valid cellml:units attribute.");
+                err->setDescription("Math has a " + node->name() + " element with a cellml:units attribute '" + unitsName + "' that is not a valid reference to units in component '" + component->name() + "' or a standard unit.");
                 err->setComponent(component);
                 err->setKind(Error::Kind::MATHML);
-                mValidator->addError(err);
+                addError(err);
             }
         }
+    }
+    // Now that we've validated this XML node's cellml:units attribute, remove it from the node.
+    // This is done so we can validate a "clean" MathML string using the MathML DTD. The math
+    // string stored on the component will not be affected.
+    if (unitsAttribute) {
+        unitsAttribute->removeAttribute();
+    }
+}
 
-        // Check that a specified units is valid.
-        if (checkUnitsIsInComponent) {
-            // Check for a matching units in this component.
-            auto model = static_cast<Model *>(component->parent());
-            if (!model->hasUnits(unitsName)) {
-                // Check for a matching standard units.
-                if (!isStandardUnitName(unitsName)) {
-                    ErrorPtr err = std::make_shared<Error>();
-                    err->setDescription("Math has a " + node->name() + " element with a cellml:units attribute '" + unitsName + "' that is not a valid reference to units in component '" + component->name() + "' or a standard unit.");
-                    err->setComponent(component);
-                    err->setKind(Error::Kind::MATHML);
-                    mValidator->addError(err);
-                }
+void Validator::ValidatorImpl::validateConnections(const ModelPtr &model)
+{
+    // Index the variables of the model by the component they belong to, and
+    // the components by their parent component, so that each equivalence can
+    // be checked in constant time.
+    std::vector<VariablePtr> variables;
+    std::unordered_map<const Variable *, size_t> variableIndices;
+    std::unordered_map<const Variable *, const Component *> variableComponents;
+    std::unordered_map<const Component *, const Component *> componentParents;
+    std::vector<std::pair<ComponentPtr, const Component *>> componentStack;
+    for (size_t i = model->componentCount(); i-- > 0;) {
+        componentStack.emplace_back(model->component(i), nullptr);
+    }
+    while (!componentStack.empty()) {
+        ComponentPtr component = componentStack.back().first;
+        componentParents[component.get()] = componentStack.back().second;
+        componentStack.pop_back();
+        for (size_t i = 0; i < component->variableCount(); ++i) {
+            VariablePtr variable = component->variable(i);
+            if (variableIndices.emplace(variable.get(), variables.size()).second) {
+                variables.push_back(variable);
+                variableComponents[variable.get()] = component.get();
             }
         }
-        // Now that we've validated this XML node's cellml:units attribute, remove it from the node.
-        // This is done so we can validate a "clean" MathML string using the MathML DTD. The math
-        // string stored on the component will not be affected.
-        if (unitsAttribute) {
-            unitsAttribute->removeAttribute();
+        for (size_t i = component->componentCount(); i-- > 0;) {
+            componentStack.emplace_back(component->component(i), component.get());
         }
-    } else {
-        // Check children for ci/cn elements.
-        if (childNode != nullptr) {
-            validateAndCleanMathCiCnNodes(childNode, component, variableNames, bvarNames);
+    }
+    std::unordered_set<std::pair<const Variable *, const Variable *>, VariablePairHash> equivalences;
+    for (const VariablePtr &variable : variables) {
+        for (size_t i = 0; i < variable->equivalentVariableCount(); ++i) {
+            VariablePtr equivalentVariable = variable->equivalentVariable(i);
+            if (equivalentVariable != nullptr) {
+                equivalences.emplace(variable.get(), equivalentVariable.get());
+            }
         }
     }
-    // Check siblings for ci/cn.
-    node = node->next();
-    if (node != nullptr) {
-        validateAndCleanMathCiCnNodes(node, component, variableNames, bvarNames);
+
+    // Visit each equivalence once, joining the equivalent variables into
+    // sets as we go.  An equivalence between variables that are already in
+    // the same set duplicates a connection that exists through other
+    // variables.
+    std::vector<size_t> sets(variables.size());
+    for (size_t i = 0; i < sets.size(); ++i) {
+        sets.at(i) = i;
+    }
+    auto findSet = [&sets](size_t index) {
+        while (sets.at(index) != index) {
+            sets.at(index) = sets.at(sets.at(index));
+            index = sets.at(index);
+        }
+        return index;
+    };
+    for (size_t i = 0; i < variables.size(); ++i) {
+        const VariablePtr &variable = variables.at(i);
+        for (size_t k = 0; k < variable->equivalentVariableCount(); ++k) {
+            VariablePtr equivalentVariable = variable->equivalentVariable(k);
+            if (equivalentVariable == nullptr) {
+                continue;
+            }
+            auto found = variableIndices.find(equivalentVariable.get());
+            bool reciprocal = (found != variableIndices.end()) ? equivalences.count(std::make_pair(equivalentVariable.get(), variable.get())) > 0 : equivalentVariable->hasEquivalentVariable(variable);
+            if (!reciprocal) {
+                ErrorPtr err = std::make_shared<Error>();
+                err->setDescription("Variable '" + variable->name() + "' has an equivalent variable '" + equivalentVariable->name() + "'  which does not reciprocally have '" + variable->name() + "' set as an equivalent variable.");
+                err->setModel(model);
+                err->setKind(Error::Kind::CONNECTION);
+                addError(err);
+                continue;
+            }
+            if (found == variableIndices.end()) {
+                ErrorPtr err = std::make_shared<Error>();
+                err->setDescription("Variable '" + equivalentVariable->name() + "' is an equivalent variable to '" + variable->name() + "' but has no parent component.");
+                err->setModel(model);
+                err->setKind(Error::Kind::CONNECTION);
+                addError(err);
+                continue;
+            }
+            // The equivalence was checked from the other side already.
+            if (found->second < i) {
+                continue;
+            }
+            const Component *component = variableComponents.at(variable.get());
+            const Component *equivalentComponent = variableComponents.at(equivalentVariable.get());
+            std::string connection = "Variable '" + variable->name() + "' in component '" + component->name() + "' and variable '" + equivalentVariable->name() + "' in component '" + equivalentComponent->name() + "'";
+            size_t set = findSet(i);
+            size_t equivalentSet = findSet(found->second);
+            if (set == equivalentSet) {
+                ErrorPtr err = std::make_shared<Error>();
+                err->setDescription(connection + " are equivalent but are already connected through other equivalent variables.");
+                err->setModel(model);
+                err->setKind(Error::Kind::CONNECTION);
+                err->setRule(SpecificationRule::CONNECTION_UNIQUE_TRANSITIVE);
+                addError(err);
+            } else {
+                sets.at(equivalentSet) = set;
+            }
+            // Sibling components connect through public interfaces, while a
+            // parent connects to its children through a private one.
+            const Component *parent = componentParents.at(component);
+            const Component *equivalentParent = componentParents.at(equivalentComponent);
+            std::vector<std::pair<const VariablePtr *, std::string>> requiredInterfaces;
+            if ((component != equivalentComponent) && (parent == equivalentParent)) {
+                requiredInterfaces = {{&variable, "public"}, {&equivalentVariable, "public"}};
+            } else if (equivalentParent == component) {
+                requiredInterfaces = {{&variable, "private"}, {&equivalentVariable, "public"}};
+            } else if (parent == equivalentComponent) {
+                requiredInterfaces = {{&variable, "public"}, {&equivalentVariable, "private"}};
+            } else {
+                ErrorPtr err = std::make_shared<Error>();
+                err->setDescription(connection + " are equivalent but their components are neither siblings nor parent and child.");
+                err->setModel(model);
+                err->setKind(Error::Kind::CONNECTION);
+                addError(err);
+            }
+            for (const auto &requiredInterface : requiredInterfaces) {
+                const VariablePtr &interfaceVariable = *requiredInterface.first;
+                // The variables of an imported component are placeholders,
+                // whose interface is given in the model it is imported from.
+                if (variableComponents.at(interfaceVariable.get())->isImport()) {
+                    continue;
+                }
+                std::string interfaceType = interfaceVariable->interfaceType();
+                if ((interfaceType != requiredInterface.second) && (interfaceType != "public_and_private")) {
+                    ErrorPtr err = std::make_shared<Error>();
+                    err->setDescription(connection + " are equivalent but variable '" + interfaceVariable->name() + "' does not have a " + requiredInterface.second + " interface.");
+                    err->setVariable(interfaceVariable);
+                    err->setKind(Error::Kind::CONNECTION);
+                    err->setRule(SpecificationRule::VARIABLE_INTERFACE);
+                    addError(err);
+                }
+            }
+        }
     }
 }
 
-void Validator::ValidatorImpl::validateMathMLElements(const XmlNodePtr &node, const ComponentPtr &component)
+// TODO: validateEncapsulations
+
+void Validator::ValidatorImpl::checkComponentDimensions(const ModelPtr &model, const ComponentPtr &component)
 {
-    XmlNodePtr childNode = node->firstChild();
-    if (childNode != nullptr) {
-        if (!childNode->isComment() && !childNode->isText() && !isSupportedMathMLElement(childNode)) {
-            ErrorPtr err = std::make_shared<Error>();
-            err->setDescription("Math has a '" + childNode->name() + "' element" + " that is not a supported MathML element.");
-            err->setComponent(component);
-            err->setKind(Error::Kind::MATHML);
-            mValidator->addError(err);
+    if (component->isImport()) {
+        return;
+    }
+    std::vector<MathAstPtr> asts;
+    std::string error;
+    if (!component->math().empty() && parseMathAst(component->math(), component, asts, error)) {
+        for (size_t i = 0; i < asts.size(); ++i) {
+            expressionDimension(asts.at(i), model, component, i + 1);
         }
-        validateMathMLElements(childNode, component);
     }
+    for (size_t i = 0; i < component->componentCount(); ++i) {
+        checkComponentDimensions(model, component->component(i));
+    }
+}
 
-    XmlNodePtr nextNode = node->next();
-    if (nextNode != nullptr) {
-        if (!nextNode->isComment() && !nextNode->isText() && !isSupportedMathMLElement(nextNode)) {
-            ErrorPtr err = std::make_shared<Error>();
-            err->setDescription("Math has a '" + nextNode->name() + "' element" + " that is not a supported MathML element.");
-            err->setComponent(component);
-            err->setKind(Error::Kind::MATHML);
-            mValidator->addError(err);
-        }
-        validateMathMLElements(nextNode, component);
+ExpressionDimension Validator::ValidatorImpl::unitsDimension(const ModelPtr &model, const std::string &name)
+{
+    auto found = mUnitsDimensions.find(name);
+    if (found != mUnitsDimensions.end()) {
+        return found->second;
     }
+    ExpressionDimension dimension;
+    dimension.mKnown = reduceUnits(model.get(), name, dimension.mDefinition);
+    mUnitsDimensions.emplace(name, dimension);
+    return dimension;
 }
 
-void Validator::ValidatorImpl::gatherMathBvarVariableNames(XmlNodePtr &node, std::vector<std::string> &bvarNames)
+ExpressionDimension Validator::ValidatorImpl::expressionDimension(const MathAstPtr &ast, const ModelPtr &model, const ComponentPtr &component, size_t equation)
 {
-    XmlNodePtr childNode = node->firstChild();
-    if (node->isMathmlElement("bvar")) {
-        while (childNode != nullptr) {
-            if (childNode->isMathmlElement("ci")) {
-                XmlNodePtr grandchildNode = childNode->firstChild();
-                bool hasBvarName = false;
-                while (grandchildNode != nullptr) {
-                    if (grandchildNode->isText()) {
-                        std::string textNode = grandchildNode->convertToStrippedString();
-                        if (!textNode.empty()) {
-                            bvarNames.push_back(textNode);
-                            hasBvarName = true;
-                            break;
-                        }
-                    }
-                    grandchildNode = grandchildNode->next();
-                }
-                if (hasBvarName) {
-                    break;
+    const std::string name = "'" + mathAstTypeName(ast->mType) + "'";
+    switch (ast->mType) {
+    case MathAst::Type::CI:
+        return unitsDimension(model, ast->mVariable->units());
+    case MathAst::Type::CN:
+        return ast->mUnits.empty() ? ExpressionDimension() : unitsDimension(model, ast->mUnits);
+    case MathAst::Type::BOOLEAN_TRUE:
+    case MathAst::Type::BOOLEAN_FALSE:
+    case MathAst::Type::E:
+    case MathAst::Type::PI:
+        return dimensionless();
+    case MathAst::Type::INF:
+    case MathAst::Type::NOT_A_NUMBER:
+    case MathAst::Type::LOOKUP:
+        return ExpressionDimension();
+    case MathAst::Type::PIECEWISE: {
+        // The values of the pieces must match, while their conditions only
+        // need to be consistent themselves.
+        std::vector<ExpressionDimension> values;
+        for (const MathAstPtr &piece : ast->mChildren) {
+            if (!piece->mChildren.empty()) {
+                values.push_back(expressionDimension(piece->mChildren.at(0), model, component, equation));
+            }
+            if (piece->mChildren.size() > 1) {
+                expressionDimension(piece->mChildren.at(1), model, component, equation);
+            }
+        }
+        return commonDimension(values, ast->mType, component, equation);
+    }
+    case MathAst::Type::DIFF: {
+        // d(x)/d(t)^n has the dimension of x divided by that of t^n.
+        ExpressionDimension result;
+        ExpressionDimension bvar;
+        double degree = 1.0;
+        bool constantDegree = true;
+        for (const MathAstPtr &child : ast->mChildren) {
+            if (child->mType != MathAst::Type::BVAR) {
+                result = expressionDimension(child, model, component, equation);
+                continue;
+            }
+            for (const MathAstPtr &bvarChild : child->mChildren) {
+                if (bvarChild->mType == MathAst::Type::DEGREE) {
+                    constantDegree = !bvarChild->mChildren.empty() && constantValue(bvarChild->mChildren.at(0), degree);
+                } else {
+                    bvar = expressionDimension(bvarChild, model, component, equation);
                 }
             }
-            childNode = childNode->next();
         }
-    } else {
-        // Check children for bvars.
-        if (childNode != nullptr) {
-            gatherMathBvarVariableNames(childNode, bvarNames);
+        if (!result.mKnown || !bvar.mKnown || !constantDegree) {
+            return ExpressionDimension();
+        }
+        result.mDefinition.multiply(bvar.mDefinition, -degree);
+        return result;
+    }
+    default:
+        break;
+    }
+
+    // Work out the dimensions of the arguments of the operator, keeping any
+    // degree or logarithm base aside.
+    std::vector<ExpressionDimension> arguments;
+    std::vector<MathAstPtr> argumentAsts;
+    MathAstPtr qualifier = nullptr;
+    for (const MathAstPtr &child : ast->mChildren) {
+        if ((child->mType == MathAst::Type::DEGREE) || (child->mType == MathAst::Type::LOGBASE)) {
+            qualifier = child->mChildren.empty() ? nullptr : child->mChildren.at(0);
+        } else {
+            arguments.push_back(expressionDimension(child, model, component, equation));
+            argumentAsts.push_back(child);
+        }
+    }
+    if (arguments.empty()) {
+        return ExpressionDimension();
+    }
+
+    switch (ast->mType) {
+    case MathAst::Type::EQ:
+    case MathAst::Type::NEQ:
+    case MathAst::Type::LT:
+    case MathAst::Type::LEQ:
+    case MathAst::Type::GT:
+    case MathAst::Type::GEQ:
+        commonDimension(arguments, ast->mType, component, equation);
+        return dimensionless();
+    case MathAst::Type::AND:
+    case MathAst::Type::OR:
+    case MathAst::Type::XOR:
+    case MathAst::Type::NOT:
+        return dimensionless();
+    case MathAst::Type::PLUS:
+    case MathAst::Type::MINUS:
+    case MathAst::Type::MIN:
+    case MathAst::Type::MAX:
+    case MathAst::Type::REM:
+        return commonDimension(arguments, ast->mType, component, equation);
+    case MathAst::Type::TIMES:
+    case MathAst::Type::DIVIDE: {
+        ExpressionDimension result = dimensionless();
+        for (size_t i = 0; i < arguments.size(); ++i) {
+            if (!arguments.at(i).mKnown) {
+                return ExpressionDimension();
+            }
+            double exponent = ((ast->mType == MathAst::Type::DIVIDE) && (i > 0)) ? -1.0 : 1.0;
+            result.mDefinition.multiply(arguments.at(i).mDefinition, exponent);
+        }
+        return result;
+    }
+    case MathAst::Type::POWER:
+    case MathAst::Type::ROOT: {
+        // A dimensional base can only be raised to a constant power, which
+        // must itself be dimensionless.
+        const ExpressionDimension &base = arguments.at(0);
+        ExpressionDimension exponentDimension;
+        MathAstPtr exponentAst = nullptr;
+        if (ast->mType == MathAst::Type::POWER) {
+            if (arguments.size() > 1) {
+                exponentDimension = arguments.at(1);
+                exponentAst = argumentAsts.at(1);
+            }
+        } else if (qualifier != nullptr) {
+            exponentDimension = expressionDimension(qualifier, model, component, equation);
+            exponentAst = qualifier;
+        }
+        if (isDimensional(exponentDimension)) {
+            addDimensionError(component, equation, "the " + std::string((ast->mType == MathAst::Type::POWER) ? "exponent" : "degree") + " of " + name + " has dimension '" + exponentDimension.mDefinition.dimension() + "' but must be dimensionless.");
+            return ExpressionDimension();
+        }
+        double exponent = 2.0;
+        if ((exponentAst != nullptr) && !constantValue(exponentAst, exponent)) {
+            if (isDimensional(base)) {
+                addDimensionError(component, equation, "the base of " + name + " has dimension '" + base.mDefinition.dimension() + "' but must be dimensionless as the " + std::string((ast->mType == MathAst::Type::POWER) ? "exponent" : "degree") + " is not constant.");
+                return ExpressionDimension();
+            }
+            return base;
+        }
+        if ((exponentAst == nullptr) && (ast->mType == MathAst::Type::POWER)) {
+            return ExpressionDimension();
+        }
+        if (!base.mKnown) {
+            return base;
+        }
+        ExpressionDimension result = dimensionless();
+        result.mDefinition.multiply(base.mDefinition, (ast->mType == MathAst::Type::POWER) ? exponent : 1.0 / exponent);
+        return result;
+    }
+    case MathAst::Type::ABS:
+    case MathAst::Type::FLOOR:
+    case MathAst::Type::CEILING:
+        return arguments.at(0);
+    default: {
+        // The remaining operators are transcendental functions, which only
+        // apply to dimensionless arguments and bases.
+        if (qualifier != nullptr) {
+            ExpressionDimension base = expressionDimension(qualifier, model, component, equation);
+            if (isDimensional(base)) {
+                addDimensionError(component, equation, "the base of " + name + " has dimension '" + base.mDefinition.dimension() + "' but must be dimensionless.");
+            }
+        }
+        if (isDimensional(arguments.at(0))) {
+            addDimensionError(component, equation, "the argument of " + name + " has dimension '" + arguments.at(0).mDefinition.dimension() + "' but must be dimensionless.");
         }
+        return dimensionless();
     }
-    // Check siblings for bvars.
-    node = node->next();
-    if (node != nullptr) {
-        gatherMathBvarVariableNames(node, bvarNames);
     }
 }
 
-void Validator::ValidatorImpl::validateConnections(const ModelPtr &model)
+ExpressionDimension Validator::ValidatorImpl::commonDimension(const std::vector<ExpressionDimension> &dimensions, MathAst::Type type, const ComponentPtr &component, size_t equation)
 {
-    // Check the components in this model.
-    if (model->componentCount() > 0) {
-        for (size_t i = 0; i < model->componentCount(); ++i) {
-            ComponentPtr component = model->component(i);
-            // Check the variables in this component.
-            for (size_t j = 0; j < component->variableCount(); ++j) {
-                VariablePtr variable = component->variable(j);
-                // Check the equivalent variables in this variable.
-                if (variable->equivalentVariableCount() > 0) {
-                    for (size_t k = 0; k < variable->equivalentVariableCount(); ++k) {
-                        VariablePtr equivalentVariable = variable->equivalentVariable(k);
-                        // TODO: validate variable interfaces according to 17.10.8
-                        // TODO: add check for cyclical connections (17.10.5)
-                        if (equivalentVariable->hasEquivalentVariable(variable)) {
-                            // Check that the equivalent variable has a valid parent component.
-                            auto component2 = static_cast<Component *>(equivalentVariable->parent());
-                            if (!component2->hasVariable(equivalentVariable)) {
-                                ErrorPtr err = std::make_shared<Error>();
-                                err->setDescription("Variable '" + equivalentVariable->name() + "' is an equivalent variable to '" + variable->name() + "' but has no parent component.");
-                                err->setModel(model);
-                                err->setKind(Error::Kind::CONNECTION);
-                                mValidator->addError(err);
-                            }
-                        } else {
-                            ErrorPtr err = std::make_shared<Error>();
-                            err->setDescription("Variable '" + variable->name() + "' has an equivalent variable '" + equivalentVariable->name() + "'  which does not reciprocally have '" + variable->name() + "' set as an equivalent variable.");
-                            err->setModel(model);
-                            err->setKind(Error::Kind::CONNECTION);
-                            mValidator->addError(err);
-                        }
-                    }
-                }
-            }
+    ExpressionDimension result;
+    for (const ExpressionDimension &dimension : dimensions) {
+        if (!dimension.mKnown) {
+            continue;
+        }
+        if (!result.mKnown) {
+            result = dimension;
+        } else if (!result.mDefinition.hasSameDimension(dimension.mDefinition)) {
+            addDimensionError(component, equation, "the arguments of '" + mathAstTypeName(type) + "' have different dimensions '" + result.mDefinition.dimension() + "' and '" + dimension.mDefinition.dimension() + "'.");
+            return ExpressionDimension();
         }
     }
+    return result;
 }
 
-// TODO: validateEncapsulations
+void Validator::ValidatorImpl::addDimensionError(const ComponentPtr &component, size_t equation, const std::string &description)
+{
+    ErrorPtr err = std::make_shared<Error>();
+    err->setDescription("Equation " + convertIntToString(int(equation)) + " in component '" + component->name() + "' is not dimensionally consistent: " + description);
+    err->setComponent(component);
+    err->setKind(Error::Kind::UNITS);
+    addError(err);
+}
 
 void Validator::ValidatorImpl::removeSubstring(std::string &input, const std::string &pattern)
 {
@@ -1063,7 +1784,7 @@ bool Validator::ValidatorImpl::isCellmlIdentifier(const std::string &name)
             ErrorPtr err = std::make_shared<Error>();
             err->setDescription("CellML identifiers must not begin with a European numeric character [0-9].");
             err->setRule(SpecificationRule::DATA_REPR_IDENTIFIER_BEGIN_EURO_NUM);
-            mValidator->addError(err);
+            addError(err);
         } else {
             // Basic Latin alphanumeric characters and underscores.
             if (name.find_first_not_of("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_") != std::string::npos) {
@@ -1071,7 +1792,7 @@ bool Validator::ValidatorImpl::isCellmlIdentifier(const std::string &name)
                 ErrorPtr err = std::make_shared<Error>();
                 err->setDescription("CellML identifiers must not contain any characters other than [a-zA-Z0-9_].");
                 err->setRule(SpecificationRule::DATA_REPR_IDENTIFIER_LATIN_ALPHANUM);
-                mValidator->addError(err);
+                addError(err);
             }
         }
     } else {
@@ -1079,7 +1800,7 @@ bool Validator::ValidatorImpl::isCellmlIdentifier(const std::string &name)
         ErrorPtr err = std::make_shared<Error>();
         err->setDescription("CellML identifiers must contain one or more basic Latin alphabetic characters.");
         err->setRule(SpecificationRule::DATA_REPR_IDENTIFIER_AT_LEAST_ONE_ALPHANUM);
-        mValidator->addError(err);
+        addError(err);
     }
     return result;
 }
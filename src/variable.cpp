@@ -14,15 +14,20 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include "arena.h"
+#include "symbols.h"
 #include "utilities.h"
 
 #include "libcellml/units.h"
 #include "libcellml/variable.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <map>
+#include <set>
 #include <sstream>
+#include <unordered_map>
 #include <vector>
 
 namespace libcellml {
@@ -40,6 +45,40 @@ static const std::map<Variable::InterfaceType, const std::string> interfaceTypeT
 
 using VariableWeakPtr = std::weak_ptr<Variable>; /**< Type definition for weak variable pointer. */
 
+/**
+ * @brief The EquivalenceSet struct.
+ *
+ * An internal structure holding a set of variables that are connected
+ * through their equivalences, which is shared by all of them.  Sets are
+ * merged when an equivalence joins two of them, moving the variables of the
+ * smaller set into the larger one, and split again when an equivalence is
+ * removed.
+ */
+struct EquivalenceSet
+{
+    size_t mId = 0; /**< The id of this set, which is unique and kept for as long as this set exists. */
+    std::vector<VariableWeakPtr> mMembers; /**< The variables in this set, starting with its representative. */
+};
+
+using EquivalenceSetPtr = std::shared_ptr<EquivalenceSet>; /**< Type definition for shared equivalence set pointer. */
+
+/**
+ * The id of the next equivalence set to be created.
+ */
+static std::atomic<size_t> nextEquivalenceSetId(0);
+
+/**
+ * @brief Create an empty equivalence set with a new id.
+ *
+ * @return The new equivalence set.
+ */
+static EquivalenceSetPtr createEquivalenceSet()
+{
+    EquivalenceSetPtr set = std::make_shared<EquivalenceSet>();
+    set->mId = nextEquivalenceSetId++;
+    return set;
+}
+
 /**
  * @brief The Variable::VariableImpl struct.
  *
@@ -146,6 +185,37 @@ struct Variable::VariableImpl
      */
     std::string equivalentConnectionId(const VariablePtr &equivalentVariable) const;
 
+    /**
+     * @brief Get the equivalence set of @p variable.
+     *
+     * A variable that has never been part of an equivalence only gets a set,
+     * holding just itself, when it is first asked for.
+     *
+     * @param variable The variable to get the equivalence set of.
+     *
+     * @return The equivalence set of @p variable.
+     */
+    static EquivalenceSetPtr equivalenceSet(const VariablePtr &variable);
+
+    /**
+     * @brief Merge the equivalence sets of @p variable1 and @p variable2.
+     *
+     * @param variable1 A variable of the first set.
+     * @param variable2 A variable of the second set.
+     */
+    static void mergeEquivalenceSets(const VariablePtr &variable1, const VariablePtr &variable2);
+
+    /**
+     * @brief Split @p set into the sets of variables that are still connected.
+     *
+     * The variables connected to the first one in @p set stay in @p set, and
+     * any others are moved to new sets.  Variables that no longer exist are
+     * dropped.
+     *
+     * @param set The equivalence set to split.
+     */
+    static void splitEquivalenceSet(const EquivalenceSetPtr &set);
+
     std::vector<VariableWeakPtr>::iterator findEquivalentVariable(const VariablePtr &equivalentVariable);
     std::vector<VariableWeakPtr>::const_iterator findEquivalentVariable(const VariablePtr &equivalentVariable) const;
     std::vector<VariableWeakPtr> mEquivalentVariables; /**< Equivalent variables for this Variable.*/
@@ -153,7 +223,8 @@ struct Variable::VariableImpl
     std::map<VariableWeakPtr, std::string, std::owner_less<VariableWeakPtr>> mConnectionIdMap; /**< Connection id map for equivalent variable.*/
     std::string mInitialValue; /**< Initial value for this Variable.*/
     std::string mInterfaceType; /**< Interface type for this Variable.*/
-    std::string mUnits; /**< The name of the units defined for this Variable.*/
+    InternedString mUnits; /**< The name of the units defined for this Variable, interned.*/
+    EquivalenceSetPtr mEquivalenceSet = nullptr; /**< The equivalence set of this Variable, created when first needed.*/
 };
 
 std::vector<VariableWeakPtr>::const_iterator Variable::VariableImpl::findEquivalentVariable(const VariablePtr &equivalentVariable) const
@@ -169,18 +240,18 @@ std::vector<VariableWeakPtr>::iterator Variable::VariableImpl::findEquivalentVar
 }
 
 Variable::Variable()
-    : mPimpl(new VariableImpl())
+    : mPimpl(newImpl<VariableImpl>())
 {
 }
 
 Variable::~Variable()
 {
-    delete mPimpl;
+    deleteImpl(mPimpl);
 }
 
 Variable::Variable(const Variable &rhs)
     : NamedEntity(rhs)
-    , mPimpl(new VariableImpl())
+    , mPimpl(newImpl<VariableImpl>())
 {
     mPimpl->mEquivalentVariables = rhs.mPimpl->mEquivalentVariables;
     mPimpl->mConnectionIdMap = rhs.mPimpl->mConnectionIdMap;
@@ -213,6 +284,9 @@ void Variable::addEquivalence(const VariablePtr &variable1, const VariablePtr &v
 {
     variable1->mPimpl->setEquivalentTo(variable2);
     variable2->mPimpl->setEquivalentTo(variable1);
+    VariableImpl::mergeEquivalenceSets(variable1, variable2);
+    variable1->markModified();
+    variable2->markModified();
 }
 
 void Variable::addEquivalence(const VariablePtr &variable1, const VariablePtr &variable2, const std::string &mappingId, const std::string &connectionId)
@@ -228,6 +302,12 @@ bool Variable::removeEquivalence(const VariablePtr &variable1, const VariablePtr
 {
     bool equivalence_1 = variable1->mPimpl->unsetEquivalentTo(variable2);
     bool equivalence_2 = variable2->mPimpl->unsetEquivalentTo(variable1);
+    EquivalenceSetPtr set = variable1->mPimpl->mEquivalenceSet;
+    if ((equivalence_1 || equivalence_2) && (set != nullptr) && (set == variable2->mPimpl->mEquivalenceSet)) {
+        VariableImpl::splitEquivalenceSet(set);
+    }
+    variable1->markModified();
+    variable2->markModified();
 
     return equivalence_1 && equivalence_2;
 }
@@ -235,6 +315,150 @@ bool Variable::removeEquivalence(const VariablePtr &variable1, const VariablePtr
 void Variable::removeAllEquivalences()
 {
     mPimpl->mEquivalentVariables.clear();
+    if (mPimpl->mEquivalenceSet != nullptr) {
+        VariableImpl::splitEquivalenceSet(mPimpl->mEquivalenceSet);
+    }
+    markModified();
+}
+
+std::vector<VariablePtr> Variable::equivalenceSet(const VariablePtr &variable)
+{
+    std::vector<VariablePtr> variables;
+    for (const VariableWeakPtr &member : VariableImpl::equivalenceSet(variable)->mMembers) {
+        VariablePtr memberVariable = member.lock();
+        if (memberVariable != nullptr) {
+            variables.push_back(memberVariable);
+        }
+    }
+    return variables;
+}
+
+VariablePtr Variable::equivalenceRepresentative(const VariablePtr &variable)
+{
+    for (const VariableWeakPtr &member : VariableImpl::equivalenceSet(variable)->mMembers) {
+        VariablePtr memberVariable = member.lock();
+        if (memberVariable != nullptr) {
+            return memberVariable;
+        }
+    }
+    return variable;
+}
+
+size_t Variable::equivalenceSetId(const VariablePtr &variable)
+{
+    return VariableImpl::equivalenceSet(variable)->mId;
+}
+
+EquivalenceSetPtr Variable::VariableImpl::equivalenceSet(const VariablePtr &variable)
+{
+    if (variable->mPimpl->mEquivalenceSet == nullptr) {
+        variable->mPimpl->mEquivalenceSet = createEquivalenceSet();
+        variable->mPimpl->mEquivalenceSet->mMembers.push_back(variable);
+    }
+    return variable->mPimpl->mEquivalenceSet;
+}
+
+void Variable::VariableImpl::mergeEquivalenceSets(const VariablePtr &variable1, const VariablePtr &variable2)
+{
+    EquivalenceSetPtr set1 = equivalenceSet(variable1);
+    EquivalenceSetPtr set2 = equivalenceSet(variable2);
+    if (set1 == set2) {
+        return;
+    }
+    // Moving the variables of the smaller set means that each variable moves
+    // at most a logarithmic number of times.
+    if (set1->mMembers.size() < set2->mMembers.size()) {
+        std::swap(set1, set2);
+    }
+    for (const VariableWeakPtr &member : set2->mMembers) {
+        VariablePtr memberVariable = member.lock();
+        if (memberVariable != nullptr) {
+            memberVariable->mPimpl->mEquivalenceSet = set1;
+            set1->mMembers.push_back(member);
+        }
+    }
+    set2->mMembers.clear();
+}
+
+void Variable::VariableImpl::splitEquivalenceSet(const EquivalenceSetPtr &set)
+{
+    std::vector<VariablePtr> members;
+    for (const VariableWeakPtr &member : set->mMembers) {
+        VariablePtr memberVariable = member.lock();
+        if (memberVariable != nullptr) {
+            members.push_back(memberVariable);
+        }
+    }
+    set->mMembers.clear();
+    // Follow the equivalences in both directions, so that those only held by
+    // one of their variables, as left by removeAllEquivalences(), give the
+    // same sets whatever the order of the members.
+    std::map<Variable *, std::vector<VariablePtr>> neighbours;
+    for (const VariablePtr &member : members) {
+        for (const VariableWeakPtr &equivalent : member->mPimpl->mEquivalentVariables) {
+            VariablePtr equivalentVariable = equivalent.lock();
+            if (equivalentVariable != nullptr) {
+                neighbours[member.get()].push_back(equivalentVariable);
+                neighbours[equivalentVariable.get()].push_back(member);
+            }
+        }
+    }
+    // Breadth first traversal of the equivalences from each member that is
+    // not yet in a set, the first of which refills the original set.
+    std::set<Variable *> visited;
+    for (const VariablePtr &start : members) {
+        if (!visited.insert(start.get()).second) {
+            continue;
+        }
+        EquivalenceSetPtr component = set->mMembers.empty() ? set : createEquivalenceSet();
+        component->mMembers.push_back(start);
+        start->mPimpl->mEquivalenceSet = component;
+        for (size_t next = 0; next < component->mMembers.size(); ++next) {
+            VariablePtr current = component->mMembers.at(next).lock();
+            auto found = neighbours.find(current.get());
+            if (found == neighbours.end()) {
+                continue;
+            }
+            for (const VariablePtr &equivalentVariable : found->second) {
+                if (visited.insert(equivalentVariable.get()).second) {
+                    component->mMembers.push_back(equivalentVariable);
+                    equivalentVariable->mPimpl->mEquivalenceSet = component;
+                }
+            }
+        }
+    }
+}
+
+void cloneEquivalences(const std::vector<VariablePtr> &variables, const std::vector<VariablePtr> &clones)
+{
+    std::unordered_map<const Variable *, VariablePtr> cloneOf;
+    for (size_t i = 0; i < variables.size(); ++i) {
+        cloneOf.emplace(variables.at(i).get(), clones.at(i));
+    }
+    for (size_t i = 0; i < variables.size(); ++i) {
+        const Variable::VariableImpl *original = variables.at(i)->mPimpl;
+        const VariablePtr &clone = clones.at(i);
+        clone->mPimpl->mEquivalentVariables.clear();
+        clone->mPimpl->mMappingIdMap.clear();
+        clone->mPimpl->mConnectionIdMap.clear();
+        for (const VariableWeakPtr &equivalent : original->mEquivalentVariables) {
+            auto found = cloneOf.find(equivalent.lock().get());
+            if (found == cloneOf.end()) {
+                continue;
+            }
+            const VariablePtr &equivalentClone = found->second;
+            clone->mPimpl->mEquivalentVariables.push_back(equivalentClone);
+            auto mappingId = original->mMappingIdMap.find(equivalent);
+            if (mappingId != original->mMappingIdMap.end()) {
+                clone->mPimpl->mMappingIdMap.emplace(equivalentClone, mappingId->second);
+            }
+            auto connectionId = original->mConnectionIdMap.find(equivalent);
+            if (connectionId != original->mConnectionIdMap.end()) {
+                clone->mPimpl->mConnectionIdMap.emplace(equivalentClone, connectionId->second);
+            }
+            Variable::VariableImpl::mergeEquivalenceSets(clone, equivalentClone);
+        }
+    }
 }
 
 VariablePtr Variable::equivalentVariable(size_t index) const
@@ -325,32 +549,37 @@ std::string Variable::VariableImpl::equivalentConnectionId(const VariablePtr &eq
 
 void Variable::setUnits(const std::string &name)
 {
-    mPimpl->mUnits = name;
+    mPimpl->mUnits = InternedString(name);
+    markModified();
 }
 
 void Variable::setUnits(const UnitsPtr &units)
 {
-    mPimpl->mUnits = units->name();
+    mPimpl->mUnits = InternedString(nameSymbol(*units));
+    markModified();
 }
 
-std::string Variable::units() const
+const std::string &Variable::units() const
 {
-    return mPimpl->mUnits;
+    return mPimpl->mUnits.string();
 }
 
 void Variable::setInitialValue(const std::string &initialValue)
 {
     mPimpl->mInitialValue = initialValue;
+    markModified();
 }
 
 void Variable::setInitialValue(double initialValue)
 {
     mPimpl->mInitialValue = convertDoubleToString(initialValue);
+    markModified();
 }
 
 void Variable::setInitialValue(const VariablePtr &variable)
 {
     mPimpl->mInitialValue = variable->name();
+    markModified();
 }
 
 std::string Variable::initialValue() const
@@ -361,6 +590,7 @@ std::string Variable::initialValue() const
 void Variable::setInterfaceType(const std::string &interfaceType)
 {
     mPimpl->mInterfaceType = interfaceType;
+    markModified();
 }
 
 void Variable::setInterfaceType(Variable::InterfaceType interfaceType)
@@ -380,6 +610,8 @@ void Variable::setEquivalenceMappingId(const VariablePtr &variable1, const Varia
     if (variable1->hasEquivalentVariable(variable2) && variable2->hasEquivalentVariable(variable1)) {
         variable1->mPimpl->setEquivalentMappingId(variable2, mappingId);
         variable2->mPimpl->setEquivalentMappingId(variable1, mappingId);
+        variable1->markModified();
+        variable2->markModified();
     }
 }
 
@@ -388,6 +620,8 @@ void Variable::setEquivalenceConnectionId(const VariablePtr &variable1, const Va
     if (variable1->hasEquivalentVariable(variable2) && variable2->hasEquivalentVariable(variable1)) {
         variable1->mPimpl->setEquivalentConnectionId(variable2, connectionId);
         variable2->mPimpl->setEquivalentConnectionId(variable1, connectionId);
+        variable1->markModified();
+        variable2->markModified();
     }
 }
 
@@ -0,0 +1,192 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace libcellml {
+
+/*
+ * Branch-free implementations of exp, log and pow.  They only use
+ * arithmetic, comparisons, selects and integer operations on the bit pattern
+ * of their arguments, so that loops calling them over contiguous arrays can
+ * be vectorised by the compiler for whatever instruction set the library is
+ * built for.  The results of exp and log are within one unit in the last place
+ * of those of the standard library, while the relative error of pow grows
+ * with the magnitude of y * log(x), which is small for the expressions found
+ * in typical models.
+ */
+
+/**
+ * The constant 1.5 * 2^52.  Adding it to a double of magnitude less than
+ * 2^51 rounds the double to the nearest integer, which is then held in the
+ * low bits of the mantissa of the sum.
+ */
+static const double ROUNDING_MAGIC = 6755399441055744.0;
+
+static const double LOG2_E = 1.44269504088896338700e+00;
+static const double LN2_HI = 6.93147180369123816490e-01;
+static const double LN2_LO = 1.90821492927058770002e-10;
+static const double SQRT_2 = 1.41421356237309514547e+00;
+
+/**
+ * @brief Reinterpret the bits of @p value as an integer.
+ *
+ * @param value The value to reinterpret.
+ *
+ * @return The bit pattern of @p value.
+ */
+inline int64_t bitsOf(double value)
+{
+    int64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+/**
+ * @brief Reinterpret the integer @p bits as a double.
+ *
+ * @param bits The bit pattern to reinterpret.
+ *
+ * @return The double with the bit pattern @p bits.
+ */
+inline double doubleOf(int64_t bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Compute e raised to the power @p x.
+ *
+ * @param x The exponent.
+ *
+ * @return The exponential of @p x.
+ */
+inline double vectorExp(double x)
+{
+    // Beyond these bounds the result over- or underflows anyway.  NaN is
+    // clamped too so that the integer arithmetic below stays in range.
+    double clamped = (x > -746.0) ? x : -746.0;
+    clamped = (clamped < 710.0) ? clamped : 710.0;
+
+    // Reduce to x = n * ln(2) + r with |r| <= ln(2) / 2.
+    double shifted = clamped * LOG2_E + ROUNDING_MAGIC;
+    double n = shifted - ROUNDING_MAGIC;
+    int64_t k = bitsOf(shifted) - bitsOf(ROUNDING_MAGIC);
+    double r = (clamped - n * LN2_HI) - n * LN2_LO;
+
+    // Taylor expansion of exp(r), truncated well below double precision.
+    double p = 1.0 / 6227020800.0;
+    p = p * r + 1.0 / 479001600.0;
+    p = p * r + 1.0 / 39916800.0;
+    p = p * r + 1.0 / 3628800.0;
+    p = p * r + 1.0 / 362880.0;
+    p = p * r + 1.0 / 40320.0;
+    p = p * r + 1.0 / 5040.0;
+    p = p * r + 1.0 / 720.0;
+    p = p * r + 1.0 / 120.0;
+    p = p * r + 1.0 / 24.0;
+    p = p * r + 1.0 / 6.0;
+    p = p * r + 0.5;
+    p = p * r + 1.0;
+    p = p * r + 1.0;
+
+    // Scale by 2^k in two steps so that subnormal results and results close
+    // to overflow do not need an out of range exponent.
+    int64_t k1 = k / 2;
+    int64_t k2 = k - k1;
+    double result = p * doubleOf((k1 + 1023) << 52) * doubleOf((k2 + 1023) << 52);
+
+    return (x != x) ? x : result;
+}
+
+/**
+ * @brief Compute the natural logarithm of @p x.
+ *
+ * @param x The argument.
+ *
+ * @return The natural logarithm of @p x.
+ */
+inline double vectorLog(double x)
+{
+    // Bring subnormal arguments into the normal range.
+    bool subnormal = x < std::numeric_limits<double>::min();
+    double scaled = subnormal ? x * 18014398509481984.0 : x;
+    int64_t bits = bitsOf(scaled);
+    int64_t exponent = ((bits >> 52) & 0x7ff) - 1023 - (subnormal ? 54 : 0);
+
+    // Reduce to x = 2^exponent * m with sqrt(2) / 2 <= m < sqrt(2).
+    double m = doubleOf((bits & 0x000fffffffffffffLL) | 0x3ff0000000000000LL);
+    bool large = m > SQRT_2;
+    m = large ? 0.5 * m : m;
+    exponent += large ? 1 : 0;
+    double k = doubleOf(bitsOf(ROUNDING_MAGIC) + exponent) - ROUNDING_MAGIC;
+
+    // log(m) = log(1 + f) = 2 * atanh(s) with s = f / (2 + f).
+    double f = m - 1.0;
+    double s = f / (2.0 + f);
+    double z = s * s;
+    double r = 1.479819860511658591e-01;
+    r = r * z + 1.531383769920937332e-01;
+    r = r * z + 1.818357216161805012e-01;
+    r = r * z + 2.222219843214978396e-01;
+    r = r * z + 2.857142874366239149e-01;
+    r = r * z + 3.999999999940941908e-01;
+    r = r * z + 6.666666666666735130e-01;
+    r = r * z;
+    double halfSquare = 0.5 * f * f;
+    double result = k * LN2_HI - ((halfSquare - (s * (halfSquare + r) + k * LN2_LO)) - f);
+
+    result = (x == std::numeric_limits<double>::infinity()) ? x : result;
+    result = (x == 0.0) ? -std::numeric_limits<double>::infinity() : result;
+    return (x < 0.0) || (x != x) ? std::numeric_limits<double>::quiet_NaN() : result;
+}
+
+/**
+ * @brief Compute @p x raised to the power @p y.
+ *
+ * @param x The base.
+ * @param y The exponent.
+ *
+ * @return @p x raised to the power @p y.
+ */
+inline double vectorPow(double x, double y)
+{
+    double magnitude = std::fabs(x);
+    double result = vectorExp(y * vectorLog(magnitude));
+    result = (magnitude == 1.0) ? 1.0 : result;
+
+    // A negative base only has a real power for integer exponents, whose
+    // parity gives the sign of the result.  Exponents of at least 2^51 in
+    // magnitude are all treated as even integers.
+    bool huge = std::fabs(y) >= 2251799813685248.0;
+    double shifted = y + ROUNDING_MAGIC;
+    bool integer = huge || (shifted - ROUNDING_MAGIC == y);
+    bool odd = !huge && ((bitsOf(shifted) & 1) != 0);
+    double signedResult = odd ? -result : result;
+    signedResult = integer ? signedResult : std::numeric_limits<double>::quiet_NaN();
+    result = (x < 0.0) ? signedResult : result;
+
+    return (y == 0.0) ? 1.0 : result;
+}
+
+} // namespace libcellml
@@ -14,6 +14,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 */
 
+#include "arena.h"
+
 #include "libcellml/when.h"
 
 namespace libcellml {
@@ -30,18 +32,18 @@ struct When::WhenImpl
 };
 
 When::When()
-    : mPimpl(new WhenImpl())
+    : mPimpl(newImpl<WhenImpl>())
 {
 }
 
 When::~When()
 {
-    delete mPimpl;
+    deleteImpl(mPimpl);
 }
 
 When::When(const When &rhs)
     : OrderedEntity(rhs)
-    , mPimpl(new WhenImpl())
+    , mPimpl(newImpl<WhenImpl>())
 {
     mPimpl->mCondition = rhs.mPimpl->mCondition;
     mPimpl->mValue = rhs.mPimpl->mValue;
@@ -69,6 +71,7 @@ void When::swap(When &rhs)
 void When::setCondition(const std::string &condition)
 {
     mPimpl->mCondition = condition;
+    markModified();
 }
 
 std::string When::condition() const
@@ -79,6 +82,7 @@ std::string When::condition() const
 void When::setValue(const std::string &value)
 {
     mPimpl->mValue = value;
+    markModified();
 }
 
 std::string When::value() const
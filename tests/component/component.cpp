@@ -497,3 +497,60 @@ TEST(Component, constructors)
     libcellml::ComponentPtr c3 = std::move(c2);
     EXPECT_EQ("my_name", c3->name());
 }
+
+TEST(Component, lookUpByName)
+{
+    libcellml::ComponentPtr c = std::make_shared<libcellml::Component>();
+    libcellml::VariablePtr v1 = std::make_shared<libcellml::Variable>();
+    libcellml::VariablePtr v2 = std::make_shared<libcellml::Variable>();
+    v1->setName("shared_name");
+    v2->setName(std::string("shared") + "_name");
+    v1->setUnits("second");
+    v2->setUnits(std::string("sec") + "ond");
+    c->addVariable(v1);
+    c->addVariable(v2);
+
+    // Equal names and units are stored once, and read without a copy.
+    EXPECT_EQ(&v1->name(), &v2->name());
+    EXPECT_EQ(&v1->units(), &v2->units());
+    EXPECT_EQ(v1, c->variable("shared_name"));
+    EXPECT_EQ(nullptr, c->variable("a_name_nothing_else_has"));
+    EXPECT_FALSE(c->hasVariable("another_name_nothing_else_has"));
+
+    v1->setName("renamed");
+    EXPECT_EQ("renamed", v1->name());
+    EXPECT_EQ("shared_name", v2->name());
+    EXPECT_EQ(v2, c->variable("shared_name"));
+    EXPECT_EQ(v1, c->variable("renamed"));
+
+    v2->setName("");
+    EXPECT_EQ("", v2->name());
+    EXPECT_EQ(nullptr, c->variable("shared_name"));
+}
+
+TEST(Component, renameManyTimes)
+{
+    libcellml::ComponentPtr c = std::make_shared<libcellml::Component>();
+    libcellml::VariablePtr v1 = std::make_shared<libcellml::Variable>();
+    libcellml::VariablePtr v2 = std::make_shared<libcellml::Variable>();
+    v2->setName("kept_name");
+    c->addVariable(v1);
+    c->addVariable(v2);
+
+    // The intermediate names are released, and may be reused for later
+    // names, without affecting the names still in use.
+    for (size_t i = 0; i < 10000; ++i) {
+        v1->setName("name_" + std::to_string(i));
+        v1->setUnits("units_" + std::to_string(i));
+        EXPECT_EQ(v1, c->variable("name_" + std::to_string(i)));
+        EXPECT_EQ("units_" + std::to_string(i), v1->units());
+    }
+    EXPECT_EQ(nullptr, c->variable("name_0"));
+    EXPECT_EQ(v2, c->variable("kept_name"));
+    EXPECT_EQ("kept_name", v2->name());
+
+    libcellml::Variable copy(*v2);
+    v2->setName("renamed");
+    EXPECT_EQ("kept_name", copy.name());
+    EXPECT_EQ("renamed", v2->name());
+}
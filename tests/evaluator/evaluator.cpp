@@ -0,0 +1,785 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "gtest/gtest.h"
+
+#include "test_resources.h"
+#include "test_utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <libcellml>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+TEST(Evaluator, exponentialDecay)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr c = std::make_shared<libcellml::Component>();
+    c->setName("main");
+    m->addComponent(c);
+    createVariable(c, "t");
+    createVariable(c, "x", "1");
+    createVariable(c, "k", "2");
+    createVariable(c, "y");
+    createVariable(c, "k2");
+    c->setMath(mathStart
+               + "<apply><eq/><apply><diff/><bvar><ci>t</ci></bvar><ci>x</ci></apply>"
+                 "<apply><minus/><apply><times/><ci>k</ci><ci>x</ci></apply></apply></apply>"
+                 "<apply><eq/><ci>y</ci><apply><times/><ci>k2</ci><ci>x</ci></apply></apply>"
+                 "<apply><eq/><ci>k2</ci><apply><power/><ci>k</ci><cn cellml:units=\"dimensionless\">2</cn></apply></apply>"
+               + mathEnd);
+
+    libcellml::Evaluator e;
+    e.processModel(m);
+
+    EXPECT_EQ(size_t(0), e.errorCount());
+    EXPECT_TRUE(e.isValid());
+    EXPECT_EQ("t", e.voi()->name());
+    EXPECT_EQ(size_t(1), e.stateCount());
+    EXPECT_EQ("x", e.state(0)->name());
+    EXPECT_EQ(nullptr, e.state(1));
+    EXPECT_EQ(size_t(3), e.variableCount());
+    EXPECT_EQ("k", e.variable(0)->name());
+    EXPECT_EQ("k2", e.variable(1)->name());
+    EXPECT_EQ("y", e.variable(2)->name());
+    EXPECT_EQ(nullptr, e.variable(3));
+
+    std::vector<double> states(e.stateCount());
+    std::vector<double> rates(e.stateCount());
+    std::vector<double> variables(e.variableCount());
+    e.initialiseStatesAndConstants(states.data(), variables.data());
+    EXPECT_EQ(1.0, states.at(0));
+    EXPECT_EQ(2.0, variables.at(0));
+
+    e.computeComputedConstants(variables.data());
+    EXPECT_EQ(4.0, variables.at(1));
+
+    states.at(0) = 3.0;
+    e.computeRates(0.0, states.data(), rates.data(), variables.data());
+    EXPECT_EQ(-6.0, rates.at(0));
+
+    e.computeVariables(0.0, states.data(), rates.data(), variables.data());
+    EXPECT_EQ(12.0, variables.at(2));
+}
+
+TEST(Evaluator, equivalentVariablesAndPiecewise)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr c1 = std::make_shared<libcellml::Component>();
+    libcellml::ComponentPtr c2 = std::make_shared<libcellml::Component>();
+    c1->setName("c1");
+    c2->setName("c2");
+    m->addComponent(c1);
+    c1->addComponent(c2);
+    libcellml::VariablePtr a1 = createVariable(c1, "a", "-3");
+    libcellml::VariablePtr b1 = createVariable(c1, "b");
+    libcellml::VariablePtr a2 = createVariable(c2, "a");
+    libcellml::VariablePtr b2 = createVariable(c2, "b");
+    libcellml::Variable::addEquivalence(a1, a2);
+    libcellml::Variable::addEquivalence(b1, b2);
+    c2->setMath(mathStart
+                + "<apply><eq/><ci>b</ci>"
+                  "<piecewise>"
+                  "<piece><apply><minus/><ci>a</ci></apply><apply><lt/><ci>a</ci><cn cellml:units=\"dimensionless\">0</cn></apply></piece>"
+                  "<otherwise><ci>a</ci></otherwise>"
+                  "</piecewise></apply>"
+                + mathEnd);
+
+    libcellml::Evaluator e;
+    e.processModel(m);
+
+    EXPECT_EQ(size_t(0), e.errorCount());
+    EXPECT_EQ(nullptr, e.voi());
+    EXPECT_EQ(size_t(0), e.stateCount());
+    EXPECT_EQ(size_t(2), e.variableCount());
+
+    std::vector<double> variables(e.variableCount());
+    e.initialiseStatesAndConstants(nullptr, variables.data());
+    e.computeComputedConstants(variables.data());
+    EXPECT_EQ(-3.0, variables.at(0));
+    EXPECT_EQ(3.0, variables.at(1));
+}
+
+TEST(Evaluator, invalidModels)
+{
+    const std::vector<std::string> expectedErrors = {
+        "State variable 'x' in component 'main' does not have an initial value.",
+        "Variable 'y' in component 'main' is not computed by any equation and does not have an initial value.",
+    };
+
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr c = std::make_shared<libcellml::Component>();
+    c->setName("main");
+    m->addComponent(c);
+    createVariable(c, "t");
+    createVariable(c, "x");
+    createVariable(c, "y");
+    c->setMath(mathStart
+               + "<apply><eq/><apply><diff/><bvar><ci>t</ci></bvar><ci>x</ci></apply><ci>y</ci></apply>"
+               + mathEnd);
+
+    libcellml::Evaluator e;
+    e.processModel(m);
+
+    EXPECT_FALSE(e.isValid());
+    EXPECT_EQ(expectedErrors.size(), e.errorCount());
+    for (size_t i = 0; i < e.errorCount(); ++i) {
+        EXPECT_EQ(expectedErrors.at(i), e.error(i)->description());
+    }
+}
+
+TEST(Evaluator, algebraicLoop)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr c = std::make_shared<libcellml::Component>();
+    c->setName("main");
+    m->addComponent(c);
+    createVariable(c, "x");
+    createVariable(c, "y");
+    c->setMath(mathStart
+               + "<apply><eq/><ci>x</ci><ci>y</ci></apply>"
+                 "<apply><eq/><ci>y</ci><ci>x</ci></apply>"
+               + mathEnd);
+
+    libcellml::Evaluator e;
+    e.processModel(m);
+
+    EXPECT_EQ(size_t(1), e.errorCount());
+    EXPECT_EQ("Variable 'x' in component 'main' is part of an algebraic loop, which cannot be evaluated.", e.error(0)->description());
+    EXPECT_EQ(libcellml::Error::Kind::MATHML, e.error(0)->kind());
+}
+
+TEST(Evaluator, importedComponent)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr c = std::make_shared<libcellml::Component>();
+    libcellml::ImportSourcePtr imp = std::make_shared<libcellml::ImportSource>();
+    imp->setUrl("some-other-model.xml");
+    c->setName("imported");
+    c->setSourceComponent(imp, "a_component");
+    m->addComponent(c);
+
+    libcellml::Evaluator e;
+    e.processModel(m);
+
+    EXPECT_EQ(size_t(1), e.errorCount());
+    EXPECT_EQ("Component 'imported' is imported and cannot be evaluated until its import is resolved.", e.error(0)->description());
+    EXPECT_EQ(libcellml::Error::Kind::IMPORT, e.error(0)->kind());
+}
+
+TEST(Evaluator, ohara_rudy)
+{
+    std::ifstream t(TestResources::location(
+        TestResources::CELLML_ORD_MODEL_RESOURCE));
+    std::stringstream buffer;
+    buffer << t.rdbuf();
+
+    libcellml::Parser p;
+    libcellml::ModelPtr model = p.parseModel(buffer.str());
+
+    libcellml::Evaluator e;
+    e.processModel(model);
+
+    EXPECT_EQ(size_t(0), e.errorCount());
+    EXPECT_EQ("time", e.voi()->name());
+    EXPECT_EQ(size_t(41), e.stateCount());
+
+    std::vector<double> states(e.stateCount());
+    std::vector<double> rates(e.stateCount());
+    std::vector<double> variables(e.variableCount());
+    e.initialiseStatesAndConstants(states.data(), variables.data());
+    e.computeComputedConstants(variables.data());
+    e.computeRates(0.0, states.data(), rates.data(), variables.data());
+    for (double rate : rates) {
+        EXPECT_TRUE(std::isfinite(rate));
+    }
+
+    // The membrane potential and concentrations are not gating variables,
+    // but all the gates of the ion channels are.
+    EXPECT_EQ(size_t(33), e.gatingStateCount());
+    EXPECT_FALSE(e.isGatingState(0));
+    std::vector<double> coefficients(2 * e.stateCount());
+    e.computeGatingCoefficients(0.0, states.data(), rates.data(), variables.data(), coefficients.data());
+    for (size_t i = 0; i < e.stateCount(); ++i) {
+        if (e.isGatingState(i)) {
+            EXPECT_NEAR(rates.at(i), coefficients.at(2 * i) + coefficients.at(2 * i + 1) * states.at(i), 1.0e-9 * (1.0 + std::fabs(rates.at(i))));
+        }
+    }
+}
+
+TEST(Evaluator, gatingStates)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr c = std::make_shared<libcellml::Component>();
+    c->setName("main");
+    m->addComponent(c);
+    createVariable(c, "t");
+    createVariable(c, "x", "0.5");
+    createVariable(c, "y", "2");
+    createVariable(c, "alpha", "3");
+    createVariable(c, "beta");
+    c->setMath(mathStart
+               + "<apply><eq/><apply><diff/><bvar><ci>t</ci></bvar><ci>x</ci></apply>"
+                 "<apply><minus/>"
+                 "<apply><times/><ci>alpha</ci><apply><minus/><cn cellml:units=\"dimensionless\">1</cn><ci>x</ci></apply></apply>"
+                 "<apply><times/><ci>beta</ci><ci>x</ci></apply>"
+                 "</apply></apply>"
+                 "<apply><eq/><ci>beta</ci><apply><exp/><ci>y</ci></apply></apply>"
+                 "<apply><eq/><apply><diff/><bvar><ci>t</ci></bvar><ci>y</ci></apply>"
+                 "<apply><times/><ci>y</ci><ci>y</ci></apply></apply>"
+               + mathEnd);
+
+    libcellml::Evaluator e;
+    e.processModel(m);
+
+    EXPECT_EQ(size_t(0), e.errorCount());
+    EXPECT_EQ(size_t(2), e.stateCount());
+    EXPECT_EQ(size_t(1), e.gatingStateCount());
+    EXPECT_TRUE(e.isGatingState(0));
+    EXPECT_FALSE(e.isGatingState(1));
+    EXPECT_FALSE(e.isGatingState(2));
+
+    std::vector<double> states(e.stateCount());
+    std::vector<double> rates(e.stateCount());
+    std::vector<double> variables(e.variableCount());
+    std::vector<double> coefficients(2 * e.stateCount(), -1.0);
+    e.initialiseStatesAndConstants(states.data(), variables.data());
+    e.computeComputedConstants(variables.data());
+    e.computeRates(0.0, states.data(), rates.data(), variables.data());
+    e.computeGatingCoefficients(0.0, states.data(), rates.data(), variables.data(), coefficients.data());
+
+    EXPECT_DOUBLE_EQ(3.0, coefficients.at(0));
+    EXPECT_DOUBLE_EQ(-3.0 - std::exp(2.0), coefficients.at(1));
+    EXPECT_EQ(-1.0, coefficients.at(2));
+    EXPECT_EQ(-1.0, coefficients.at(3));
+}
+
+TEST(Evaluator, batchElementaryFunctions)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr c = std::make_shared<libcellml::Component>();
+    c->setName("main");
+    m->addComponent(c);
+    createVariable(c, "x", "0");
+    createVariable(c, "e");
+    createVariable(c, "l");
+    createVariable(c, "p");
+    c->setMath(mathStart
+               + "<apply><eq/><ci>e</ci><apply><exp/><ci>x</ci></apply></apply>"
+                 "<apply><eq/><ci>l</ci><apply><ln/><ci>x</ci></apply></apply>"
+                 "<apply><eq/><ci>p</ci><apply><power/><ci>x</ci><cn cellml:units=\"dimensionless\">3</cn></apply></apply>"
+               + mathEnd);
+
+    libcellml::Evaluator e;
+    e.processModel(m);
+    EXPECT_EQ(size_t(0), e.errorCount());
+    EXPECT_EQ(size_t(4), e.variableCount());
+
+    const std::vector<double> values = {-800.0, -745.5, -20.0, -1.5, -0.0, 0.0, 1.0e-310, 0.25, 1.0, 3.5, 700.0, 710.0, INFINITY, NAN};
+    const size_t instanceCount = values.size();
+    std::vector<double> variables(4 * instanceCount);
+    e.initialiseStatesAndConstantsBatch(nullptr, variables.data(), instanceCount);
+    std::copy(values.begin(), values.end(), variables.begin());
+    e.computeComputedConstantsBatch(variables.data(), instanceCount);
+
+    for (size_t j = 0; j < instanceCount; ++j) {
+        double x = values.at(j);
+        const double expected[] = {std::exp(x), std::log(x), std::pow(x, 3.0)};
+        for (size_t i = 0; i < 3; ++i) {
+            double value = variables.at((i + 1) * instanceCount + j);
+            if (std::isnan(expected[i]) || std::isinf(expected[i])) {
+                EXPECT_EQ(std::isnan(expected[i]), std::isnan(value));
+                EXPECT_EQ(std::isinf(expected[i]), std::isinf(value));
+            } else {
+                EXPECT_NEAR(expected[i], value, 1.0e-14 * std::fabs(expected[i]));
+            }
+        }
+    }
+}
+
+TEST(Evaluator, batchOharaRudy)
+{
+    std::ifstream t(TestResources::location(
+        TestResources::CELLML_ORD_MODEL_RESOURCE));
+    std::stringstream buffer;
+    buffer << t.rdbuf();
+
+    libcellml::Parser p;
+    libcellml::ModelPtr model = p.parseModel(buffer.str());
+
+    libcellml::Evaluator e;
+    e.processModel(model);
+
+    // Enough instances for a partial block after the full ones.
+    const size_t instanceCount = 100;
+    const size_t stateCount = e.stateCount();
+    const size_t variableCount = e.variableCount();
+    std::vector<double> states(stateCount * instanceCount);
+    std::vector<double> rates(stateCount * instanceCount);
+    std::vector<double> variables(variableCount * instanceCount);
+    std::vector<double> coefficients(2 * stateCount * instanceCount);
+    e.initialiseStatesAndConstantsBatch(states.data(), variables.data(), instanceCount);
+    for (size_t j = 0; j < instanceCount; ++j) {
+        // Sweep the membrane potential across the instances, avoiding the
+        // removable singularities of the current equations at zero.
+        states.at(j) = -90.25 + static_cast<double>(j);
+    }
+    e.computeComputedConstantsBatch(variables.data(), instanceCount);
+    e.computeRatesBatch(1.0, states.data(), rates.data(), variables.data(), instanceCount);
+    e.computeVariablesBatch(1.0, states.data(), rates.data(), variables.data(), instanceCount);
+    e.computeGatingCoefficientsBatch(1.0, states.data(), rates.data(), variables.data(), coefficients.data(), instanceCount);
+
+    std::vector<double> instanceStates(stateCount);
+    std::vector<double> instanceRates(stateCount);
+    std::vector<double> instanceVariables(variableCount);
+    std::vector<double> instanceCoefficients(2 * stateCount);
+    for (size_t j = 0; j < instanceCount; ++j) {
+        e.initialiseStatesAndConstants(instanceStates.data(), instanceVariables.data());
+        instanceStates.at(0) = -90.25 + static_cast<double>(j);
+        e.computeComputedConstants(instanceVariables.data());
+        e.computeRates(1.0, instanceStates.data(), instanceRates.data(), instanceVariables.data());
+        e.computeVariables(1.0, instanceStates.data(), instanceRates.data(), instanceVariables.data());
+        e.computeGatingCoefficients(1.0, instanceStates.data(), instanceRates.data(), instanceVariables.data(), instanceCoefficients.data());
+        for (size_t i = 0; i < stateCount; ++i) {
+            EXPECT_NEAR(instanceRates.at(i), rates.at(i * instanceCount + j), 1.0e-12 * (1.0 + std::fabs(instanceRates.at(i))));
+            if (e.isGatingState(i)) {
+                EXPECT_NEAR(instanceCoefficients.at(2 * i + 1), coefficients.at((2 * i + 1) * instanceCount + j), 1.0e-12 * (1.0 + std::fabs(instanceCoefficients.at(2 * i + 1))));
+            }
+        }
+        for (size_t i = 0; i < variableCount; ++i) {
+            EXPECT_NEAR(instanceVariables.at(i), variables.at(i * instanceCount + j), 1.0e-12 * (1.0 + std::fabs(instanceVariables.at(i))));
+        }
+    }
+}
+
+TEST(Evaluator, lookupTables)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr c = std::make_shared<libcellml::Component>();
+    c->setName("main");
+    m->addComponent(c);
+    createVariable(c, "t");
+    libcellml::VariablePtr v = createVariable(c, "v", "1.234");
+    createVariable(c, "k", "3");
+    createVariable(c, "y");
+    createVariable(c, "z");
+    createVariable(c, "w");
+    c->setMath(mathStart
+               + "<apply><eq/><apply><diff/><bvar><ci>t</ci></bvar><ci>v</ci></apply><cn cellml:units=\"dimensionless\">1</cn></apply>"
+                 "<apply><eq/><ci>y</ci><apply><plus/>"
+                 "<apply><exp/><apply><divide/><ci>v</ci><cn cellml:units=\"dimensionless\">10</cn></apply></apply>"
+                 "<apply><times/><cn cellml:units=\"dimensionless\">2</cn><ci>v</ci></apply>"
+                 "</apply></apply>"
+                 "<apply><eq/><ci>z</ci><apply><times/><ci>k</ci><apply><exp/><ci>v</ci></apply></apply></apply>"
+                 "<apply><eq/><ci>w</ci><piecewise>"
+                 "<piece><apply><exp/><ci>v</ci></apply><apply><lt/><ci>v</ci><cn cellml:units=\"dimensionless\">0</cn></apply></piece>"
+                 "<otherwise><cn cellml:units=\"dimensionless\">1</cn></otherwise>"
+                 "</piecewise></apply>"
+               + mathEnd);
+
+    libcellml::Evaluator e;
+    e.setLookupTableVariable(v, -10.0, 10.0, 0.1);
+    EXPECT_EQ(v, e.lookupTableVariable());
+    e.processModel(m);
+
+    // The whole of y, and the exponential of v shared by z and w are
+    // tabulated.
+    EXPECT_EQ(size_t(0), e.errorCount());
+    EXPECT_EQ(size_t(2), e.lookupTableCount());
+    // The error of linear interpolation is about step^2 / 8 * |f''|.
+    EXPECT_GT(e.lookupTableError(0), 0.0);
+    EXPECT_LT(e.lookupTableError(0), 0.01 / 8.0 * std::exp(1.0) / 100.0 * 1.01);
+    EXPECT_LT(e.lookupTableError(1), 0.01 / 8.0 * std::exp(10.0) * 1.01);
+    EXPECT_EQ(0.0, e.lookupTableError(2));
+
+    std::vector<double> states(e.stateCount());
+    std::vector<double> rates(e.stateCount());
+    std::vector<double> variables(e.variableCount());
+    e.initialiseStatesAndConstants(states.data(), variables.data());
+    e.computeComputedConstants(variables.data());
+    e.computeRates(0.0, states.data(), rates.data(), variables.data());
+    e.computeVariables(0.0, states.data(), rates.data(), variables.data());
+    EXPECT_NEAR(std::exp(0.1234) + 2.468, variables.at(1), e.lookupTableError(0));
+    EXPECT_NEAR(3.0 * std::exp(1.234), variables.at(2), 3.0 * e.lookupTableError(1));
+    EXPECT_EQ(1.0, variables.at(3));
+
+    // Outside of the tabulated range the expressions are evaluated exactly.
+    states.at(0) = -20.0;
+    e.computeVariables(0.0, states.data(), rates.data(), variables.data());
+    EXPECT_DOUBLE_EQ(std::exp(-2.0) - 40.0, variables.at(1));
+    EXPECT_DOUBLE_EQ(std::exp(-20.0), variables.at(3));
+
+    e.removeLookupTableVariable();
+    EXPECT_EQ(nullptr, e.lookupTableVariable());
+    e.processModel(m);
+    EXPECT_EQ(size_t(0), e.lookupTableCount());
+}
+
+TEST(Evaluator, invalidLookupTables)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr c = std::make_shared<libcellml::Component>();
+    c->setName("main");
+    m->addComponent(c);
+    libcellml::VariablePtr v = createVariable(c, "v", "1");
+
+    libcellml::Evaluator e;
+    e.setLookupTableVariable(v, 1.0, 0.0, 0.1);
+    e.processModel(m);
+    EXPECT_EQ(size_t(1), e.errorCount());
+    EXPECT_EQ("The lookup table range must not be empty and its step must be greater than zero.", e.error(0)->description());
+
+    e.setLookupTableVariable(v, 0.0, std::numeric_limits<double>::infinity(), 0.1);
+    e.processModel(m);
+    EXPECT_EQ(size_t(1), e.errorCount());
+    EXPECT_EQ("The lookup table range and step must be finite.", e.error(0)->description());
+
+    e.setLookupTableVariable(v, 0.0, 1.0, std::numeric_limits<double>::quiet_NaN());
+    e.processModel(m);
+    EXPECT_EQ(size_t(1), e.errorCount());
+    EXPECT_EQ("The lookup table range and step must be finite.", e.error(0)->description());
+
+    e.setLookupTableVariable(v, -1.0e300, 1.0e300, 1.0e-300);
+    e.processModel(m);
+    EXPECT_EQ(size_t(1), e.errorCount());
+    EXPECT_EQ("The lookup table must not have more than 1048576 points.", e.error(0)->description());
+
+    libcellml::VariablePtr u = std::make_shared<libcellml::Variable>();
+    u->setName("u");
+    e.setLookupTableVariable(u, 0.0, 1.0, 0.1);
+    e.processModel(m);
+    EXPECT_EQ(size_t(1), e.errorCount());
+    EXPECT_EQ("Lookup table variable 'u' is not part of the model.", e.error(0)->description());
+    EXPECT_EQ(libcellml::Error::Kind::VARIABLE, e.error(0)->kind());
+}
+
+TEST(Evaluator, lookupTablesOharaRudy)
+{
+    std::ifstream t(TestResources::location(
+        TestResources::CELLML_ORD_MODEL_RESOURCE));
+    std::stringstream buffer;
+    buffer << t.rdbuf();
+
+    libcellml::Parser p;
+    libcellml::ModelPtr model = p.parseModel(buffer.str());
+
+    libcellml::Evaluator e;
+    e.processModel(model);
+    libcellml::Evaluator tabulated;
+    tabulated.setLookupTableVariable(model->component("membrane")->variable("v"), -100.0, 100.0, 0.01);
+    tabulated.processModel(model);
+    EXPECT_EQ(size_t(0), tabulated.errorCount());
+    EXPECT_LT(size_t(30), tabulated.lookupTableCount());
+
+    std::vector<double> states(e.stateCount());
+    std::vector<double> rates(e.stateCount());
+    std::vector<double> variables(e.variableCount());
+    std::vector<double> tabulatedRates(e.stateCount());
+    std::vector<double> tabulatedVariables(e.variableCount());
+    e.initialiseStatesAndConstants(states.data(), variables.data());
+    e.computeComputedConstants(variables.data());
+    tabulated.initialiseStatesAndConstants(states.data(), tabulatedVariables.data());
+    tabulated.computeComputedConstants(tabulatedVariables.data());
+    // Use a potential between two tabulated values.
+    states.at(0) = -52.345;
+    e.computeRates(0.0, states.data(), rates.data(), variables.data());
+    tabulated.computeRates(0.0, states.data(), tabulatedRates.data(), tabulatedVariables.data());
+    for (size_t i = 0; i < e.stateCount(); ++i) {
+        EXPECT_NEAR(rates.at(i), tabulatedRates.at(i), 1.0e-4 * (1.0e-6 + std::fabs(rates.at(i))));
+    }
+}
+
+TEST(Evaluator, jacobian)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr c = std::make_shared<libcellml::Component>();
+    c->setName("main");
+    m->addComponent(c);
+    createVariable(c, "t");
+    createVariable(c, "x", "0.5");
+    createVariable(c, "y", "2");
+    createVariable(c, "w", "0");
+    createVariable(c, "z");
+    c->setMath(mathStart
+               + "<apply><eq/><apply><diff/><bvar><ci>t</ci></bvar><ci>x</ci></apply>"
+                 "<apply><plus/><apply><times/><ci>x</ci><ci>y</ci></apply><apply><sin/><ci>x</ci></apply></apply></apply>"
+                 "<apply><eq/><apply><diff/><bvar><ci>t</ci></bvar><ci>y</ci></apply>"
+                 "<apply><minus/><apply><exp/><ci>z</ci></apply><apply><power/><ci>y</ci><cn cellml:units=\"dimensionless\">2</cn></apply></apply></apply>"
+                 "<apply><eq/><ci>z</ci><apply><times/><cn cellml:units=\"dimensionless\">2</cn><ci>x</ci></apply></apply>"
+                 "<apply><eq/><apply><diff/><bvar><ci>t</ci></bvar><ci>w</ci></apply>"
+                 "<piecewise>"
+                 "<piece><apply><divide/><ci>w</ci><ci>y</ci></apply><apply><lt/><ci>x</ci><cn cellml:units=\"dimensionless\">1</cn></apply></piece>"
+                 "<otherwise><cn cellml:units=\"dimensionless\">1</cn></otherwise>"
+                 "</piecewise></apply>"
+               + mathEnd);
+
+    libcellml::Evaluator e;
+    e.processModel(m);
+    EXPECT_EQ(size_t(0), e.errorCount());
+
+    // The condition of the piecewise rate of w is considered constant.
+    const std::vector<std::pair<size_t, size_t>> expectedEntries = {
+        {0, 0}, {0, 1}, {1, 0}, {1, 1}, {2, 1}, {2, 2}};
+    EXPECT_EQ(expectedEntries.size(), e.jacobianEntryCount());
+    for (size_t i = 0; i < e.jacobianEntryCount(); ++i) {
+        EXPECT_EQ(expectedEntries.at(i).first, e.jacobianEntryRow(i));
+        EXPECT_EQ(expectedEntries.at(i).second, e.jacobianEntryColumn(i));
+    }
+    EXPECT_EQ(e.stateCount(), e.jacobianEntryRow(6));
+    EXPECT_EQ(e.stateCount(), e.jacobianEntryColumn(6));
+
+    std::vector<double> states(e.stateCount());
+    std::vector<double> rates(e.stateCount());
+    std::vector<double> variables(e.variableCount());
+    std::vector<double> jacobian(e.jacobianEntryCount());
+    e.initialiseStatesAndConstants(states.data(), variables.data());
+    states.at(2) = 3.0;
+    e.computeRates(0.0, states.data(), rates.data(), variables.data());
+    e.computeJacobian(0.0, states.data(), rates.data(), variables.data(), jacobian.data());
+
+    EXPECT_DOUBLE_EQ(2.0 + std::cos(0.5), jacobian.at(0));
+    EXPECT_DOUBLE_EQ(0.5, jacobian.at(1));
+    EXPECT_DOUBLE_EQ(2.0 * std::exp(1.0), jacobian.at(2));
+    EXPECT_DOUBLE_EQ(-4.0, jacobian.at(3));
+    EXPECT_DOUBLE_EQ(-0.75, jacobian.at(4));
+    EXPECT_DOUBLE_EQ(0.5, jacobian.at(5));
+}
+
+TEST(Evaluator, jacobianOharaRudy)
+{
+    std::ifstream t(TestResources::location(
+        TestResources::CELLML_ORD_MODEL_RESOURCE));
+    std::stringstream buffer;
+    buffer << t.rdbuf();
+
+    libcellml::Parser p;
+    libcellml::ModelPtr model = p.parseModel(buffer.str());
+
+    libcellml::Evaluator e;
+    e.processModel(model);
+    EXPECT_EQ(size_t(0), e.errorCount());
+
+    const size_t stateCount = e.stateCount();
+    EXPECT_LT(e.jacobianEntryCount(), stateCount * stateCount / 4);
+
+    std::vector<double> states(stateCount);
+    std::vector<double> rates(stateCount);
+    std::vector<double> variables(e.variableCount());
+    std::vector<double> jacobian(e.jacobianEntryCount());
+    e.initialiseStatesAndConstants(states.data(), variables.data());
+    e.computeComputedConstants(variables.data());
+    states.at(0) = -52.345;
+    e.computeRates(3.0, states.data(), rates.data(), variables.data());
+    e.computeJacobian(3.0, states.data(), rates.data(), variables.data(), jacobian.data());
+
+    // Compare against central differences.
+    std::vector<double> differences(stateCount * stateCount);
+    for (size_t column = 0; column < stateCount; ++column) {
+        std::vector<double> forward = states;
+        std::vector<double> backward = states;
+        std::vector<double> forwardRates(stateCount);
+        std::vector<double> backwardRates(stateCount);
+        std::vector<double> work = variables;
+        double step = 1.0e-6 * std::max(1.0, std::fabs(states.at(column)));
+        forward.at(column) += step;
+        backward.at(column) -= step;
+        e.computeRates(3.0, forward.data(), forwardRates.data(), work.data());
+        e.computeRates(3.0, backward.data(), backwardRates.data(), work.data());
+        for (size_t row = 0; row < stateCount; ++row) {
+            differences.at(row * stateCount + column) = (forwardRates.at(row) - backwardRates.at(row)) / (2.0 * step);
+        }
+    }
+    std::vector<bool> structural(stateCount * stateCount, false);
+    for (size_t i = 0; i < e.jacobianEntryCount(); ++i) {
+        size_t position = e.jacobianEntryRow(i) * stateCount + e.jacobianEntryColumn(i);
+        structural.at(position) = true;
+        EXPECT_NEAR(differences.at(position), jacobian.at(i), 1.0e-4 * std::fabs(differences.at(position)) + 1.0e-7);
+    }
+    for (size_t i = 0; i < structural.size(); ++i) {
+        if (!structural.at(i)) {
+            EXPECT_EQ(0.0, differences.at(i));
+        }
+    }
+}
+
+TEST(Evaluator, sharedSubexpressions)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr c = std::make_shared<libcellml::Component>();
+    c->setName("main");
+    m->addComponent(c);
+    createVariable(c, "t");
+    createVariable(c, "v", "1.5");
+    createVariable(c, "a");
+    createVariable(c, "b");
+    createVariable(c, "c");
+    const std::string gate = "<apply><exp/><apply><divide/><apply><minus/><ci>v</ci></apply><cn cellml:units=\"dimensionless\">25</cn></apply></apply>";
+    c->setMath(mathStart
+               + "<apply><eq/><apply><diff/><bvar><ci>t</ci></bvar><ci>v</ci></apply><cn cellml:units=\"dimensionless\">1</cn></apply>"
+                 "<apply><eq/><ci>a</ci><apply><times/>"
+               + gate + "<cn cellml:units=\"dimensionless\">2</cn></apply></apply>"
+                        "<apply><eq/><ci>b</ci><apply><plus/>"
+               + gate + "<ci>v</ci></apply></apply>"
+                        "<apply><eq/><ci>c</ci><apply><times/><cn cellml:units=\"dimensionless\">3</cn>"
+               + gate + "</apply></apply>"
+               + mathEnd);
+
+    libcellml::Evaluator e;
+    e.processModel(m);
+    EXPECT_EQ(size_t(0), e.errorCount());
+    // The negation, division and exponential are only computed once.
+    EXPECT_EQ(size_t(6), e.removedOperationCount());
+
+    std::vector<double> states(e.stateCount());
+    std::vector<double> rates(e.stateCount());
+    std::vector<double> variables(e.variableCount());
+    e.initialiseStatesAndConstants(states.data(), variables.data());
+    e.computeRates(0.0, states.data(), rates.data(), variables.data());
+    e.computeVariables(0.0, states.data(), rates.data(), variables.data());
+    double expected = std::exp(-1.5 / 25.0);
+    EXPECT_EQ(expected * 2.0, variables.at(0));
+    EXPECT_EQ(expected + 1.5, variables.at(1));
+    EXPECT_EQ(3.0 * expected, variables.at(2));
+}
+
+TEST(Evaluator, constantFolding)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr c = std::make_shared<libcellml::Component>();
+    c->setName("main");
+    m->addComponent(c);
+    createVariable(c, "t");
+    createVariable(c, "v", "1.5");
+    createVariable(c, "k", "3");
+    createVariable(c, "x");
+    createVariable(c, "y");
+    createVariable(c, "z");
+    createVariable(c, "w");
+    c->setMath(mathStart
+               + "<apply><eq/><apply><diff/><bvar><ci>t</ci></bvar><ci>v</ci></apply><cn cellml:units=\"dimensionless\">1</cn></apply>"
+                 "<apply><eq/><ci>x</ci><apply><times/>"
+                 "<apply><plus/><cn cellml:units=\"dimensionless\">2</cn><cn cellml:units=\"dimensionless\">3</cn></apply>"
+                 "<ci>v</ci></apply></apply>"
+                 "<apply><eq/><ci>y</ci><piecewise>"
+                 "<piece><ci>v</ci><apply><lt/><cn cellml:units=\"dimensionless\">1</cn><cn cellml:units=\"dimensionless\">0</cn></apply></piece>"
+                 "<otherwise><apply><times/><ci>v</ci><apply><divide/><pi/><cn cellml:units=\"dimensionless\">2</cn></apply></apply></otherwise>"
+                 "</piecewise></apply>"
+                 "<apply><eq/><ci>z</ci><apply><times/><apply><times/><ci>k</ci><ci>k</ci></apply><ci>v</ci></apply></apply>"
+                 "<apply><eq/><ci>w</ci><apply><plus/><ci>k</ci><cn cellml:units=\"dimensionless\">1</cn></apply></apply>"
+               + mathEnd);
+
+    // The sum, the condition of the piecewise and its selection, and the
+    // division are folded.
+    libcellml::Evaluator e;
+    EXPECT_FALSE(e.foldConstantVariables());
+    e.processModel(m);
+    EXPECT_EQ(size_t(0), e.errorCount());
+    EXPECT_EQ(size_t(4), e.removedOperationCount());
+
+    std::vector<double> states(e.stateCount());
+    std::vector<double> rates(e.stateCount());
+    std::vector<double> variables(e.variableCount());
+    e.initialiseStatesAndConstants(states.data(), variables.data());
+    e.computeComputedConstants(variables.data());
+    e.computeVariables(0.0, states.data(), rates.data(), variables.data());
+    EXPECT_EQ("k", e.variable(0)->name());
+    EXPECT_EQ("w", e.variable(1)->name());
+    EXPECT_EQ(4.0, variables.at(1));
+    EXPECT_EQ(7.5, variables.at(2));
+    EXPECT_DOUBLE_EQ(0.75 * std::acos(-1.0), variables.at(3));
+    EXPECT_EQ(13.5, variables.at(4));
+
+    // So are the product of constants and the computed constant.
+    e.setFoldConstantVariables(true);
+    EXPECT_TRUE(e.foldConstantVariables());
+    e.processModel(m);
+    EXPECT_EQ(size_t(6), e.removedOperationCount());
+    std::vector<double> folded(e.variableCount());
+    e.initialiseStatesAndConstants(states.data(), folded.data());
+    e.computeComputedConstants(folded.data());
+    e.computeVariables(0.0, states.data(), rates.data(), folded.data());
+    EXPECT_EQ(variables, folded);
+
+    // Changing the constant no longer has any effect.
+    folded.at(0) = 4.0;
+    e.computeComputedConstants(folded.data());
+    e.computeVariables(0.0, states.data(), rates.data(), folded.data());
+    EXPECT_EQ(13.5, folded.at(4));
+}
+
+TEST(Evaluator, constantFoldingOharaRudy)
+{
+    std::ifstream t(TestResources::location(
+        TestResources::CELLML_ORD_MODEL_RESOURCE));
+    std::stringstream buffer;
+    buffer << t.rdbuf();
+
+    libcellml::Parser p;
+    libcellml::ModelPtr model = p.parseModel(buffer.str());
+
+    libcellml::Evaluator e;
+    e.processModel(model);
+    EXPECT_LT(size_t(0), e.removedOperationCount());
+    libcellml::Evaluator folded;
+    folded.setFoldConstantVariables(true);
+    folded.processModel(model);
+    EXPECT_EQ(size_t(0), folded.errorCount());
+    EXPECT_LT(e.removedOperationCount(), folded.removedOperationCount());
+
+    // Folding evaluates the same operations, only earlier.
+    std::vector<double> states(e.stateCount());
+    std::vector<double> rates(e.stateCount());
+    std::vector<double> variables(e.variableCount());
+    std::vector<double> foldedRates(e.stateCount());
+    std::vector<double> foldedVariables(e.variableCount());
+    e.initialiseStatesAndConstants(states.data(), variables.data());
+    e.computeComputedConstants(variables.data());
+    folded.initialiseStatesAndConstants(states.data(), foldedVariables.data());
+    folded.computeComputedConstants(foldedVariables.data());
+    states.at(0) = -52.345;
+    e.computeRates(0.0, states.data(), rates.data(), variables.data());
+    folded.computeRates(0.0, states.data(), foldedRates.data(), foldedVariables.data());
+    EXPECT_EQ(rates, foldedRates);
+}
+
+TEST(Evaluator, copyAndMove)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr c = std::make_shared<libcellml::Component>();
+    c->setName("main");
+    m->addComponent(c);
+    createVariable(c, "x", "1.5");
+
+    libcellml::Evaluator e;
+    e.processModel(m);
+    libcellml::Evaluator copied(e);
+    libcellml::Evaluator moved(std::move(e));
+    libcellml::Evaluator assigned;
+    assigned = copied;
+
+    EXPECT_EQ(size_t(1), copied.variableCount());
+    EXPECT_EQ(size_t(1), moved.variableCount());
+    EXPECT_EQ(size_t(1), assigned.variableCount());
+    EXPECT_EQ("x", assigned.variable(0)->name());
+
+    // Moved from evaluators can be moved from again and assigned to.
+    libcellml::Evaluator movedAgain(std::move(e));
+    e = copied;
+    EXPECT_EQ(size_t(1), e.variableCount());
+}
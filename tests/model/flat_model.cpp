@@ -0,0 +1,92 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <libcellml>
+
+TEST(FlatModel, tables)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr c1 = std::make_shared<libcellml::Component>();
+    libcellml::ComponentPtr c2 = std::make_shared<libcellml::Component>();
+    libcellml::ComponentPtr c3 = std::make_shared<libcellml::Component>();
+    libcellml::ComponentPtr c4 = std::make_shared<libcellml::Component>();
+    m->addComponent(c1);
+    c1->addComponent(c2);
+    c2->addComponent(c3);
+    m->addComponent(c4);
+
+    libcellml::VariablePtr v1 = std::make_shared<libcellml::Variable>();
+    v1->setUnits("second");
+    v1->setInitialValue(1.5);
+    v1->setInterfaceType("private");
+    libcellml::VariablePtr v2 = std::make_shared<libcellml::Variable>();
+    v2->setUnits("metre");
+    v2->setInitialValue("v1");
+    v2->setInterfaceType("public");
+    libcellml::VariablePtr v3 = std::make_shared<libcellml::Variable>();
+    v3->setUnits("second");
+    v3->setInterfaceType("public_and_private");
+    libcellml::VariablePtr v4 = std::make_shared<libcellml::Variable>();
+    v4->setUnits("second");
+    c1->addVariable(v1);
+    c3->addVariable(v2);
+    c3->addVariable(v3);
+    c4->addVariable(v4);
+    libcellml::Variable::addEquivalence(v1, v3);
+    libcellml::Variable::addEquivalence(v3, v4);
+
+    libcellml::FlatModelPtr f = std::make_shared<libcellml::FlatModel>(m);
+
+    EXPECT_EQ(size_t(4), f->componentCount());
+    EXPECT_EQ(c3, f->components()[2]);
+    const std::vector<size_t> parents = {libcellml::FlatModel::NO_INDEX, 0, 1, libcellml::FlatModel::NO_INDEX};
+    EXPECT_EQ(parents, f->componentParents());
+    const std::vector<size_t> childOffsets = {0, 1, 2, 2, 2};
+    EXPECT_EQ(childOffsets, f->componentChildOffsets());
+    const std::vector<size_t> children = {1, 2};
+    EXPECT_EQ(children, f->componentChildren());
+    const std::vector<size_t> variableOffsets = {0, 1, 1, 3, 4};
+    EXPECT_EQ(variableOffsets, f->componentVariableOffsets());
+
+    EXPECT_EQ(size_t(4), f->variableCount());
+    EXPECT_EQ(v2, f->variables()[1]);
+    const std::vector<size_t> variableComponents = {0, 2, 2, 3};
+    EXPECT_EQ(variableComponents, f->variableComponents());
+    const std::vector<std::string> unitsNames = {"second", "metre"};
+    EXPECT_EQ(unitsNames, f->unitsNames());
+    const std::vector<size_t> variableUnits = {0, 1, 0, 0};
+    EXPECT_EQ(variableUnits, f->variableUnits());
+    const std::vector<libcellml::Variable::InterfaceType> interfaceTypes = {
+        libcellml::Variable::InterfaceType::PRIVATE,
+        libcellml::Variable::InterfaceType::PUBLIC,
+        libcellml::Variable::InterfaceType::PUBLIC_AND_PRIVATE,
+        libcellml::Variable::InterfaceType::NONE};
+    EXPECT_EQ(interfaceTypes, f->variableInterfaceTypes());
+    EXPECT_EQ(1.5, f->variableInitialValues()[0]);
+    EXPECT_TRUE(std::isnan(f->variableInitialValues()[1]));
+    EXPECT_TRUE(std::isnan(f->variableInitialValues()[2]));
+
+    EXPECT_EQ(size_t(2), f->equivalenceSetCount());
+    const std::vector<size_t> equivalenceSets = {0, 1, 0, 0};
+    EXPECT_EQ(equivalenceSets, f->variableEquivalenceSets());
+    const std::vector<size_t> equivalenceOffsets = {0, 1, 1, 3, 4};
+    EXPECT_EQ(equivalenceOffsets, f->equivalenceOffsets());
+    const std::vector<size_t> equivalentVariables = {2, 0, 3, 2};
+    EXPECT_EQ(equivalentVariables, f->equivalentVariables());
+}
@@ -0,0 +1,215 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "gtest/gtest.h"
+
+#include <libcellml>
+
+TEST(FrozenModel, freeze)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    m->setName("model");
+    m->setId("model_id");
+    libcellml::UnitsPtr u = std::make_shared<libcellml::Units>();
+    u->setName("fast");
+    u->setId("fast_id");
+    m->addUnits(u);
+    libcellml::ImportSourcePtr importSource = std::make_shared<libcellml::ImportSource>();
+    importSource->setUrl("library.cellml");
+
+    libcellml::ComponentPtr c1 = std::make_shared<libcellml::Component>();
+    c1->setName("c1");
+    c1->setMath("<math/>");
+    libcellml::ComponentPtr c2 = std::make_shared<libcellml::Component>();
+    c2->setName("c2");
+    libcellml::ComponentPtr c3 = std::make_shared<libcellml::Component>();
+    c3->setName("c3");
+    libcellml::ComponentPtr c4 = std::make_shared<libcellml::Component>();
+    c4->setName("c4");
+    c4->setImportSource(importSource);
+    c4->setImportReference("library_component");
+    m->addComponent(c1);
+    c1->addComponent(c2);
+    c1->addComponent(c3);
+    m->addComponent(c4);
+
+    libcellml::VariablePtr v1 = std::make_shared<libcellml::Variable>();
+    v1->setName("v1");
+    v1->setUnits("fast");
+    v1->setInitialValue(2.0);
+    v1->setInterfaceType("private");
+    libcellml::VariablePtr v2 = std::make_shared<libcellml::Variable>();
+    v2->setName("v2");
+    v2->setUnits("fast");
+    v2->setInterfaceType("public");
+    libcellml::VariablePtr v3 = std::make_shared<libcellml::Variable>();
+    v3->setName("v3");
+    c1->addVariable(v1);
+    c3->addVariable(v2);
+    c3->addVariable(v3);
+    libcellml::Variable::addEquivalence(v1, v2);
+
+    libcellml::FrozenModelPtr f = m->freeze();
+
+    EXPECT_EQ("model", f->name());
+    EXPECT_EQ("model_id", f->id());
+    EXPECT_EQ(size_t(1), f->unitsCount());
+    EXPECT_EQ(size_t(0), f->units("fast"));
+    EXPECT_EQ("fast_id", f->unitsId(0));
+    EXPECT_EQ("", f->unitsImportUrl(0));
+    EXPECT_EQ(libcellml::FrozenModel::NO_INDEX, f->units("slow"));
+
+    // Components are in depth-first order.
+    EXPECT_EQ(size_t(4), f->componentCount());
+    EXPECT_EQ("c1", f->componentName(0));
+    EXPECT_EQ("c2", f->componentName(1));
+    EXPECT_EQ("c3", f->componentName(2));
+    EXPECT_EQ("c4", f->componentName(3));
+    EXPECT_EQ("<math/>", f->componentMath(0));
+    EXPECT_EQ(size_t(2), f->component("c3"));
+    EXPECT_EQ(libcellml::FrozenModel::NO_INDEX, f->componentParent(0));
+    EXPECT_EQ(size_t(0), f->componentParent(2));
+    EXPECT_EQ(size_t(2), f->componentChildCount(0));
+    EXPECT_EQ(size_t(1), f->componentChild(0, 0));
+    EXPECT_EQ(size_t(2), f->componentChild(0, 1));
+    EXPECT_EQ(libcellml::FrozenModel::NO_INDEX, f->componentChild(0, 2));
+    EXPECT_EQ("library.cellml", f->componentImportUrl(3));
+    EXPECT_EQ("library_component", f->componentImportReference(3));
+
+    // Variables are in the order of their components.
+    EXPECT_EQ(size_t(3), f->variableCount());
+    EXPECT_EQ(size_t(1), f->componentFirstVariable(2));
+    EXPECT_EQ(size_t(2), f->componentVariableCount(2));
+    EXPECT_EQ(size_t(0), f->componentVariableCount(1));
+    EXPECT_EQ(size_t(2), f->variable(2, "v3"));
+    EXPECT_EQ(libcellml::FrozenModel::NO_INDEX, f->variable(0, "v3"));
+    EXPECT_EQ("v2", f->variableName(1));
+    EXPECT_EQ("fast", f->variableUnits(0));
+    EXPECT_EQ("2", f->variableInitialValue(0));
+    EXPECT_EQ("public", f->variableInterfaceType(1));
+    EXPECT_EQ(size_t(2), f->variableComponent(1));
+    EXPECT_EQ(size_t(1), f->equivalentVariableCount(0));
+    EXPECT_EQ(size_t(1), f->equivalentVariable(0, 0));
+    EXPECT_EQ(size_t(0), f->equivalentVariable(1, 0));
+    EXPECT_EQ(size_t(0), f->equivalentVariableCount(2));
+
+    // Out of range indices.
+    EXPECT_EQ("", f->variableName(3));
+    EXPECT_EQ(libcellml::FrozenModel::NO_INDEX, f->variableComponent(3));
+    EXPECT_EQ("", f->componentName(4));
+
+    // The snapshot does not change with the model.
+    c1->setName("renamed");
+    v1->setUnits("slow");
+    m->removeAllComponents();
+    EXPECT_EQ("c1", f->componentName(0));
+    EXPECT_EQ("fast", f->variableUnits(0));
+    EXPECT_EQ(size_t(4), f->componentCount());
+}
+
+TEST(FrozenModel, freezeUnitRowsAndResets)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::UnitsPtr u1 = std::make_shared<libcellml::Units>();
+    u1->setName("per_ms");
+    u1->addUnit("second", "milli", -1.0, 2.0);
+    libcellml::UnitsPtr u2 = std::make_shared<libcellml::Units>();
+    u2->setName("base");
+    m->addUnits(u1);
+    m->addUnits(u2);
+
+    libcellml::ComponentPtr c1 = std::make_shared<libcellml::Component>();
+    c1->setName("c1");
+    libcellml::ComponentPtr c2 = std::make_shared<libcellml::Component>();
+    c2->setName("c2");
+    m->addComponent(c1);
+    c1->addComponent(c2);
+    libcellml::VariablePtr v1 = std::make_shared<libcellml::Variable>();
+    v1->setName("v1");
+    libcellml::VariablePtr v2 = std::make_shared<libcellml::Variable>();
+    v2->setName("v2");
+    c1->addVariable(v1);
+    c2->addVariable(v2);
+
+    libcellml::ResetPtr r1 = std::make_shared<libcellml::Reset>();
+    r1->setId("r1_id");
+    r1->setOrder(2);
+    r1->setVariable(v1);
+    libcellml::WhenPtr w1 = std::make_shared<libcellml::When>();
+    w1->setOrder(1);
+    w1->setCondition("<math>condition1</math>");
+    w1->setValue("<math>value1</math>");
+    libcellml::WhenPtr w2 = std::make_shared<libcellml::When>();
+    w2->setOrder(3);
+    w2->setCondition("<math>condition2</math>");
+    w2->setValue("<math>value2</math>");
+    r1->addWhen(w1);
+    r1->addWhen(w2);
+    libcellml::ResetPtr r2 = std::make_shared<libcellml::Reset>();
+    r2->setOrder(-1);
+    r2->setVariable(std::make_shared<libcellml::Variable>());
+    libcellml::ResetPtr r3 = std::make_shared<libcellml::Reset>();
+    r3->setVariable(v2);
+    c1->addReset(r1);
+    c1->addReset(r2);
+    c2->addReset(r3);
+
+    libcellml::FrozenModelPtr f = m->freeze();
+
+    // Unit rows.
+    EXPECT_EQ(size_t(1), f->unitsUnitCount(0));
+    EXPECT_EQ("second", f->unitsUnitReference(0, 0));
+    EXPECT_EQ("milli", f->unitsUnitPrefix(0, 0));
+    EXPECT_EQ(-1.0, f->unitsUnitExponent(0, 0));
+    EXPECT_EQ(2.0, f->unitsUnitMultiplier(0, 0));
+    EXPECT_EQ(size_t(0), f->unitsUnitCount(1));
+    EXPECT_EQ("", f->unitsUnitReference(1, 0));
+    EXPECT_EQ(1.0, f->unitsUnitExponent(1, 0));
+    EXPECT_EQ(size_t(0), f->unitsUnitCount(2));
+
+    // Resets are in the order of their components.
+    EXPECT_EQ(size_t(3), f->resetCount());
+    EXPECT_EQ(size_t(0), f->componentFirstReset(0));
+    EXPECT_EQ(size_t(2), f->componentResetCount(0));
+    EXPECT_EQ(size_t(2), f->componentFirstReset(1));
+    EXPECT_EQ(size_t(1), f->componentResetCount(1));
+    EXPECT_EQ("r1_id", f->resetId(0));
+    EXPECT_EQ(2, f->resetOrder(0));
+    EXPECT_EQ(-1, f->resetOrder(1));
+    EXPECT_EQ(size_t(0), f->resetVariable(0));
+    EXPECT_EQ(libcellml::FrozenModel::NO_INDEX, f->resetVariable(1));
+    EXPECT_EQ(size_t(1), f->resetVariable(2));
+    EXPECT_EQ(size_t(0), f->resetComponent(1));
+    EXPECT_EQ(size_t(1), f->resetComponent(2));
+    EXPECT_EQ(size_t(2), f->resetWhenCount(0));
+    EXPECT_EQ(size_t(0), f->resetWhenCount(2));
+    EXPECT_EQ(3, f->resetWhenOrder(0, 1));
+    EXPECT_EQ("<math>condition1</math>", f->resetWhenCondition(0, 0));
+    EXPECT_EQ("<math>value2</math>", f->resetWhenValue(0, 1));
+
+    // Out of range indices.
+    EXPECT_EQ("", f->resetWhenCondition(0, 2));
+    EXPECT_EQ(0, f->resetWhenOrder(2, 0));
+    EXPECT_EQ("", f->resetId(3));
+    EXPECT_EQ(libcellml::FrozenModel::NO_INDEX, f->resetVariable(3));
+    EXPECT_EQ(libcellml::FrozenModel::NO_INDEX, f->componentFirstReset(2));
+
+    // The snapshot does not change with the model.
+    w1->setCondition("<math>changed</math>");
+    u1->removeAllUnits();
+    EXPECT_EQ("<math>condition1</math>", f->resetWhenCondition(0, 0));
+    EXPECT_EQ(size_t(1), f->unitsUnitCount(0));
+}
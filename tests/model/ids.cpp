@@ -0,0 +1,185 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "gtest/gtest.h"
+
+#include <libcellml>
+
+TEST(Model, itemWithId)
+{
+    const std::string in =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<model xmlns=\"http://www.cellml.org/cellml/2.0#\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" name=\"model\" id=\"model_id\">\n"
+        "  <import xlink:href=\"library.cellml\" id=\"import_id\">\n"
+        "    <component name=\"imported\" component_ref=\"c\" id=\"imported_id\"/>\n"
+        "  </import>\n"
+        "  <units name=\"per_second\" id=\"units_id\">\n"
+        "    <unit units=\"second\" exponent=\"-1\" id=\"unit_id\"/>\n"
+        "  </units>\n"
+        "  <component name=\"c1\" id=\"c1_id\">\n"
+        "    <variable name=\"x\" units=\"dimensionless\" interface=\"public\" id=\"x1_id\"/>\n"
+        "    <variable name=\"y\" units=\"dimensionless\" interface=\"public\" id=\"y1_id\"/>\n"
+        "  </component>\n"
+        "  <component name=\"c2\" id=\"c2_id\">\n"
+        "    <variable name=\"x\" units=\"dimensionless\" interface=\"public\" id=\"x2_id\"/>\n"
+        "    <variable name=\"y\" units=\"dimensionless\" interface=\"public\" id=\"duplicate_id\"/>\n"
+        "  </component>\n"
+        "  <encapsulation id=\"encapsulation_id\">\n"
+        "    <component_ref component=\"c1\" id=\"component_ref_id\">\n"
+        "      <component_ref component=\"imported\"/>\n"
+        "    </component_ref>\n"
+        "  </encapsulation>\n"
+        "  <connection component_1=\"c1\" component_2=\"c2\" id=\"connection_id\">\n"
+        "    <map_variables variable_1=\"x\" variable_2=\"x\" id=\"map_x_id\"/>\n"
+        "    <map_variables variable_1=\"y\" variable_2=\"y\" id=\"duplicate_id\"/>\n"
+        "  </connection>\n"
+        "</model>\n";
+
+    libcellml::Parser parser;
+    libcellml::ModelPtr model = parser.parseModel(in);
+    EXPECT_EQ(size_t(0), parser.errorCount());
+
+    libcellml::ComponentPtr c1 = model->component("c1");
+    libcellml::ComponentPtr c2 = model->component("c2");
+    libcellml::UnitsPtr units = model->units("per_second");
+
+    EXPECT_EQ(libcellml::IdentifiedItem::Type::MODEL, model->itemWithId("model_id")->type());
+    EXPECT_EQ(model, model->itemWithId("model_id")->entity());
+    EXPECT_EQ(libcellml::IdentifiedItem::Type::ENCAPSULATION, model->itemWithId("encapsulation_id")->type());
+    EXPECT_EQ(model, model->itemWithId("encapsulation_id")->entity());
+    EXPECT_EQ(libcellml::IdentifiedItem::Type::IMPORT, model->itemWithId("import_id")->type());
+    EXPECT_EQ(c1->component("imported")->importSource(), model->itemWithId("import_id")->entity());
+    EXPECT_EQ(libcellml::IdentifiedItem::Type::UNITS, model->itemWithId("units_id")->type());
+    EXPECT_EQ(units, model->itemWithId("units_id")->entity());
+    EXPECT_EQ(libcellml::IdentifiedItem::Type::UNIT, model->itemWithId("unit_id")->type());
+    EXPECT_EQ(units, model->itemWithId("unit_id")->entity());
+    EXPECT_EQ(size_t(0), model->itemWithId("unit_id")->index());
+    EXPECT_EQ(libcellml::IdentifiedItem::Type::COMPONENT, model->itemWithId("c1_id")->type());
+    EXPECT_EQ(c1, model->itemWithId("c1_id")->entity());
+    EXPECT_EQ(libcellml::IdentifiedItem::Type::COMPONENT, model->itemWithId("imported_id")->type());
+    EXPECT_EQ(libcellml::IdentifiedItem::Type::COMPONENT_REF, model->itemWithId("component_ref_id")->type());
+    EXPECT_EQ(c1, model->itemWithId("component_ref_id")->entity());
+    EXPECT_EQ(libcellml::IdentifiedItem::Type::VARIABLE, model->itemWithId("x2_id")->type());
+    EXPECT_EQ(c2->variable("x"), model->itemWithId("x2_id")->entity());
+
+    libcellml::IdentifiedItemPtr connection = model->itemWithId("connection_id");
+    EXPECT_EQ(libcellml::IdentifiedItem::Type::CONNECTION, connection->type());
+    EXPECT_EQ(nullptr, connection->entity());
+    EXPECT_TRUE(connection->variable1()->hasEquivalentVariable(connection->variable2()));
+    EXPECT_NE(connection->variable1()->parent(), connection->variable2()->parent());
+    EXPECT_EQ(size_t(1), model->itemCountWithId("connection_id"));
+    EXPECT_EQ(libcellml::IdentifiedItem::Type::MAP_VARIABLES, model->itemWithId("map_x_id")->type());
+    EXPECT_EQ(size_t(1), model->itemCountWithId("map_x_id"));
+
+    // Duplicate ids.
+    EXPECT_EQ(size_t(2), model->itemCountWithId("duplicate_id"));
+    EXPECT_EQ(libcellml::IdentifiedItem::Type::VARIABLE, model->itemWithId("duplicate_id", 0)->type());
+    EXPECT_EQ(libcellml::IdentifiedItem::Type::MAP_VARIABLES, model->itemWithId("duplicate_id", 1)->type());
+    EXPECT_EQ(nullptr, model->itemWithId("duplicate_id", 2));
+    EXPECT_EQ(std::vector<std::string>({"duplicate_id"}), model->duplicateIds());
+
+    // Unknown ids.
+    EXPECT_EQ(nullptr, model->itemWithId("unknown_id"));
+    EXPECT_EQ(nullptr, model->itemWithId(""));
+    EXPECT_EQ(size_t(0), model->itemCountWithId("unknown_id"));
+}
+
+TEST(Model, itemWithIdFollowsChanges)
+{
+    libcellml::ModelPtr model = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr c = std::make_shared<libcellml::Component>();
+    libcellml::VariablePtr v = std::make_shared<libcellml::Variable>();
+    libcellml::ResetPtr r = std::make_shared<libcellml::Reset>();
+    libcellml::WhenPtr w = std::make_shared<libcellml::When>();
+    libcellml::ImportSourcePtr importSource = std::make_shared<libcellml::ImportSource>();
+    libcellml::ComponentPtr imported = std::make_shared<libcellml::Component>();
+    c->addVariable(v);
+    r->addWhen(w);
+    c->addReset(r);
+    imported->setSourceComponent(importSource, "i");
+    model->addComponent(c);
+    c->addComponent(imported);
+    EXPECT_TRUE(model->duplicateIds().empty());
+
+    v->setId("id");
+    EXPECT_EQ(v, model->itemWithId("id")->entity());
+    c->setId("id");
+    EXPECT_EQ(c, model->itemWithId("id")->entity());
+    EXPECT_EQ(v, model->itemWithId("id", 1)->entity());
+    v->setId("variable_id");
+    EXPECT_EQ(size_t(1), model->itemCountWithId("id"));
+    EXPECT_EQ(v, model->itemWithId("variable_id")->entity());
+
+    // Resets, whens and import sources have no parent.
+    r->setId("reset_id");
+    EXPECT_EQ(r, model->itemWithId("reset_id")->entity());
+    w->setId("when_id");
+    EXPECT_EQ(w, model->itemWithId("when_id")->entity());
+    importSource->setId("import_id");
+    EXPECT_EQ(importSource, model->itemWithId("import_id")->entity());
+    w->setId("reset_id");
+    EXPECT_EQ(std::vector<std::string>({"reset_id"}), model->duplicateIds());
+
+    // Removing entities.
+    c->removeAllResets();
+    EXPECT_EQ(nullptr, model->itemWithId("when_id"));
+    EXPECT_TRUE(model->duplicateIds().empty());
+    model->removeAllComponents();
+    EXPECT_EQ(nullptr, model->itemWithId("id"));
+    EXPECT_EQ(nullptr, model->itemWithId("import_id"));
+
+    // Replacing entities.
+    libcellml::UnitsPtr a = std::make_shared<libcellml::Units>();
+    a->setName("a");
+    a->setId("a_id");
+    model->addUnits(a);
+    EXPECT_EQ(a, model->itemWithId("a_id")->entity());
+    libcellml::UnitsPtr b = std::make_shared<libcellml::Units>();
+    b->setName("a");
+    EXPECT_TRUE(model->replaceUnits("a", b));
+    EXPECT_EQ(size_t(0), model->itemCountWithId("a_id"));
+    b->setId("new");
+    EXPECT_EQ(size_t(1), model->itemCountWithId("new"));
+    libcellml::ComponentPtr d = std::make_shared<libcellml::Component>();
+    model->addComponent(std::make_shared<libcellml::Component>());
+    EXPECT_TRUE(model->replaceComponent(0, d));
+    d->setId("d_id");
+    EXPECT_EQ(d, model->itemWithId("d_id")->entity());
+}
+
+TEST(Model, itemWithIdAfterEquivalentVariableIsGone)
+{
+    libcellml::ModelPtr model = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr c1 = std::make_shared<libcellml::Component>();
+    libcellml::ComponentPtr c2 = std::make_shared<libcellml::Component>();
+    libcellml::VariablePtr v1 = std::make_shared<libcellml::Variable>();
+    libcellml::VariablePtr v2 = std::make_shared<libcellml::Variable>();
+    v1->setId("x");
+    c1->addVariable(v1);
+    c2->addVariable(v2);
+    model->addComponent(c1);
+    model->addComponent(c2);
+    libcellml::Variable::addEquivalence(v1, v2, "mapping_id", "connection_id");
+    EXPECT_EQ(size_t(1), model->itemCountWithId("mapping_id"));
+
+    // The equivalence to a variable that no longer exists is ignored.
+    model->removeComponent(c2);
+    c2.reset();
+    v2.reset();
+    EXPECT_EQ(size_t(1), model->itemCountWithId("x"));
+    EXPECT_EQ(size_t(0), model->itemCountWithId("mapping_id"));
+    EXPECT_EQ(size_t(0), model->itemCountWithId("connection_id"));
+}
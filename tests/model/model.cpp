@@ -549,3 +549,273 @@ TEST(Model, setAndCheckIdsAllEntities)
     const std::string a = printer.printModel(m);
     EXPECT_EQ(a, e);
 }
+
+TEST(Model, revision)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr c1 = std::make_shared<libcellml::Component>();
+    libcellml::ComponentPtr c2 = std::make_shared<libcellml::Component>();
+    libcellml::ComponentPtr c3 = std::make_shared<libcellml::Component>();
+    libcellml::VariablePtr v1 = std::make_shared<libcellml::Variable>();
+    libcellml::VariablePtr v2 = std::make_shared<libcellml::Variable>();
+    libcellml::UnitsPtr u = std::make_shared<libcellml::Units>();
+
+    EXPECT_NE(c1->revision(), c2->revision());
+
+    m->addComponent(c1);
+    c1->addComponent(c2);
+    m->addComponent(c3);
+    c2->addVariable(v1);
+    c3->addVariable(v2);
+    m->addUnits(u);
+
+    size_t modelRevision = m->revision();
+    size_t c1Revision = c1->revision();
+    size_t c2Revision = c2->revision();
+    size_t c3Revision = c3->revision();
+
+    // Changes propagate to all the ancestors of an entity, and only to them.
+    v1->setName("v1");
+    EXPECT_LT(c2Revision, c2->revision());
+    EXPECT_LT(c1Revision, c1->revision());
+    EXPECT_LT(modelRevision, m->revision());
+    EXPECT_EQ(c3Revision, c3->revision());
+
+    c2Revision = c2->revision();
+    c3Revision = c3->revision();
+    libcellml::Variable::addEquivalence(v1, v2);
+    EXPECT_LT(c2Revision, c2->revision());
+    EXPECT_LT(c3Revision, c3->revision());
+
+    c1Revision = c1->revision();
+    c3Revision = c3->revision();
+    c1->appendMath("<math/>");
+    EXPECT_LT(c1Revision, c1->revision());
+    EXPECT_EQ(c3Revision, c3->revision());
+
+    modelRevision = m->revision();
+    c1Revision = c1->revision();
+    u->addUnit("second");
+    EXPECT_LT(modelRevision, m->revision());
+    EXPECT_EQ(c1Revision, c1->revision());
+
+    // Reading does not change anything.
+    modelRevision = m->revision();
+    EXPECT_EQ("v1", v1->name());
+    EXPECT_EQ(size_t(2), m->componentCount());
+    EXPECT_EQ(modelRevision, m->revision());
+}
+
+TEST(Model, revisionAfterParentIsGone)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr c1 = std::make_shared<libcellml::Component>();
+    libcellml::ComponentPtr c2 = std::make_shared<libcellml::Component>();
+    libcellml::ComponentPtr c3 = std::make_shared<libcellml::Component>();
+    libcellml::VariablePtr v = std::make_shared<libcellml::Variable>();
+    libcellml::UnitsPtr u1 = std::make_shared<libcellml::Units>();
+    libcellml::UnitsPtr u2 = std::make_shared<libcellml::Units>();
+    m->addComponent(c1);
+    m->addComponent(c2);
+    c2->addComponent(c3);
+    c2->addVariable(v);
+    m->addUnits(u1);
+    m->addUnits(u2);
+
+    // Removed entities no longer refer to their parent.
+    m->removeUnits(u2);
+    EXPECT_EQ(nullptr, u2->parent());
+    c2->removeComponent(c3);
+    EXPECT_EQ(nullptr, c3->parent());
+    c2->removeAllVariables();
+    EXPECT_EQ(nullptr, v->parent());
+    c2->addComponent(c3);
+    c2->addVariable(v);
+
+    // Copies are not contained in the parent of the original.
+    libcellml::ComponentPtr copy = std::make_shared<libcellml::Component>(*c1);
+    EXPECT_EQ(nullptr, copy->parent());
+
+    // Nor do the entities of a destroyed model or component.
+    m->removeComponent(c2);
+    EXPECT_EQ(nullptr, c2->parent());
+    c2.reset();
+    EXPECT_EQ(nullptr, c3->parent());
+    EXPECT_EQ(nullptr, v->parent());
+    m.reset();
+    EXPECT_EQ(nullptr, c1->parent());
+    EXPECT_EQ(nullptr, u1->parent());
+    size_t revision = c1->revision();
+    c1->setName("c1");
+    u1->setName("u1");
+    c3->setName("c3");
+    v->setName("v");
+    EXPECT_LT(revision, c1->revision());
+}
+
+TEST(Model, clone)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    m->setName("model");
+    m->setId("model_id");
+    libcellml::ImportSourcePtr importSource = std::make_shared<libcellml::ImportSource>();
+    importSource->setUrl("some-other-model.xml");
+    libcellml::UnitsPtr u1 = std::make_shared<libcellml::Units>();
+    u1->setName("fast");
+    u1->addUnit("second", "milli");
+    libcellml::UnitsPtr u2 = std::make_shared<libcellml::Units>();
+    u2->setName("imported");
+    u2->setImportSource(importSource);
+    u2->setImportReference("units_in_that_model");
+    m->addUnits(u1);
+    m->addUnits(u2);
+
+    libcellml::ComponentPtr c1 = std::make_shared<libcellml::Component>();
+    c1->setName("c1");
+    libcellml::ComponentPtr c2 = std::make_shared<libcellml::Component>();
+    c2->setName("c2");
+    libcellml::ComponentPtr c3 = std::make_shared<libcellml::Component>();
+    c3->setName("c3");
+    c3->setImportSource(importSource);
+    c3->setImportReference("component_in_that_model");
+    m->addComponent(c1);
+    c1->addComponent(c2);
+    m->addComponent(c3);
+
+    libcellml::VariablePtr v1 = std::make_shared<libcellml::Variable>();
+    v1->setName("v1");
+    v1->setUnits("fast");
+    v1->setInterfaceType("public_and_private");
+    v1->setInitialValue(1.0);
+    libcellml::VariablePtr v2 = std::make_shared<libcellml::Variable>();
+    v2->setName("v2");
+    v2->setUnits("fast");
+    v2->setInterfaceType("public");
+    c1->addVariable(v1);
+    c2->addVariable(v2);
+    libcellml::Variable::addEquivalence(v1, v2, "mapping_id", "connection_id");
+
+    libcellml::ResetPtr r = std::make_shared<libcellml::Reset>();
+    r->setOrder(1);
+    r->setVariable(v1);
+    libcellml::WhenPtr w = std::make_shared<libcellml::When>();
+    w->setOrder(2);
+    w->setCondition("<math/>");
+    w->setValue("<math/>");
+    r->addWhen(w);
+    c1->addReset(r);
+
+    libcellml::ModelPtr clone = m->clone();
+    libcellml::Printer printer;
+    EXPECT_EQ(printer.printModel(m), printer.printModel(clone));
+
+    // The copy only refers to its own entities.
+    libcellml::ComponentPtr cc1 = clone->component("c1");
+    libcellml::ComponentPtr cc2 = clone->component("c2");
+    libcellml::ComponentPtr cc3 = clone->component("c3");
+    libcellml::VariablePtr cv1 = cc1->variable("v1");
+    libcellml::VariablePtr cv2 = cc2->variable("v2");
+    EXPECT_NE(c1, cc1);
+    EXPECT_NE(v1, cv1);
+    EXPECT_EQ(clone.get(), cc1->parent());
+    EXPECT_EQ(cc1.get(), cc2->parent());
+    EXPECT_EQ(cc1.get(), cv1->parent());
+    EXPECT_EQ(clone.get(), clone->units("fast")->parent());
+    EXPECT_EQ(size_t(1), cv1->equivalentVariableCount());
+    EXPECT_EQ(cv2, cv1->equivalentVariable(0));
+    EXPECT_EQ(cv1, cv2->equivalentVariable(0));
+    EXPECT_EQ("mapping_id", libcellml::Variable::equivalenceMappingId(cv1, cv2));
+    EXPECT_EQ("connection_id", libcellml::Variable::equivalenceConnectionId(cv1, cv2));
+    EXPECT_EQ(libcellml::Variable::equivalenceSetId(cv1), libcellml::Variable::equivalenceSetId(cv2));
+    EXPECT_NE(libcellml::Variable::equivalenceSetId(v1), libcellml::Variable::equivalenceSetId(cv1));
+    EXPECT_EQ(cv1, cc1->reset(0)->variable());
+    EXPECT_NE(w, cc1->reset(0)->when(0));
+    EXPECT_NE(importSource, cc3->importSource());
+    EXPECT_EQ(cc3->importSource(), clone->units("imported")->importSource());
+    EXPECT_EQ(size_t(1), v1->equivalentVariableCount());
+
+    // Changing the copy leaves the original alone.
+    cv1->setName("renamed");
+    cc1->removeAllResets();
+    libcellml::Variable::removeEquivalence(cv1, cv2);
+    clone->units("fast")->removeAllUnits();
+    EXPECT_EQ("v1", v1->name());
+    EXPECT_EQ(size_t(1), c1->resetCount());
+    EXPECT_TRUE(v1->hasEquivalentVariable(v2));
+    EXPECT_EQ(size_t(1), u1->unitCount());
+}
+
+TEST(Model, walkComponents)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr c1 = std::make_shared<libcellml::Component>();
+    c1->setName("c1");
+    libcellml::ComponentPtr c2 = std::make_shared<libcellml::Component>();
+    c2->setName("c2");
+    libcellml::ComponentPtr c3 = std::make_shared<libcellml::Component>();
+    c3->setName("c3");
+    libcellml::ComponentPtr c4 = std::make_shared<libcellml::Component>();
+    c4->setName("c4");
+    libcellml::ComponentPtr c5 = std::make_shared<libcellml::Component>();
+    c5->setName("c5");
+    m->addComponent(c1);
+    c1->addComponent(c2);
+    c2->addComponent(c3);
+    c1->addComponent(c4);
+    m->addComponent(c5);
+    libcellml::VariablePtr v1 = std::make_shared<libcellml::Variable>();
+    v1->setName("v1");
+    libcellml::VariablePtr v2 = std::make_shared<libcellml::Variable>();
+    v2->setName("v2");
+    c1->addVariable(v1);
+    c1->addVariable(v2);
+
+    std::string names;
+    for (const libcellml::VariablePtr &variable : c1->variables()) {
+        names += variable->name();
+    }
+    EXPECT_EQ("v1v2", names);
+    EXPECT_TRUE(c3->variables().empty());
+
+    names.clear();
+    for (const libcellml::ComponentPtr &component : m->components()) {
+        names += component->name();
+    }
+    EXPECT_EQ("c1c5", names);
+
+    names.clear();
+    m->forEachComponent([&names](const libcellml::ComponentPtr &component) {
+        names += component->name();
+    });
+    EXPECT_EQ("c1c2c3c4c5", names);
+
+    names.clear();
+    c1->forEachComponent([&names](const libcellml::ComponentPtr &component) {
+        names += component->name();
+    });
+    EXPECT_EQ("c2c3c4", names);
+
+    std::string depths;
+    names.clear();
+    libcellml::ModelWalker walker(m);
+    while (walker.next()) {
+        names += walker.component()->name();
+        depths += std::to_string(walker.depth());
+    }
+    EXPECT_EQ("c1c2c3c4c5", names);
+    EXPECT_EQ("01210", depths);
+    EXPECT_FALSE(walker.next());
+
+    names.clear();
+    libcellml::ModelWalker skippingWalker(m);
+    while (skippingWalker.next()) {
+        names += skippingWalker.component()->name();
+        if (skippingWalker.component() == c2) {
+            skippingWalker.skipChildren();
+        }
+    }
+    EXPECT_EQ("c1c2c4c5", names);
+
+    libcellml::ModelWalker emptyWalker(c5);
+    EXPECT_FALSE(emptyWalker.next());
+}
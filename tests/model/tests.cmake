@@ -11,6 +11,9 @@ list(APPEND LIBCELLML_TESTS ${CURRENT_TEST})
 # Using absolute path relative to this file
 set(${CURRENT_TEST}_SRCS
   ${CMAKE_CURRENT_LIST_DIR}/component_import.cpp
+  ${CMAKE_CURRENT_LIST_DIR}/flat_model.cpp
+  ${CMAKE_CURRENT_LIST_DIR}/frozen_model.cpp
+  ${CMAKE_CURRENT_LIST_DIR}/ids.cpp
   ${CMAKE_CURRENT_LIST_DIR}/model.cpp
   ${CMAKE_CURRENT_LIST_DIR}/units_import.cpp
 )
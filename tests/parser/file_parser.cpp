@@ -162,3 +162,41 @@ TEST(Parser, parseModelWithComponentsWithMultipleMathElements)
     a = model->component("c2")->math();
     EXPECT_EQ(e2, a);
 }
+
+TEST(Parser, parseOrdModelFromFileWithArenaAllocation)
+{
+    std::ifstream t(TestResources::location(
+        TestResources::CELLML_ORD_MODEL_RESOURCE));
+    std::stringstream buffer;
+    buffer << t.rdbuf();
+
+    libcellml::Parser p;
+    libcellml::ModelPtr heapModel = p.parseModel(buffer.str());
+    EXPECT_FALSE(p.arenaAllocation());
+    p.setArenaAllocation(true);
+    EXPECT_TRUE(p.arenaAllocation());
+    libcellml::ModelPtr arenaModel = p.parseModel(buffer.str());
+    EXPECT_EQ(size_t(0), p.errorCount());
+
+    libcellml::Printer printer;
+    const std::string expected = printer.printModel(heapModel);
+    EXPECT_EQ(expected, printer.printModel(arenaModel));
+
+    // Entities may outlive their model, and the model may be edited.
+    libcellml::ComponentPtr component = arenaModel->component(0);
+    libcellml::VariablePtr variable = component->variable(0);
+    const std::string name = variable->name();
+    libcellml::ComponentPtr extra = std::make_shared<libcellml::Component>();
+    extra->setName("extra");
+    arenaModel->addComponent(extra);
+    arenaModel->removeComponent(extra);
+    arenaModel = nullptr;
+    EXPECT_EQ(name, variable->name());
+    EXPECT_EQ(component.get(), variable->parent());
+
+    libcellml::Validator heapValidator;
+    libcellml::Validator arenaValidator;
+    heapValidator.validateModel(heapModel);
+    arenaValidator.validateModel(p.parseModel(buffer.str()));
+    EXPECT_EQ(heapValidator.errorCount(), arenaValidator.errorCount());
+}
@@ -173,3 +173,42 @@ TEST(Printer, printEncapsulationWithNames)
     const std::string a_parent = printer.printModel(model);
     EXPECT_EQ(e_parent, a_parent);
 }
+
+TEST(Printer, printEncapsulatedImports)
+{
+    const std::string e =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<model xmlns=\"http://www.cellml.org/cellml/2.0#\">\n"
+        "  <import xlink:href=\"library.cellml\" xmlns:xlink=\"http://www.w3.org/1999/xlink\">\n"
+        "    <component component_ref=\"a\" name=\"child1\"/>\n"
+        "    <component component_ref=\"b\" name=\"child2\"/>\n"
+        "  </import>\n"
+        "  <component name=\"parent\"/>\n"
+        "  <encapsulation>\n"
+        "    <component_ref component=\"parent\">\n"
+        "      <component_ref component=\"child1\"/>\n"
+        "      <component_ref component=\"child2\"/>\n"
+        "    </component_ref>\n"
+        "  </encapsulation>\n"
+        "</model>\n";
+
+    libcellml::ModelPtr model = std::make_shared<libcellml::Model>();
+    libcellml::ImportSourcePtr importSource = std::make_shared<libcellml::ImportSource>();
+    importSource->setUrl("library.cellml");
+    libcellml::ComponentPtr parent = std::make_shared<libcellml::Component>();
+    parent->setName("parent");
+    libcellml::ComponentPtr child1 = std::make_shared<libcellml::Component>();
+    child1->setName("child1");
+    child1->setImportSource(importSource);
+    child1->setImportReference("a");
+    libcellml::ComponentPtr child2 = std::make_shared<libcellml::Component>();
+    child2->setName("child2");
+    child2->setImportSource(importSource);
+    child2->setImportReference("b");
+    parent->addComponent(child1);
+    parent->addComponent(child2);
+    model->addComponent(parent);
+
+    libcellml::Printer printer;
+    EXPECT_EQ(e, printer.printModel(model));
+}
@@ -19,6 +19,7 @@ limitations under the License.
 #include "gtest/gtest.h"
 
 #include <algorithm>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <libcellml>
@@ -127,3 +128,349 @@ TEST(ResolveImports, resolveImportsFromFileLevel0Unresolvable)
     model->resolveImports(modelLocation);
     EXPECT_TRUE(model->hasUnresolvedImports());
 }
+
+TEST(ResolveImports, importedModelsAreSharedUntilModified)
+{
+    const std::string modelLocation = TestResources::location(
+        TestResources::CELLML_IMPORT_LEVEL0_MODEL_RESOURCE);
+    std::ifstream t(modelLocation);
+    std::stringstream buffer;
+    buffer << t.rdbuf();
+
+    libcellml::Parser p;
+    libcellml::ModelPtr model1 = p.parseModel(buffer.str());
+    libcellml::ModelPtr model2 = p.parseModel(buffer.str());
+    libcellml::ImportLibrary library;
+    model1->resolveImports(modelLocation, library);
+    model2->resolveImports(modelLocation);
+    EXPECT_FALSE(model1->hasUnresolvedImports());
+    EXPECT_FALSE(model2->hasUnresolvedImports());
+
+    // The imports of level1-3.xml share the same model, only when resolved
+    // through a library.
+    libcellml::ImportSourcePtr importSource1 = model1->component("level13_in_level0_1")->importSource();
+    libcellml::ImportSourcePtr importSource2 = model1->component("level13_in_level0_2")->importSource();
+    EXPECT_NE(importSource1, importSource2);
+    EXPECT_EQ(importSource1->model(), importSource2->model());
+    EXPECT_NE(importSource1->model(), model2->component("level13_in_level0_1")->importSource()->model());
+    EXPECT_NE(model2->component("level13_in_level0_1")->importSource()->model(),
+              model2->component("level13_in_level0_2")->importSource()->model());
+
+    // Modifying the model of an import source copies it first, once.
+    libcellml::ModelPtr sharedModel = importSource1->model();
+    libcellml::ModelPtr mutableModel = importSource1->mutableModel();
+    EXPECT_NE(sharedModel, mutableModel);
+    EXPECT_EQ(mutableModel, importSource1->mutableModel());
+    mutableModel->component("level13_component")->setName("renamed");
+    EXPECT_EQ(nullptr, sharedModel->component("renamed"));
+    EXPECT_NE(nullptr, importSource2->model()->component("level13_component"));
+    EXPECT_EQ(sharedModel, importSource2->model());
+
+    // A model that nothing else refers to is not copied.
+    libcellml::ImportSourcePtr importSource = std::make_shared<libcellml::ImportSource>();
+    importSource->setModel(std::make_shared<libcellml::Model>());
+    libcellml::Model *ownModel = importSource->model().get();
+    EXPECT_EQ(ownModel, importSource->mutableModel().get());
+}
+
+/**
+ * @brief Write a model named @p name, with a component named "c", to the file
+ * at @p url.
+ */
+static void writeImportedModel(const std::string &url, const std::string &name)
+{
+    std::ofstream file(url);
+    file << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+         << "<model xmlns=\"http://www.cellml.org/cellml/2.0#\" name=\"" << name << "\">\n"
+         << "  <component name=\"c\"/>\n"
+         << "</model>\n";
+}
+
+TEST(ResolveImports, importLibrarySharesModelsUntilFilesChange)
+{
+    const std::string url = "import_library_imported.cellml";
+    const std::string in =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<model xmlns=\"http://www.cellml.org/cellml/2.0#\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" name=\"importing\">\n"
+        "  <import xlink:href=\"import_library_imported.cellml\">\n"
+        "    <component name=\"c\" component_ref=\"c\"/>\n"
+        "  </import>\n"
+        "</model>\n";
+    writeImportedModel(url, "first");
+
+    libcellml::Parser p;
+    libcellml::ImportLibrary library;
+    libcellml::ModelPtr model1 = p.parseModel(in);
+    libcellml::ModelPtr model2 = p.parseModel(in);
+    model1->resolveImports("importing.cellml", library);
+    model2->resolveImports("importing.cellml", library);
+    EXPECT_FALSE(model1->hasUnresolvedImports());
+    EXPECT_FALSE(model2->hasUnresolvedImports());
+    EXPECT_EQ(size_t(1), library.modelCount());
+    EXPECT_TRUE(library.hasModel(url));
+
+    // Separate models resolved through the same library share the model.
+    libcellml::ModelPtr importedModel = model1->component("c")->importSource()->model();
+    EXPECT_EQ("first", importedModel->name());
+    EXPECT_EQ(importedModel, model2->component("c")->importSource()->model());
+    EXPECT_EQ(importedModel, library.importedModel(url));
+
+    // A changed file is parsed again, while the resolved imports keep the
+    // model they were resolved to.
+    writeImportedModel(url, "second");
+    libcellml::ModelPtr model3 = p.parseModel(in);
+    model3->resolveImports("importing.cellml", library);
+    EXPECT_EQ("second", model3->component("c")->importSource()->model()->name());
+    EXPECT_EQ(size_t(1), library.modelCount());
+    EXPECT_EQ(importedModel, model1->component("c")->importSource()->model());
+
+    // A library can be copied and cleared.
+    libcellml::ImportLibrary copy(library);
+    library.clear();
+    EXPECT_EQ(size_t(0), library.modelCount());
+    EXPECT_EQ(size_t(1), copy.modelCount());
+
+    std::remove(url.c_str());
+    EXPECT_EQ(nullptr, copy.importedModel(url));
+}
+
+TEST(ResolveImports, mutableModelAfterSharingModel)
+{
+    libcellml::ImportSourcePtr importSource1 = std::make_shared<libcellml::ImportSource>();
+    libcellml::ImportSourcePtr importSource2 = std::make_shared<libcellml::ImportSource>();
+    importSource1->setModel(std::make_shared<libcellml::Model>());
+
+    // Sharing a model after it was modified copies it on the next change.
+    importSource1->mutableModel()->setName("first");
+    importSource2->setModel(importSource1->model());
+    importSource1->mutableModel()->setName("second");
+    EXPECT_EQ("second", importSource1->model()->name());
+    EXPECT_EQ("first", importSource2->model()->name());
+
+    // Holding on to the model for modification does not copy it again.
+    libcellml::ModelPtr mutableModel = importSource1->mutableModel();
+    EXPECT_EQ(mutableModel, importSource1->mutableModel());
+    mutableModel->setName("third");
+    EXPECT_EQ("third", importSource1->model()->name());
+
+    // Neither do copies of the import source going away.
+    {
+        libcellml::ImportSource copy(*importSource1);
+    }
+    EXPECT_EQ(mutableModel, importSource1->mutableModel());
+}
+
+TEST(ResolveImports, flattenImportsModelFromFile)
+{
+    const std::string modelLocation = TestResources::location(
+        TestResources::CELLML_SINE_IMPORTS_MODEL_RESOURCE);
+    std::ifstream t(modelLocation);
+    std::stringstream buffer;
+    buffer << t.rdbuf();
+
+    libcellml::Parser p;
+    libcellml::ModelPtr model = p.parseModel(buffer.str());
+    model->resolveImports(modelLocation);
+
+    libcellml::ModelPtr flatModel = model->flatten();
+    EXPECT_FALSE(flatModel->hasUnresolvedImports());
+    EXPECT_TRUE(model->component("actual_sin", true)->isImport());
+
+    libcellml::ComponentPtr main = flatModel->component("main");
+    EXPECT_EQ(size_t(3), main->componentCount());
+    libcellml::ComponentPtr actualSin = main->component("actual_sin");
+    EXPECT_FALSE(actualSin->isImport());
+    EXPECT_EQ(main.get(), actualSin->parent());
+    EXPECT_FALSE(actualSin->math().empty());
+    EXPECT_TRUE(actualSin->variable("sin")->hasEquivalentVariable(main->variable("sin1")));
+    EXPECT_TRUE(actualSin->variable("x")->hasEquivalentVariable(main->variable("x")));
+    libcellml::ComponentPtr derivApproxSin = main->component("deriv_approx_sin");
+    EXPECT_TRUE(derivApproxSin->variable("sin_initial_value")->hasEquivalentVariable(main->variable("deriv_approx_initial_value")));
+}
+
+TEST(ResolveImports, flattenImportedUnits)
+{
+    libcellml::ModelPtr importedModel = std::make_shared<libcellml::Model>();
+    libcellml::UnitsPtr millisecond = std::make_shared<libcellml::Units>();
+    millisecond->setName("ms");
+    millisecond->addUnit("second", "milli");
+    libcellml::UnitsPtr rate = std::make_shared<libcellml::Units>();
+    rate->setName("rate");
+    rate->addUnit("ms", -1.0);
+    importedModel->addUnits(millisecond);
+    importedModel->addUnits(rate);
+    libcellml::ComponentPtr importedComponent = std::make_shared<libcellml::Component>();
+    importedComponent->setName("c");
+    libcellml::VariablePtr k = std::make_shared<libcellml::Variable>();
+    k->setName("k");
+    k->setUnits("rate");
+    importedComponent->addVariable(k);
+    importedModel->addComponent(importedComponent);
+
+    libcellml::ImportSourcePtr importSource = std::make_shared<libcellml::ImportSource>();
+    importSource->setUrl("imported.cellml");
+    importSource->setModel(importedModel);
+
+    libcellml::ModelPtr model = std::make_shared<libcellml::Model>();
+    libcellml::UnitsPtr localMillisecond = std::make_shared<libcellml::Units>();
+    localMillisecond->setName("ms");
+    localMillisecond->addUnit("metre", "milli");
+    libcellml::UnitsPtr importedRate = std::make_shared<libcellml::Units>();
+    importedRate->setName("per_ms");
+    importedRate->setSourceUnits(importSource, "rate");
+    model->addUnits(localMillisecond);
+    model->addUnits(importedRate);
+    libcellml::ComponentPtr component = std::make_shared<libcellml::Component>();
+    component->setName("c1");
+    component->setSourceComponent(importSource, "c");
+    model->addComponent(component);
+
+    libcellml::ModelPtr flatModel = model->flatten();
+    EXPECT_FALSE(flatModel->hasUnresolvedImports());
+    EXPECT_EQ(size_t(3), flatModel->unitsCount());
+
+    // The imported units refer to a copy of "ms", renamed since "ms" is used.
+    std::string reference;
+    std::string prefix;
+    double exponent;
+    double multiplier;
+    std::string id;
+    libcellml::UnitsPtr flatRate = flatModel->units("per_ms");
+    EXPECT_FALSE(flatRate->isImport());
+    flatRate->unitAttributes(0, reference, prefix, exponent, multiplier, id);
+    EXPECT_EQ("ms_1", reference);
+    EXPECT_EQ(-1.0, exponent);
+    flatModel->units("ms_1")->unitAttributes(0, reference, prefix, exponent, multiplier, id);
+    EXPECT_EQ("second", reference);
+    EXPECT_EQ("milli", prefix);
+
+    // The units of the imported component are copied too, once.
+    libcellml::ComponentPtr flatComponent = flatModel->component("c1");
+    EXPECT_FALSE(flatComponent->isImport());
+    EXPECT_EQ("per_ms", flatComponent->variable("k")->units());
+    EXPECT_EQ(flatModel.get(), flatComponent->parent());
+}
+
+TEST(ResolveImports, flattenUnitsOfConstants)
+{
+    const std::string math =
+        "<math xmlns=\"http://www.w3.org/1998/Math/MathML\" xmlns:cellml=\"http://www.cellml.org/cellml/2.0#\">\n"
+        "  <apply>\n"
+        "    <eq/>\n"
+        "    <ci>k</ci>\n"
+        "    <cn cellml:units=\"per_ms\">2</cn>\n"
+        "  </apply>\n"
+        "</math>\n";
+    libcellml::ModelPtr importedModel = std::make_shared<libcellml::Model>();
+    importedModel->setName("library");
+    libcellml::UnitsPtr perMillisecond = std::make_shared<libcellml::Units>();
+    perMillisecond->setName("per_ms");
+    perMillisecond->addUnit("second", "milli", -1.0);
+    importedModel->addUnits(perMillisecond);
+    libcellml::ComponentPtr importedComponent = std::make_shared<libcellml::Component>();
+    importedComponent->setName("c");
+    libcellml::VariablePtr k = std::make_shared<libcellml::Variable>();
+    k->setName("k");
+    k->setUnits("hertz");
+    k->setInterfaceType("public");
+    importedComponent->addVariable(k);
+    importedComponent->setMath(math);
+    importedModel->addComponent(importedComponent);
+    libcellml::Validator validator;
+    validator.validateModel(importedModel);
+    EXPECT_EQ(size_t(0), validator.errorCount());
+
+    libcellml::ImportSourcePtr importSource = std::make_shared<libcellml::ImportSource>();
+    importSource->setUrl("library.cellml");
+    importSource->setModel(importedModel);
+    libcellml::ModelPtr model = std::make_shared<libcellml::Model>();
+    model->setName("model");
+    libcellml::UnitsPtr localPerMillisecond = std::make_shared<libcellml::Units>();
+    localPerMillisecond->setName("per_ms");
+    localPerMillisecond->addUnit("metre", "milli", -1.0);
+    model->addUnits(localPerMillisecond);
+    libcellml::ComponentPtr component = std::make_shared<libcellml::Component>();
+    component->setName("c1");
+    component->setSourceComponent(importSource, "c");
+    model->addComponent(component);
+
+    // The units used only by constants are copied, and renamed since
+    // "per_ms" is used.
+    libcellml::ModelPtr flatModel = model->flatten();
+    EXPECT_EQ(size_t(2), flatModel->unitsCount());
+    EXPECT_NE(nullptr, flatModel->units("per_ms_1"));
+    EXPECT_NE(std::string::npos, flatModel->component("c1")->math().find("cellml:units=\"per_ms_1\""));
+    validator.validateModel(flatModel);
+    EXPECT_EQ(size_t(0), validator.errorCount());
+}
+
+TEST(ResolveImports, hasUnresolvedImportsFollowsChanges)
+{
+    libcellml::ModelPtr importedModel = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr importedComponent = std::make_shared<libcellml::Component>();
+    importedComponent->setName("c");
+    importedModel->addComponent(importedComponent);
+
+    libcellml::ImportSourcePtr importSource = std::make_shared<libcellml::ImportSource>();
+    importSource->setUrl("imported.cellml");
+    libcellml::ModelPtr model = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr component = std::make_shared<libcellml::Component>();
+    component->setName("c1");
+    component->setSourceComponent(importSource, "c");
+    model->addComponent(component);
+    EXPECT_TRUE(model->hasUnresolvedImports());
+    EXPECT_TRUE(model->hasUnresolvedImports());
+
+    // Resolving the import source.
+    importSource->setModel(importedModel);
+    EXPECT_EQ(importedComponent, importSource->importedComponent("c"));
+    EXPECT_FALSE(model->hasUnresolvedImports());
+    EXPECT_FALSE(model->hasUnresolvedImports());
+
+    // Changing the import reference.
+    component->setImportReference("d");
+    EXPECT_TRUE(model->hasUnresolvedImports());
+    component->setImportReference("c");
+    EXPECT_FALSE(model->hasUnresolvedImports());
+
+    // Adding an unresolved import to the imported model.
+    libcellml::ImportSourcePtr nestedImportSource = std::make_shared<libcellml::ImportSource>();
+    libcellml::ComponentPtr nestedComponent = std::make_shared<libcellml::Component>();
+    nestedComponent->setName("n");
+    nestedComponent->setSourceComponent(nestedImportSource, "n");
+    importedComponent->addComponent(nestedComponent);
+    EXPECT_TRUE(model->hasUnresolvedImports());
+
+    // Resolving the nested import source.
+    libcellml::ModelPtr nestedModel = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr n = std::make_shared<libcellml::Component>();
+    n->setName("n");
+    nestedModel->addComponent(n);
+    nestedImportSource->setModel(nestedModel);
+    EXPECT_FALSE(model->hasUnresolvedImports());
+
+    // Removing the component from the nested model.
+    nestedModel->removeComponent(n);
+    EXPECT_EQ(nullptr, nestedImportSource->importedComponent("n"));
+    EXPECT_TRUE(model->hasUnresolvedImports());
+
+    // Changing the URL forgets the components looked up.
+    nestedModel->addComponent(n);
+    nestedImportSource->setUrl("nested.cellml");
+    EXPECT_EQ(n, nestedImportSource->importedComponent("n"));
+    EXPECT_FALSE(model->hasUnresolvedImports());
+
+    // Removing the imported component.
+    model->removeComponent(component);
+    EXPECT_FALSE(model->hasUnresolvedImports());
+
+    // Changing a component that replaced another one.
+    libcellml::ComponentPtr replacement = std::make_shared<libcellml::Component>();
+    replacement->setSourceComponent(importSource, "c");
+    model->addComponent(std::make_shared<libcellml::Component>());
+    EXPECT_TRUE(model->replaceComponent(0, replacement));
+    EXPECT_EQ(model.get(), replacement->parent());
+    EXPECT_FALSE(model->hasUnresolvedImports());
+    replacement->setImportReference("does_not_exist");
+    EXPECT_TRUE(model->hasUnresolvedImports());
+}
@@ -0,0 +1,227 @@
+/*
+Copyright libCellML Contributors
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "gtest/gtest.h"
+
+#include "test_resources.h"
+#include "test_utils.h"
+
+#include <cmath>
+#include <fstream>
+#include <libcellml>
+#include <sstream>
+#include <vector>
+
+static libcellml::ModelPtr createDecayModel()
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr c = std::make_shared<libcellml::Component>();
+    c->setName("main");
+    m->addComponent(c);
+    createVariable(c, "t");
+    createVariable(c, "x", "1");
+    createVariable(c, "k", "2");
+    c->setMath(mathStart
+               + "<apply><eq/><apply><diff/><bvar><ci>t</ci></bvar><ci>x</ci></apply>"
+                 "<apply><minus/><apply><times/><ci>k</ci><ci>x</ci></apply></apply></apply>"
+               + mathEnd);
+    return m;
+}
+
+static double maximumDecayError(libcellml::Solver::Method method, double step)
+{
+    libcellml::Evaluator e;
+    e.processModel(createDecayModel());
+    std::vector<double> states(e.stateCount());
+    std::vector<double> variables(e.variableCount());
+    e.initialiseStatesAndConstants(states.data(), variables.data());
+    e.computeComputedConstants(variables.data());
+
+    libcellml::Solver s;
+    s.setMethod(method);
+    s.setStep(step);
+    const size_t pointCount = 11;
+    const size_t rowSize = 1 + e.stateCount() + e.variableCount();
+    std::vector<double> output(pointCount * rowSize);
+    EXPECT_TRUE(s.solve(e, states.data(), variables.data(), 0.0, 1.0, pointCount, output.data()));
+    EXPECT_EQ(size_t(0), s.errorCount());
+
+    double maximumError = 0.0;
+    for (size_t i = 0; i < pointCount; ++i) {
+        double voi = output.at(i * rowSize);
+        EXPECT_NEAR(0.1 * static_cast<double>(i), voi, 1.0e-12);
+        maximumError = std::max(maximumError, std::fabs(output.at(i * rowSize + 1) - std::exp(-2.0 * voi)));
+    }
+    return maximumError;
+}
+
+TEST(Solver, defaults)
+{
+    libcellml::Solver s;
+
+    EXPECT_EQ(libcellml::Solver::Method::RUNGE_KUTTA_4, s.method());
+    EXPECT_EQ(1.0e-3, s.step());
+    EXPECT_EQ(0.0, s.maximumStep());
+    EXPECT_EQ(1.0e-6, s.relativeTolerance());
+    EXPECT_EQ(1.0e-8, s.absoluteTolerance());
+}
+
+TEST(Solver, copyAndMove)
+{
+    libcellml::Solver s;
+    s.setMethod(libcellml::Solver::Method::FORWARD_EULER);
+    libcellml::Solver moved(std::move(s));
+    EXPECT_EQ(libcellml::Solver::Method::FORWARD_EULER, moved.method());
+
+    // Moved from solvers can be moved from again and assigned to.
+    libcellml::Solver movedAgain(std::move(s));
+    s = moved;
+    EXPECT_EQ(libcellml::Solver::Method::FORWARD_EULER, s.method());
+}
+
+TEST(Solver, exponentialDecay)
+{
+    EXPECT_LT(maximumDecayError(libcellml::Solver::Method::FORWARD_EULER, 1.0e-4), 1.0e-4);
+    EXPECT_LT(maximumDecayError(libcellml::Solver::Method::RUNGE_KUTTA_4, 1.0e-2), 1.0e-8);
+    EXPECT_LT(maximumDecayError(libcellml::Solver::Method::DORMAND_PRINCE_54, 1.0e-2), 1.0e-6);
+    // The decay is linear, so Rush-Larsen is exact even with a large step.
+    EXPECT_LT(maximumDecayError(libcellml::Solver::Method::RUSH_LARSEN, 1.0e-1), 1.0e-12);
+}
+
+TEST(Solver, invalidArguments)
+{
+    libcellml::Evaluator e;
+    libcellml::Solver s;
+    double output[3];
+
+    EXPECT_FALSE(s.solve(e, nullptr, nullptr, 0.0, 1.0, 2, output));
+    EXPECT_EQ(size_t(1), s.errorCount());
+    EXPECT_EQ("Evaluator does not hold a successfully processed model.", s.error(0)->description());
+
+    e.processModel(createDecayModel());
+    EXPECT_FALSE(s.solve(e, nullptr, nullptr, 0.0, 1.0, 1, output));
+    EXPECT_EQ("The number of output points must be at least two.", s.error(0)->description());
+    EXPECT_FALSE(s.solve(e, nullptr, nullptr, 1.0, 0.0, 2, output));
+    EXPECT_EQ("The end of the integration interval must be greater than its start.", s.error(0)->description());
+    s.setStep(0.0);
+    EXPECT_FALSE(s.solve(e, nullptr, nullptr, 0.0, 1.0, 2, output));
+    EXPECT_EQ("The step size must be greater than zero.", s.error(0)->description());
+}
+
+TEST(Solver, sawtoothReset)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr c = std::make_shared<libcellml::Component>();
+    c->setName("main");
+    m->addComponent(c);
+    createVariable(c, "t");
+    libcellml::VariablePtr x = createVariable(c, "x", "0");
+    c->setMath(mathStart
+               + "<apply><eq/><apply><diff/><bvar><ci>t</ci></bvar><ci>x</ci></apply><cn cellml:units=\"dimensionless\">1</cn></apply>"
+               + mathEnd);
+    libcellml::ResetPtr r = std::make_shared<libcellml::Reset>();
+    libcellml::WhenPtr w = std::make_shared<libcellml::When>();
+    r->setVariable(x);
+    r->setOrder(1);
+    w->setOrder(1);
+    w->setCondition(mathStart + "<apply><geq/><ci>x</ci><cn cellml:units=\"dimensionless\">1</cn></apply>" + mathEnd);
+    w->setValue(mathStart + "<cn cellml:units=\"dimensionless\">0</cn>" + mathEnd);
+    r->addWhen(w);
+    c->addReset(r);
+
+    libcellml::Evaluator e;
+    e.processModel(m);
+    EXPECT_EQ(size_t(0), e.errorCount());
+    EXPECT_EQ(size_t(1), e.whenCount());
+
+    std::vector<double> states(e.stateCount());
+    std::vector<double> variables(e.variableCount());
+    e.initialiseStatesAndConstants(states.data(), variables.data());
+
+    libcellml::Solver s;
+    s.setMethod(libcellml::Solver::Method::FORWARD_EULER);
+    s.setStep(0.125);
+    const size_t pointCount = 21;
+    std::vector<double> output(pointCount * 2);
+    EXPECT_TRUE(s.solve(e, states.data(), variables.data(), 0.0, 2.5, pointCount, output.data()));
+
+    // The state ramps up from zero and is reset back to zero on reaching one.
+    for (size_t i = 0; i < pointCount; ++i) {
+        double voi = output.at(2 * i);
+        EXPECT_EQ(voi - std::floor(voi), output.at(2 * i + 1));
+    }
+}
+
+TEST(Solver, ohara_rudy)
+{
+    std::ifstream t(TestResources::location(
+        TestResources::CELLML_ORD_MODEL_RESOURCE));
+    std::stringstream buffer;
+    buffer << t.rdbuf();
+
+    libcellml::Parser p;
+    libcellml::ModelPtr model = p.parseModel(buffer.str());
+    libcellml::Evaluator e;
+    e.processModel(model);
+
+    std::vector<double> states(e.stateCount());
+    std::vector<double> variables(e.variableCount());
+    e.initialiseStatesAndConstants(states.data(), variables.data());
+    e.computeComputedConstants(variables.data());
+
+    libcellml::Solver s;
+    s.setMethod(libcellml::Solver::Method::FORWARD_EULER);
+    s.setStep(0.005);
+    const size_t pointCount = 11;
+    std::vector<double> output(pointCount * (1 + e.stateCount() + e.variableCount()));
+    EXPECT_TRUE(s.solve(e, states.data(), variables.data(), 0.0, 10.0, pointCount, output.data()));
+    EXPECT_EQ(size_t(0), s.errorCount());
+    for (double value : states) {
+        EXPECT_TRUE(std::isfinite(value));
+    }
+    // The stimulus at the start of the run triggers an action potential.
+    EXPECT_GT(states.at(0), 0.0);
+}
+
+TEST(Solver, ohara_rudyRushLarsen)
+{
+    std::ifstream t(TestResources::location(
+        TestResources::CELLML_ORD_MODEL_RESOURCE));
+    std::stringstream buffer;
+    buffer << t.rdbuf();
+
+    libcellml::Parser p;
+    libcellml::ModelPtr model = p.parseModel(buffer.str());
+    libcellml::Evaluator e;
+    e.processModel(model);
+
+    std::vector<double> states(e.stateCount());
+    std::vector<double> variables(e.variableCount());
+    e.initialiseStatesAndConstants(states.data(), variables.data());
+    e.computeComputedConstants(variables.data());
+
+    // Forward Euler is unstable at this step size.
+    libcellml::Solver s;
+    s.setMethod(libcellml::Solver::Method::RUSH_LARSEN);
+    s.setStep(0.1);
+    const size_t pointCount = 11;
+    std::vector<double> output(pointCount * (1 + e.stateCount() + e.variableCount()));
+    EXPECT_TRUE(s.solve(e, states.data(), variables.data(), 0.0, 100.0, pointCount, output.data()));
+    EXPECT_EQ(size_t(0), s.errorCount());
+    for (double value : states) {
+        EXPECT_TRUE(std::isfinite(value));
+    }
+}
@@ -18,6 +18,9 @@ limitations under the License.
 
 #include <iostream>
 
+const std::string mathStart = "<math xmlns=\"http://www.w3.org/1998/Math/MathML\" xmlns:cellml=\"http://www.cellml.org/cellml/2.0#\">";
+const std::string mathEnd = "</math>";
+
 void printErrors(const libcellml::Validator &v)
 {
     for (size_t i = 0; i < v.errorCount(); ++i) {
@@ -49,3 +52,15 @@ libcellml::ModelPtr createModelWithComponent(const std::string &name)
     model->addComponent(component);
     return model;
 }
+
+libcellml::VariablePtr createVariable(const libcellml::ComponentPtr &component, const std::string &name, const std::string &initialValue)
+{
+    libcellml::VariablePtr v = std::make_shared<libcellml::Variable>();
+    v->setName(name);
+    v->setUnits("dimensionless");
+    if (!initialValue.empty()) {
+        v->setInitialValue(initialValue);
+    }
+    component->addVariable(v);
+    return v;
+}
@@ -9,5 +9,9 @@ void printErrors(const libcellml::Parser &p);
 
 libcellml::ModelPtr createModel(const std::string &name = "");
 libcellml::ModelPtr createModelWithComponent(const std::string &name = "");
+libcellml::VariablePtr createVariable(const libcellml::ComponentPtr &component, const std::string &name, const std::string &initialValue = "");
+
+extern const std::string mathStart;
+extern const std::string mathEnd;
 
 #endif
@@ -541,6 +541,36 @@ TEST(Units, removeUnit)
     EXPECT_EQ(size_t(0), u.unitCount());
 }
 
+TEST(Units, unitExponentAndMultiplier)
+{
+    libcellml::UnitsPtr u = std::make_shared<libcellml::Units>();
+    u->setName("awkward");
+
+    // Values that need all their digits are kept exactly.
+    const double exponent = 1.0 / 3.0;
+    const double multiplier = 0.1 + 0.2;
+    u->addUnit("metre", "milli", exponent, multiplier);
+    u->addUnit("second");
+
+    EXPECT_EQ(exponent, u->unitExponent(0));
+    EXPECT_EQ(multiplier, u->unitMultiplier(0));
+    EXPECT_EQ(1.0, u->unitExponent(1));
+    EXPECT_EQ(1.0, u->unitMultiplier(1));
+
+    std::string reference;
+    std::string prefix;
+    std::string id;
+    double attributeExponent;
+    double attributeMultiplier;
+    u->unitAttributes(0, reference, prefix, attributeExponent, attributeMultiplier, id);
+    EXPECT_EQ(exponent, attributeExponent);
+    EXPECT_EQ(multiplier, attributeMultiplier);
+
+    // Get non-existent unit.
+    EXPECT_EQ(1.0, u->unitExponent(2));
+    EXPECT_EQ(1.0, u->unitMultiplier(2));
+}
+
 TEST(Units, multipleAndParse)
 {
     const std::string e =
@@ -607,3 +637,229 @@ TEST(Units, unitsWithPrefixOutOfRange)
 
     EXPECT_EQ(size_t(0), validator.errorCount());
 }
+
+TEST(Units, compatibleAndEquivalent)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+
+    libcellml::UnitsPtr millivolt = std::make_shared<libcellml::Units>();
+    millivolt->setName("mV");
+    millivolt->addUnit(libcellml::Units::StandardUnit::VOLT, libcellml::Prefix::MILLI);
+    libcellml::UnitsPtr thousandthVolt = std::make_shared<libcellml::Units>();
+    thousandthVolt->setName("thousandth_volt");
+    thousandthVolt->addUnit(libcellml::Units::StandardUnit::VOLT, 0, 1.0, 0.001);
+    libcellml::UnitsPtr volt = std::make_shared<libcellml::Units>();
+    volt->setName("V");
+    volt->addUnit(libcellml::Units::StandardUnit::VOLT);
+    libcellml::UnitsPtr perMillisecond = std::make_shared<libcellml::Units>();
+    perMillisecond->setName("per_ms");
+    perMillisecond->addUnit(libcellml::Units::StandardUnit::SECOND, libcellml::Prefix::MILLI, -1.0);
+    libcellml::UnitsPtr millivoltPerMillisecond = std::make_shared<libcellml::Units>();
+    millivoltPerMillisecond->setName("mV_per_ms");
+    millivoltPerMillisecond->addUnit("mV");
+    millivoltPerMillisecond->addUnit("per_ms");
+    libcellml::UnitsPtr voltPerSecond = std::make_shared<libcellml::Units>();
+    voltPerSecond->setName("V_per_s");
+    voltPerSecond->addUnit("kilogram");
+    voltPerSecond->addUnit("metre", 2.0);
+    voltPerSecond->addUnit("second", -4.0);
+    voltPerSecond->addUnit("ampere", -1.0);
+    m->addUnits(millivolt);
+    m->addUnits(thousandthVolt);
+    m->addUnits(volt);
+    m->addUnits(perMillisecond);
+    m->addUnits(millivoltPerMillisecond);
+    m->addUnits(voltPerSecond);
+
+    EXPECT_TRUE(libcellml::Units::compatible(millivolt, volt));
+    EXPECT_FALSE(libcellml::Units::equivalent(millivolt, volt));
+    EXPECT_TRUE(libcellml::Units::equivalent(millivolt, thousandthVolt));
+    EXPECT_FALSE(libcellml::Units::compatible(millivolt, perMillisecond));
+    EXPECT_TRUE(libcellml::Units::equivalent(millivoltPerMillisecond, voltPerSecond));
+    EXPECT_FALSE(libcellml::Units::compatible(millivolt, nullptr));
+
+    // Changing a units invalidates the cached reductions.
+    millivolt->addUnit("second", -1.0);
+    EXPECT_FALSE(libcellml::Units::compatible(millivolt, volt));
+    EXPECT_TRUE(libcellml::Units::compatible(millivolt, voltPerSecond));
+    EXPECT_FALSE(libcellml::Units::equivalent(millivoltPerMillisecond, voltPerSecond));
+    millivolt->removeUnit("second");
+    EXPECT_TRUE(libcellml::Units::equivalent(millivolt, thousandthVolt));
+    EXPECT_TRUE(libcellml::Units::equivalent(millivoltPerMillisecond, voltPerSecond));
+}
+
+TEST(Units, compatibleBaseAndImportedUnits)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::UnitsPtr fish = std::make_shared<libcellml::Units>();
+    fish->setName("fish");
+    libcellml::UnitsPtr kilofish = std::make_shared<libcellml::Units>();
+    kilofish->setName("kilofish");
+    kilofish->addUnit("fish", "kilo");
+    libcellml::UnitsPtr fishPerFish = std::make_shared<libcellml::Units>();
+    fishPerFish->setName("fish_per_fish");
+    fishPerFish->addUnit("fish");
+    fishPerFish->addUnit("kilofish", -1.0);
+    libcellml::UnitsPtr dimensionless = std::make_shared<libcellml::Units>();
+    dimensionless->setName("ratio");
+    dimensionless->addUnit("dimensionless", 3, 1.0);
+    m->addUnits(fish);
+    m->addUnits(kilofish);
+    m->addUnits(fishPerFish);
+    m->addUnits(dimensionless);
+
+    EXPECT_TRUE(libcellml::Units::compatible(fish, kilofish));
+    EXPECT_FALSE(libcellml::Units::equivalent(fish, kilofish));
+    EXPECT_FALSE(libcellml::Units::compatible(fish, dimensionless));
+    EXPECT_TRUE(libcellml::Units::compatible(fishPerFish, dimensionless));
+    EXPECT_FALSE(libcellml::Units::equivalent(fishPerFish, dimensionless));
+
+    // Imported units are reduced in the model they are imported from, once
+    // the import is resolved.
+    libcellml::ModelPtr importing = std::make_shared<libcellml::Model>();
+    libcellml::ImportSourcePtr importSource = std::make_shared<libcellml::ImportSource>();
+    importSource->setUrl("fish.cellml");
+    libcellml::UnitsPtr imported = std::make_shared<libcellml::Units>();
+    imported->setName("imported_kilofish");
+    imported->setSourceUnits(importSource, "kilofish");
+    importing->addUnits(imported);
+    EXPECT_FALSE(libcellml::Units::compatible(imported, kilofish));
+    importSource->setModel(m);
+    EXPECT_TRUE(libcellml::Units::equivalent(imported, kilofish));
+
+    // Units defined in terms of themselves or of unknown units cannot be
+    // reduced.
+    libcellml::UnitsPtr a = std::make_shared<libcellml::Units>();
+    a->setName("a");
+    a->addUnit("b");
+    libcellml::UnitsPtr b = std::make_shared<libcellml::Units>();
+    b->setName("b");
+    b->addUnit("a", 2.0);
+    libcellml::UnitsPtr c = std::make_shared<libcellml::Units>();
+    c->setName("c");
+    c->addUnit("unknown");
+    m->addUnits(a);
+    m->addUnits(b);
+    m->addUnits(c);
+    EXPECT_FALSE(libcellml::Units::compatible(a, a));
+    EXPECT_FALSE(libcellml::Units::compatible(c, c));
+    b->removeUnit("a");
+    b->addUnit("second");
+    EXPECT_TRUE(libcellml::Units::equivalent(a, b));
+}
+
+TEST(Units, conversionFactor)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::UnitsPtr millivolt = std::make_shared<libcellml::Units>();
+    millivolt->setName("mV");
+    millivolt->addUnit("volt", "milli");
+    libcellml::UnitsPtr millisecond = std::make_shared<libcellml::Units>();
+    millisecond->setName("ms");
+    millisecond->addUnit("second", -3, 1.0);
+    libcellml::UnitsPtr millivoltPerMillisecond = std::make_shared<libcellml::Units>();
+    millivoltPerMillisecond->setName("mV_per_ms");
+    millivoltPerMillisecond->addUnit("mV");
+    millivoltPerMillisecond->addUnit("ms", -1.0);
+    libcellml::UnitsPtr microvoltPerHour = std::make_shared<libcellml::Units>();
+    microvoltPerHour->setName("uV_per_hour");
+    microvoltPerHour->addUnit("volt", "micro");
+    microvoltPerHour->addUnit("second", 0, -1.0, 3600.0);
+    libcellml::UnitsPtr squareCentimetre = std::make_shared<libcellml::Units>();
+    squareCentimetre->setName("cm2");
+    squareCentimetre->addUnit("metre", "centi", 2.0);
+    m->addUnits(millivolt);
+    m->addUnits(millisecond);
+    m->addUnits(millivoltPerMillisecond);
+    m->addUnits(microvoltPerHour);
+    libcellml::UnitsPtr squareMetre = std::make_shared<libcellml::Units>();
+    squareMetre->setName("m2");
+    squareMetre->addUnit("metre", 2.0);
+    libcellml::UnitsPtr cubicMetre = std::make_shared<libcellml::Units>();
+    cubicMetre->setName("m3");
+    cubicMetre->addUnit("metre", 3.0);
+    m->addUnits(squareCentimetre);
+    m->addUnits(squareMetre);
+    m->addUnits(cubicMetre);
+
+    double factor = 0.0;
+    EXPECT_TRUE(libcellml::Units::conversionFactor(m, "mV", "volt", factor));
+    EXPECT_DOUBLE_EQ(1.0e-3, factor);
+    EXPECT_TRUE(libcellml::Units::conversionFactor(m, "volt", "mV", factor));
+    EXPECT_DOUBLE_EQ(1.0e3, factor);
+    EXPECT_TRUE(libcellml::Units::conversionFactor(millivoltPerMillisecond, m->units("mV_per_ms"), factor));
+    EXPECT_DOUBLE_EQ(1.0, factor);
+    // 1 mV/ms = 1000 uV per 1/3600000 hour.
+    EXPECT_TRUE(libcellml::Units::conversionFactor(millivoltPerMillisecond, microvoltPerHour, factor));
+    EXPECT_DOUBLE_EQ(3.6e9, factor);
+    EXPECT_TRUE(libcellml::Units::conversionFactor(squareCentimetre, squareMetre, factor));
+    EXPECT_DOUBLE_EQ(1.0e-4, factor);
+    EXPECT_TRUE(libcellml::Units::conversionFactor(m, "litre", "m3", factor));
+    EXPECT_DOUBLE_EQ(1.0e-3, factor);
+    EXPECT_TRUE(libcellml::Units::conversionFactor(nullptr, "gram", "kilogram", factor));
+    EXPECT_DOUBLE_EQ(1.0e-3, factor);
+    EXPECT_TRUE(libcellml::Units::conversionFactor(nullptr, "liter", "litre", factor));
+    EXPECT_DOUBLE_EQ(1.0, factor);
+
+    // Different dimensions and units that cannot be reduced have no
+    // conversion factor, and the logger is told which it is.
+    const std::vector<std::string> expectedErrors = {
+        "Units 'mV' and 'ms' have different dimensions and cannot be converted to each other.",
+        "Units 'unknown' cannot be found or reduced to base units.",
+        "The units to convert from and to must both be given.",
+        "Units 'mV' and 'ms' have different dimensions and cannot be converted to each other.",
+        "Units 'base' cannot be reduced to base units.",
+    };
+    libcellml::UnitsPtr base = std::make_shared<libcellml::Units>();
+    base->setName("base");
+    base->addUnit("base");
+    libcellml::Logger logger;
+    factor = 2.0;
+    EXPECT_FALSE(libcellml::Units::conversionFactor(m, "mV", "ms", factor, &logger));
+    EXPECT_FALSE(libcellml::Units::conversionFactor(m, "mV", "unknown", factor, &logger));
+    EXPECT_FALSE(libcellml::Units::conversionFactor(millivolt, nullptr, factor, &logger));
+    EXPECT_FALSE(libcellml::Units::conversionFactor(millivolt, millisecond, factor, &logger));
+    EXPECT_FALSE(libcellml::Units::conversionFactor(base, millivolt, factor, &logger));
+    EXPECT_FALSE(libcellml::Units::conversionFactor(m, "mV", "ms", factor));
+    EXPECT_EQ(2.0, factor);
+    EXPECT_EQ(expectedErrors.size(), logger.errorCount());
+    for (size_t i = 0; i < logger.errorCount(); ++i) {
+        EXPECT_EQ(expectedErrors.at(i), logger.error(i)->description());
+        EXPECT_EQ(libcellml::Error::Kind::UNITS, logger.error(i)->kind());
+    }
+}
+
+TEST(Units, conversionFactorAfterReplaceAndChanges)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::UnitsPtr millisecond = std::make_shared<libcellml::Units>();
+    millisecond->setName("ms");
+    millisecond->addUnit("second", "milli");
+    libcellml::UnitsPtr time = std::make_shared<libcellml::Units>();
+    time->setName("time");
+    time->addUnit("second");
+    libcellml::UnitsPtr second = std::make_shared<libcellml::Units>();
+    second->setName("s");
+    second->addUnit("second");
+    m->addUnits(millisecond);
+    m->addUnits(time);
+
+    // The replacing units refer to units of the model they are now in.
+    libcellml::UnitsPtr replacement = std::make_shared<libcellml::Units>();
+    replacement->setName("time");
+    replacement->addUnit("ms");
+    EXPECT_TRUE(m->replaceUnits("time", replacement));
+    EXPECT_EQ(m.get(), replacement->parent());
+    EXPECT_TRUE(libcellml::Units::compatible(replacement, second));
+    double factor = 0.0;
+    EXPECT_TRUE(libcellml::Units::conversionFactor(replacement, second, factor));
+    EXPECT_DOUBLE_EQ(1.0e-3, factor);
+
+    // Changes to the units referred to are taken into account.
+    millisecond->removeAllUnits();
+    millisecond->addUnit("second", "micro");
+    EXPECT_TRUE(libcellml::Units::conversionFactor(replacement, second, factor));
+    EXPECT_DOUBLE_EQ(1.0e-6, factor);
+    millisecond->setName("us");
+    EXPECT_FALSE(libcellml::Units::compatible(replacement, second));
+}
@@ -747,6 +747,7 @@ TEST(Validator, validateInvalidConnections)
     const std::vector<std::string> expectedErrors = {
         "Variable 'variable4' is an equivalent variable to 'variable1_1' but has no parent component.",
         "Variable 'variable2' has an equivalent variable 'variable1_2'  which does not reciprocally have 'variable2' set as an equivalent variable.",
+        "Variable 'variable2' in component 'component2' and variable 'variable3' in component 'component3' are equivalent but are already connected through other equivalent variables.",
     };
 
     libcellml::Validator v;
@@ -778,6 +779,12 @@ TEST(Validator, validateInvalidConnections)
     v3->setUnits("dimensionless");
     v4->setUnits("dimensionless");
 
+    v1_1->setInterfaceType("public");
+    v1_2->setInterfaceType("public");
+    v2->setInterfaceType("public");
+    v3->setInterfaceType("public");
+    v4->setInterfaceType("public");
+
     comp1->addVariable(v1_1);
     comp1->addVariable(v1_2);
     comp2->addVariable(v2);
@@ -788,7 +795,7 @@ TEST(Validator, validateInvalidConnections)
     m->addComponent(comp3);
     m->addComponent(comp4);
 
-    // Valid connections.
+    // Valid connections, except for v2 - v3, which duplicates v2 - v1_1 - v3.
     libcellml::Variable::addEquivalence(v1_1, v2);
     libcellml::Variable::addEquivalence(v1_2, v2);
     libcellml::Variable::addEquivalence(v1_1, v3);
@@ -807,6 +814,75 @@ TEST(Validator, validateInvalidConnections)
     }
 }
 
+TEST(Validator, validateConnectionInterfaces)
+{
+    const std::vector<std::string> expectedErrors = {
+        "Variable 'x' in component 'parent' and variable 'x' in component 'child1' are equivalent but variable 'x' does not have a private interface.",
+        "Variable 'y' in component 'parent' and variable 'y' in component 'grandchild' are equivalent but their components are neither siblings nor parent and child.",
+        "Variable 'x' in component 'child1' and variable 'x' in component 'child2' are equivalent but variable 'x' does not have a public interface.",
+    };
+
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr parent = std::make_shared<libcellml::Component>();
+    libcellml::ComponentPtr child1 = std::make_shared<libcellml::Component>();
+    libcellml::ComponentPtr child2 = std::make_shared<libcellml::Component>();
+    libcellml::ComponentPtr grandchild = std::make_shared<libcellml::Component>();
+    m->setName("model");
+    parent->setName("parent");
+    child1->setName("child1");
+    child2->setName("child2");
+    grandchild->setName("grandchild");
+    m->addComponent(parent);
+    parent->addComponent(child1);
+    parent->addComponent(child2);
+    child2->addComponent(grandchild);
+
+    auto addVariable = [](const libcellml::ComponentPtr &component, const std::string &name, const std::string &interfaceType) {
+        libcellml::VariablePtr variable = std::make_shared<libcellml::Variable>();
+        variable->setName(name);
+        variable->setUnits("dimensionless");
+        variable->setInterfaceType(interfaceType);
+        component->addVariable(variable);
+        return variable;
+    };
+    libcellml::VariablePtr parentX = addVariable(parent, "x", "public");
+    libcellml::VariablePtr parentY = addVariable(parent, "y", "private");
+    libcellml::VariablePtr child1X = addVariable(child1, "x", "public");
+    libcellml::VariablePtr child2X = addVariable(child2, "x", "private");
+    libcellml::VariablePtr child2Z = addVariable(child2, "z", "public_and_private");
+    libcellml::VariablePtr grandchildY = addVariable(grandchild, "y", "public");
+    libcellml::VariablePtr grandchildZ = addVariable(grandchild, "z", "public");
+
+    libcellml::Variable::addEquivalence(parentX, child1X);
+    libcellml::Variable::addEquivalence(child1X, child2X);
+    libcellml::Variable::addEquivalence(parentY, grandchildY);
+    libcellml::Variable::addEquivalence(child2Z, grandchildZ);
+
+    // The interfaces of the variables of an imported component are given in
+    // the model it is imported from.
+    libcellml::ComponentPtr imported = std::make_shared<libcellml::Component>();
+    libcellml::ImportSourcePtr importSource = std::make_shared<libcellml::ImportSource>();
+    importSource->setUrl("imported.cellml");
+    imported->setName("imported");
+    imported->setSourceComponent(importSource, "component");
+    parent->addComponent(imported);
+    libcellml::VariablePtr parentW = addVariable(parent, "w", "private");
+    libcellml::VariablePtr importedW = addVariable(imported, "w", "");
+    libcellml::Variable::addEquivalence(parentW, importedW);
+
+    libcellml::Validator v;
+    v.validateModel(m);
+    EXPECT_EQ(expectedErrors.size(), v.errorCount());
+    for (size_t i = 0; i < v.errorCount(); ++i) {
+        EXPECT_EQ(expectedErrors.at(i), v.error(i)->description());
+    }
+    EXPECT_EQ(parentX, v.error(0)->variable());
+    EXPECT_EQ(libcellml::SpecificationRule::VARIABLE_INTERFACE, v.error(0)->rule());
+    EXPECT_EQ(libcellml::Error::Kind::CONNECTION, v.error(0)->kind());
+    EXPECT_EQ(libcellml::Error::Kind::CONNECTION, v.error(1)->kind());
+    EXPECT_EQ(child2X, v.error(2)->variable());
+}
+
 TEST(Validator, integerStrings)
 {
     const std::string input =
@@ -1065,3 +1141,258 @@ TEST(Validator, validMathCnElements)
     v.validateModel(m);
     EXPECT_EQ(size_t(0), v.errorCount());
 }
+
+TEST(Validator, dimensionalConsistency)
+{
+    const std::string in =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<model xmlns=\"http://www.cellml.org/cellml/2.0#\" name=\"dimensions\">\n"
+        "  <units name=\"mV\">\n"
+        "    <unit prefix=\"milli\" units=\"volt\"/>\n"
+        "  </units>\n"
+        "  <units name=\"ms\">\n"
+        "    <unit prefix=\"milli\" units=\"second\"/>\n"
+        "  </units>\n"
+        "  <units name=\"mV_per_ms\">\n"
+        "    <unit units=\"mV\"/>\n"
+        "    <unit units=\"ms\" exponent=\"-1\"/>\n"
+        "  </units>\n"
+        "  <units name=\"mV2\">\n"
+        "    <unit prefix=\"milli\" units=\"volt\" exponent=\"2\"/>\n"
+        "  </units>\n"
+        "  <component name=\"cell\">\n"
+        "    <variable name=\"t\" units=\"ms\"/>\n"
+        "    <variable name=\"v\" units=\"mV\" initial_value=\"0\"/>\n"
+        "    <variable name=\"a\" units=\"mV_per_ms\" initial_value=\"1\"/>\n"
+        "    <variable name=\"b\" units=\"mV_per_ms\" initial_value=\"2\"/>\n"
+        "    <variable name=\"k\" units=\"dimensionless\" initial_value=\"3\"/>\n"
+        "    <variable name=\"x\" units=\"mV\"/>\n"
+        "    <variable name=\"y\" units=\"dimensionless\"/>\n"
+        "    <variable name=\"z\" units=\"mV2\"/>\n"
+        "    <variable name=\"w\" units=\"ms\"/>\n"
+        "    <math xmlns=\"http://www.w3.org/1998/Math/MathML\" xmlns:cellml=\"http://www.cellml.org/cellml/2.0#\">\n"
+        "      <apply><eq/>\n"
+        "        <apply><diff/><bvar><ci>t</ci></bvar><ci>v</ci></apply>\n"
+        "        <apply><plus/><ci>a</ci><ci>b</ci></apply>\n"
+        "      </apply>\n"
+        "      <apply><eq/>\n"
+        "        <ci>x</ci>\n"
+        "        <apply><plus/><ci>v</ci><ci>t</ci></apply>\n"
+        "      </apply>\n"
+        "      <apply><eq/>\n"
+        "        <ci>y</ci>\n"
+        "        <apply><exp/><ci>v</ci></apply>\n"
+        "      </apply>\n"
+        "      <apply><eq/>\n"
+        "        <ci>z</ci>\n"
+        "        <apply><power/><ci>v</ci><cn cellml:units=\"dimensionless\">2</cn></apply>\n"
+        "      </apply>\n"
+        "      <apply><eq/>\n"
+        "        <ci>w</ci>\n"
+        "        <apply><times/><ci>v</ci><ci>k</ci></apply>\n"
+        "      </apply>\n"
+        "      <apply><eq/>\n"
+        "        <ci>x</ci>\n"
+        "        <apply><root/><ci>z</ci></apply>\n"
+        "      </apply>\n"
+        "      <apply><eq/>\n"
+        "        <ci>y</ci>\n"
+        "        <apply><power/><ci>v</ci><ci>k</ci></apply>\n"
+        "      </apply>\n"
+        "      <apply><eq/>\n"
+        "        <ci>x</ci>\n"
+        "        <piecewise>\n"
+        "          <piece>\n"
+        "            <ci>v</ci>\n"
+        "            <apply><gt/><ci>t</ci><cn cellml:units=\"second\">0</cn></apply>\n"
+        "          </piece>\n"
+        "          <otherwise><apply><minus/><ci>v</ci></apply></otherwise>\n"
+        "        </piecewise>\n"
+        "      </apply>\n"
+        "    </math>\n"
+        "  </component>\n"
+        "</model>\n";
+
+    const std::vector<std::string> expectedErrors = {
+        "Equation 2 in component 'cell' is not dimensionally consistent: the arguments of 'plus' have different dimensions 'ampere^-1.kilogram.metre^2.second^-3' and 'second'.",
+        "Equation 3 in component 'cell' is not dimensionally consistent: the argument of 'exp' has dimension 'ampere^-1.kilogram.metre^2.second^-3' but must be dimensionless.",
+        "Equation 5 in component 'cell' is not dimensionally consistent: the arguments of 'eq' have different dimensions 'second' and 'ampere^-1.kilogram.metre^2.second^-3'.",
+        "Equation 7 in component 'cell' is not dimensionally consistent: the base of 'power' has dimension 'ampere^-1.kilogram.metre^2.second^-3' but must be dimensionless as the exponent is not constant.",
+    };
+
+    libcellml::Parser parser;
+    libcellml::ModelPtr model = parser.parseModel(in);
+    EXPECT_EQ(size_t(0), parser.errorCount());
+
+    // The validator does not accept a variable of the component as a bvar,
+    // so there is one error regardless of the dimensions.
+    libcellml::Validator validator;
+    EXPECT_FALSE(validator.checkDimensions());
+    validator.validateModel(model);
+    const size_t otherErrorCount = validator.errorCount();
+    EXPECT_EQ(size_t(1), otherErrorCount);
+
+    validator.setCheckDimensions(true);
+    EXPECT_TRUE(validator.checkDimensions());
+    validator.validateModel(model);
+    EXPECT_EQ(otherErrorCount + expectedErrors.size(), validator.errorCount());
+    for (size_t i = 0; i < expectedErrors.size(); ++i) {
+        EXPECT_EQ(expectedErrors.at(i), validator.error(otherErrorCount + i)->description());
+        EXPECT_EQ(libcellml::Error::Kind::UNITS, validator.error(otherErrorCount + i)->kind());
+        EXPECT_EQ(model->component("cell"), validator.error(otherErrorCount + i)->component());
+    }
+
+    // Scaling a units does not change its dimension, while changing its
+    // dimension moves the mismatches.
+    model->units("ms")->removeAllUnits();
+    model->units("ms")->addUnit("second", "micro");
+    validator.validateModel(model);
+    EXPECT_EQ(otherErrorCount + expectedErrors.size(), validator.errorCount());
+
+    model->units("ms")->removeAllUnits();
+    model->units("ms")->addUnit("volt", "milli");
+    validator.validateModel(model);
+    EXPECT_EQ(otherErrorCount + 3, validator.errorCount());
+    EXPECT_EQ("Equation 8 in component 'cell' is not dimensionally consistent: the arguments of 'gt' have different dimensions 'ampere^-1.kilogram.metre^2.second^-3' and 'second'.", validator.error(otherErrorCount + 2)->description());
+
+    libcellml::Validator copy(validator);
+    EXPECT_TRUE(copy.checkDimensions());
+}
+
+TEST(Validator, parallelComponentValidation)
+{
+    const std::string invalidMath =
+        "<math xmlns=\"http://www.w3.org/1998/Math/MathML\">\n"
+        "  <apply>\n"
+        "    <eq/>\n"
+        "    <ci>x</ci>\n"
+        "    <apply>\n"
+        "      <bogus/>\n"
+        "      <ci>undefined</ci>\n"
+        "    </apply>\n"
+        "  </apply>\n"
+        "</math>\n";
+
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    m->setName("model");
+    for (size_t i = 0; i < 40; ++i) {
+        libcellml::ComponentPtr c = std::make_shared<libcellml::Component>();
+        c->setName((i % 7 == 0) ? "invalid name" : "component" + std::to_string(i));
+        libcellml::VariablePtr v = std::make_shared<libcellml::Variable>();
+        v->setName("x");
+        v->setUnits((i % 3 == 0) ? "" : "dimensionless");
+        c->addVariable(v);
+        if (i % 2 == 0) {
+            c->setMath(invalidMath);
+        }
+        m->addComponent(c);
+    }
+
+    libcellml::Validator serial;
+    EXPECT_EQ(size_t(1), serial.threadCount());
+    serial.validateModel(m);
+    EXPECT_LT(size_t(40), serial.errorCount());
+
+    for (size_t threadCount : {size_t(0), size_t(4), size_t(64)}) {
+        libcellml::Validator parallel;
+        parallel.setThreadCount(threadCount);
+        EXPECT_EQ(threadCount, parallel.threadCount());
+        parallel.validateModel(m);
+        EXPECT_EQ(serial.errorCount(), parallel.errorCount());
+        for (size_t i = 0; i < std::min(serial.errorCount(), parallel.errorCount()); ++i) {
+            EXPECT_EQ(serial.error(i)->description(), parallel.error(i)->description());
+            EXPECT_EQ(serial.error(i)->component(), parallel.error(i)->component());
+        }
+    }
+}
+
+TEST(Validator, incrementalValidation)
+{
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    m->setName("model");
+    std::vector<libcellml::ComponentPtr> components;
+    for (size_t i = 0; i < 3; ++i) {
+        libcellml::ComponentPtr c = std::make_shared<libcellml::Component>();
+        c->setName("component" + std::to_string(i));
+        libcellml::VariablePtr v = std::make_shared<libcellml::Variable>();
+        v->setName("x");
+        v->setUnits("u");
+        c->addVariable(v);
+        m->addComponent(c);
+        components.push_back(c);
+    }
+
+    libcellml::Validator v;
+    EXPECT_FALSE(v.isIncremental());
+    v.setIncremental(true);
+    EXPECT_TRUE(v.isIncremental());
+
+    // Each variable refers to units that do not exist.
+    v.validateModel(m);
+    EXPECT_EQ(size_t(3), v.errorCount());
+    std::vector<libcellml::ErrorPtr> errors;
+    for (size_t i = 0; i < v.errorCount(); ++i) {
+        errors.push_back(v.error(i));
+    }
+
+    // Only the changed component is validated again, the errors found in the
+    // others are reused as they are.
+    components.at(1)->setName("invalid name");
+    v.validateModel(m);
+    EXPECT_EQ(size_t(5), v.errorCount());
+    EXPECT_EQ(errors.at(0), v.error(0));
+    EXPECT_NE(errors.at(1), v.error(3));
+    EXPECT_EQ(errors.at(2), v.error(4));
+
+    // Adding the missing units affects all of the components.
+    libcellml::UnitsPtr u = std::make_shared<libcellml::Units>();
+    u->setName("u");
+    m->addUnits(u);
+    v.validateModel(m);
+    EXPECT_EQ(size_t(2), v.errorCount());
+    EXPECT_EQ("Component does not have a valid name attribute.", v.error(1)->description());
+
+    // A change to a variable counts as a change to its component.
+    components.at(2)->variable(0)->setUnits("unknown");
+    v.validateModel(m);
+
+    libcellml::Validator full;
+    full.validateModel(m);
+    EXPECT_EQ(size_t(3), v.errorCount());
+    EXPECT_EQ(full.errorCount(), v.errorCount());
+    for (size_t i = 0; i < std::min(full.errorCount(), v.errorCount()); ++i) {
+        EXPECT_EQ(full.error(i)->description(), v.error(i)->description());
+    }
+}
+
+TEST(Validator, mathWithManySiblings)
+{
+    // Long lists of siblings used to be walked recursively, one level per
+    // sibling, so enough of them would overflow the stack.
+    std::string math = "<math xmlns=\"http://www.w3.org/1998/Math/MathML\" xmlns:cellml=\"http://www.cellml.org/cellml/2.0#\">\n";
+    for (size_t i = 0; i < 20000; ++i) {
+        math += "  <apply><eq/><ci>x</ci><apply><plus/><ci>y</ci><cn cellml:units=\"dimensionless\">1</cn></apply></apply>\n";
+    }
+    math += "  <apply><eq/><ci>z</ci><cn>2</cn></apply>\n"
+            "</math>\n";
+
+    libcellml::ModelPtr m = std::make_shared<libcellml::Model>();
+    libcellml::ComponentPtr c = std::make_shared<libcellml::Component>();
+    m->setName("model");
+    c->setName("component");
+    for (const char *name : {"x", "y"}) {
+        libcellml::VariablePtr v = std::make_shared<libcellml::Variable>();
+        v->setName(name);
+        v->setUnits("dimensionless");
+        c->addVariable(v);
+    }
+    c->setMath(math);
+    m->addComponent(c);
+
+    libcellml::Validator v;
+    v.validateModel(m);
+    EXPECT_EQ(size_t(3), v.errorCount());
+    EXPECT_EQ("MathML ci element has the child text 'z', which does not correspond with any variable names present in component 'component' and is not a variable defined within a bvar element.", v.error(0)->description());
+    EXPECT_EQ("CellML identifiers must contain one or more basic Latin alphabetic characters.", v.error(1)->description());
+    EXPECT_EQ("Math cn element with the value '2' does not have a valid cellml:units attribute.", v.error(2)->description());
+}
@@ -1018,3 +1018,124 @@ TEST(Variable, modelUnitsAttributeBeforeNameAttribute)
     parser.parseModel(e);
     EXPECT_EQ(size_t(0), parser.errorCount());
 }
+
+TEST(Variable, equivalenceSets)
+{
+    libcellml::VariablePtr v1 = std::make_shared<libcellml::Variable>();
+    libcellml::VariablePtr v2 = std::make_shared<libcellml::Variable>();
+    libcellml::VariablePtr v3 = std::make_shared<libcellml::Variable>();
+    libcellml::VariablePtr v4 = std::make_shared<libcellml::Variable>();
+
+    // A variable without equivalences is in a set of its own.
+    EXPECT_EQ(std::vector<libcellml::VariablePtr>({v1}), libcellml::Variable::equivalenceSet(v1));
+    EXPECT_EQ(v1, libcellml::Variable::equivalenceRepresentative(v1));
+    EXPECT_NE(libcellml::Variable::equivalenceSetId(v1), libcellml::Variable::equivalenceSetId(v2));
+
+    // v1 - v2 - v3, v4.
+    libcellml::Variable::addEquivalence(v1, v2);
+    libcellml::Variable::addEquivalence(v3, v2);
+    EXPECT_EQ(size_t(3), libcellml::Variable::equivalenceSet(v3).size());
+    EXPECT_EQ(libcellml::Variable::equivalenceSetId(v1), libcellml::Variable::equivalenceSetId(v3));
+    EXPECT_NE(libcellml::Variable::equivalenceSetId(v1), libcellml::Variable::equivalenceSetId(v4));
+    libcellml::VariablePtr representative = libcellml::Variable::equivalenceRepresentative(v1);
+    EXPECT_EQ(representative, libcellml::Variable::equivalenceRepresentative(v2));
+    EXPECT_EQ(representative, libcellml::Variable::equivalenceRepresentative(v3));
+    EXPECT_EQ(representative, libcellml::Variable::equivalenceSet(v2).front());
+
+    // Adding an equivalence within a set changes nothing.
+    size_t id = libcellml::Variable::equivalenceSetId(v1);
+    libcellml::Variable::addEquivalence(v1, v3);
+    EXPECT_EQ(id, libcellml::Variable::equivalenceSetId(v2));
+    EXPECT_EQ(size_t(3), libcellml::Variable::equivalenceSet(v1).size());
+
+    // The loop keeps v1, v2 and v3 together when one equivalence is removed.
+    EXPECT_TRUE(libcellml::Variable::removeEquivalence(v1, v2));
+    EXPECT_EQ(size_t(3), libcellml::Variable::equivalenceSet(v1).size());
+    EXPECT_EQ(libcellml::Variable::equivalenceSetId(v1), libcellml::Variable::equivalenceSetId(v2));
+
+    // Removing another one splits off v1.
+    EXPECT_TRUE(libcellml::Variable::removeEquivalence(v3, v1));
+    EXPECT_EQ(std::vector<libcellml::VariablePtr>({v1}), libcellml::Variable::equivalenceSet(v1));
+    EXPECT_EQ(size_t(2), libcellml::Variable::equivalenceSet(v2).size());
+    EXPECT_NE(libcellml::Variable::equivalenceSetId(v1), libcellml::Variable::equivalenceSetId(v2));
+    EXPECT_EQ(libcellml::Variable::equivalenceSetId(v2), libcellml::Variable::equivalenceSetId(v3));
+
+    // Joining two sets.
+    libcellml::Variable::addEquivalence(v4, v1);
+    libcellml::Variable::addEquivalence(v4, v3);
+    EXPECT_EQ(size_t(4), libcellml::Variable::equivalenceSet(v1).size());
+
+    // Variables that no longer exist are not listed.  The equivalences that
+    // v1 and v3 still hold with v4 keep them in the same set.
+    v4->removeAllEquivalences();
+    v4 = nullptr;
+    EXPECT_EQ(size_t(3), libcellml::Variable::equivalenceSet(v2).size());
+    EXPECT_EQ(size_t(3), libcellml::Variable::equivalenceSet(v1).size());
+}
+
+TEST(Variable, equivalenceSetAfterRemovingAllEquivalences)
+{
+    // Whichever variable removes its equivalences, the other one still holds
+    // the equivalence and so keeps both variables in the same set.
+    for (size_t remover = 0; remover < 2; ++remover) {
+        libcellml::VariablePtr a = std::make_shared<libcellml::Variable>();
+        libcellml::VariablePtr b = std::make_shared<libcellml::Variable>();
+        libcellml::Variable::addEquivalence(a, b);
+        if (remover == 0) {
+            a->removeAllEquivalences();
+        } else {
+            b->removeAllEquivalences();
+        }
+        EXPECT_EQ(size_t(2), libcellml::Variable::equivalenceSet(a).size());
+        EXPECT_EQ(size_t(2), libcellml::Variable::equivalenceSet(b).size());
+        EXPECT_EQ(libcellml::Variable::equivalenceSetId(a), libcellml::Variable::equivalenceSetId(b));
+
+        // Removing the remaining side separates them.
+        if (remover == 0) {
+            b->removeAllEquivalences();
+        } else {
+            a->removeAllEquivalences();
+        }
+        EXPECT_EQ(std::vector<libcellml::VariablePtr>({a}), libcellml::Variable::equivalenceSet(a));
+        EXPECT_EQ(std::vector<libcellml::VariablePtr>({b}), libcellml::Variable::equivalenceSet(b));
+    }
+}
+
+TEST(Variable, equivalenceSetOfParsedModel)
+{
+    const std::string in =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<model xmlns=\"http://www.cellml.org/cellml/2.0#\" name=\"model\">\n"
+        "  <component name=\"a\">\n"
+        "    <variable name=\"x\" units=\"dimensionless\" interface=\"public\"/>\n"
+        "  </component>\n"
+        "  <component name=\"b\">\n"
+        "    <variable name=\"x\" units=\"dimensionless\" interface=\"public\"/>\n"
+        "    <variable name=\"y\" units=\"dimensionless\" interface=\"public\"/>\n"
+        "  </component>\n"
+        "  <component name=\"c\">\n"
+        "    <variable name=\"x\" units=\"dimensionless\" interface=\"public\"/>\n"
+        "    <variable name=\"y\" units=\"dimensionless\" interface=\"public\"/>\n"
+        "  </component>\n"
+        "  <connection component_1=\"a\" component_2=\"b\">\n"
+        "    <map_variables variable_1=\"x\" variable_2=\"x\"/>\n"
+        "  </connection>\n"
+        "  <connection component_1=\"b\" component_2=\"c\">\n"
+        "    <map_variables variable_1=\"x\" variable_2=\"x\"/>\n"
+        "    <map_variables variable_1=\"y\" variable_2=\"y\"/>\n"
+        "  </connection>\n"
+        "</model>\n";
+
+    libcellml::Parser parser;
+    libcellml::ModelPtr model = parser.parseModel(in);
+    EXPECT_EQ(size_t(0), parser.errorCount());
+
+    libcellml::VariablePtr ax = model->component("a")->variable("x");
+    libcellml::VariablePtr cx = model->component("c")->variable("x");
+    libcellml::VariablePtr by = model->component("b")->variable("y");
+    libcellml::VariablePtr cy = model->component("c")->variable("y");
+    EXPECT_EQ(size_t(3), libcellml::Variable::equivalenceSet(cx).size());
+    EXPECT_EQ(libcellml::Variable::equivalenceSetId(ax), libcellml::Variable::equivalenceSetId(cx));
+    EXPECT_EQ(libcellml::Variable::equivalenceSetId(by), libcellml::Variable::equivalenceSetId(cy));
+    EXPECT_NE(libcellml::Variable::equivalenceSetId(ax), libcellml::Variable::equivalenceSetId(cy));
+}